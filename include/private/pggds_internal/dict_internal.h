@@ -0,0 +1,88 @@
+/*!
+ * \file            dict_internal.h
+ * \brief           Private interface to generic dictionary data structure.
+ * \details         These functions allow other data structures built on
+ * top of a dictionary to hash a key once, and to forward variable
+ * arguments, rather than going through the public interface.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_DICT_INTERNAL_H
+#define PG_GENERIC_DATA_STRUCTURES_DICT_INTERNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#include <pggds/dict.h>
+
+/*!
+ * \brief           Calculates the hash of a dictionary key.
+ * \param key       The key.
+ * \returns         The hash value.
+ */
+size_t dict_hash_key(const char * key);
+
+/*!
+ * \brief           Inserts a key-value into a dictionary.
+ * \details         Behaves as `dict_insert()`.
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key.
+ * \param hash      The hash of the key, as returned by `dict_hash_key()`.
+ * \param ap        A `va_list` containing the value corresponding to the key.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+bool dict_insert_hashed(Dict dict, const char * key,
+                        const size_t hash, va_list ap);
+
+/*!
+ * \brief           Deletes a key from a dictionary.
+ * \details         Behaves as `dict_delete()`.
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key to delete.
+ * \param hash      The hash of the key, as returned by `dict_hash_key()`.
+ * \retval true     The key was deleted
+ * \retval false    The key was not found in the dictionary
+ */
+bool dict_delete_hashed(Dict dict, const char * key, const size_t hash);
+
+/*!
+ * \brief           Retrieves the value for a key in the dictionary.
+ * \details         Behaves as `dict_value_for_key()`, except that `p`
+ * may be `NULL` to merely check for the existence of the key.
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key for which to retrieve the value.
+ * \param hash      The hash of the key, as returned by `dict_hash_key()`.
+ * \param p         A pointer to an object to contain the value, or `NULL`.
+ * \retval true     Success
+ * \retval false    Failure, key was not found
+ */
+bool dict_value_for_key_hashed(Dict dict, const char * key,
+                               const size_t hash, void * p);
+
+/*!
+ * \brief           Returns the datatype of a dictionary.
+ * \param dict      A pointer to the dictionary.
+ * \returns         The datatype set when creating the dictionary.
+ */
+enum gds_datatype dict_datatype(Dict dict);
+
+/*!
+ * \brief           Returns the number of keys in a dictionary.
+ * \param dict      A pointer to the dictionary.
+ * \returns         The number of keys.
+ */
+size_t dict_num_keys(Dict dict);
+
+/*!
+ * \brief           Checks whether a dictionary exits on error.
+ * \param dict      A pointer to the dictionary.
+ * \retval true     `GDS_EXIT_ON_ERROR` was set when creating the dictionary
+ * \retval false    `GDS_EXIT_ON_ERROR` was not set
+ */
+bool dict_exit_on_error(Dict dict);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_DICT_INTERNAL_H  */
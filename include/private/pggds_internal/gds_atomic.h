@@ -0,0 +1,34 @@
+/*!
+ * \file            gds_atomic.h
+ * \brief           Common internal definitions for concurrent data structures.
+ * \details         The library is written in C99, which has no atomic
+ * operations of its own, so concurrent data structures use the GCC
+ * `__atomic` builtins directly. These have the same memory ordering
+ * semantics as C11 `<stdatomic.h>`, and are also provided by Clang.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_GDS_ATOMIC_H
+#define PG_GENERIC_DATA_STRUCTURES_GDS_ATOMIC_H
+
+/*!
+ * \brief           Assumed size of a cache line, in bytes.
+ * \details         Data written by different threads is kept at least
+ * this far apart to avoid false sharing.
+ */
+#define GDS_CACHE_LINE 64
+
+/*!
+ * \brief           Hints to the processor that the caller is spin-waiting.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define gds_cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define gds_cpu_relax() __asm__ __volatile__ ("yield" ::: "memory")
+#else
+#define gds_cpu_relax() ((void) 0)
+#endif
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_GDS_ATOMIC_H  */
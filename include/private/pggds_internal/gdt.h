@@ -61,6 +61,24 @@ void gdt_set_value(struct gdt_generic_datatype * data,
                    const enum gds_datatype type,
                    gds_cfunc cfunc, va_list ap);
 
+/*!
+ * \brief           Sets the value of a generic datatype from a list pointer.
+ * \ingroup         gdt
+ * \details         This function behaves as `gdt_set_value()`, except that
+ * it consumes the next argument from the `va_list` pointed to by `ap`, which
+ * may then be used again by the caller. This allows a single variable
+ * argument list to supply more than one value.
+ * \param data      A pointer to the generic datatype.
+ * \param type      The type of data for the datatype to contain.
+ * \param cfunc     A pointer to a comparison function, as for
+ * `gdt_set_value()`.
+ * \param ap        A pointer to a `va_list` whose next argument is of the
+ * type appropriate to `type`.
+ */
+void gdt_set_value_next(struct gdt_generic_datatype * data,
+                        const enum gds_datatype type,
+                        gds_cfunc cfunc, va_list * ap);
+
 /*!
  * \brief           Gets the value of a generic datatype.
  * \ingroup         gdt
@@ -72,6 +90,74 @@ void gdt_set_value(struct gdt_generic_datatype * data,
  */
 void gdt_get_value(const struct gdt_generic_datatype * data, void * p);
 
+/*!
+ * \brief           Returns the size of the C type corresponding to a datatype.
+ * \ingroup         gdt
+ * \details         This is the size of the object which `gdt_get_value()`
+ * writes for a generic datatype of this type, and is suitable for stepping
+ * through caller-supplied arrays of values.
+ * \param type      The datatype.
+ * \returns         The size of the corresponding C type, in bytes.
+ */
+size_t gdt_size_of_type(const enum gds_datatype type);
+
+/*!
+ * \brief           Stores the value of a generic datatype as raw bytes.
+ * \ingroup         gdt
+ * \details         The destination need not be aligned for the type, so
+ * this suits packed arrays of values.
+ * \param data      A pointer to the generic datatype.
+ * \param p         A pointer to the destination.
+ * \param size      The size of the value, which must be the result of
+ * `gdt_size_of_type()` for the datatype.
+ */
+void gdt_store_raw(const struct gdt_generic_datatype * data, void * p,
+                   const size_t size);
+
+/*!
+ * \brief           Loads the value of a generic datatype from raw bytes.
+ * \ingroup         gdt
+ * \details         The source need not be aligned for the type. The data
+ * union of the generic datatype is suitably aligned for any type, so a
+ * pointer to it can be passed wherever a pointer to a value is expected.
+ * \param data      A pointer to the generic datatype.
+ * \param type      The datatype of the value.
+ * \param p         A pointer to the source.
+ * \param size      The size of the value, which must be the result of
+ * `gdt_size_of_type()` for the datatype.
+ */
+void gdt_load_raw(struct gdt_generic_datatype * data,
+                  const enum gds_datatype type, const void * p,
+                  const size_t size);
+
+/*!
+ * \brief           Returns the comparison function for a datatype.
+ * \ingroup         gdt
+ * \details         The function is the one `gdt_set_value()` would store,
+ * and compares two values of the datatype through pointers to them, so it
+ * can be used on values stored without a generic datatype wrapper.
+ * \param type      The datatype.
+ * \param cfunc     The comparison function to return for
+ * `DATATYPE_POINTER`. It is ignored for other datatypes.
+ * \returns         A pointer to the comparison function.
+ */
+gds_cfunc gdt_compfunc_for_type(const enum gds_datatype type,
+                                gds_cfunc cfunc);
+
+/*!
+ * \brief           Calculates a hash of a generic datatype.
+ * \ingroup         gdt
+ * \details         Datatypes which compare equal have equal hashes. Strings
+ * are hashed by their contents. Pointers are hashed with the supplied hash
+ * function, since their comparison function may compare what they point
+ * to, or by their address if none is supplied.
+ * \param data      A pointer to the generic datatype.
+ * \param hfunc     A hash function for `DATATYPE_POINTER`, or `NULL`. It
+ * is ignored for other datatypes.
+ * \returns         The hash value.
+ */
+size_t gdt_hash(const struct gdt_generic_datatype * data, gds_hfunc hfunc);
+
 /*!
  * \brief           Frees memory pointed to by a generic datatype.
  * \ingroup         gdt
@@ -0,0 +1,192 @@
+/*!
+ * \file            bqueue.h
+ * \brief           Interface to blocking queue data structure.
+ * \details         A blocking queue is a bounded, thread-safe queue for
+ * passing values between any number of producer and consumer threads.
+ * Producers wait while the queue is full, and consumers wait while it is
+ * empty. Once the queue is closed no more values can be pushed, and
+ * consumers drain the values remaining before being told that the queue
+ * is finished.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_BLOCKING_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_BLOCKING_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque blocking queue type definition
+ * \ingroup         bqueue
+ */
+typedef struct bqueue * BlockingQueue;
+
+/*!
+ * \brief           Creates a new blocking queue.
+ * \ingroup         bqueue
+ * \param capacity  The maximum number of values in the queue, which must
+ * be non-zero.
+ * \param type      The datatype for the queue.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values
+ * still in the queue when it is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Queue creation failed.
+ * \retval non-NULL A pointer to the new queue.
+ */
+BlockingQueue bqueue_create(const size_t capacity,
+                            const enum gds_datatype type,
+                            const int opts);
+
+/*!
+ * \brief           Destroys a blocking queue.
+ * \details         No thread may be using the queue when it is destroyed.
+ * If the `GDS_FREE_ON_DESTROY` option was specified when creating the
+ * queue, any pointer values still in the queue will be `free()`d prior
+ * to destruction.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ */
+void bqueue_destroy(BlockingQueue queue);
+
+/*!
+ * \brief           Pushes a value onto a blocking queue.
+ * \details         If the queue is full, waits until there is room. A value
+ * which could not be pushed remains the responsibility of the caller.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is closed.
+ */
+bool bqueue_push(BlockingQueue queue, ...);
+
+/*!
+ * \brief           Pushes a value onto a blocking queue without waiting.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is full or closed.
+ */
+bool bqueue_try_push(BlockingQueue queue, ...);
+
+/*!
+ * \brief           Pushes a value onto a blocking queue, with a time limit.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \param timeout_ms    The longest time to wait for room, in milliseconds.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is closed, or remained full for
+ * the whole time limit.
+ */
+bool bqueue_timed_push(BlockingQueue queue, const unsigned long timeout_ms,
+                       ...);
+
+/*!
+ * \brief           Pops a value from a blocking queue.
+ * \details         If the queue is empty, waits until a value is pushed
+ * or the queue is closed.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is closed and empty.
+ */
+bool bqueue_pop(BlockingQueue queue, void * p);
+
+/*!
+ * \brief           Pops a value from a blocking queue without waiting.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty.
+ */
+bool bqueue_try_pop(BlockingQueue queue, void * p);
+
+/*!
+ * \brief           Pops a value from a blocking queue, with a time limit.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ * \param timeout_ms    The longest time to wait for a value, in
+ * milliseconds.
+ * \retval true     Success
+ * \retval false    Failure, the queue is closed and empty, or remained
+ * empty for the whole time limit.
+ */
+bool bqueue_timed_pop(BlockingQueue queue, void * p,
+                      const unsigned long timeout_ms);
+
+/*!
+ * \brief           Pops several values from a blocking queue at once.
+ * \details         If the queue is empty, waits until a value is pushed
+ * or the queue is closed, and then pops as many values as are available,
+ * up to the maximum, while holding the lock once.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to the first element of an array of at least
+ * `max` objects of a type appropriate to the type set when creating the
+ * queue. The popped values are stored in this array in queue order.
+ * \param max       The maximum number of values to pop.
+ * \returns         The number of values popped, which is zero only if the
+ * queue is closed and empty, or if `max` is zero.
+ */
+size_t bqueue_pop_many(BlockingQueue queue, void * p, const size_t max);
+
+/*!
+ * \brief           Closes a blocking queue.
+ * \details         Any further pushes fail, and any threads waiting to
+ * push are woken and fail. Values already in the queue may still be
+ * popped, and once the queue is empty, any threads waiting to pop are
+ * woken and fail. Closing a closed queue has no effect.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ */
+void bqueue_close(BlockingQueue queue);
+
+/*!
+ * \brief           Checks whether a blocking queue is closed.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \retval true     The queue is closed
+ * \retval false    The queue is open
+ */
+bool bqueue_is_closed(BlockingQueue queue);
+
+/*!
+ * \brief           Retrieves the current size of a blocking queue.
+ * \details         Other threads may change the size at any time, so the
+ * result is only a snapshot.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The number of values in the queue.
+ */
+size_t bqueue_size(BlockingQueue queue);
+
+/*!
+ * \brief           Retrieves the capacity of a blocking queue.
+ * \ingroup         bqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The capacity of the queue.
+ */
+size_t bqueue_capacity(BlockingQueue queue);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_BLOCKING_QUEUE_H  */
@@ -0,0 +1,128 @@
+/*!
+ * \file            cdict.h
+ * \brief           Interface to concurrent generic dictionary data structure.
+ * \details         The concurrent dictionary partitions its keys by hash
+ * into a number of shards, each of which is an ordinary dictionary
+ * guarded by its own read-write lock. Any number of threads may look up
+ * keys at the same time, and a thread inserting or deleting a key only
+ * excludes other threads working on the same shard.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_CONCURRENT_DICTIONARY_H
+#define PG_GENERIC_DATA_STRUCTURES_CONCURRENT_DICTIONARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+#include "dict.h"
+
+/*!
+ * \brief           Opaque concurrent dictionary type definition
+ * \ingroup         cdict
+ */
+typedef struct cdict * CDict;
+
+/*!
+ * \brief           Creates a new concurrent dictionary.
+ * \ingroup         cdict
+ * \param num_shards    The number of shards. This is rounded up to the
+ * next power of two. If zero, a default number of shards is used. A
+ * reasonable choice is a small multiple of the number of threads which
+ * will modify the dictionary.
+ * \param type      The datatype for the dictionary.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer members
+ * when they are deleted or when the dictionary is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Dictionary creation failed.
+ * \retval non-NULL A pointer to the new dictionary.
+ */
+CDict cdict_create(const size_t num_shards,
+                   const enum gds_datatype type,
+                   const int opts);
+
+/*!
+ * \brief           Destroys a concurrent dictionary.
+ * \details         No other thread may be using the dictionary. If the
+ * `GDS_FREE_ON_DESTROY` option was specified when creating the dictionary,
+ * any pointer values still in the dictionary will be `free()`d prior to
+ * destruction.
+ * \ingroup         cdict
+ * \param cdict     A pointer to the dictionary.
+ */
+void cdict_destroy(CDict cdict);
+
+/*!
+ * \brief           Inserts a key-value into a concurrent dictionary.
+ * \details         If the key already exists in the dictionary, the
+ * existing value will be overwritten. If `GDS_FREE_ON_DESTROY` was
+ * specified during dictionary creation, the existing element will be
+ * `free()`d prior to overwriting it.
+ * \ingroup         cdict
+ * \param cdict     A pointer to the dictionary.
+ * \param key       The key.
+ * \param ...       The value corresponding to the key. This should
+ * be of a type appropriate to the type set when creating the dictionary.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+bool cdict_insert(CDict cdict, const char * key, ...);
+
+/*!
+ * \brief           Deletes a key from a concurrent dictionary.
+ * \ingroup         cdict
+ * \param cdict     A pointer to the dictionary.
+ * \param key       The key to delete.
+ * \retval true     The key was deleted
+ * \retval false    The key was not found in the dictionary
+ */
+bool cdict_delete(CDict cdict, const char * key);
+
+/*!
+ * \brief           Checks whether a key exists in a concurrent dictionary.
+ * \ingroup         cdict
+ * \param cdict     A pointer to the dictionary.
+ * \param key       The key for which to search.
+ * \retval true     The key exists in the dictionary
+ * \retval false    The key does not exist in the dictionary
+ */
+bool cdict_has_key(CDict cdict, const char * key);
+
+/*!
+ * \brief           Retrieves the value for a key in a concurrent dictionary.
+ * \details         The value is copied out while the shard is locked.
+ * If the dictionary holds pointers and was created with
+ * `GDS_FREE_ON_DESTROY`, the caller must ensure by other means that no
+ * other thread overwrites or deletes the key while the retrieved pointer
+ * is still in use.
+ * \ingroup         cdict
+ * \param cdict     A pointer to the dictionary.
+ * \param key       The key for which to retrieve the value.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the dictionary. The object at this address will
+ * be modified to contain the value for the specified key.
+ * \retval true     Success
+ * \retval false    Failure, key was not found
+ */
+bool cdict_value_for_key(CDict cdict, const char * key, void * p);
+
+/*!
+ * \brief           Calls a function for each key in a concurrent dictionary.
+ * \details         Each shard is read-locked in turn while its keys are
+ * visited, so the visit is not an atomic snapshot of the whole dictionary.
+ * The function must not modify the dictionary.
+ * \ingroup         cdict
+ * \param cdict     A pointer to the dictionary.
+ * \param fn        A pointer to the function to call.
+ * \param ctx       A pointer which is passed unchanged to `fn`.
+ * \retval true     Every key was visited
+ * \retval false    Iteration was stopped early by `fn` returning `false`
+ */
+bool cdict_foreach(CDict cdict, dict_foreach_func fn, void * ctx);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_CONCURRENT_DICTIONARY_H  */
@@ -0,0 +1,111 @@
+/*!
+ * \file            cvector.h
+ * \brief           Interface to append-only concurrent vector.
+ * \details         A concurrent vector is a vector which any number of
+ * threads may append to and read from at the same time, without locks.
+ * Elements are stored in segments, each twice the size of the one before,
+ * and a segment is never moved or freed once allocated, so an element
+ * stays at the same address until the vector is destroyed. Elements can
+ * be appended, but not deleted or changed.
+ *
+ * An appending thread first reserves an index and then stores its value,
+ * so a reader may briefly see an index below the vector's length whose
+ * value has not yet been published. Such an element reads as missing
+ * rather than as garbage.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_CONCURRENT_VECTOR_H
+#define PG_GENERIC_DATA_STRUCTURES_CONCURRENT_VECTOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque concurrent vector type definition
+ * \ingroup         cvector
+ */
+typedef struct cvector * CVector;
+
+/*!
+ * \brief           Creates a new concurrent vector.
+ * \ingroup         cvector
+ * \param capacity  The size of the first segment. This is rounded up to
+ * the next power of two. If zero, a default size is used.
+ * \param type      The datatype for the vector.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values
+ * when the vector is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Vector creation failed.
+ * \retval non-NULL A pointer to the new vector.
+ */
+CVector cvector_create(const size_t capacity, const enum gds_datatype type,
+                       const int opts);
+
+/*!
+ * \brief           Destroys a concurrent vector.
+ * \details         No other thread may be using the vector. If the
+ * `GDS_FREE_ON_DESTROY` option was specified when creating the vector,
+ * any pointer values in the vector will be `free()`d prior to
+ * destruction.
+ * \ingroup         cvector
+ * \param vector    A pointer to the vector.
+ */
+void cvector_destroy(CVector vector);
+
+/*!
+ * \brief           Appends a value to the back of a concurrent vector.
+ * \ingroup         cvector
+ * \param vector    A pointer to the vector.
+ * \param index     A pointer to an object which is modified to contain the
+ * index of the new element, or `NULL`.
+ * \param ...       The value to append to the end of the vector. This should
+ * be of a type appropriate to the type set when creating the vector.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed. The index
+ * reserved for the value is left permanently missing.
+ */
+bool cvector_append(CVector vector, size_t * index, ...);
+
+/*!
+ * \brief           Gets the value at the specified index of a concurrent
+ * vector.
+ * \ingroup         cvector
+ * \param vector    A pointer to the vector.
+ * \param index     The index of the value to get.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the vector. The object at this address will be
+ * modified to contain the value at the specified index.
+ * \retval true     Success
+ * \retval false    Failure, index was out of range, or the value at that
+ * index has not yet been published by the thread appending it.
+ */
+bool cvector_element_at_index(CVector vector, const size_t index,
+                              void * p);
+
+/*!
+ * \brief           Checks whether a concurrent vector is empty.
+ * \ingroup         cvector
+ * \param vector    A pointer to the vector.
+ * \retval true     The vector was empty
+ * \retval false    The vector was not empty
+ */
+bool cvector_is_empty(CVector vector);
+
+/*!
+ * \brief           Returns the length of a concurrent vector.
+ * \details         The length counts every index reserved by an append,
+ * including any whose values have not yet been published.
+ * \ingroup         cvector
+ * \param vector    A pointer to the vector.
+ * \returns         The length of the vector.
+ */
+size_t cvector_length(CVector vector);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_CONCURRENT_VECTOR_H  */
@@ -0,0 +1,158 @@
+/*!
+ * \file            deque.h
+ * \brief           Interface to generic double-ended queue data structure.
+ * \details         A deque holds a sequence of values which can be pushed
+ * and popped at either end in constant time, and read or written by index
+ * in constant time. The values are stored in fixed-size blocks which are
+ * never moved once allocated, so the address of a value remains valid
+ * while values are pushed and popped at either end, until that value
+ * itself is popped.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_DEQUE_H
+#define PG_GENERIC_DATA_STRUCTURES_DEQUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque deque type definition
+ * \ingroup         deque
+ */
+typedef struct deque * Deque;
+
+/*!
+ * \brief           Creates a new deque.
+ * \ingroup         deque
+ * \param type      The datatype for the deque.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values
+ * still in the deque when it is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Deque creation failed.
+ * \retval non-NULL A pointer to the new deque.
+ */
+Deque deque_create(const enum gds_datatype type, const int opts);
+
+/*!
+ * \brief           Destroys a deque.
+ * \details         If the `GDS_FREE_ON_DESTROY` option was specified
+ * when creating the deque, any pointer values still in the deque will
+ * be `free()`d prior to destruction.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ */
+void deque_destroy(Deque deque);
+
+/*!
+ * \brief           Pushes a value onto the back of a deque.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \param ...       The value to push. This should be of a type
+ * appropriate to the type set when creating the deque.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed.
+ */
+bool deque_push_back(Deque deque, ...);
+
+/*!
+ * \brief           Pushes a value onto the front of a deque.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \param ...       The value to push. This should be of a type
+ * appropriate to the type set when creating the deque.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed.
+ */
+bool deque_push_front(Deque deque, ...);
+
+/*!
+ * \brief           Pops a value from the back of a deque.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the deque. The object at this address will be
+ * modified to contain the value popped from the deque.
+ * \retval true     Success
+ * \retval false    Failure, the deque is empty.
+ */
+bool deque_pop_back(Deque deque, void * p);
+
+/*!
+ * \brief           Pops a value from the front of a deque.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the deque. The object at this address will be
+ * modified to contain the value popped from the deque.
+ * \retval true     Success
+ * \retval false    Failure, the deque is empty.
+ */
+bool deque_pop_front(Deque deque, void * p);
+
+/*!
+ * \brief           Gets the value at a specified index of a deque.
+ * \details         Index zero is the front of the deque.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \param index     The index of the value.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the deque. The object at this address will be
+ * modified to contain the value at the specified index.
+ * \retval true     Success
+ * \retval false    Failure, index out of range.
+ */
+bool deque_element_at_index(Deque deque, const size_t index, void * p);
+
+/*!
+ * \brief           Sets the value at a specified index of a deque.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \param index     The index of the value.
+ * \param ...       The new value. This should be of a type appropriate
+ * to the type set when creating the deque.
+ * \retval true     Success
+ * \retval false    Failure, index out of range.
+ */
+bool deque_set_element_at_index(Deque deque, const size_t index, ...);
+
+/*!
+ * \brief           Gets the address of the value at a specified index of
+ * a deque.
+ * \details         The address stays valid, and continues to refer to
+ * the same value, until that value is popped or the deque is destroyed.
+ * Pushing and popping other values at either end does not move it,
+ * although it does change the value's index.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \param index     The index of the value.
+ * \retval NULL     Failure, index out of range.
+ * \retval non-NULL A pointer to the value, which is an object of a type
+ * appropriate to the type set when creating the deque.
+ */
+void * deque_element_address(Deque deque, const size_t index);
+
+/*!
+ * \brief           Checks whether a deque is empty.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \retval true     The deque is empty
+ * \retval false    The deque is not empty
+ */
+bool deque_is_empty(Deque deque);
+
+/*!
+ * \brief           Retrieves the number of values in a deque.
+ * \ingroup         deque
+ * \param deque     A pointer to the deque.
+ * \returns         The number of values in the deque.
+ */
+size_t deque_size(Deque deque);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_DEQUE_H  */
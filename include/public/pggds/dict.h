@@ -21,6 +21,23 @@
  */
 typedef struct dict * Dict;
 
+/*!
+ * \brief           Opaque dictionary iterator type definition
+ * \ingroup         dict
+ */
+typedef struct dict_slot * DictItr;
+
+/*!
+ * \brief           Type definition for dictionary visitor function pointer.
+ * \details         The function is called with the key, a pointer to an
+ * object of a type appropriate to the type set when creating the dictionary
+ * containing the value for that key, and the context pointer passed to
+ * `dict_foreach()`. The function should return `true` to continue the
+ * iteration, or `false` to stop it.
+ * \ingroup         dict
+ */
+typedef bool (*dict_foreach_func)(const char * key, void * value, void * ctx);
+
 /*!
  * \brief           Creates a new dictionary.
  * \ingroup         dict
@@ -29,7 +46,11 @@ typedef struct dict * Dict;
  * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer members
  * when they are deleted or when the dictionary is destroyed;
  * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
- * and `exit()`, rather than returning a failure status.
+ * and `exit()`, rather than returning a failure status;
+ * `GDS_BLOOM_FILTER` to maintain a Bloom filter of the keys, so that most
+ * lookups of absent keys are answered from a single cache line without
+ * probing the table. This costs one byte of memory per slot, and suits
+ * dictionaries where most lookups miss.
  * \retval NULL     Dictionart creation failed.
  * \retval non-NULL A pointer to the new dictionary.
  */
@@ -95,4 +116,113 @@ bool dict_has_key(Dict dict, const char * key);
  */
 bool dict_value_for_key(Dict dict, const char * key, void * p);
 
+/*!
+ * \brief           Retrieves the values for a batch of keys.
+ * \details         This is equivalent to calling `dict_value_for_key()` for
+ * each key in turn, but hashes the keys and prefetches their slots, pairs
+ * and stored keys in groups before comparing any of them, so that the
+ * cache misses for different keys overlap rather than occurring one after
+ * another.
+ * \ingroup         dict
+ * \param dict      A pointer to the dictionary.
+ * \param keys      An array of `n` keys for which to retrieve values.
+ * \param n         The number of keys.
+ * \param out_values    A pointer to an array of `n` objects of a type
+ * appropriate to the type set when creating the dictionary. The object at
+ * each index will be modified to contain the value for the key at the same
+ * index of `keys`, if that key is found, and left unmodified otherwise.
+ * \param out_found A pointer to an array of `n` `bool` objects, each of
+ * which will be set to `true` if the corresponding key was found, and
+ * `false` otherwise. If set to `NULL`, this information is not stored.
+ * \returns         The number of keys which were found.
+ */
+size_t dict_lookup_many(Dict dict, const char * const * keys, const size_t n,
+                        void * out_values, bool * out_found);
+
+/*!
+ * \brief           Returns an iterator to the first key in a dictionary.
+ * \details         Iteration visits the keys in storage order, which is
+ * unrelated to the order of insertion. Iterating requires no dynamic
+ * memory allocation. Deleting keys during iteration, either with
+ * `dict_delete_itr()` or with `dict_delete()`, is permitted, and does not
+ * disturb iteration over the remaining keys. Inserting new keys during
+ * iteration invalidates all iterators, but overwriting the value for an
+ * existing key does not.
+ * \ingroup         dict
+ * \param dict      A pointer to the dictionary.
+ * \retval NULL     The dictionary is empty
+ * \retval non-NULL An iterator to the first key in the dictionary
+ */
+DictItr dict_itr_first(Dict dict);
+
+/*!
+ * \brief           Increments a dictionary iterator.
+ * \details         It is permitted for the key at `itr` to have been
+ * deleted since the iterator was obtained.
+ * \ingroup         dict
+ * \param dict      A pointer to the dictionary.
+ * \param itr       The iterator.
+ * \retval NULL     End of dictionary, no next iterator
+ * \retval non-NULL An iterator to the next key in the dictionary
+ */
+DictItr dict_itr_next(Dict dict, DictItr itr);
+
+/*!
+ * \brief           Retrieves the key from an iterator.
+ * \details         The returned string belongs to the dictionary, and
+ * remains valid only until the key is deleted.
+ * \ingroup         dict
+ * \param itr       The iterator.
+ * \returns         The key at the given iterator.
+ */
+const char * dict_itr_key(DictItr itr);
+
+/*!
+ * \brief           Retrieves the value from an iterator.
+ * \ingroup         dict
+ * \param itr       The iterator.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the dictionary. The object at this address will
+ * be modified to contain the value at the given iterator.
+ */
+void dict_itr_value(DictItr itr, void * p);
+
+/*!
+ * \brief           Deletes the key pointed to by an iterator.
+ * \ingroup         dict
+ * \param dict      A pointer to the dictionary.
+ * \param itr       The iterator.
+ * \returns         An iterator pointing to the next key, `NULL` if
+ * there are no more keys.
+ */
+DictItr dict_delete_itr(Dict dict, DictItr itr);
+
+/*!
+ * \brief           Calls a function for each key in a dictionary.
+ * \details         Keys are visited in the same order as by
+ * `dict_itr_first()` and `dict_itr_next()`. The function may delete the
+ * key it is passed, but must not insert new keys.
+ * \ingroup         dict
+ * \param dict      A pointer to the dictionary.
+ * \param fn        A pointer to the function to call.
+ * \param ctx       A pointer which is passed unchanged to `fn`.
+ * \retval true     Every key was visited
+ * \retval false    Iteration was stopped early by `fn` returning `false`
+ */
+bool dict_foreach(Dict dict, dict_foreach_func fn, void * ctx);
+
+/*!
+ * \brief           Estimates the false positive rate of a Bloom filter.
+ * \details         This is the probability that a lookup of a key which is
+ * not in the dictionary passes the filter and must probe the table,
+ * estimated from the proportion of bits set in the filter. Deleted keys
+ * still occupy the filter until the table is next rehashed, so frequent
+ * deletions raise the rate.
+ * \ingroup         dict
+ * \param dict      A pointer to the dictionary.
+ * \returns         The estimated false positive rate, or 1 if the
+ * dictionary was not created with `GDS_BLOOM_FILTER`.
+ */
+double dict_bloom_fp_rate(Dict dict);
+
 #endif      /*  PG_GENERIC_DATA_STRUCTURES_GENERIC_DICTIONARY_H  */
@@ -0,0 +1,127 @@
+/*!
+ * \file            dict_mapped.h
+ * \brief           Interface to memory-mapped dictionary snapshots.
+ * \details         A dictionary can be saved to a file as a ready-built
+ * hash table image, which can later be mapped into memory read-only and
+ * searched directly, without parsing or inserting any keys. Processes
+ * which map the same image share its pages.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_MAPPED_DICTIONARY_H
+#define PG_GENERIC_DATA_STRUCTURES_MAPPED_DICTIONARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+#include "dict.h"
+
+/*!
+ * \brief           Opaque mapped dictionary type definition
+ * \ingroup         dict_mapped
+ */
+typedef struct dict_mapped * DictMapped;
+
+/*!
+ * \brief           Saves a dictionary to a file.
+ * \details         Dictionaries of type `DATATYPE_GDSSTRING` and
+ * `DATATYPE_POINTER` cannot be saved, since their values have no
+ * meaningful representation outside the saving process. The image records
+ * the byte order and word size of the saving machine, and can only be
+ * opened on a machine which matches them.
+ * \ingroup         dict_mapped
+ * \param dict      A pointer to the dictionary.
+ * \param path      The path of the file to write. The image is written
+ * to a temporary file in the same directory, which then replaces any
+ * existing file, so processes which have the old image mapped can keep
+ * using it, and the old image is left untouched if the save fails. A new
+ * file is created with mode 0644, and an existing file's mode is kept.
+ * \retval true     Success
+ * \retval false    Failure, the file could not be written, dynamic memory
+ * allocation failed, or the dictionary's type cannot be saved
+ */
+bool dict_save(Dict dict, const char * path);
+
+/*!
+ * \brief           Opens a saved dictionary image.
+ * \details         The file is mapped read-only. Only the header is
+ * checked, so opening is fast and reads no more of the image than the
+ * lookups which follow. Entries are bounds-checked as lookups reach them,
+ * so a corrupt image cannot cause a read outside the mapping, but may
+ * give wrong results. Call `dict_verify_mapped()` to check the whole
+ * image.
+ * \ingroup         dict_mapped
+ * \param path      The path of a file written by `dict_save()`.
+ * \retval NULL     The file could not be opened or mapped, or is not a
+ * valid image for this machine.
+ * \retval non-NULL A pointer to the mapped dictionary.
+ */
+DictMapped dict_open_mapped(const char * path);
+
+/*!
+ * \brief           Verifies the checksum and structure of a mapped
+ * dictionary.
+ * \details         This reads the whole image, so it is best used once,
+ * for instance after copying an image from another machine, rather than
+ * on every open.
+ * \ingroup         dict_mapped
+ * \param dict      A pointer to the mapped dictionary.
+ * \retval true     The image is intact.
+ * \retval false    The image is corrupt.
+ */
+bool dict_verify_mapped(DictMapped dict);
+
+/*!
+ * \brief           Closes a mapped dictionary.
+ * \details         Any strings retrieved from the dictionary become invalid.
+ * \ingroup         dict_mapped
+ * \param dict      A pointer to the mapped dictionary.
+ */
+void dict_mapped_close(DictMapped dict);
+
+/*!
+ * \brief           Checks whether a key exists in a mapped dictionary.
+ * \ingroup         dict_mapped
+ * \param dict      A pointer to the mapped dictionary.
+ * \param key       The key for which to search.
+ * \retval true     The key exists in the dictionary
+ * \retval false    The key does not exist in the dictionary
+ */
+bool dict_mapped_has_key(DictMapped dict, const char * key);
+
+/*!
+ * \brief           Retrieves the value for a key in a mapped dictionary.
+ * \ingroup         dict_mapped
+ * \param dict      A pointer to the mapped dictionary.
+ * \param key       The key for which to retrieve the value.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type of the saved dictionary. The object at this address will be
+ * modified to contain the value for the specified key. For a dictionary of
+ * `DATATYPE_STRING`, the string points into the mapped image. It must not
+ * be modified or `free()`d, and remains valid until the dictionary is
+ * closed.
+ * \retval true     Success
+ * \retval false    Failure, key was not found
+ */
+bool dict_mapped_value_for_key(DictMapped dict, const char * key, void * p);
+
+/*!
+ * \brief           Returns the number of keys in a mapped dictionary.
+ * \ingroup         dict_mapped
+ * \param dict      A pointer to the mapped dictionary.
+ * \returns         The number of keys in the dictionary.
+ */
+size_t dict_mapped_size(DictMapped dict);
+
+/*!
+ * \brief           Returns the datatype of a mapped dictionary.
+ * \ingroup         dict_mapped
+ * \param dict      A pointer to the mapped dictionary.
+ * \returns         The datatype of the dictionary which was saved.
+ */
+enum gds_datatype dict_mapped_type(DictMapped dict);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_MAPPED_DICTIONARY_H  */
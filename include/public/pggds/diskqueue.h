@@ -0,0 +1,143 @@
+/*!
+ * \file            diskqueue.h
+ * \brief           Interface to persistent disk-backed queue.
+ * \details         A disk queue is a first-in, first-out queue of
+ * variable-length records which lives in a directory on disk, so that
+ * records pushed by one run of a program can be popped by the next, even
+ * if the first run crashed. Records are appended to fixed-size segment
+ * files which are mapped into memory, and the positions of the first and
+ * last records are kept in a small header file. A segment is reused for
+ * new records once every record in it has been popped and the queue has
+ * since been synced.
+ *
+ * Changes reach the disk when the queue is synced, either explicitly or
+ * after a chosen number of pushes and pops. After a crash, every record
+ * pushed before the last sync is recovered, and records popped since the
+ * last sync may be recovered again, so a consumer should be prepared to
+ * see a record twice. When the queue is opened, each record is checked
+ * against a checksum, and the queue is cut short at the first record
+ * which fails, since a record which failed to reach the disk intact was
+ * never synced.
+ *
+ * A disk queue may be used by only one thread, in one process, at a time.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_DISK_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_DISK_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque disk queue type definition
+ * \ingroup         diskqueue
+ */
+typedef struct diskqueue * DiskQueue;
+
+/*!
+ * \brief           Opens a disk queue, creating it if it does not exist.
+ * \details         The directory is created if needed, and holds a file
+ * named `queue.hdr` and segment files whose names end in `.seg`. Any
+ * records left by a previous run are recovered.
+ * \ingroup         diskqueue
+ * \param dir       The path of the directory holding the queue.
+ * \param segment_size  The minimum size of each segment file, in bytes,
+ * which limits the size of a record. This is rounded up to a whole number
+ * of pages, and is ignored if the queue already exists.
+ * \param sync_interval The number of pushes and pops after which the
+ * queue is synced automatically, or zero to sync only when
+ * `diskqueue_sync()` or `diskqueue_close()` is called.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     The queue could not be opened or created.
+ * \retval non-NULL A pointer to the queue.
+ */
+DiskQueue diskqueue_open(const char * dir, const size_t segment_size,
+                         const size_t sync_interval, const int opts);
+
+/*!
+ * \brief           Syncs and closes a disk queue.
+ * \details         Any record data returned by `diskqueue_front()`
+ * becomes invalid.
+ * \ingroup         diskqueue
+ * \param queue     A pointer to the queue.
+ * \retval true     Success
+ * \retval false    Failure, the final sync failed, although the queue
+ * is still closed.
+ */
+bool diskqueue_close(DiskQueue queue);
+
+/*!
+ * \brief           Pushes a record onto the back of a disk queue.
+ * \ingroup         diskqueue
+ * \param queue     A pointer to the queue.
+ * \param data      A pointer to the record data.
+ * \param size      The size of the record data, in bytes.
+ * \retval true     Success
+ * \retval false    Failure, the record is too large for a segment, or a
+ * segment file could not be created or synced.
+ */
+bool diskqueue_push(DiskQueue queue, const void * data, const size_t size);
+
+/*!
+ * \brief           Gets the record at the front of a disk queue.
+ * \details         The record is read in place, and stays valid until it
+ * is popped or the queue is closed.
+ * \ingroup         diskqueue
+ * \param queue     A pointer to the queue.
+ * \param data      A pointer to a pointer which is modified to point to
+ * the record data.
+ * \param size      A pointer to an object which is modified to contain
+ * the size of the record data, in bytes.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty.
+ */
+bool diskqueue_front(DiskQueue queue, const void ** data, size_t * size);
+
+/*!
+ * \brief           Pops the record at the front of a disk queue.
+ * \details         Call `diskqueue_front()` first to read the record.
+ * \ingroup         diskqueue
+ * \param queue     A pointer to the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty, or the next segment file
+ * could not be mapped, or the queue could not be synced.
+ */
+bool diskqueue_pop(DiskQueue queue);
+
+/*!
+ * \brief           Syncs a disk queue to disk.
+ * \details         Once this returns successfully, every record pushed
+ * so far will survive a crash, and no record popped so far will be
+ * recovered.
+ * \ingroup         diskqueue
+ * \param queue     A pointer to the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue's files could not be synced.
+ */
+bool diskqueue_sync(DiskQueue queue);
+
+/*!
+ * \brief           Checks whether a disk queue is empty.
+ * \ingroup         diskqueue
+ * \param queue     A pointer to the queue.
+ * \retval true     The queue is empty
+ * \retval false    The queue is not empty
+ */
+bool diskqueue_is_empty(DiskQueue queue);
+
+/*!
+ * \brief           Retrieves the number of records in a disk queue.
+ * \ingroup         diskqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The number of records in the queue.
+ */
+size_t diskqueue_size(DiskQueue queue);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_DISK_QUEUE_H  */
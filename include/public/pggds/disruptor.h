@@ -0,0 +1,180 @@
+/*!
+ * \file            disruptor.h
+ * \brief           Interface to broadcast ring buffer.
+ * \details         A broadcast ring buffer, or disruptor, passes a stream
+ * of fixed-size entries from one producer thread to a fixed number of
+ * consumer threads, every one of which sees every entry. Each entry is
+ * written once, directly into the ring, and each consumer reads it in
+ * place, so adding consumers does not add copies. Every consumer keeps
+ * its own position in the stream, and the producer may not overwrite an
+ * entry until the slowest consumer has released it.
+ *
+ * Entries are identified by sequence numbers, which count up from zero.
+ * The producer claims one or more entries, fills them in, and publishes
+ * them; each consumer asks which entries are available to it, reads
+ * them, and releases them.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_DISRUPTOR_H
+#define PG_GENERIC_DATA_STRUCTURES_DISRUPTOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque broadcast ring buffer type definition
+ * \ingroup         disruptor
+ */
+typedef struct disruptor * Disruptor;
+
+/*!
+ * \brief           Creates a new broadcast ring buffer.
+ * \ingroup         disruptor
+ * \param capacity  The minimum number of entries in the ring. This is
+ * rounded up to the next power of two, and to at least two.
+ * \param entry_size    The size of each entry, in bytes.
+ * \param num_consumers The number of consumers, which must be at least
+ * one. Consumers are numbered from zero.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Creation failed.
+ * \retval non-NULL A pointer to the new ring buffer.
+ */
+Disruptor disruptor_create(const size_t capacity, const size_t entry_size,
+                           const size_t num_consumers, const int opts);
+
+/*!
+ * \brief           Destroys a broadcast ring buffer.
+ * \details         No thread may be using the ring buffer when it is
+ * destroyed.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ */
+void disruptor_destroy(Disruptor ring);
+
+/*!
+ * \brief           Claims entries for the producer to fill, without
+ * waiting.
+ * \details         Only the producer thread may call this function.
+ * Either all `n` entries are claimed, or none are.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ * \param n         The number of entries to claim, which must not be
+ * greater than the capacity.
+ * \param first     A pointer to an object which is modified to contain
+ * the sequence number of the first claimed entry.
+ * \retval true     Success
+ * \retval false    Failure, a consumer has not yet released entries
+ * which would be overwritten.
+ */
+bool disruptor_try_claim(Disruptor ring, const size_t n, size_t * first);
+
+/*!
+ * \brief           Claims entries for the producer to fill.
+ * \details         Only the producer thread may call this function. If
+ * there is not yet room for `n` entries, spins, and then yields the
+ * processor, until the consumers release enough entries.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ * \param n         The number of entries to claim, which must not be
+ * greater than the capacity.
+ * \returns         The sequence number of the first claimed entry.
+ */
+size_t disruptor_claim(Disruptor ring, const size_t n);
+
+/*!
+ * \brief           Publishes claimed entries to the consumers.
+ * \details         Only the producer thread may call this function.
+ * Entries are published in the order they were claimed, and become
+ * visible to the consumers together.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ * \param n         The number of entries to publish, which must not be
+ * greater than the number claimed and not yet published.
+ */
+void disruptor_publish(Disruptor ring, const size_t n);
+
+/*!
+ * \brief           Closes a broadcast ring buffer.
+ * \details         Only the producer thread may call this function, and
+ * it may not claim any more entries afterwards. Consumers waiting in
+ * `disruptor_wait()` return once they have consumed every published
+ * entry.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ */
+void disruptor_close(Disruptor ring);
+
+/*!
+ * \brief           Finds the entries available to a consumer, without
+ * waiting.
+ * \details         Only the thread acting as the given consumer may call
+ * this function.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ * \param consumer  The consumer number.
+ * \param first     A pointer to an object which is modified to contain
+ * the sequence number of the first entry the consumer has not released.
+ * \returns         The number of published entries, starting at `*first`,
+ * which the consumer may read.
+ */
+size_t disruptor_available(Disruptor ring, const size_t consumer,
+                           size_t * first);
+
+/*!
+ * \brief           Waits for entries to become available to a consumer.
+ * \details         Only the thread acting as the given consumer may call
+ * this function. If no entries are available, spins, and then yields the
+ * processor, until the producer publishes one or closes the ring buffer.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ * \param consumer  The consumer number.
+ * \param first     A pointer to an object which is modified to contain
+ * the sequence number of the first entry the consumer has not released.
+ * \returns         The number of published entries, starting at `*first`,
+ * which the consumer may read, which is zero only if the ring buffer is
+ * closed and the consumer has read every entry.
+ */
+size_t disruptor_wait(Disruptor ring, const size_t consumer,
+                      size_t * first);
+
+/*!
+ * \brief           Releases entries a consumer has finished reading.
+ * \details         Only the thread acting as the given consumer may call
+ * this function. The entries must not be read by this consumer again.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ * \param consumer  The consumer number.
+ * \param n         The number of entries to release, which must not be
+ * greater than the number available.
+ */
+void disruptor_release(Disruptor ring, const size_t consumer,
+                       const size_t n);
+
+/*!
+ * \brief           Returns the address of an entry.
+ * \details         The producer may write to entries it has claimed but
+ * not yet published, and a consumer may read entries which are available
+ * to it and which it has not released.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ * \param sequence  The sequence number of the entry.
+ * \returns         A pointer to the entry.
+ */
+void * disruptor_entry(Disruptor ring, const size_t sequence);
+
+/*!
+ * \brief           Retrieves the capacity of a broadcast ring buffer.
+ * \ingroup         disruptor
+ * \param ring      A pointer to the ring buffer.
+ * \returns         The number of entries in the ring.
+ */
+size_t disruptor_capacity(Disruptor ring);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_DISRUPTOR_H  */
@@ -0,0 +1,132 @@
+/*!
+ * \file            gds_epoch.h
+ * \brief           Interface to epoch-based memory reclamation.
+ * \details         Epoch-based reclamation lets lock-free data structures
+ * free memory which other threads may still be reading. A thread reading
+ * shared memory does so inside a critical section, and a thread which
+ * unlinks an object from a shared structure retires it rather than freeing
+ * it. The object is freed later, once every thread which was in a critical
+ * section when it was retired has left that critical section, so no thread
+ * can still hold a pointer to it.
+ *
+ * Each thread keeps its own list of retired objects, and frees objects
+ * from it as the global epoch advances. An object retired by a thread
+ * which then exits is freed by the next thread to take over its record,
+ * or when the domain is destroyed.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_GDS_EPOCH_H
+#define PG_GENERIC_DATA_STRUCTURES_GDS_EPOCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque reclamation domain type definition
+ * \ingroup         gds_epoch
+ */
+typedef struct gds_epoch * GDSEpoch;
+
+/*!
+ * \brief           Creates a new reclamation domain.
+ * \details         A domain is normally shared by all the threads using
+ * one data structure, or a group of structures whose objects are retired
+ * together.
+ * \ingroup         gds_epoch
+ * \param opts      The following options can be OR'd together:
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status, both here and
+ * when a later call fails.
+ * \retval NULL     Domain creation failed.
+ * \retval non-NULL A pointer to the new domain.
+ */
+GDSEpoch gds_epoch_create(const int opts);
+
+/*!
+ * \brief           Destroys a reclamation domain.
+ * \details         No other thread may be using the domain. Every object
+ * still waiting to be freed is freed.
+ * \ingroup         gds_epoch
+ * \param domain    A pointer to the domain.
+ */
+void gds_epoch_destroy(GDSEpoch domain);
+
+/*!
+ * \brief           Begins a critical section.
+ * \details         An object which a thread finds in a shared structure
+ * within a critical section will not be freed before the critical section
+ * ends, even if another thread unlinks and retires it meanwhile. Critical
+ * sections may be nested. They should be kept short, since a
+ * thread in a critical section holds up the freeing of every object
+ * retired meanwhile.
+ * \ingroup         gds_epoch
+ * \param domain    A pointer to the domain.
+ * \retval true     Success
+ * \retval false    Failure, this is the thread's first use of the domain
+ * and dynamic memory allocation for its record failed. The thread is not
+ * in a critical section, and must not call `gds_epoch_exit()`.
+ */
+bool gds_epoch_enter(GDSEpoch domain);
+
+/*!
+ * \brief           Ends a critical section.
+ * \details         The thread must not use pointers to shared objects
+ * loaded within the critical section after it ends.
+ * \ingroup         gds_epoch
+ * \param domain    A pointer to the domain.
+ */
+void gds_epoch_exit(GDSEpoch domain);
+
+/*!
+ * \brief           Retires an object, to be freed once no thread can be
+ * using it.
+ * \details         The object must already be unlinked from every shared
+ * structure, so that no thread entering a critical section afterwards can
+ * find it. This function may be called inside or outside a critical
+ * section, and occasionally frees objects retired earlier by the calling
+ * thread.
+ * \ingroup         gds_epoch
+ * \param domain    A pointer to the domain.
+ * \param ptr       A pointer to the object.
+ * \param free_fn   The function to free the object, or `NULL` to use
+ * `free()`. It is called from whichever thread frees the object, outside
+ * any locks held by the library.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed, and the
+ * object has not been retired.
+ */
+bool gds_epoch_retire(GDSEpoch domain, void * ptr, void (*free_fn)(void *));
+
+/*!
+ * \brief           Waits until no thread can be using an unlinked object.
+ * \details         Returns once every thread which was in a critical
+ * section when this function was called has left it, so objects the caller
+ * unlinked beforehand may be freed directly rather than retired. Objects
+ * retired by the calling thread which can now be freed are also freed. The
+ * caller must not be in a critical section itself.
+ * \ingroup         gds_epoch
+ * \param domain    A pointer to the domain.
+ */
+void gds_epoch_synchronize(GDSEpoch domain);
+
+/*!
+ * \brief           Frees objects retired by the calling thread which no
+ * thread can still be using.
+ * \details         This also tries to advance the global epoch. An object
+ * can be freed once the epoch has advanced twice since it was retired,
+ * so calling this function repeatedly while no thread is in a critical
+ * section frees every object the calling thread has retired.
+ * \ingroup         gds_epoch
+ * \param domain    A pointer to the domain.
+ * \returns         The number of objects freed, which is zero if this is
+ * the thread's first use of the domain and dynamic memory allocation for
+ * its record failed.
+ */
+size_t gds_epoch_reclaim(GDSEpoch domain);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_GDS_EPOCH_H  */
@@ -18,6 +18,15 @@
  */
 typedef int (*gds_cfunc)(const void *, const void *);
 
+/*!
+ *  \brief          Type definition for hash function pointer.
+ *  \details        The function is passed a pointer to the element, in the
+ *  same way as a comparison function, and must return equal hashes for any
+ *  two elements which the comparison function considers equal.
+ *  \ingroup        gdt
+ */
+typedef size_t (*gds_hfunc)(const void *);
+
 /*!
  *  \brief          Enumeration type for data structure options.
  *  \ingroup        general
@@ -25,7 +34,9 @@ typedef int (*gds_cfunc)(const void *, const void *);
 enum gds_option {
     GDS_RESIZABLE = 1,          /*!<  Dynamically resizes on demand        */
     GDS_FREE_ON_DESTROY = 2,    /*!<  Automatically frees pointer members  */
-    GDS_EXIT_ON_ERROR = 4       /*!<  Exits on error                       */
+    GDS_EXIT_ON_ERROR = 4,      /*!<  Exits on error                       */
+    GDS_BLOOM_FILTER = 8,       /*!<  Filters lookups of absent keys       */
+    GDS_SEGMENTED = 16          /*!<  Grows in chunks without copying      */
 };
 
 /*!
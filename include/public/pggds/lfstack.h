@@ -0,0 +1,102 @@
+/*!
+ * \file            lfstack.h
+ * \brief           Interface to lock-free stack.
+ * \details         A lock-free stack is a bounded, last-in first-out stack
+ * which any number of threads may push to and pop from at the same time,
+ * without locks. It suits pools and free-lists of objects shared between
+ * threads, where the order in which values come back out matters less
+ * than handing them out and taking them back cheaply.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_LF_STACK_H
+#define PG_GENERIC_DATA_STRUCTURES_LF_STACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque lock-free stack type definition
+ * \ingroup         lfstack
+ */
+typedef struct lfstack * LFStack;
+
+/*!
+ * \brief           Creates a new lock-free stack.
+ * \ingroup         lfstack
+ * \param capacity  The capacity of the stack, which must be less than
+ * 2<sup>32</sup> - 1.
+ * \param type      The datatype for the stack.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values
+ * still in the stack when it is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Stack creation failed.
+ * \retval non-NULL A pointer to the new stack.
+ */
+LFStack lfstack_create(const size_t capacity, const enum gds_datatype type,
+                       const int opts);
+
+/*!
+ * \brief           Destroys a lock-free stack.
+ * \details         No thread may be using the stack when it is destroyed.
+ * If the `GDS_FREE_ON_DESTROY` option was specified when creating the
+ * stack, any pointer values still in the stack will be `free()`d prior
+ * to destruction.
+ * \ingroup         lfstack
+ * \param stack     A pointer to the stack.
+ */
+void lfstack_destroy(LFStack stack);
+
+/*!
+ * \brief           Pushes a value onto a lock-free stack.
+ * \details         This function does not wait for room if the stack is
+ * full.
+ * \ingroup         lfstack
+ * \param stack     A pointer to the stack.
+ * \param ...       The value to push onto the stack. This should
+ * be of a type appropriate to the type set when creating the stack.
+ * \retval true     Success
+ * \retval false    Failure, the stack is full.
+ */
+bool lfstack_push(LFStack stack, ...);
+
+/*!
+ * \brief           Pops a value from a lock-free stack.
+ * \details         This function does not wait for a value if the stack
+ * is empty.
+ * \ingroup         lfstack
+ * \param stack     A pointer to the stack.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the stack. The object at this address will be
+ * modified to contain the value popped from the stack.
+ * \retval true     Success
+ * \retval false    Failure, the stack is empty.
+ */
+bool lfstack_pop(LFStack stack, void * p);
+
+/*!
+ * \brief           Checks whether a lock-free stack is empty.
+ * \details         Other threads may push or pop at any time, so the
+ * result may be out of date as soon as it is returned.
+ * \ingroup         lfstack
+ * \param stack     A pointer to the stack.
+ * \retval true     The stack was empty
+ * \retval false    The stack was not empty
+ */
+bool lfstack_is_empty(LFStack stack);
+
+/*!
+ * \brief           Retrieves the capacity of a lock-free stack.
+ * \ingroup         lfstack
+ * \param stack     A pointer to the stack.
+ * \returns         The capacity of the stack.
+ */
+size_t lfstack_capacity(LFStack stack);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_LF_STACK_H  */
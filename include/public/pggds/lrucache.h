@@ -0,0 +1,176 @@
+/*!
+ * \file            lrucache.h
+ * \brief           Interface to generic LRU cache data structure.
+ * \details         An LRU cache maps string keys to values, and holds at
+ * most a fixed number of them. When a new key is added to a full cache, the
+ * least recently used key is evicted to make room for it.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_GENERIC_LRU_CACHE_H
+#define PG_GENERIC_DATA_STRUCTURES_GENERIC_LRU_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque LRU cache type definition
+ * \ingroup         lrucache
+ */
+typedef struct lrucache * LRUCache;
+
+/*!
+ * \brief           Type definition for LRU cache eviction function pointer.
+ * \details         The function is called with the evicted key, a pointer
+ * to an object of the cache's datatype containing the evicted value, and
+ * the context pointer passed to `lrucache_set_evict_func()`. If the cache
+ * was created with `GDS_FREE_ON_DESTROY`, a pointer value is `free()`d
+ * after the function returns, so the function must not keep it. The
+ * function must not modify the cache.
+ * \ingroup         lrucache
+ */
+typedef void (*lrucache_evict_func)(const char * key, void * value,
+                                    void * ctx);
+
+/*!
+ * \brief           Creates a new LRU cache.
+ * \details         All the memory needed to track `capacity` entries is
+ * allocated up front, so after creation only the copies of the keys
+ * themselves are allocated.
+ * \ingroup         lrucache
+ * \param capacity  The maximum number of keys the cache can hold. This
+ * must be greater than zero.
+ * \param type      The datatype for the cache values.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values when
+ * they are evicted, deleted, overwritten or when the cache is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Cache creation failed.
+ * \retval non-NULL A pointer to the new cache.
+ */
+LRUCache lrucache_create(const size_t capacity,
+                         const enum gds_datatype type,
+                         const int opts);
+
+/*!
+ * \brief           Destroys an LRU cache.
+ * \details         The eviction function is not called for keys still in
+ * the cache. If the `GDS_FREE_ON_DESTROY` option was specified when
+ * creating the cache, any pointer values still in the cache will be
+ * `free()`d prior to destruction.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ */
+void lrucache_destroy(LRUCache cache);
+
+/*!
+ * \brief           Sets the function to call when a key is evicted.
+ * \details         The function is only called when a key is evicted to
+ * make room for another, and not when a key is deleted or overwritten.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \param fn        A pointer to the function, or `NULL` for none.
+ * \param ctx       A pointer which is passed unchanged to `fn`.
+ */
+void lrucache_set_evict_func(LRUCache cache, lrucache_evict_func fn,
+                             void * ctx);
+
+/*!
+ * \brief           Inserts a key-value into an LRU cache.
+ * \details         The key becomes the most recently used. If the key
+ * already exists in the cache, the existing value will be overwritten, and
+ * `free()`d first if `GDS_FREE_ON_DESTROY` was specified. Otherwise, if the
+ * cache is full, the least recently used key is evicted.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \param key       The key.
+ * \param ...       The value corresponding to the key. This should
+ * be of a type appropriate to the type set when creating the cache.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+bool lrucache_put(LRUCache cache, const char * key, ...);
+
+/*!
+ * \brief           Retrieves the value for a key in an LRU cache.
+ * \details         If found, the key becomes the most recently used. The
+ * lookup is counted as a hit or a miss.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \param key       The key for which to retrieve the value.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the cache. The object at this address will be
+ * modified to contain the value for the specified key. If set to `NULL`,
+ * the function merely reports whether or not the key was found.
+ * \retval true     Success
+ * \retval false    Failure, key was not found
+ */
+bool lrucache_get(LRUCache cache, const char * key, void * p);
+
+/*!
+ * \brief           Checks whether a key exists in an LRU cache.
+ * \details         This neither changes the order of use of the keys, nor
+ * counts as a hit or a miss.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \param key       The key for which to search.
+ * \retval true     The key exists in the cache
+ * \retval false    The key does not exist in the cache
+ */
+bool lrucache_has_key(LRUCache cache, const char * key);
+
+/*!
+ * \brief           Deletes a key from an LRU cache.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \param key       The key to delete.
+ * \retval true     The key was deleted
+ * \retval false    The key was not found in the cache
+ */
+bool lrucache_delete(LRUCache cache, const char * key);
+
+/*!
+ * \brief           Returns the number of keys in an LRU cache.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \returns         The number of keys in the cache.
+ */
+size_t lrucache_size(LRUCache cache);
+
+/*!
+ * \brief           Returns the capacity of an LRU cache.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \returns         The maximum number of keys the cache can hold.
+ */
+size_t lrucache_capacity(LRUCache cache);
+
+/*!
+ * \brief           Returns the number of lookups which found their key.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \returns         The number of hits since creation or the last reset.
+ */
+size_t lrucache_hits(LRUCache cache);
+
+/*!
+ * \brief           Returns the number of lookups which missed their key.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ * \returns         The number of misses since creation or the last reset.
+ */
+size_t lrucache_misses(LRUCache cache);
+
+/*!
+ * \brief           Resets the hit and miss counts of an LRU cache to zero.
+ * \ingroup         lrucache
+ * \param cache     A pointer to the cache.
+ */
+void lrucache_reset_stats(LRUCache cache);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_GENERIC_LRU_CACHE_H  */
@@ -0,0 +1,128 @@
+/*!
+ * \file            mpmcqueue.h
+ * \brief           Interface to multi-producer multi-consumer queue.
+ * \details         A multi-producer multi-consumer queue is a bounded,
+ * lock-free queue which any number of threads may push to and pop from
+ * at the same time. Threads never block one another while holding a
+ * lock, so a thread which is descheduled part way through an operation
+ * delays only the value it is pushing or popping.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_MPMC_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_MPMC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque multi-producer multi-consumer queue type
+ * definition
+ * \ingroup         mpmcqueue
+ */
+typedef struct mpmcqueue * MPMCQueue;
+
+/*!
+ * \brief           Creates a new multi-producer multi-consumer queue.
+ * \ingroup         mpmcqueue
+ * \param capacity  The minimum capacity of the queue. This is rounded up
+ * to the next power of two, and to at least two.
+ * \param type      The datatype for the queue.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values
+ * still in the queue when it is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Queue creation failed.
+ * \retval non-NULL A pointer to the new queue.
+ */
+MPMCQueue mpmcqueue_create(const size_t capacity,
+                           const enum gds_datatype type,
+                           const int opts);
+
+/*!
+ * \brief           Destroys a multi-producer multi-consumer queue.
+ * \details         No thread may be using the queue when it is destroyed.
+ * If the `GDS_FREE_ON_DESTROY` option was specified when creating the
+ * queue, any pointer values still in the queue will be `free()`d prior
+ * to destruction.
+ * \ingroup         mpmcqueue
+ * \param queue     A pointer to the queue.
+ */
+void mpmcqueue_destroy(MPMCQueue queue);
+
+/*!
+ * \brief           Pushes a value onto a multi-producer multi-consumer
+ * queue.
+ * \details         If the queue is full, spins, and then yields the
+ * processor, until a consumer makes room.
+ * \ingroup         mpmcqueue
+ * \param queue     A pointer to the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ */
+void mpmcqueue_push(MPMCQueue queue, ...);
+
+/*!
+ * \brief           Pushes a value onto a multi-producer multi-consumer
+ * queue without waiting.
+ * \ingroup         mpmcqueue
+ * \param queue     A pointer to the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is full.
+ */
+bool mpmcqueue_try_push(MPMCQueue queue, ...);
+
+/*!
+ * \brief           Pops a value from a multi-producer multi-consumer queue.
+ * \details         If the queue is empty, spins, and then yields the
+ * processor, until a producer pushes a value.
+ * \ingroup         mpmcqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ */
+void mpmcqueue_pop(MPMCQueue queue, void * p);
+
+/*!
+ * \brief           Pops a value from a multi-producer multi-consumer queue
+ * without waiting.
+ * \ingroup         mpmcqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty.
+ */
+bool mpmcqueue_try_pop(MPMCQueue queue, void * p);
+
+/*!
+ * \brief           Retrieves the approximate size of a multi-producer
+ * multi-consumer queue.
+ * \details         Other threads may change the size at any time, and
+ * values part way through being pushed or popped may or may not be
+ * counted, so the result is only an estimate.
+ * \ingroup         mpmcqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The approximate number of values in the queue.
+ */
+size_t mpmcqueue_size(MPMCQueue queue);
+
+/*!
+ * \brief           Retrieves the capacity of a multi-producer
+ * multi-consumer queue.
+ * \ingroup         mpmcqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The capacity of the queue.
+ */
+size_t mpmcqueue_capacity(MPMCQueue queue);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_MPMC_QUEUE_H  */
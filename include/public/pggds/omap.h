@@ -0,0 +1,227 @@
+/*!
+ * \file            omap.h
+ * \brief           Interface to generic ordered map data structure.
+ * \details         The ordered map is implemented as a B+tree. Every
+ * key-value is stored in a leaf, and the leaves are linked in key order,
+ * so in-order iteration and range scans walk wide, contiguous nodes
+ * rather than chasing a pointer per element.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_GENERIC_ORDERED_MAP_H
+#define PG_GENERIC_DATA_STRUCTURES_GENERIC_ORDERED_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque ordered map type definition
+ * \ingroup         omap
+ */
+typedef struct omap * OMap;
+
+/*!
+ * \brief           Ordered map iterator type definition
+ * \details         An iterator is a small value which may be freely
+ * copied. Its members should not be accessed directly. Any insertion into
+ * or deletion from the map invalidates all iterators, but replacing the
+ * value of an existing key does not.
+ * \ingroup         omap
+ */
+typedef struct omap_itr {
+    struct omap_leaf * leaf;        /*!<  Leaf containing the element       */
+    size_t index;                   /*!<  Index of element within leaf      */
+} OMapItr;
+
+/*!
+ * \brief           Type definition for ordered map visitor function pointer.
+ * \details         The function is called with a pointer to an object of
+ * the key type containing the key, a pointer to an object of the value type
+ * containing the value, and the context pointer passed to `omap_range()`.
+ * The function should return `true` to continue the iteration, or `false`
+ * to stop it. The function must not modify the map.
+ * \ingroup         omap
+ */
+typedef bool (*omap_visit_func)(const void * key, void * value, void * ctx);
+
+/*!
+ * \brief           Creates a new ordered map.
+ * \ingroup         omap
+ * \param key_type      The datatype for the keys.
+ * \param value_type    The datatype for the values.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer keys and values
+ * when they are deleted or when the map is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \param ...       If `key_type` is `DATATYPE_POINTER`, this argument should
+ * be a pointer to a comparison function. In all other cases, this argument
+ * is not required, and will be ignored if it is provided.
+ * \retval NULL     Map creation failed.
+ * \retval non-NULL A pointer to the new map.
+ */
+OMap omap_create(const enum gds_datatype key_type,
+                 const enum gds_datatype value_type,
+                 const int opts, ...);
+
+/*!
+ * \brief           Destroys an ordered map.
+ * \details         If the `GDS_FREE_ON_DESTROY` option was specified
+ * when creating the map, any pointer keys and values still in the map will
+ * be `free()`d prior to destruction.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ */
+void omap_destroy(OMap omap);
+
+/*!
+ * \brief           Inserts a key-value into an ordered map.
+ * \details         If the key already exists in the map, the existing
+ * value will be overwritten. If `GDS_FREE_ON_DESTROY` was specified during
+ * map creation, the existing value will be `free()`d prior to overwriting
+ * it, and the duplicate key passed to this function will also be
+ * `free()`d, since the map retains the original.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \param ...       The key, followed by the value. These should be of the
+ * types appropriate to the types set when creating the map.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+bool omap_insert(OMap omap, ...);
+
+/*!
+ * \brief           Deletes a key from an ordered map.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \param ...       The key to delete. This should be of a type appropriate
+ * to the key type set when creating the map.
+ * \retval true     The key was deleted
+ * \retval false    The key was not found in the map
+ */
+bool omap_delete(OMap omap, ...);
+
+/*!
+ * \brief           Retrieves the value for a key in an ordered map.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \param p         A pointer to an object of a type appropriate to the
+ * value type set when creating the map. The object at this address will
+ * be modified to contain the value for the specified key. If set to `NULL`,
+ * the function merely reports whether or not the key was found.
+ * \param ...       The key for which to search. This should be of a type
+ * appropriate to the key type set when creating the map.
+ * \retval true     The key was found
+ * \retval false    The key was not found
+ */
+bool omap_find(OMap omap, void * p, ...);
+
+/*!
+ * \brief           Finds the first key not less than a given key.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \param itr       A pointer to an iterator which, if such a key exists,
+ * will be modified to point to it.
+ * \param ...       The key for which to search. This should be of a type
+ * appropriate to the key type set when creating the map.
+ * \retval true     Success
+ * \retval false    Every key in the map is less than the given key
+ */
+bool omap_lower_bound(OMap omap, OMapItr * itr, ...);
+
+/*!
+ * \brief           Calls a function for each key in a range, in order.
+ * \details         The range is half-open, containing every key which is
+ * not less than the first key given and is less than the second.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \param fn        A pointer to the function to call.
+ * \param ctx       A pointer which is passed unchanged to `fn`.
+ * \param ...       The lower and upper bounds of the range. These should
+ * be of a type appropriate to the key type set when creating the map.
+ * \returns         The number of keys visited.
+ */
+size_t omap_range(OMap omap, omap_visit_func fn, void * ctx, ...);
+
+/*!
+ * \brief           Returns an iterator to the smallest key in a map.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \param itr       A pointer to an iterator which, if the map is not
+ * empty, will be modified to point to the smallest key.
+ * \retval true     Success
+ * \retval false    The map is empty
+ */
+bool omap_itr_first(OMap omap, OMapItr * itr);
+
+/*!
+ * \brief           Returns an iterator to the largest key in a map.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \param itr       A pointer to an iterator which, if the map is not
+ * empty, will be modified to point to the largest key.
+ * \retval true     Success
+ * \retval false    The map is empty
+ */
+bool omap_itr_last(OMap omap, OMapItr * itr);
+
+/*!
+ * \brief           Advances an iterator to the next larger key.
+ * \ingroup         omap
+ * \param itr       A pointer to the iterator.
+ * \retval true     Success
+ * \retval false    The iterator was at the largest key, and is now invalid
+ */
+bool omap_itr_next(OMapItr * itr);
+
+/*!
+ * \brief           Moves an iterator to the next smaller key.
+ * \ingroup         omap
+ * \param itr       A pointer to the iterator.
+ * \retval true     Success
+ * \retval false    The iterator was at the smallest key, and is now invalid
+ */
+bool omap_itr_previous(OMapItr * itr);
+
+/*!
+ * \brief           Retrieves the key from an iterator.
+ * \ingroup         omap
+ * \param itr       A pointer to the iterator.
+ * \param p         A pointer to an object of a type appropriate to the
+ * key type set when creating the map. The object at this address will be
+ * modified to contain the key at the given iterator.
+ */
+void omap_itr_key(const OMapItr * itr, void * p);
+
+/*!
+ * \brief           Retrieves the value from an iterator.
+ * \ingroup         omap
+ * \param itr       A pointer to the iterator.
+ * \param p         A pointer to an object of a type appropriate to the
+ * value type set when creating the map. The object at this address will be
+ * modified to contain the value at the given iterator.
+ */
+void omap_itr_value(const OMapItr * itr, void * p);
+
+/*!
+ * \brief           Returns the number of keys in an ordered map.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \returns         The number of keys in the map.
+ */
+size_t omap_size(OMap omap);
+
+/*!
+ * \brief           Tests if an ordered map is empty.
+ * \ingroup         omap
+ * \param omap      A pointer to the map.
+ * \retval true     The map is empty
+ * \retval false    The map is not empty
+ */
+bool omap_is_empty(OMap omap);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_GENERIC_ORDERED_MAP_H  */
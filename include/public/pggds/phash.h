@@ -0,0 +1,136 @@
+/*!
+ * \file            phash.h
+ * \brief           Interface to minimal perfect hash data structure.
+ * \details         A minimal perfect hash is built from a fixed set of
+ * `n` string keys, and maps each of them to a distinct index in the range
+ * `0` to `n - 1`. Looking up a key takes one probe and one key comparison,
+ * with no collisions to resolve, and the hash function itself needs only a
+ * few bits per key. A value of a generic datatype is stored at each index.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_PERFECT_HASH_H
+#define PG_GENERIC_DATA_STRUCTURES_PERFECT_HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Index returned by `phash_index()` for an unknown key.
+ * \ingroup         phash
+ */
+#define PHASH_NOT_FOUND SIZE_MAX
+
+/*!
+ * \brief           Opaque minimal perfect hash type definition
+ * \ingroup         phash
+ */
+typedef struct phash * PHash;
+
+/*!
+ * \brief           Builds a minimal perfect hash for a set of keys.
+ * \details         The keys are copied, so the array and strings need not
+ * outlive the hash. Every value is initially zero, or `NULL` for pointer
+ * datatypes.
+ * \ingroup         phash
+ * \param keys      An array of `n` distinct keys.
+ * \param n         The number of keys.
+ * \param type      The datatype for the values.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values
+ * when they are overwritten or when the hash is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Creation failed, either because dynamic memory
+ * allocation failed, because the keys were not distinct, or because the
+ * keys total more than 4 GiB.
+ * \retval non-NULL A pointer to the new hash.
+ */
+PHash phash_create(const char * const * keys, const size_t n,
+                   const enum gds_datatype type, const int opts);
+
+/*!
+ * \brief           Destroys a minimal perfect hash.
+ * \details         If the `GDS_FREE_ON_DESTROY` option was specified when
+ * creating the hash, any non-`NULL` pointer values will be `free()`d prior
+ * to destruction.
+ * \ingroup         phash
+ * \param hash      A pointer to the hash.
+ */
+void phash_destroy(PHash hash);
+
+/*!
+ * \brief           Returns the index of a key.
+ * \details         This can be used to index arrays of size `n` kept by
+ * the caller, in place of the hash's own values.
+ * \ingroup         phash
+ * \param hash      A pointer to the hash.
+ * \param key       The key.
+ * \returns         The index of the key, or `PHASH_NOT_FOUND` if the key
+ * is not one of the keys the hash was built from.
+ */
+size_t phash_index(PHash hash, const char * key);
+
+/*!
+ * \brief           Checks whether a key is in a minimal perfect hash.
+ * \ingroup         phash
+ * \param hash      A pointer to the hash.
+ * \param key       The key for which to search.
+ * \retval true     The key is in the hash
+ * \retval false    The key is not in the hash
+ */
+bool phash_has_key(PHash hash, const char * key);
+
+/*!
+ * \brief           Sets the value for a key in a minimal perfect hash.
+ * \details         If `GDS_FREE_ON_DESTROY` was specified when creating the
+ * hash, the existing value is `free()`d if it is not `NULL`.
+ * \ingroup         phash
+ * \param hash      A pointer to the hash.
+ * \param key       The key.
+ * \param ...       The value corresponding to the key. This should
+ * be of a type appropriate to the type set when creating the hash.
+ * \retval true     Success
+ * \retval false    Failure, the key is not in the hash
+ */
+bool phash_set_value(PHash hash, const char * key, ...);
+
+/*!
+ * \brief           Retrieves the value for a key in a minimal perfect hash.
+ * \ingroup         phash
+ * \param hash      A pointer to the hash.
+ * \param key       The key for which to retrieve the value.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the hash. The object at this address will be
+ * modified to contain the value for the specified key.
+ * \retval true     Success
+ * \retval false    Failure, the key is not in the hash
+ */
+bool phash_value_for_key(PHash hash, const char * key, void * p);
+
+/*!
+ * \brief           Returns the number of keys in a minimal perfect hash.
+ * \ingroup         phash
+ * \param hash      A pointer to the hash.
+ * \returns         The number of keys.
+ */
+size_t phash_size(PHash hash);
+
+/*!
+ * \brief           Returns the space overhead of the hash.
+ * \details         This counts everything a lookup reads besides the key
+ * text and the values: the per-bucket displacements which make up the hash
+ * function, and the offset of each stored key, which takes 16 bits when the
+ * keys total at most 64 KiB and 32 bits otherwise.
+ * \ingroup         phash
+ * \param hash      A pointer to the hash.
+ * \returns         The overhead of the hash, in bits per key.
+ */
+double phash_bits_per_key(PHash hash);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_PERFECT_HASH_H  */
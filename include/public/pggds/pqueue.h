@@ -0,0 +1,211 @@
+/*!
+ * \file            pqueue.h
+ * \brief           Interface to generic priority queue data structure.
+ * \details         A priority queue always pops its smallest value first.
+ * It is implemented as a d-ary heap, so pushing and popping take time
+ * logarithmic in the number of values. An indexed priority queue also
+ * associates each value with an integer identifier, such as a vertex
+ * number, so that the value for an identifier can later be reduced.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_PRIORITY_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_PRIORITY_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque priority queue type definition
+ * \ingroup         pqueue
+ */
+typedef struct pqueue * PriorityQueue;
+
+/*!
+ * \brief           Creates a new priority queue.
+ * \ingroup         pqueue
+ * \param arity     The number of children of each node in the heap,
+ * which must be at least two if not zero. If zero, a 4-ary heap is used,
+ * which keeps the children of a node in one or two cache lines.
+ * \param type      The datatype for the queue.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values
+ * still in the queue when it is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \param ...       If `type` is `DATATYPE_POINTER`, this argument should
+ * be a pointer to a comparison function which orders the values. In all
+ * other cases, this argument is not required, and will be ignored if it
+ * is provided.
+ * \retval NULL     Queue creation failed.
+ * \retval non-NULL A pointer to the new queue.
+ */
+PriorityQueue pqueue_create(const size_t arity,
+                            const enum gds_datatype type,
+                            const int opts, ...);
+
+/*!
+ * \brief           Creates a new indexed priority queue.
+ * \details         Each value in an indexed queue has an identifier less
+ * than `num_ids`, and each identifier may have at most one value in the
+ * queue at a time. Values must be pushed with `pqueue_push_with_id()`.
+ * \ingroup         pqueue
+ * \param num_ids   The number of identifiers.
+ * \param arity     As for `pqueue_create()`.
+ * \param type      As for `pqueue_create()`.
+ * \param opts      As for `pqueue_create()`.
+ * \param ...       As for `pqueue_create()`.
+ * \retval NULL     Queue creation failed.
+ * \retval non-NULL A pointer to the new queue.
+ */
+PriorityQueue pqueue_create_indexed(const size_t num_ids,
+                                    const size_t arity,
+                                    const enum gds_datatype type,
+                                    const int opts, ...);
+
+/*!
+ * \brief           Destroys a priority queue.
+ * \details         If the `GDS_FREE_ON_DESTROY` option was specified
+ * when creating the queue, any pointer values still in the queue will
+ * be `free()`d prior to destruction.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ */
+void pqueue_destroy(PriorityQueue queue);
+
+/*!
+ * \brief           Pushes a value onto a priority queue.
+ * \details         The queue must not be indexed.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory reallocation failed.
+ */
+bool pqueue_push(PriorityQueue queue, ...);
+
+/*!
+ * \brief           Pushes an array of values onto a priority queue.
+ * \details         The queue must not be indexed. The heap is rebuilt
+ * from the bottom up, which takes time linear in the size of the queue
+ * rather than pushing each value in turn, so this is the fastest way to
+ * fill a queue from an existing array.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \param values    A pointer to the first element of an array of `n`
+ * objects of a type appropriate to the type set when creating the queue.
+ * \param n         The number of values.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory reallocation failed, and the
+ * queue is unchanged.
+ */
+bool pqueue_heapify(PriorityQueue queue, const void * values,
+                    const size_t n);
+
+/*!
+ * \brief           Pops the smallest value from a priority queue.
+ * \details         Values which compare equal are popped in no particular
+ * order.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty.
+ */
+bool pqueue_pop(PriorityQueue queue, void * p);
+
+/*!
+ * \brief           Retrieves the smallest value in a priority queue
+ * without popping it.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the smallest value.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty.
+ */
+bool pqueue_peek(PriorityQueue queue, void * p);
+
+/*!
+ * \brief           Pushes a value with an identifier onto an indexed
+ * priority queue.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \param id        The identifier, which must be less than the number of
+ * identifiers given when creating the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, the identifier already has a value in the
+ * queue.
+ */
+bool pqueue_push_with_id(PriorityQueue queue, const size_t id, ...);
+
+/*!
+ * \brief           Pops the smallest value and its identifier from an
+ * indexed priority queue.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \param id        A pointer to an object which will be modified to
+ * contain the identifier of the popped value.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty.
+ */
+bool pqueue_pop_with_id(PriorityQueue queue, size_t * id, void * p);
+
+/*!
+ * \brief           Reduces the value for an identifier in an indexed
+ * priority queue.
+ * \details         If `GDS_FREE_ON_DESTROY` was specified when creating
+ * the queue, the old value is `free()`d, unless it is the new value.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \param id        The identifier.
+ * \param ...       The new value, which must not compare greater than the
+ * old value. This should be of a type appropriate to the type set when
+ * creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, the identifier has no value in the queue.
+ */
+bool pqueue_decrease_key(PriorityQueue queue, const size_t id, ...);
+
+/*!
+ * \brief           Checks whether an identifier has a value in an indexed
+ * priority queue.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \param id        The identifier.
+ * \retval true     The identifier has a value in the queue
+ * \retval false    The identifier has no value in the queue
+ */
+bool pqueue_contains_id(PriorityQueue queue, const size_t id);
+
+/*!
+ * \brief           Retrieves the number of values in a priority queue.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The number of values in the queue.
+ */
+size_t pqueue_size(PriorityQueue queue);
+
+/*!
+ * \brief           Checks whether a priority queue is empty.
+ * \ingroup         pqueue
+ * \param queue     A pointer to the queue.
+ * \retval true     The queue is empty
+ * \retval false    The queue is not empty
+ */
+bool pqueue_is_empty(PriorityQueue queue);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_PRIORITY_QUEUE_H  */
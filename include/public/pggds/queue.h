@@ -61,6 +61,24 @@ void queue_destroy(Queue queue);
  */
 bool queue_push(Queue queue, ...);
 
+/*!
+ * \brief           Pushes an array of values onto the queue.
+ * \details         The values are copied in as a block, which is much
+ * faster than pushing them one at a time. Either all of the values are
+ * pushed, or none of them are.
+ * \ingroup         queue
+ * \param queue     A pointer to the queue.
+ * \param values    A pointer to the first element of an array of `n`
+ * objects of a type appropriate to the type set when creating the queue.
+ * The first element of the array is pushed first.
+ * \param n         The number of values to push.
+ * \retval true     Success
+ * \retval false    Failure, either because the queue has too little free
+ * space or, if the `GDS_RESIZABLE` option was specified when creating the
+ * queue, because dynamic memory reallocation failed.
+ */
+bool queue_push_n(Queue queue, const void * values, const size_t n);
+
 /*!
  * \brief           Pops a value from the queue.
  * \ingroup         queue
@@ -73,6 +91,21 @@ bool queue_push(Queue queue, ...);
  */
 bool queue_pop(Queue queue, void * p);
 
+/*!
+ * \brief           Pops several values from the queue.
+ * \details         The values are copied out as a block, which is much
+ * faster than popping them one at a time.
+ * \ingroup         queue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to the first element of an array of at least
+ * `max` objects of a type appropriate to the type set when creating the
+ * queue. The popped values are stored in this array in queue order.
+ * \param max       The maximum number of values to pop.
+ * \returns         The number of values popped, which is less than `max`
+ * if the queue held fewer values, and zero if it was empty.
+ */
+size_t queue_pop_n(Queue queue, void * p, const size_t max);
+
 /*!
  * \brief           Peeks at the top value of the queue.
  * \details         This function retrieves the value which would be
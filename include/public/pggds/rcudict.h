@@ -0,0 +1,187 @@
+/*!
+ * \file            rcudict.h
+ * \brief           Interface to read-mostly generic dictionary data structure.
+ * \details         The read-mostly dictionary is intended for data which is
+ * looked up very frequently by many threads and updated rarely. Readers
+ * take no locks and write to no shared memory. They look up keys in an
+ * immutable snapshot of the dictionary. Writers build a new snapshot and
+ * publish it atomically. They then wait until no reader can still be
+ * using the old snapshot before freeing it.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_RCU_DICTIONARY_H
+#define PG_GENERIC_DATA_STRUCTURES_RCU_DICTIONARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque read-mostly dictionary type definition
+ * \ingroup         rcudict
+ */
+typedef struct rcudict * RCUDict;
+
+/*!
+ * \brief           Creates a new read-mostly dictionary.
+ * \ingroup         rcudict
+ * \param type      The datatype for the dictionary.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer members
+ * when they are deleted, overwritten or when the dictionary is destroyed,
+ * in each case only once no reader can still be using them;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Dictionary creation failed.
+ * \retval non-NULL A pointer to the new dictionary.
+ */
+RCUDict rcudict_create(const enum gds_datatype type, const int opts);
+
+/*!
+ * \brief           Destroys a read-mostly dictionary.
+ * \details         No other thread may be using the dictionary. If the
+ * `GDS_FREE_ON_DESTROY` option was specified when creating the dictionary,
+ * any pointer values still in the dictionary will be `free()`d prior to
+ * destruction.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ */
+void rcudict_destroy(RCUDict dict);
+
+/*!
+ * \brief           Begins a read-side critical section.
+ * \details         Within a critical section, pointer values retrieved
+ * from the dictionary remain valid even if another thread concurrently
+ * overwrites or deletes their keys, and all lookups see the same snapshot
+ * unless it is updated in between. Critical sections may be nested. They
+ * should be kept short, since writers wait for them to end. A thread must
+ * not update the dictionary from within a critical section.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ * \retval true     Success
+ * \retval false    Failure, this is the thread's first use of the
+ * dictionary and dynamic memory allocation failed. The thread is not in a
+ * critical section, and must not call `rcudict_read_unlock()`.
+ */
+bool rcudict_read_lock(RCUDict dict);
+
+/*!
+ * \brief           Ends a read-side critical section.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ */
+void rcudict_read_unlock(RCUDict dict);
+
+/*!
+ * \brief           Checks whether a key exists in a read-mostly dictionary.
+ * \details         This function is lock-free, and may be called
+ * concurrently with any other function except `rcudict_destroy()`.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key for which to search.
+ * \retval true     The key exists in the dictionary
+ * \retval false    The key does not exist in the dictionary
+ */
+bool rcudict_has_key(RCUDict dict, const char * key);
+
+/*!
+ * \brief           Retrieves the value for a key in a read-mostly dictionary.
+ * \details         This function is lock-free, and may be called
+ * concurrently with any other function except `rcudict_destroy()`. If the
+ * dictionary holds pointers and was created with `GDS_FREE_ON_DESTROY`,
+ * the retrieved pointer should only be used within a critical section
+ * begun before this call with `rcudict_read_lock()`.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key for which to retrieve the value.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the dictionary. The object at this address will
+ * be modified to contain the value for the specified key.
+ * \retval true     Success
+ * \retval false    Failure, key was not found, or this is the thread's
+ * first use of the dictionary and dynamic memory allocation failed
+ */
+bool rcudict_value_for_key(RCUDict dict, const char * key, void * p);
+
+/*!
+ * \brief           Inserts a key-value into a read-mostly dictionary.
+ * \details         This is equivalent to a single-insert update with
+ * `rcudict_update_begin()`, `rcudict_update_insert()` and
+ * `rcudict_update_commit()`. It copies the whole dictionary, so prefer an
+ * explicit update when changing many keys.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key.
+ * \param ...       The value corresponding to the key. This should
+ * be of a type appropriate to the type set when creating the dictionary.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+bool rcudict_insert(RCUDict dict, const char * key, ...);
+
+/*!
+ * \brief           Deletes a key from a read-mostly dictionary.
+ * \details         This is equivalent to a single-delete update with
+ * `rcudict_update_begin()`, `rcudict_update_delete()` and
+ * `rcudict_update_commit()`.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key to delete.
+ * \retval true     The key was deleted
+ * \retval false    The key was not found, or dynamic memory allocation
+ * failed
+ */
+bool rcudict_delete(RCUDict dict, const char * key);
+
+/*!
+ * \brief           Begins an update of a read-mostly dictionary.
+ * \details         Only one update may be in progress at a time, and
+ * other writers block until the current update is committed. Readers
+ * continue to see the previous snapshot, without any of the changes made
+ * during the update, until it is committed.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ */
+void rcudict_update_begin(RCUDict dict);
+
+/*!
+ * \brief           Inserts a key-value as part of an update.
+ * \details         If the key already exists in the dictionary, the
+ * existing value will be replaced.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key.
+ * \param ...       The value corresponding to the key. This should
+ * be of a type appropriate to the type set when creating the dictionary.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+bool rcudict_update_insert(RCUDict dict, const char * key, ...);
+
+/*!
+ * \brief           Deletes a key as part of an update.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key to delete.
+ * \retval true     The key was deleted
+ * \retval false    The key was not found, or dynamic memory allocation
+ * failed
+ */
+bool rcudict_update_delete(RCUDict dict, const char * key);
+
+/*!
+ * \brief           Publishes an update of a read-mostly dictionary.
+ * \details         The new snapshot becomes visible to readers atomically.
+ * This function then waits until every reader which might still be using
+ * the previous snapshot has finished with it, and frees the snapshot and
+ * any replaced or deleted values.
+ * \ingroup         rcudict
+ * \param dict      A pointer to the dictionary.
+ */
+void rcudict_update_commit(RCUDict dict);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_RCU_DICTIONARY_H  */
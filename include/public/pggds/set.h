@@ -0,0 +1,182 @@
+/*!
+ * \file            set.h
+ * \brief           Interface to generic set data structure.
+ * \details         A set holds distinct elements of any supported datatype,
+ * and answers whether an element is a member without storing any value
+ * alongside it.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_GENERIC_SET_H
+#define PG_GENERIC_DATA_STRUCTURES_GENERIC_SET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque set type definition
+ * \ingroup         set
+ */
+typedef struct set * Set;
+
+/*!
+ * \brief           Opaque set iterator type definition
+ * \details         Any insertion into or removal from the set invalidates
+ * all iterators.
+ * \ingroup         set
+ */
+typedef struct set_slot * SetItr;
+
+/*!
+ * \brief           Creates a new set.
+ * \ingroup         set
+ * \param type      The datatype for the set.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer members
+ * when they are removed or when the set is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \param ...       If `type` is `DATATYPE_POINTER`, these arguments should
+ * be a pointer to a comparison function, followed by a pointer to a hash
+ * function consistent with it. In all other cases, these arguments are
+ * not required, and will be ignored if they are provided.
+ * \retval NULL     Set creation failed.
+ * \retval non-NULL A pointer to the new set.
+ */
+Set set_create(const enum gds_datatype type, const int opts, ...);
+
+/*!
+ * \brief           Destroys a set.
+ * \details         If the `GDS_FREE_ON_DESTROY` option was specified
+ * when creating the set, any pointer members still in the set will be
+ * `free()`d prior to destruction.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ */
+void set_destroy(Set set);
+
+/*!
+ * \brief           Inserts an element into a set.
+ * \details         If an equal element is already a member, the set is
+ * unchanged, and if `GDS_FREE_ON_DESTROY` was specified during set
+ * creation, the element passed to this function is `free()`d.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ * \param ...       The element to insert. This should be of a type
+ * appropriate to the type set when creating the set.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+bool set_insert(Set set, ...);
+
+/*!
+ * \brief           Checks whether an element is a member of a set.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ * \param ...       The element for which to search. This should be of a
+ * type appropriate to the type set when creating the set.
+ * \retval true     The element is a member of the set
+ * \retval false    The element is not a member of the set
+ */
+bool set_contains(Set set, ...);
+
+/*!
+ * \brief           Removes an element from a set.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ * \param ...       The element to remove. This should be of a type
+ * appropriate to the type set when creating the set.
+ * \retval true     The element was removed
+ * \retval false    The element was not a member of the set
+ */
+bool set_remove(Set set, ...);
+
+/*!
+ * \brief           Returns the number of elements in a set.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ * \returns         The number of elements in the set.
+ */
+size_t set_size(Set set);
+
+/*!
+ * \brief           Tests if a set is empty.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ * \retval true     The set is empty
+ * \retval false    The set is not empty
+ */
+bool set_is_empty(Set set);
+
+/*!
+ * \brief           Returns an iterator to the first element of a set.
+ * \details         The elements are visited in no particular order.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ * \retval NULL     The set is empty
+ * \retval non-NULL An iterator to the first element
+ */
+SetItr set_itr_first(Set set);
+
+/*!
+ * \brief           Returns an iterator to the next element of a set.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ * \param itr       An iterator to the current element.
+ * \retval NULL     There are no more elements
+ * \retval non-NULL An iterator to the next element
+ */
+SetItr set_itr_next(Set set, SetItr itr);
+
+/*!
+ * \brief           Retrieves the element from a set iterator.
+ * \ingroup         set
+ * \param set       A pointer to the set.
+ * \param itr       The iterator.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the set. The object at this address will be
+ * modified to contain the element.
+ */
+void set_itr_value(Set set, SetItr itr, void * p);
+
+/*!
+ * \brief           Creates a set of the elements in either of two sets.
+ * \details         The sets must be of the same datatype. The new set
+ * shares any pointer members with the sets it was made from, so is never
+ * created with `GDS_FREE_ON_DESTROY`, and should be destroyed before they
+ * are.
+ * \ingroup         set
+ * \param a         A pointer to the first set.
+ * \param b         A pointer to the second set.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the new set.
+ */
+Set set_union(Set a, Set b);
+
+/*!
+ * \brief           Creates a set of the elements in both of two sets.
+ * \details         As for `set_union()`.
+ * \ingroup         set
+ * \param a         A pointer to the first set.
+ * \param b         A pointer to the second set.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the new set.
+ */
+Set set_intersection(Set a, Set b);
+
+/*!
+ * \brief           Creates a set of the elements in one set but not another.
+ * \details         As for `set_union()`.
+ * \ingroup         set
+ * \param a         A pointer to the set whose elements to include.
+ * \param b         A pointer to the set whose elements to exclude.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the new set.
+ */
+Set set_difference(Set a, Set b);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_GENERIC_SET_H  */
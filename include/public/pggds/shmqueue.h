@@ -0,0 +1,163 @@
+/*!
+ * \file            shmqueue.h
+ * \brief           Interface to shared-memory queue.
+ * \details         A shared-memory queue is a bounded queue of fixed-size
+ * values which lives in a named POSIX shared memory object, so that
+ * separate processes may push to and pop from it. Each process opens the
+ * queue by name and maps it into its own address space, and the queue
+ * holds no pointers, so it works wherever it is mapped. Values are passed
+ * without any system calls unless a process has to wait because the queue
+ * is empty or full, when it sleeps until another process wakes it.
+ *
+ * A queue may have either a single producer or many producers, chosen
+ * when it is created, and always has a single consumer. Only datatypes
+ * which hold their value directly, rather than pointing to it, may be
+ * used, since a pointer is meaningless in another process.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_SHM_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_SHM_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque shared-memory queue type definition
+ * \ingroup         shmqueue
+ */
+typedef struct shmqueue * ShmQueue;
+
+/*!
+ * \brief           Creates a new shared-memory queue.
+ * \details         The shared memory object must not already exist. The
+ * creating process has its own handle to the queue, and other processes
+ * open it with `shmqueue_open()` once this function has returned.
+ * \ingroup         shmqueue
+ * \param name      The name of the shared memory object, which should
+ * begin with a slash and contain no other slashes.
+ * \param capacity  The minimum capacity of the queue. This is rounded up
+ * to the next power of two, and to at least two.
+ * \param type      The datatype for the queue, which must not be
+ * `DATATYPE_STRING`, `DATATYPE_GDSSTRING` or `DATATYPE_POINTER`.
+ * \param multi_producer    `true` if more than one thread or process
+ * may push to the queue at the same time, `false` if only one may.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Queue creation failed.
+ * \retval non-NULL A pointer to the new queue.
+ */
+ShmQueue shmqueue_create(const char * name, const size_t capacity,
+                         const enum gds_datatype type,
+                         const bool multi_producer, const int opts);
+
+/*!
+ * \brief           Opens an existing shared-memory queue.
+ * \ingroup         shmqueue
+ * \param name      The name of the shared memory object.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     The queue could not be opened, or the shared memory
+ * object is not a queue.
+ * \retval non-NULL A pointer to the queue.
+ */
+ShmQueue shmqueue_open(const char * name, const int opts);
+
+/*!
+ * \brief           Closes a shared-memory queue.
+ * \details         This unmaps the queue from the calling process, but
+ * leaves the queue and any values in it for other processes. No thread
+ * in this process may be using the handle when it is closed.
+ * \ingroup         shmqueue
+ * \param queue     A pointer to the queue.
+ */
+void shmqueue_close(ShmQueue queue);
+
+/*!
+ * \brief           Removes the name of a shared-memory queue.
+ * \details         Processes which already have the queue open may go on
+ * using it, and the memory is freed once they have all closed it.
+ * \ingroup         shmqueue
+ * \param name      The name of the shared memory object.
+ * \retval true     Success
+ * \retval false    Failure, the name could not be removed.
+ */
+bool shmqueue_unlink(const char * name);
+
+/*!
+ * \brief           Pushes a value onto a shared-memory queue.
+ * \details         If the queue is full, spins for a while, and then
+ * sleeps until the consumer makes room.
+ * \ingroup         shmqueue
+ * \param queue     A pointer to the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ */
+void shmqueue_push(ShmQueue queue, ...);
+
+/*!
+ * \brief           Pushes a value onto a shared-memory queue without
+ * waiting.
+ * \ingroup         shmqueue
+ * \param queue     A pointer to the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is full.
+ */
+bool shmqueue_try_push(ShmQueue queue, ...);
+
+/*!
+ * \brief           Pops a value from a shared-memory queue.
+ * \details         Only one thread, in one process, may pop from the
+ * queue at a time. If the queue is empty, spins for a while, and then
+ * sleeps until a producer pushes a value.
+ * \ingroup         shmqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ */
+void shmqueue_pop(ShmQueue queue, void * p);
+
+/*!
+ * \brief           Pops a value from a shared-memory queue without
+ * waiting.
+ * \details         Only one thread, in one process, may pop from the
+ * queue at a time.
+ * \ingroup         shmqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty.
+ */
+bool shmqueue_try_pop(ShmQueue queue, void * p);
+
+/*!
+ * \brief           Retrieves the approximate size of a shared-memory
+ * queue.
+ * \details         Other threads and processes may change the size at
+ * any time, so the result is only an estimate.
+ * \ingroup         shmqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The approximate number of values in the queue.
+ */
+size_t shmqueue_size(ShmQueue queue);
+
+/*!
+ * \brief           Retrieves the capacity of a shared-memory queue.
+ * \ingroup         shmqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The capacity of the queue.
+ */
+size_t shmqueue_capacity(ShmQueue queue);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_SHM_QUEUE_H  */
@@ -0,0 +1,135 @@
+/*!
+ * \file            spscqueue.h
+ * \brief           Interface to single-producer single-consumer queue.
+ * \details         A single-producer single-consumer queue is a bounded,
+ * lock-free queue for passing values from exactly one producer thread to
+ * exactly one consumer thread. Every operation completes in a bounded
+ * number of steps without waiting for the other thread, and fails rather
+ * than blocking if the queue is full or empty.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_SPSC_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_SPSC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque single-producer single-consumer queue type
+ * definition
+ * \ingroup         spscqueue
+ */
+typedef struct spscqueue * SPSCQueue;
+
+/*!
+ * \brief           Creates a new single-producer single-consumer queue.
+ * \ingroup         spscqueue
+ * \param capacity  The minimum capacity of the queue, which must be
+ * non-zero. This is rounded up to the next power of two.
+ * \param type      The datatype for the queue.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer values
+ * still in the queue when it is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Queue creation failed.
+ * \retval non-NULL A pointer to the new queue.
+ */
+SPSCQueue spscqueue_create(const size_t capacity,
+                           const enum gds_datatype type,
+                           const int opts);
+
+/*!
+ * \brief           Destroys a single-producer single-consumer queue.
+ * \details         If the `GDS_FREE_ON_DESTROY` option was specified
+ * when creating the queue, any pointer values still in the queue will
+ * be `free()`d prior to destruction.
+ * \ingroup         spscqueue
+ * \param queue     A pointer to the queue.
+ */
+void spscqueue_destroy(SPSCQueue queue);
+
+/*!
+ * \brief           Pushes a value onto a single-producer single-consumer
+ * queue.
+ * \details         Only the producer thread may call this function.
+ * \ingroup         spscqueue
+ * \param queue     A pointer to the queue.
+ * \param ...       The value to push onto the queue. This should
+ * be of a type appropriate to the type set when creating the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is full.
+ */
+bool spscqueue_push(SPSCQueue queue, ...);
+
+/*!
+ * \brief           Pops a value from a single-producer single-consumer
+ * queue.
+ * \details         Only the consumer thread may call this function.
+ * \ingroup         spscqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the queue. The object at this address will be
+ * modified to contain the value popped from the queue.
+ * \retval true     Success
+ * \retval false    Failure, the queue is empty.
+ */
+bool spscqueue_pop(SPSCQueue queue, void * p);
+
+/*!
+ * \brief           Pushes several values onto a single-producer
+ * single-consumer queue at once.
+ * \details         Only the producer thread may call this function. The
+ * values are published to the consumer together.
+ * \ingroup         spscqueue
+ * \param queue     A pointer to the queue.
+ * \param values    A pointer to the first element of an array of `n`
+ * objects of a type appropriate to the type set when creating the queue.
+ * \param n         The number of values to push.
+ * \returns         The number of values pushed, from the start of the
+ * array, which is less than `n` if the queue became full.
+ */
+size_t spscqueue_push_many(SPSCQueue queue, const void * values,
+                           const size_t n);
+
+/*!
+ * \brief           Pops several values from a single-producer
+ * single-consumer queue at once.
+ * \details         Only the consumer thread may call this function.
+ * \ingroup         spscqueue
+ * \param queue     A pointer to the queue.
+ * \param p         A pointer to the first element of an array of at least
+ * `max` objects of a type appropriate to the type set when creating the
+ * queue. The popped values are stored in this array in queue order.
+ * \param max       The maximum number of values to pop.
+ * \returns         The number of values popped, which is zero if the
+ * queue is empty.
+ */
+size_t spscqueue_pop_many(SPSCQueue queue, void * p, const size_t max);
+
+/*!
+ * \brief           Retrieves the current size of a single-producer
+ * single-consumer queue.
+ * \details         The other thread may change the size at any time, so
+ * the result is only a snapshot.
+ * \ingroup         spscqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The number of values in the queue.
+ */
+size_t spscqueue_size(SPSCQueue queue);
+
+/*!
+ * \brief           Retrieves the capacity of a single-producer
+ * single-consumer queue.
+ * \ingroup         spscqueue
+ * \param queue     A pointer to the queue.
+ * \returns         The capacity of the queue.
+ */
+size_t spscqueue_capacity(SPSCQueue queue);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_SPSC_QUEUE_H  */
@@ -0,0 +1,132 @@
+/*!
+ * \file            sstable.h
+ * \brief           Interface to immutable sorted string table data structure.
+ * \details         A sorted string table maps string keys to values, and is
+ * built once from a sorted set of key-value pairs and never modified
+ * afterwards. The keys are stored in key order in prefix-compressed blocks,
+ * so that a table uses far less memory than a dictionary holding the same
+ * keys, and keys sharing a prefix can be visited together.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_SORTED_STRING_TABLE_H
+#define PG_GENERIC_DATA_STRUCTURES_SORTED_STRING_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+#include "vector.h"
+
+/*!
+ * \brief           Opaque sorted string table type definition
+ * \ingroup         sstable
+ */
+typedef struct sstable * SSTable;
+
+/*!
+ * \brief           Type definition for sorted string table visitor function.
+ * \details         The function is called with the key, a pointer to an
+ * object of a type appropriate to the type set when creating the table
+ * containing the value for that key, and the context pointer passed to
+ * `sstable_prefix_scan()`. The key is only valid until the function
+ * returns. The function should return `true` to continue the scan, or
+ * `false` to stop it.
+ * \ingroup         sstable
+ */
+typedef bool (*sstable_visit_func)(const char * key, void * value,
+                                   void * ctx);
+
+/*!
+ * \brief           Creates a new sorted string table.
+ * \details         The table copies the keys and values, and does not
+ * retain or modify the vector or its pairs.
+ * \ingroup         sstable
+ * \param pairs     A vector of `DATATYPE_POINTER` elements, each a `KVPair`,
+ * sorted by key. There must be no duplicate keys.
+ * \param type      The datatype of the values, which must match the type
+ * of the value in every pair.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_FREE_ON_DESTROY` to take ownership of pointer values, and
+ * automatically `free()` them when the table is destroyed;
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Table creation failed, either because dynamic memory
+ * allocation failed, or because the pairs were not in strictly increasing
+ * key order or had values of the wrong type.
+ * \retval non-NULL A pointer to the new table.
+ */
+SSTable sstable_create(Vector pairs, const enum gds_datatype type,
+                       const int opts);
+
+/*!
+ * \brief           Destroys a sorted string table.
+ * \details         If the `GDS_FREE_ON_DESTROY` option was specified when
+ * creating the table, any pointer values will be `free()`d prior to
+ * destruction.
+ * \ingroup         sstable
+ * \param table     A pointer to the table.
+ */
+void sstable_destroy(SSTable table);
+
+/*!
+ * \brief           Checks whether a key exists in a sorted string table.
+ * \ingroup         sstable
+ * \param table     A pointer to the table.
+ * \param key       The key for which to search.
+ * \retval true     The key exists in the table
+ * \retval false    The key does not exist in the table
+ */
+bool sstable_has_key(SSTable table, const char * key);
+
+/*!
+ * \brief           Retrieves the value for a key in a sorted string table.
+ * \ingroup         sstable
+ * \param table     A pointer to the table.
+ * \param key       The key for which to retrieve the value.
+ * \param p         A pointer to an object of a type appropriate to the
+ * type set when creating the table. The object at this address will be
+ * modified to contain the value for the specified key.
+ * \retval true     Success
+ * \retval false    Failure, key was not found
+ */
+bool sstable_value_for_key(SSTable table, const char * key, void * p);
+
+/*!
+ * \brief           Calls a function for each key with a given prefix.
+ * \details         The keys are visited in order. An empty prefix visits
+ * every key in the table.
+ * \ingroup         sstable
+ * \param table     A pointer to the table.
+ * \param prefix    The prefix.
+ * \param fn        A pointer to the function to call.
+ * \param ctx       A pointer which is passed unchanged to `fn`.
+ * \returns         The number of keys visited. Tables with keys longer
+ * than 255 bytes need a key buffer from the heap, and if allocating it
+ * fails, this is zero unless the table was created with
+ * `GDS_EXIT_ON_ERROR`.
+ */
+size_t sstable_prefix_scan(SSTable table, const char * prefix,
+                           sstable_visit_func fn, void * ctx);
+
+/*!
+ * \brief           Returns the number of keys in a sorted string table.
+ * \ingroup         sstable
+ * \param table     A pointer to the table.
+ * \returns         The number of keys in the table.
+ */
+size_t sstable_size(SSTable table);
+
+/*!
+ * \brief           Returns the memory used by a sorted string table.
+ * \details         This counts the memory allocated by the table itself,
+ * but not any memory pointed to by pointer values.
+ * \ingroup         sstable
+ * \param table     A pointer to the table.
+ * \returns         The number of bytes allocated.
+ */
+size_t sstable_memory_usage(SSTable table);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_SORTED_STRING_TABLE_H  */
@@ -23,10 +23,16 @@ typedef struct stack * Stack;
 /*!
  * \brief           Creates a new stack.
  * \ingroup         stack
- * \param capacity  The initial capacity of the stack.
+ * \param capacity  The initial capacity of the stack. For a segmented
+ * stack, this is also the size of each chunk added as it grows, or if it
+ * is zero, a default chunk size is used.
  * \param type      The datatype for the stack.
  * \param opts      The following options can be OR'd together:
  * `GDS_RESIZABLE` to dynamically resize the stack on-demand;
+ * `GDS_SEGMENTED` to resize the stack on-demand by adding fixed-size
+ * chunks of storage, rather than by reallocating and copying all of its
+ * values, so that no push of a single value takes longer than allocating
+ * one chunk;
  * `GDS_FREE_ON_DESTROY` to automatically `free()` pointer members
  * when they are deleted or when the stack is destroyed;
  * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
@@ -61,6 +67,25 @@ void stack_destroy(Stack stack);
  */
 bool stack_push(Stack stack, ...);
 
+/*!
+ * \brief           Pushes an array of values onto the stack.
+ * \details         The values are copied in as a block, which is much
+ * faster than pushing them one at a time. Either all of the values are
+ * pushed, or none of them are.
+ * \ingroup         stack
+ * \param stack     A pointer to the stack.
+ * \param values    A pointer to the first element of an array of `n`
+ * objects of a type appropriate to the type set when creating the stack.
+ * The first element of the array is pushed first, so the last element
+ * ends up on top.
+ * \param n         The number of values to push.
+ * \retval true     Success
+ * \retval false    Failure, either because the stack has too little free
+ * space or, if the `GDS_RESIZABLE` option was specified when creating the
+ * stack, because dynamic memory reallocation failed.
+ */
+bool stack_push_n(Stack stack, const void * values, const size_t n);
+
 /*!
  * \brief           Pops a value from the stack.
  * \ingroup         stack
@@ -73,6 +98,24 @@ bool stack_push(Stack stack, ...);
  */
 bool stack_pop(Stack stack, void * p);
 
+/*!
+ * \brief           Pops several values from the stack.
+ * \details         The values are copied out as a block, which is much
+ * faster than popping them one at a time. They are stored in the order
+ * in which they were pushed, so the value which was on top of the stack
+ * is stored last, and `stack_push_n()` with the same array would restore
+ * the stack.
+ * \ingroup         stack
+ * \param stack     A pointer to the stack.
+ * \param p         A pointer to the first element of an array of at least
+ * `max` objects of a type appropriate to the type set when creating the
+ * stack.
+ * \param max       The maximum number of values to pop.
+ * \returns         The number of values popped, which is less than `max`
+ * if the stack held fewer values, and zero if it was empty.
+ */
+size_t stack_pop_n(Stack stack, void * p, const size_t max);
+
 /*!
  * \brief           Peeks at the top value of the stack.
  * \details         This function retrieves the value which would be
@@ -108,7 +151,9 @@ bool stack_is_empty(Stack stack);
 /*!
  * \brief           Retrieves the current capacity of a stack.
  * \details         This value can change dynamically if the `GDS_RESIZABLE`
- * option was specified when creating the stack.
+ * or `GDS_SEGMENTED` option was specified when creating the stack. A
+ * segmented stack frees chunks it no longer needs as values are popped,
+ * so its capacity can shrink as well as grow.
  * \ingroup         stack
  * \param stack     A pointer to the stack.
  * \returns         The capacity of the stack.
@@ -0,0 +1,141 @@
+/*!
+ * \file            threadpool.h
+ * \brief           Interface to work-stealing thread pool.
+ * \details         A thread pool runs tasks on a fixed set of worker
+ * threads. Each worker keeps its own queue of tasks, and a worker which
+ * runs out of tasks steals them from the others, so that tasks which
+ * submit further tasks spread their work across the pool with little
+ * contention. A thread waiting for a task to finish runs other tasks in
+ * the meantime, so tasks may safely wait for tasks they have submitted.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_THREAD_POOL_H
+#define PG_GENERIC_DATA_STRUCTURES_THREAD_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque thread pool type definition
+ * \ingroup         threadpool
+ */
+typedef struct threadpool * ThreadPool;
+
+/*!
+ * \brief           Opaque future type definition
+ * \details         A future stands for the result of a submitted task.
+ * Every future must be passed to `future_wait()` exactly once, which
+ * releases it.
+ * \ingroup         threadpool
+ */
+typedef struct threadpool_task * Future;
+
+/*!
+ * \brief           Type definition for thread pool task function.
+ * \details         The function is called with the argument passed to
+ * `threadpool_submit()`, and its return value is the result of the task.
+ * \ingroup         threadpool
+ */
+typedef void * (*threadpool_task_func)(void * arg);
+
+/*!
+ * \brief           Type definition for parallel for loop body function.
+ * \details         The function is called with a subrange `[begin, end)`
+ * of the loop's range, and the context pointer passed to
+ * `threadpool_parallel_for()`.
+ * \ingroup         threadpool
+ */
+typedef void (*threadpool_range_func)(size_t begin, size_t end, void * ctx);
+
+/*!
+ * \brief           Creates a new thread pool.
+ * \ingroup         threadpool
+ * \param num_threads   The number of worker threads. If zero, one thread
+ * is created for each online processor.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Pool creation failed.
+ * \retval non-NULL A pointer to the new pool.
+ */
+ThreadPool threadpool_create(const size_t num_threads, const int opts);
+
+/*!
+ * \brief           Destroys a thread pool.
+ * \details         Waits for every submitted task to finish before
+ * stopping the worker threads. Futures may still be waited for after the
+ * pool is destroyed, since their tasks have finished. This function must
+ * not be called from a task.
+ * \ingroup         threadpool
+ * \param pool      A pointer to the pool.
+ */
+void threadpool_destroy(ThreadPool pool);
+
+/*!
+ * \brief           Submits a task to a thread pool.
+ * \details         A task submitted from within another task is queued on
+ * the submitting worker, and is run by it unless another worker steals it
+ * first.
+ * \ingroup         threadpool
+ * \param pool      A pointer to the pool.
+ * \param fn        A pointer to the task function.
+ * \param arg       The argument to pass to the task function.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A future for the result of the task.
+ */
+Future threadpool_submit(ThreadPool pool, threadpool_task_func fn,
+                         void * arg);
+
+/*!
+ * \brief           Waits for a task to finish and returns its result.
+ * \details         While the task is unfinished, the calling thread runs
+ * other tasks from the pool, and sleeps only if there are none to run.
+ * The future is released, and may not be used again.
+ * \ingroup         threadpool
+ * \param future    The future returned when the task was submitted.
+ * \returns         The value returned by the task function.
+ */
+void * future_wait(Future future);
+
+/*!
+ * \brief           Checks whether a task has finished, without waiting.
+ * \ingroup         threadpool
+ * \param future    The future returned when the task was submitted.
+ * \retval true     The task has finished
+ * \retval false    The task has not finished
+ */
+bool future_is_ready(Future future);
+
+/*!
+ * \brief           Runs a loop body over a range in parallel.
+ * \details         The range `[begin, end)` is split in half repeatedly
+ * until the pieces are no larger than `grain`, and the pieces are spread
+ * across the pool, with the calling thread taking part. The function
+ * returns once `fn` has been called for every piece.
+ * \ingroup         threadpool
+ * \param pool      A pointer to the pool.
+ * \param begin     The start of the range.
+ * \param end       The end of the range, which is excluded.
+ * \param grain     The largest piece to pass to `fn`. If zero, a grain of
+ * one is used.
+ * \param fn        A pointer to the loop body function.
+ * \param ctx       A pointer which is passed unchanged to `fn`.
+ */
+void threadpool_parallel_for(ThreadPool pool, const size_t begin,
+                             const size_t end, const size_t grain,
+                             threadpool_range_func fn, void * ctx);
+
+/*!
+ * \brief           Returns the number of worker threads in a thread pool.
+ * \ingroup         threadpool
+ * \param pool      A pointer to the pool.
+ * \returns         The number of worker threads.
+ */
+size_t threadpool_num_threads(ThreadPool pool);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_THREAD_POOL_H  */
@@ -0,0 +1,126 @@
+/*!
+ * \file            timerwheel.h
+ * \brief           Interface to hierarchical timer wheel.
+ * \details         A timer wheel calls a function once a given time has
+ * been reached. Scheduling and cancelling a timer take constant time
+ * however many timers are pending, which suits programs which set and
+ * cancel a timeout for every request or connection. Time is measured in
+ * ticks of whatever length the caller chooses, such as milliseconds, and
+ * the wheel only moves forward when `timerwheel_tick()` is called.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PG_GENERIC_DATA_STRUCTURES_TIMER_WHEEL_H
+#define PG_GENERIC_DATA_STRUCTURES_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gds_public_types.h"
+
+/*!
+ * \brief           Opaque timer wheel type definition
+ * \ingroup         timerwheel
+ */
+typedef struct timerwheel * TimerWheel;
+
+/*!
+ * \brief           Type definition for timer identifier.
+ * \details         An identifier stays unique to its timer after the timer
+ * has fired or been cancelled, so it is always safe to pass an old one to
+ * `timerwheel_cancel()`. Zero is never a valid identifier.
+ * \ingroup         timerwheel
+ */
+typedef uint64_t TimerId;
+
+/*!
+ * \brief           Type definition for timer callback function.
+ * \details         The function is called with the argument passed to
+ * `timerwheel_schedule()`. It may schedule and cancel timers on the same
+ * wheel, but must not call `timerwheel_tick()` or `timerwheel_destroy()`.
+ * \ingroup         timerwheel
+ */
+typedef void (*timerwheel_callback)(void * arg);
+
+/*!
+ * \brief           Creates a new timer wheel.
+ * \ingroup         timerwheel
+ * \param now       The current time, in ticks.
+ * \param opts      The following options can be OR'd together:
+ * `GDS_EXIT_ON_ERROR` to print a message to the standard error stream
+ * and `exit()`, rather than returning a failure status.
+ * \retval NULL     Wheel creation failed.
+ * \retval non-NULL A pointer to the new wheel.
+ */
+TimerWheel timerwheel_create(const uint64_t now, const int opts);
+
+/*!
+ * \brief           Destroys a timer wheel.
+ * \details         Pending timers are discarded without being called.
+ * \ingroup         timerwheel
+ * \param wheel     A pointer to the wheel.
+ */
+void timerwheel_destroy(TimerWheel wheel);
+
+/*!
+ * \brief           Schedules a timer.
+ * \details         A timer whose time has already been reached is called
+ * by the next call to `timerwheel_tick()`.
+ * \ingroup         timerwheel
+ * \param wheel     A pointer to the wheel.
+ * \param expires   The time, in ticks, at which to call the function.
+ * \param fn        A pointer to the callback function.
+ * \param arg       The argument to pass to the callback function.
+ * \retval 0        Failure, dynamic memory allocation failed.
+ * \retval non-zero The identifier of the new timer.
+ */
+TimerId timerwheel_schedule(TimerWheel wheel, const uint64_t expires,
+                            timerwheel_callback fn, void * arg);
+
+/*!
+ * \brief           Cancels a timer.
+ * \ingroup         timerwheel
+ * \param wheel     A pointer to the wheel.
+ * \param id        The identifier of the timer.
+ * \retval true     The timer was cancelled
+ * \retval false    The timer had already fired or been cancelled
+ */
+bool timerwheel_cancel(TimerWheel wheel, const TimerId id);
+
+/*!
+ * \brief           Advances a timer wheel and calls expired timers.
+ * \details         Every timer due at or before `now` is called, in order
+ * of expiry, except that timers due at the same tick, or scheduled after
+ * they were due, are called in no particular order. Ticks with no timers
+ * due are skipped over, so the cost does not grow with the time elapsed
+ * since the last call.
+ * \ingroup         timerwheel
+ * \param wheel     A pointer to the wheel.
+ * \param now       The current time, in ticks. If this is earlier than
+ * the time of the last call, the wheel is not moved back.
+ * \returns         The number of timers called.
+ */
+size_t timerwheel_tick(TimerWheel wheel, const uint64_t now);
+
+/*!
+ * \brief           Retrieves the number of pending timers.
+ * \ingroup         timerwheel
+ * \param wheel     A pointer to the wheel.
+ * \returns         The number of timers which have been scheduled and
+ * have neither fired nor been cancelled.
+ */
+size_t timerwheel_size(TimerWheel wheel);
+
+/*!
+ * \brief           Retrieves the current time of a timer wheel.
+ * \ingroup         timerwheel
+ * \param wheel     A pointer to the wheel.
+ * \returns         The time, in ticks, of the latest call to
+ * `timerwheel_tick()`, or the time the wheel was created.
+ */
+uint64_t timerwheel_now(TimerWheel wheel);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TIMER_WHEEL_H  */
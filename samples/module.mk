@@ -3,3 +3,4 @@ include samples/workqueues/module.mk
 include samples/ifreader/module.mk
 include samples/errormacros/module.mk
 include samples/logging/module.mk
+include samples/queuebench/module.mk
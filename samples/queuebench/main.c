@@ -0,0 +1,151 @@
+/*
+ * queuebench
+ * ==========
+ *
+ * Benchmark program for multi-producer multi-consumer queues.
+ *
+ * Passes values from a number of producer threads to the same number of
+ * consumer threads, first through the lock-free MPMC queue and then
+ * through the mutex and condition variable based blocking queue, and
+ * reports the throughput of each for increasing numbers of threads.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <pggds/mpmcqueue.h>
+#include <pggds/bqueue.h>
+
+/*  Total number of values passed in each run  */
+static const long num_values = 1L << 21;
+
+/*  Capacity of each queue  */
+static const size_t queue_capacity = 1024;
+
+/*  Largest number of producer threads, and of consumer threads  */
+static const size_t max_pairs = 16;
+
+/*  Value marking the end of the run for a consumer  */
+static const long end_of_run = -1;
+
+/*  Struct containing info passed to a thread on creation  */
+struct thread_info {
+    MPMCQueue mpmc;                 /*!<  Lock-free queue, or NULL          */
+    BlockingQueue blocking;         /*!<  Blocking queue, or NULL           */
+    long count;                     /*!<  Number of values to push          */
+};
+
+/*  Pushes a value onto whichever queue is in use  */
+
+static void push(struct thread_info * info, const long value)
+{
+    if ( info->mpmc ) {
+        mpmcqueue_push(info->mpmc, value);
+    }
+    else {
+        bqueue_push(info->blocking, value);
+    }
+}
+
+/*  Producer thread function  */
+
+static void * producer(void * arg)
+{
+    struct thread_info * info = arg;
+
+    for ( long i = 0; i < info->count; ++i ) {
+        push(info, i);
+    }
+
+    return NULL;
+}
+
+/*  Consumer thread function, popping until the end of the run  */
+
+static void * consumer(void * arg)
+{
+    struct thread_info * info = arg;
+    long value;
+
+    do {
+        if ( info->mpmc ) {
+            mpmcqueue_pop(info->mpmc, &value);
+        }
+        else {
+            bqueue_pop(info->blocking, &value);
+        }
+    } while ( value != end_of_run );
+
+    return NULL;
+}
+
+/*  Returns the current time in seconds  */
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*  Runs one benchmark and returns millions of values per second  */
+
+static double run(struct thread_info * info, const size_t pairs)
+{
+    pthread_t producers[max_pairs], consumers[max_pairs];
+    const double start = now();
+
+    for ( size_t i = 0; i < pairs; ++i ) {
+        if ( pthread_create(&consumers[i], NULL, consumer, info) != 0 ||
+             pthread_create(&producers[i], NULL, producer, info) != 0 ) {
+            fprintf(stderr, "couldn't create thread\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for ( size_t i = 0; i < pairs; ++i ) {
+        pthread_join(producers[i], NULL);
+    }
+
+    /*  Tell each consumer to finish once the values are drained  */
+
+    for ( size_t i = 0; i < pairs; ++i ) {
+        push(info, end_of_run);
+    }
+
+    for ( size_t i = 0; i < pairs; ++i ) {
+        pthread_join(consumers[i], NULL);
+    }
+
+    return num_values / (now() - start) / 1e6;
+}
+
+int main(void)
+{
+    printf("%8s %12s %12s\n", "threads", "mpmc", "blocking");
+    printf("%8s %12s %12s\n", "", "(Mops/s)", "(Mops/s)");
+
+    for ( size_t pairs = 1; pairs <= max_pairs; pairs *= 2 ) {
+        struct thread_info info;
+        info.count = num_values / (long) pairs;
+
+        info.mpmc = mpmcqueue_create(queue_capacity, DATATYPE_LONG,
+                                     GDS_EXIT_ON_ERROR);
+        info.blocking = NULL;
+        const double mpmc_rate = run(&info, pairs);
+        mpmcqueue_destroy(info.mpmc);
+
+        info.mpmc = NULL;
+        info.blocking = bqueue_create(queue_capacity, DATATYPE_LONG,
+                                      GDS_EXIT_ON_ERROR);
+        const double blocking_rate = run(&info, pairs);
+        bqueue_destroy(info.blocking);
+
+        printf("%8zu %12.2f %12.2f\n", pairs * 2, mpmc_rate, blocking_rate);
+    }
+
+    return 0;
+}
@@ -0,0 +1,10 @@
+LOCAL_DIR  := samples/queuebench
+LOCAL_PROG := $(BINDIR)/queuebench
+LOCAL_SRC  := $(wildcard $(LOCAL_DIR)/*.c)
+LOCAL_OBJ  := $(subst .c,.o,$(LOCAL_SRC))
+
+SOURCES   += $(LOCAL_SRC)
+SAMPLES   += $(LOCAL_PROG)
+
+$(LOCAL_PROG): $(LOCAL_OBJ)
+	$(CC) -o $@ $^ -L$(LIBDIR) -pthread -lpggds -lpthread
@@ -5,7 +5,7 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include <pthread.h>
-#include <pggds/queue.h>
+#include <pggds/bqueue.h>
 #include <pggds/gds_util.h>
 
 /*  Total number of worker threads  */
@@ -21,68 +21,13 @@ struct job_report {
     bool done;                  /*!<  true if thread is finished            */
 };
 
-/*  Struct to contain a job queue  */
-struct job_queue {
-    Queue queue;                /*!<  The queue itself                      */
-    pthread_mutex_t mutex;      /*!<  Mutex to access the queue             */
-    pthread_cond_t cond;        /*!<  Condition variable for jobs in queue  */
-};
-
 /*  Struct containing info passed to a worker thread on creation  */
 struct thread_info {
-    struct job_queue * in_queue;    /*!<  Queue for incoming tasks          */
-    struct job_queue * out_queue;   /*!<  Queue for outgoing job reports    */
+    BlockingQueue in_queue;         /*!<  Queue for incoming tasks          */
+    BlockingQueue out_queue;        /*!<  Queue for outgoing job reports    */
     int worker_id;                  /*!<  ID of worker thread (self)        */
 };
 
-/*  Creates a new job queue  */
-
-struct job_queue * job_queue_create(const enum gds_datatype type)
-{
-    struct job_queue * new_queue = xmalloc(sizeof *new_queue);
-
-    /*  Queue could conceivably need more than num_jobs elements,
-     *  since each thread will send an additional report when it's
-     *  done, so we make it resizable just in case.                 */
-
-    new_queue->queue = queue_create(num_jobs, type, GDS_RESIZABLE);
-    if ( !new_queue->queue ) {
-        fprintf(stderr, "couldn't create queue\n");
-        exit(EXIT_FAILURE);
-    }
-
-    if ( pthread_mutex_init(&new_queue->mutex, NULL) != 0 ) {
-        perror("couldn't initialize mutex");
-        exit(EXIT_FAILURE);
-    }
-
-    if ( pthread_cond_init(&new_queue->cond, NULL) != 0 ) {
-        perror("couldn't initialize condition variable");
-        exit(EXIT_FAILURE);
-    }
-
-    return new_queue;
-}
-
-/*  Destroys a job queue  */
-
-void job_queue_destroy(struct job_queue * queue)
-{
-    queue_destroy(queue->queue);
-
-    if ( pthread_mutex_destroy(&queue->mutex) != 0 ) {
-        fprintf(stderr, "couldn't destroy mutex\n");
-        exit(EXIT_FAILURE);
-    }
-
-    if ( pthread_cond_destroy(&queue->cond) != 0 ) {
-        fprintf(stderr, "couldn't destroy condition variable\n");
-        exit(EXIT_FAILURE);
-    }
-
-    free(queue);
-}
-
 /*  Creates a job report for sending back to the main thread  */
 
 struct job_report * job_report_create(const int sleep_time,
@@ -101,8 +46,8 @@ struct job_report * job_report_create(const int sleep_time,
 /*  Creates a new thread info object  */
 
 struct thread_info * thread_info_create(const int worker_id,
-                                        struct job_queue * in_queue,
-                                        struct job_queue * out_queue)
+                                        BlockingQueue in_queue,
+                                        BlockingQueue out_queue)
 {
     struct thread_info * tinfo = xmalloc(sizeof *tinfo);
 
@@ -118,77 +63,41 @@ struct thread_info * thread_info_create(const int worker_id,
 void * thread_func(void * arg)
 {
     struct thread_info * tinfo = arg;
-    struct job_queue * in_queue = tinfo->in_queue;
-    struct job_queue * out_queue = tinfo->out_queue;
+    BlockingQueue in_queue = tinfo->in_queue;
+    BlockingQueue out_queue = tinfo->out_queue;
     const int id = tinfo->worker_id;
     free(arg);
 
-    bool done = false;
-
-    /*  Loop until done  */
-
-    while ( !done ) {
-        int job = -1;
-
-        /*  Get next job from in queue  */
-
-        if ( pthread_mutex_lock(&in_queue->mutex) != 0 ) {
-            fprintf(stderr, "couldn't lock mutex\n");
-            exit(EXIT_FAILURE);
-        }
-
-        if ( queue_is_empty(in_queue->queue) ) {
-
-            /*  If queue is empty, we're finished  */
+    int job;
 
-            done = true;
-        }
-        else {
+    /*  Take jobs until the queue is closed and empty, waiting
+     *  for more if it is empty but still open.                 */
 
-            /*  Otherwise retrieve the next job  */
-
-            queue_pop(in_queue->queue, &job);
-        }
+    while ( bqueue_pop(in_queue, &job) ) {
 
-        if ( pthread_mutex_unlock(&in_queue->mutex) != 0 ) {
-            fprintf(stderr, "couldn't unlock mutex\n");
-            exit(EXIT_FAILURE);
-        }
-        
         /*  Do the work  */
 
-        if ( !done ) {
-            sleep(job);
-        }
-
-        /*  Report the job or done status to the out queue  */
+        sleep(job);
 
-        if ( pthread_mutex_lock(&out_queue->mutex) != 0 ) {
-            fprintf(stderr, "couldn't lock mutex\n");
-            exit(EXIT_FAILURE);
-        }
+        /*  Report the job to the out queue  */
 
-        struct job_report * report = job_report_create(job, id, done);
-        queue_push(out_queue->queue, report);
+        bqueue_push(out_queue, job_report_create(job, id, false));
+    }
 
-        if ( pthread_cond_signal(&out_queue->cond) != 0 ) {
-            fprintf(stderr, "couldn't signal condition variable\n");
-            exit(EXIT_FAILURE);
-        }
+    /*  Report that we're done  */
 
-        if ( pthread_mutex_unlock(&out_queue->mutex) != 0 ) {
-            fprintf(stderr, "couldn't unlock mutex\n");
-            exit(EXIT_FAILURE);
-        }
-    }
+    bqueue_push(out_queue, job_report_create(-1, id, true));
 
     return NULL;
 }
 
 int main(void)
 {
-    struct job_queue * out_queue = job_queue_create(DATATYPE_INT);
-    struct job_queue * done_queue = job_queue_create(DATATYPE_POINTER);
+    BlockingQueue out_queue = bqueue_create(num_jobs, DATATYPE_INT,
+                                            GDS_EXIT_ON_ERROR);
+    BlockingQueue done_queue = bqueue_create(num_jobs + num_threads,
+                                             DATATYPE_POINTER,
+                                             GDS_EXIT_ON_ERROR);
     pthread_t tid[num_threads];
     int live_threads = 0;
 
@@ -196,12 +105,15 @@ int main(void)
      *  pedants some ammunition in the process. Each
      *  'task' consists of merely sleeping (nice job!)
      *  for a specified number of seconds. Here we just
-     *  randomly generate those numbers of seconds.      */
+     *  randomly generate those numbers of seconds.
+     *  Closing the queue tells the threads that no
+     *  more tasks are coming once these are done.       */
 
     srand( (unsigned) time(NULL));
     for ( size_t i = 0; i < num_jobs; ++i ) {
-        queue_push(out_queue->queue, rand() % 10 + 1);
+        bqueue_push(out_queue, rand() % 10 + 1);
     }
+    bqueue_close(out_queue);
 
     /*  Start threads  */
 
@@ -216,68 +128,42 @@ int main(void)
         ++live_threads;
     }
 
-    /*  Main event loop  */
-
-    if ( pthread_mutex_lock(&done_queue->mutex) != 0 ) {
-        fprintf(stderr, "couldn't lock mutex\n");
-        exit(EXIT_FAILURE);
-    }
+    /*  Main event loop. Popping waits until a report is
+     *  available, and the last report should be the one
+     *  saying the last thread is finished, at which point
+     *  the main event loop will end.                       */
 
     while ( live_threads ) {
+        struct job_report * report;
+        bqueue_pop(done_queue, &report);
 
-        /*  If queue is empty, wait on the condition variable.
-         *  This should never wait forever, since the last thing
-         *  off the queue should be the report saying the last
-         *  thread is finished, at which point the main event
-         *  loop will end.                                        */
-
-        while ( queue_is_empty(done_queue->queue) ) {
-            if ( pthread_cond_wait(&done_queue->cond,
-                                   &done_queue->mutex) != 0 ) {
-                fprintf(stderr, "couldn't wait on condition variable\n");
-                exit(EXIT_FAILURE);
-            }
-        }
-
-        /*  Process any job reports on the queue  */
-
-        while ( !queue_is_empty(done_queue->queue) ) {
-            struct job_report * report;
-            queue_pop(done_queue->queue, (void *) &report);
+        if ( report->done ) {
 
-            if ( report->done ) {
+            /*  Join thread and decrement live thread
+             *  counter if the thread has finished.    */
 
-                /*  Join thread and decrement live thread
-                 *  counter if the thread has finished.    */
-
-                if ( pthread_join(tid[report->worker_id - 1], NULL) != 0 ) {
-                    fprintf(stderr, "couldn't join thread\n");
-                    exit(EXIT_FAILURE);
-                }
-
-                --live_threads;
+            if ( pthread_join(tid[report->worker_id - 1], NULL) != 0 ) {
+                fprintf(stderr, "couldn't join thread\n");
+                exit(EXIT_FAILURE);
             }
-            else {
 
-                /*  Otherwise report on the finished job.  */
+            --live_threads;
+        }
+        else {
 
-                printf("Thread %d worked hard and slept for %d seconds.\n",
-                       report->worker_id, report->sleep_time);
-            }
+            /*  Otherwise report on the finished job.  */
 
-            free(report);
+            printf("Thread %d worked hard and slept for %d seconds.\n",
+                   report->worker_id, report->sleep_time);
         }
-    }
 
-    if ( pthread_mutex_unlock(&done_queue->mutex) != 0 ) {
-        fprintf(stderr, "couldn't unlock mutex\n");
-        exit(EXIT_FAILURE);
+        free(report);
     }
 
     /*  Tidy up and exit  */
 
-    job_queue_destroy(out_queue);
-    job_queue_destroy(done_queue);
+    bqueue_destroy(out_queue);
+    bqueue_destroy(done_queue);
 
     return 0;
 }
@@ -0,0 +1,407 @@
+/*!
+ * \file            bqueue.c
+ * \brief           Implementation of blocking queue data structure.
+ * \details         The values are held in a fixed circular buffer guarded
+ * by a single mutex. Producers and consumers wait on separate condition
+ * variables, so a push only ever wakes a consumer and a pop only ever
+ * wakes a producer. The number of threads waiting on each condition
+ * variable is counted, so that the common uncontended case makes no
+ * signalling calls at all, and signals are sent after releasing the
+ * mutex, so that a woken thread does not immediately block on it.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds/bqueue.h>
+
+/*!  Blocking queue structure  */
+struct bqueue {
+    pthread_mutex_t lock;           /*!<  Lock guarding all other members   */
+    pthread_cond_t not_empty;       /*!<  Signalled when a value is pushed  */
+    pthread_cond_t not_full;        /*!<  Signalled when a value is popped  */
+    size_t pop_waiters;             /*!<  Threads waiting on not_empty      */
+    size_t push_waiters;            /*!<  Threads waiting on not_full       */
+
+    size_t front;                   /*!<  Index of front of queue           */
+    size_t size;                    /*!<  Number of values in queue         */
+    size_t capacity;                /*!<  Maximum number of values          */
+    struct gdt_generic_datatype * elements;     /*!<  Circular buffer       */
+
+    enum gds_datatype type;         /*!<  Queue datatype                    */
+    bool closed;                    /*!<  No more pushes if true            */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Locks a queue, aborting on failure.
+ * \param queue     A pointer to the queue.
+ */
+static void bqueue_lock(BlockingQueue queue);
+
+/*!
+ * \brief           Unlocks a queue, aborting on failure.
+ * \param queue     A pointer to the queue.
+ */
+static void bqueue_unlock(BlockingQueue queue);
+
+/*!
+ * \brief           Calculates a deadline from a time limit.
+ * \param deadline  A pointer to the deadline to set.
+ * \param timeout_ms    The time limit in milliseconds.
+ */
+static void bqueue_deadline(struct timespec * deadline,
+                            const unsigned long timeout_ms);
+
+/*!
+ * \brief           Waits on a condition variable of a locked queue.
+ * \param queue     A pointer to the queue, which must be locked.
+ * \param cond      A pointer to the condition variable.
+ * \param waiters   A pointer to the count of waiters on the condition
+ * variable.
+ * \param deadline  A pointer to the deadline, or `NULL` to wait forever.
+ * \retval true     The condition variable was signalled
+ * \retval false    The deadline passed
+ */
+static bool bqueue_wait(BlockingQueue queue, pthread_cond_t * cond,
+                        size_t * waiters, const struct timespec * deadline);
+
+/*!
+ * \brief           Private function to push a value onto a queue.
+ * \param queue     A pointer to the queue.
+ * \param block     `true` to wait while the queue is full.
+ * \param deadline  A pointer to the deadline, or `NULL` to wait forever.
+ * \param ap        A `va_list` containing the value to push.
+ * \retval true     Success
+ * \retval false    Failure, the queue is closed or full.
+ */
+static bool bqueue_push_internal(BlockingQueue queue, const bool block,
+                                 const struct timespec * deadline,
+                                 va_list ap);
+
+/*!
+ * \brief           Private function to pop values from a queue.
+ * \param queue     A pointer to the queue.
+ * \param block     `true` to wait while the queue is empty.
+ * \param deadline  A pointer to the deadline, or `NULL` to wait forever.
+ * \param p         A pointer to an array of objects to receive the values.
+ * \param max       The maximum number of values to pop.
+ * \returns         The number of values popped.
+ */
+static size_t bqueue_pop_internal(BlockingQueue queue, const bool block,
+                                  const struct timespec * deadline,
+                                  void * p, const size_t max);
+
+BlockingQueue bqueue_create(const size_t capacity,
+                            const enum gds_datatype type,
+                            const int opts)
+{
+    if ( capacity == 0 ) {
+        abort_error("gds library", "blocking queue capacity must be "
+                                   "non-zero");
+    }
+
+    struct bqueue * new_queue = malloc(sizeof *new_queue);
+    if ( new_queue ) {
+        new_queue->elements = malloc(capacity * sizeof *new_queue->elements);
+        if ( !new_queue->elements ) {
+            free(new_queue);
+            new_queue = NULL;
+        }
+    }
+
+    if ( !new_queue ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_queue->pop_waiters = 0;
+    new_queue->push_waiters = 0;
+    new_queue->front = 0;
+    new_queue->size = 0;
+    new_queue->capacity = capacity;
+    new_queue->type = type;
+    new_queue->closed = false;
+    new_queue->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_queue->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    /*  Time limits are measured on the monotonic clock, so
+     *  that they are not affected by changes to the time.   */
+
+    pthread_condattr_t attr;
+    bool cond_ok = false;
+    if ( pthread_condattr_init(&attr) == 0 ) {
+        cond_ok = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0 &&
+                  pthread_cond_init(&new_queue->not_empty, &attr) == 0;
+        if ( cond_ok &&
+             pthread_cond_init(&new_queue->not_full, &attr) != 0 ) {
+            pthread_cond_destroy(&new_queue->not_empty);
+            cond_ok = false;
+        }
+        pthread_condattr_destroy(&attr);
+    }
+
+    if ( !cond_ok || pthread_mutex_init(&new_queue->lock, NULL) != 0 ) {
+        if ( cond_ok ) {
+            pthread_cond_destroy(&new_queue->not_empty);
+            pthread_cond_destroy(&new_queue->not_full);
+        }
+        free(new_queue->elements);
+        free(new_queue);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "couldn't initialize lock");
+        }
+        else {
+            log_error("gds library", "couldn't initialize lock");
+            return NULL;
+        }
+    }
+
+    return new_queue;
+}
+
+void bqueue_destroy(BlockingQueue queue)
+{
+    if ( queue->free_on_destroy ) {
+        for ( size_t i = 0; i < queue->size; ++i ) {
+            gdt_free(&queue->elements[(queue->front + i) % queue->capacity]);
+        }
+    }
+
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue->elements);
+    free(queue);
+}
+
+bool bqueue_push(BlockingQueue queue, ...)
+{
+    va_list ap;
+    va_start(ap, queue);
+    const bool result = bqueue_push_internal(queue, true, NULL, ap);
+    va_end(ap);
+
+    return result;
+}
+
+bool bqueue_try_push(BlockingQueue queue, ...)
+{
+    va_list ap;
+    va_start(ap, queue);
+    const bool result = bqueue_push_internal(queue, false, NULL, ap);
+    va_end(ap);
+
+    return result;
+}
+
+bool bqueue_timed_push(BlockingQueue queue, const unsigned long timeout_ms,
+                       ...)
+{
+    struct timespec deadline;
+    bqueue_deadline(&deadline, timeout_ms);
+
+    va_list ap;
+    va_start(ap, timeout_ms);
+    const bool result = bqueue_push_internal(queue, true, &deadline, ap);
+    va_end(ap);
+
+    return result;
+}
+
+bool bqueue_pop(BlockingQueue queue, void * p)
+{
+    return bqueue_pop_internal(queue, true, NULL, p, 1) == 1;
+}
+
+bool bqueue_try_pop(BlockingQueue queue, void * p)
+{
+    return bqueue_pop_internal(queue, false, NULL, p, 1) == 1;
+}
+
+bool bqueue_timed_pop(BlockingQueue queue, void * p,
+                      const unsigned long timeout_ms)
+{
+    struct timespec deadline;
+    bqueue_deadline(&deadline, timeout_ms);
+    return bqueue_pop_internal(queue, true, &deadline, p, 1) == 1;
+}
+
+size_t bqueue_pop_many(BlockingQueue queue, void * p, const size_t max)
+{
+    if ( max == 0 ) {
+        return 0;
+    }
+
+    return bqueue_pop_internal(queue, true, NULL, p, max);
+}
+
+void bqueue_close(BlockingQueue queue)
+{
+    bqueue_lock(queue);
+    queue->closed = true;
+    const bool wake_pop = queue->pop_waiters > 0;
+    const bool wake_push = queue->push_waiters > 0;
+    bqueue_unlock(queue);
+
+    if ( wake_pop ) {
+        pthread_cond_broadcast(&queue->not_empty);
+    }
+    if ( wake_push ) {
+        pthread_cond_broadcast(&queue->not_full);
+    }
+}
+
+bool bqueue_is_closed(BlockingQueue queue)
+{
+    bqueue_lock(queue);
+    const bool closed = queue->closed;
+    bqueue_unlock(queue);
+
+    return closed;
+}
+
+size_t bqueue_size(BlockingQueue queue)
+{
+    bqueue_lock(queue);
+    const size_t size = queue->size;
+    bqueue_unlock(queue);
+
+    return size;
+}
+
+size_t bqueue_capacity(BlockingQueue queue)
+{
+    return queue->capacity;
+}
+
+static void bqueue_lock(BlockingQueue queue)
+{
+    if ( pthread_mutex_lock(&queue->lock) != 0 ) {
+        abort_error("gds library", "couldn't lock queue");
+    }
+}
+
+static void bqueue_unlock(BlockingQueue queue)
+{
+    if ( pthread_mutex_unlock(&queue->lock) != 0 ) {
+        abort_error("gds library", "couldn't unlock queue");
+    }
+}
+
+static void bqueue_deadline(struct timespec * deadline,
+                            const unsigned long timeout_ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (long) (timeout_ms % 1000) * 1000000L;
+    if ( deadline->tv_nsec >= 1000000000L ) {
+        deadline->tv_sec += 1;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+static bool bqueue_wait(BlockingQueue queue, pthread_cond_t * cond,
+                        size_t * waiters, const struct timespec * deadline)
+{
+    *waiters += 1;
+    const int status = deadline ?
+                       pthread_cond_timedwait(cond, &queue->lock, deadline) :
+                       pthread_cond_wait(cond, &queue->lock);
+    *waiters -= 1;
+
+    if ( status == ETIMEDOUT ) {
+        return false;
+    }
+    else if ( status != 0 ) {
+        abort_error("gds library", "couldn't wait on condition variable");
+    }
+
+    return true;
+}
+
+static bool bqueue_push_internal(BlockingQueue queue, const bool block,
+                                 const struct timespec * deadline,
+                                 va_list ap)
+{
+    struct gdt_generic_datatype value;
+    gdt_set_value(&value, queue->type, NULL, ap);
+
+    bqueue_lock(queue);
+
+    while ( !queue->closed && queue->size == queue->capacity && block &&
+            bqueue_wait(queue, &queue->not_full,
+                        &queue->push_waiters, deadline) ) {
+        /*  Empty  */
+    }
+
+    if ( queue->closed || queue->size == queue->capacity ) {
+        bqueue_unlock(queue);
+        return false;
+    }
+
+    queue->elements[(queue->front + queue->size) % queue->capacity] = value;
+    queue->size += 1;
+    const bool wake = queue->pop_waiters > 0;
+
+    bqueue_unlock(queue);
+
+    if ( wake ) {
+        pthread_cond_signal(&queue->not_empty);
+    }
+
+    return true;
+}
+
+static size_t bqueue_pop_internal(BlockingQueue queue, const bool block,
+                                  const struct timespec * deadline,
+                                  void * p, const size_t max)
+{
+    const size_t element_size = gdt_size_of_type(queue->type);
+    char * out = p;
+
+    bqueue_lock(queue);
+
+    while ( queue->size == 0 && !queue->closed && block &&
+            bqueue_wait(queue, &queue->not_empty,
+                        &queue->pop_waiters, deadline) ) {
+        /*  Empty  */
+    }
+
+    const size_t count = queue->size < max ? queue->size : max;
+    for ( size_t i = 0; i < count; ++i ) {
+        gdt_get_value(&queue->elements[queue->front], out + i * element_size);
+        queue->front = (queue->front + 1) % queue->capacity;
+    }
+    queue->size -= count;
+
+    /*  Popping several values makes room for several producers  */
+
+    const size_t waiters = queue->push_waiters;
+
+    bqueue_unlock(queue);
+
+    if ( count > 1 && waiters > 1 ) {
+        pthread_cond_broadcast(&queue->not_full);
+    }
+    else if ( count > 0 && waiters > 0 ) {
+        pthread_cond_signal(&queue->not_full);
+    }
+
+    return count;
+}
@@ -0,0 +1,242 @@
+/*!
+ * \file            cdict.c
+ * \brief           Implementation of concurrent generic dictionary.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/dict_internal.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/cdict.h>
+
+/*!  Number of shards used if none is specified  */
+static const size_t DEFAULT_SHARDS = 16;
+
+/*!
+ * \brief           Shard structure.
+ * \details         Each shard is padded out to two cache lines, so that
+ * threads taking the locks of neighbouring shards do not contend for the
+ * same line, even with adjacent-line hardware prefetching.
+ */
+union cdict_shard {
+    struct {
+        pthread_rwlock_t lock;                  /*!<  Shard lock            */
+        Dict dict;                              /*!<  Shard dictionary      */
+    } s;                                        /*!<  Shard contents        */
+    char pad[GDS_CACHE_LINE * 2];               /*!<  Padding               */
+};
+
+/*!  Concurrent dict structure  */
+struct cdict {
+    size_t num_shards;      /*!<  Number of shards, always a power of two   */
+    union cdict_shard * shards;                 /*!<  The shards            */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Returns the shard responsible for a key.
+ * \details         The dictionary within each shard indexes its slots with
+ * the low bits of the hash, so the shard is chosen by scrambling the hash
+ * and taking higher bits, otherwise every key in a shard would compete for
+ * the same fraction of its slots.
+ * \param cdict     A pointer to the dictionary.
+ * \param hash      The hash of the key.
+ * \returns         A pointer to the shard.
+ */
+static union cdict_shard * cdict_shard_for_hash(CDict cdict,
+                                                const size_t hash);
+
+/*!
+ * \brief           Read-locks a shard, aborting on failure.
+ * \param shard     A pointer to the shard.
+ */
+static void cdict_shard_rdlock(union cdict_shard * shard);
+
+/*!
+ * \brief           Write-locks a shard, aborting on failure.
+ * \param shard     A pointer to the shard.
+ */
+static void cdict_shard_wrlock(union cdict_shard * shard);
+
+/*!
+ * \brief           Unlocks a shard, aborting on failure.
+ * \param shard     A pointer to the shard.
+ */
+static void cdict_shard_unlock(union cdict_shard * shard);
+
+CDict cdict_create(const size_t num_shards, const enum gds_datatype type,
+                   const int opts)
+{
+    struct cdict * new_cdict = malloc(sizeof *new_cdict);
+    if ( !new_cdict ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_cdict->num_shards = 1;
+    while ( new_cdict->num_shards < (num_shards ? num_shards :
+                                                  DEFAULT_SHARDS) ) {
+        new_cdict->num_shards *= 2;
+    }
+    new_cdict->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    void * shards;
+    if ( posix_memalign(&shards, GDS_CACHE_LINE,
+                        new_cdict->num_shards * sizeof *new_cdict->shards) ) {
+        if ( new_cdict->exit_on_error ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            free(new_cdict);
+            return NULL;
+        }
+    }
+    new_cdict->shards = shards;
+
+    for ( size_t i = 0; i < new_cdict->num_shards; ++i ) {
+        union cdict_shard * shard = &new_cdict->shards[i];
+
+        shard->s.dict = dict_create(type, opts);
+        if ( !shard->s.dict ) {
+            new_cdict->num_shards = i;
+            cdict_destroy(new_cdict);
+            return NULL;
+        }
+
+        if ( pthread_rwlock_init(&shard->s.lock, NULL) != 0 ) {
+            dict_destroy(shard->s.dict);
+            new_cdict->num_shards = i;
+            cdict_destroy(new_cdict);
+            if ( opts & GDS_EXIT_ON_ERROR ) {
+                quit_error("gds library", "couldn't initialize lock");
+            }
+            else {
+                log_error("gds library", "couldn't initialize lock");
+                return NULL;
+            }
+        }
+    }
+
+    return new_cdict;
+}
+
+void cdict_destroy(CDict cdict)
+{
+    for ( size_t i = 0; i < cdict->num_shards; ++i ) {
+        pthread_rwlock_destroy(&cdict->shards[i].s.lock);
+        dict_destroy(cdict->shards[i].s.dict);
+    }
+
+    free(cdict->shards);
+    free(cdict);
+}
+
+bool cdict_insert(CDict cdict, const char * key, ...)
+{
+    const size_t hash = dict_hash_key(key);
+    union cdict_shard * shard = cdict_shard_for_hash(cdict, hash);
+
+    va_list ap;
+    va_start(ap, key);
+    cdict_shard_wrlock(shard);
+    bool status = dict_insert_hashed(shard->s.dict, key, hash, ap);
+    cdict_shard_unlock(shard);
+    va_end(ap);
+
+    return status;
+}
+
+bool cdict_delete(CDict cdict, const char * key)
+{
+    const size_t hash = dict_hash_key(key);
+    union cdict_shard * shard = cdict_shard_for_hash(cdict, hash);
+
+    cdict_shard_wrlock(shard);
+    bool status = dict_delete_hashed(shard->s.dict, key, hash);
+    cdict_shard_unlock(shard);
+
+    return status;
+}
+
+bool cdict_has_key(CDict cdict, const char * key)
+{
+    return cdict_value_for_key(cdict, key, NULL);
+}
+
+bool cdict_value_for_key(CDict cdict, const char * key, void * p)
+{
+    const size_t hash = dict_hash_key(key);
+    union cdict_shard * shard = cdict_shard_for_hash(cdict, hash);
+
+    cdict_shard_rdlock(shard);
+    bool status = dict_value_for_key_hashed(shard->s.dict, key, hash, p);
+    cdict_shard_unlock(shard);
+
+    return status;
+}
+
+bool cdict_foreach(CDict cdict, dict_foreach_func fn, void * ctx)
+{
+    for ( size_t i = 0; i < cdict->num_shards; ++i ) {
+        union cdict_shard * shard = &cdict->shards[i];
+
+        cdict_shard_rdlock(shard);
+        bool status = dict_foreach(shard->s.dict, fn, ctx);
+        cdict_shard_unlock(shard);
+
+        if ( !status ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static union cdict_shard * cdict_shard_for_hash(CDict cdict,
+                                                const size_t hash)
+{
+    /*  Fibonacci hashing: multiply by 2^64 divided by the golden
+     *  ratio, and take the upper half, which depends on every bit
+     *  of the original hash.                                       */
+
+    const unsigned long long scrambled =
+        (unsigned long long) hash * 11400714819323198485ULL;
+    const size_t index = (size_t) (scrambled >> 32) & (cdict->num_shards - 1);
+
+    return &cdict->shards[index];
+}
+
+static void cdict_shard_rdlock(union cdict_shard * shard)
+{
+    if ( pthread_rwlock_rdlock(&shard->s.lock) != 0 ) {
+        abort_error("gds library", "couldn't lock shard");
+    }
+}
+
+static void cdict_shard_wrlock(union cdict_shard * shard)
+{
+    if ( pthread_rwlock_wrlock(&shard->s.lock) != 0 ) {
+        abort_error("gds library", "couldn't lock shard");
+    }
+}
+
+static void cdict_shard_unlock(union cdict_shard * shard)
+{
+    if ( pthread_rwlock_unlock(&shard->s.lock) != 0 ) {
+        abort_error("gds library", "couldn't unlock shard");
+    }
+}
@@ -0,0 +1,314 @@
+/*!
+ * \file            cvector.c
+ * \brief           Implementation of append-only concurrent vector.
+ * \details         Segment 0 holds the first `B` elements, and segment
+ * `k` holds the next `B * 2^k`, where `B` is a power of two, so segment
+ * `k` starts at index `B * (2^k - 1)`, and the segment holding index `i`
+ * is found from the highest set bit of `i / B + 1`. The segment pointers
+ * live in a fixed array with one entry for each bit in a `size_t`, which
+ * is enough for any index.
+ *
+ * An append reserves an index by atomically incrementing the length,
+ * allocates the segment if no thread has yet done so, stores the value
+ * and then sets a ready flag for the element with release ordering. A
+ * reader loads the flag with acquire ordering before reading the value,
+ * so it never sees a value which is only partly written. Two threads
+ * reaching a new segment at once may both allocate it, in which case the
+ * one which loses the compare-and-swap frees its copy and uses the other.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/cvector.h>
+
+/*!  Default size of first segment  */
+static const size_t DEFAULT_CAPACITY = 16;
+
+/*!  Number of segment pointers, enough to hold any index  */
+#define CVECTOR_SEGMENTS (sizeof(size_t) * CHAR_BIT)
+
+/*!  Length counter, padded to a cache line  */
+union cvector_length {
+    size_t length;                  /*!<  Number of indices reserved        */
+    char pad[GDS_CACHE_LINE];                   /*!<  Padding               */
+};
+
+/*!  Concurrent vector structure  */
+struct cvector {
+    union cvector_length reserved;  /*!<  Length, written by appenders      */
+    char * segments[CVECTOR_SEGMENTS];  /*!<  Segments, or NULL             */
+    size_t first_capacity;          /*!<  Size of first segment             */
+    unsigned int shift;             /*!<  Base two logarithm of above       */
+    size_t value_size;              /*!<  Size of each value                */
+    enum gds_datatype type;         /*!<  Vector datatype                   */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;             /*!<  Exit on error if true             */
+};
+
+/*!
+ * \brief           Finds the segment and offset of an index.
+ * \param vector    A pointer to the vector.
+ * \param index     The index.
+ * \param offset    A pointer to an object which is modified to contain
+ * the offset of the index within its segment.
+ * \returns         The number of the segment holding the index.
+ */
+static size_t cvector_locate(CVector vector, const size_t index,
+                             size_t * offset);
+
+/*!
+ * \brief           Returns the number of elements in a segment.
+ * \param vector    A pointer to the vector.
+ * \param segment   The number of the segment.
+ * \returns         The number of elements in the segment.
+ */
+static size_t cvector_segment_capacity(CVector vector, const size_t segment);
+
+/*!
+ * \brief           Allocates a segment.
+ * \details         A segment holds a ready flag for each element, padded
+ * to a multiple of eight bytes, followed by the elements. The flags are
+ * zeroed.
+ * \param vector    A pointer to the vector.
+ * \param segment   The number of the segment.
+ * \returns         A pointer to the new segment, or `NULL` if memory
+ * allocation failed.
+ */
+static char * cvector_segment_alloc(CVector vector, const size_t segment);
+
+/*!
+ * \brief           Gets the segment holding an index, allocating it if
+ * no thread has yet done so.
+ * \param vector    A pointer to the vector.
+ * \param segment   The number of the segment.
+ * \returns         A pointer to the segment, or `NULL` if memory
+ * allocation failed.
+ */
+static char * cvector_get_segment(CVector vector, const size_t segment);
+
+/*!
+ * \brief           Returns the offset of the elements within a segment.
+ * \param capacity  The number of elements in the segment.
+ * \returns         The offset of the first element.
+ */
+static size_t cvector_values_offset(const size_t capacity);
+
+CVector cvector_create(const size_t capacity, const enum gds_datatype type,
+                       const int opts)
+{
+    struct cvector * new_vector = calloc(1, sizeof *new_vector);
+    if ( !new_vector ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    const size_t wanted = capacity ? capacity : DEFAULT_CAPACITY;
+    new_vector->first_capacity = 1;
+    new_vector->shift = 0;
+    while ( new_vector->first_capacity < wanted &&
+            new_vector->first_capacity <= SIZE_MAX / 4 ) {
+        new_vector->first_capacity *= 2;
+        new_vector->shift += 1;
+    }
+
+    new_vector->value_size = gdt_size_of_type(type);
+    new_vector->type = type;
+    new_vector->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_vector->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    new_vector->segments[0] = cvector_segment_alloc(new_vector, 0);
+    if ( !new_vector->segments[0] ) {
+        free(new_vector);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    return new_vector;
+}
+
+void cvector_destroy(CVector vector)
+{
+    struct gdt_generic_datatype value;
+
+    for ( size_t s = 0; s < CVECTOR_SEGMENTS; ++s ) {
+        char * segment = vector->segments[s];
+        if ( !segment ) {
+            continue;
+        }
+
+        if ( vector->free_on_destroy ) {
+            const size_t capacity = cvector_segment_capacity(vector, s);
+            const char * values = segment +
+                                  cvector_values_offset(capacity);
+            for ( size_t i = 0; i < capacity; ++i ) {
+                if ( segment[i] ) {
+                    gdt_load_raw(&value, vector->type,
+                                 values + i * vector->value_size,
+                                 vector->value_size);
+                    gdt_free(&value);
+                }
+            }
+        }
+
+        free(segment);
+    }
+
+    free(vector);
+}
+
+bool cvector_append(CVector vector, size_t * index, ...)
+{
+    const size_t new_index = __atomic_fetch_add(&vector->reserved.length, 1,
+                                                __ATOMIC_RELAXED);
+    size_t offset;
+    const size_t s = cvector_locate(vector, new_index, &offset);
+    char * segment = cvector_get_segment(vector, s);
+    if ( !segment ) {
+        if ( vector->exit_on_error ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return false;
+        }
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, index);
+    gdt_set_value(&value, vector->type, NULL, ap);
+    va_end(ap);
+
+    const size_t capacity = cvector_segment_capacity(vector, s);
+    gdt_store_raw(&value, segment + cvector_values_offset(capacity) +
+                          offset * vector->value_size, vector->value_size);
+    __atomic_store_n(&segment[offset], 1, __ATOMIC_RELEASE);
+
+    if ( index ) {
+        *index = new_index;
+    }
+
+    return true;
+}
+
+bool cvector_element_at_index(CVector vector, const size_t index,
+                              void * p)
+{
+    if ( index >= __atomic_load_n(&vector->reserved.length,
+                                  __ATOMIC_RELAXED) ) {
+        return false;
+    }
+
+    size_t offset;
+    const size_t s = cvector_locate(vector, index, &offset);
+    const char * segment = __atomic_load_n(&vector->segments[s],
+                                           __ATOMIC_ACQUIRE);
+    if ( !segment || !__atomic_load_n(&segment[offset], __ATOMIC_ACQUIRE) ) {
+        return false;
+    }
+
+    const size_t capacity = cvector_segment_capacity(vector, s);
+    memcpy(p, segment + cvector_values_offset(capacity) +
+           offset * vector->value_size, vector->value_size);
+
+    return true;
+}
+
+bool cvector_is_empty(CVector vector)
+{
+    return cvector_length(vector) == 0;
+}
+
+size_t cvector_length(CVector vector)
+{
+    return __atomic_load_n(&vector->reserved.length, __ATOMIC_RELAXED);
+}
+
+static size_t cvector_locate(CVector vector, const size_t index,
+                             size_t * offset)
+{
+    const unsigned long long q = (index >> vector->shift) + 1ULL;
+    const size_t segment = (size_t) (sizeof q * CHAR_BIT - 1 -
+                                     __builtin_clzll(q));
+    *offset = index - (vector->first_capacity << segment) +
+              vector->first_capacity;
+    return segment;
+}
+
+static size_t cvector_segment_capacity(CVector vector, const size_t segment)
+{
+    return vector->first_capacity << segment;
+}
+
+static size_t cvector_values_offset(const size_t capacity)
+{
+    return (capacity + 7) / 8 * 8;
+}
+
+static char * cvector_segment_alloc(CVector vector, const size_t segment)
+{
+    if ( segment >= CVECTOR_SEGMENTS - vector->shift ) {
+        return NULL;
+    }
+
+    const size_t capacity = cvector_segment_capacity(vector, segment);
+    const size_t offset = cvector_values_offset(capacity);
+    if ( offset < capacity ||
+         (vector->value_size &&
+          capacity > (SIZE_MAX - offset) / vector->value_size) ) {
+        return NULL;
+    }
+
+    char * new_segment = malloc(offset + capacity * vector->value_size);
+    if ( new_segment ) {
+        memset(new_segment, 0, capacity);
+    }
+
+    return new_segment;
+}
+
+static char * cvector_get_segment(CVector vector, const size_t segment)
+{
+    char * current = __atomic_load_n(&vector->segments[segment],
+                                     __ATOMIC_ACQUIRE);
+    if ( current ) {
+        return current;
+    }
+
+    char * new_segment = cvector_segment_alloc(vector, segment);
+    if ( !new_segment ) {
+        return NULL;
+    }
+
+    /*  Release ordering publishes the zeroed ready flags  */
+
+    if ( !__atomic_compare_exchange_n(&vector->segments[segment], &current,
+                                      new_segment, false, __ATOMIC_RELEASE,
+                                      __ATOMIC_ACQUIRE) ) {
+        free(new_segment);
+        return current;
+    }
+
+    return new_segment;
+}
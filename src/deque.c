@@ -0,0 +1,435 @@
+/*!
+ * \file            deque.c
+ * \brief           Implementation of generic double-ended queue.
+ * \details         Values are stored in blocks of a fixed number of
+ * values, and a map holds a pointer to each block in order. A value's
+ * position counts from the start of the first block the map could hold,
+ * so its block and its offset within the block are found with a shift
+ * and a mask. Pushing at either end allocates a new block only when the
+ * end block is full. When the map runs out of room at one end, the block
+ * pointers are recentred in it, or moved to a map twice the size, but
+ * the blocks themselves never move. A single emptied block is kept in
+ * reserve, so pushes and pops which cross back and forth over a block
+ * boundary do not allocate and free a block every time.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds/deque.h>
+
+/*!  Largest size of a block in bytes  */
+static const size_t DEQUE_BLOCK_BYTES = 512;
+
+/*!  Initial number of block pointers in the map  */
+static const size_t DEQUE_INITIAL_MAP_SIZE = 8;
+
+/*!  Deque structure  */
+struct deque {
+    char ** map;                    /*!<  Block map                         */
+    size_t map_size;                /*!<  Number of entries in block map    */
+    size_t front;                   /*!<  Position of front value           */
+    size_t size;                    /*!<  Number of values                  */
+    char * spare;                   /*!<  Unused block, or NULL             */
+    unsigned int block_shift;       /*!<  Log2 of values per block          */
+    size_t block_mask;              /*!<  Values per block less one         */
+    size_t value_size;              /*!<  Size of each value                */
+    enum gds_datatype type;         /*!<  Deque datatype                    */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Returns a pointer to the value at a position.
+ * \param deque     A pointer to the deque.
+ * \param pos       The position, whose block must be allocated.
+ * \returns         A pointer to the value.
+ */
+static char * deque_value_at(Deque deque, const size_t pos);
+
+/*!
+ * \brief           Ensures the block for a position is allocated.
+ * \param deque     A pointer to the deque.
+ * \param pos       The position, which must be within the map.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed.
+ */
+static bool deque_acquire_block(Deque deque, const size_t pos);
+
+/*!
+ * \brief           Releases the block for a position.
+ * \param deque     A pointer to the deque.
+ * \param pos       The position, which must hold no more values.
+ */
+static void deque_release_block(Deque deque, const size_t pos);
+
+/*!
+ * \brief           Recentres the blocks in the map, growing it if needed.
+ * \details         Afterwards there is room for at least one more block
+ * at each end of the map.
+ * \param deque     A pointer to the deque.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed.
+ */
+static bool deque_remap(Deque deque);
+
+/*!
+ * \brief           Checks an index is in range, reporting an error if not.
+ * \param deque     A pointer to the deque.
+ * \param index     The index.
+ * \retval true     The index is in range
+ * \retval false    The index is out of range
+ */
+static bool deque_check_index(Deque deque, const size_t index);
+
+/*!
+ * \brief           Checks a deque is not empty, reporting an error if it is.
+ * \param deque     A pointer to the deque.
+ * \retval true     The deque is not empty
+ * \retval false    The deque is empty
+ */
+static bool deque_check_not_empty(Deque deque);
+
+Deque deque_create(const enum gds_datatype type, const int opts)
+{
+    struct deque * new_deque = malloc(sizeof *new_deque);
+    if ( !new_deque ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_deque->value_size = gdt_size_of_type(type);
+    new_deque->block_shift = 0;
+    while ( (new_deque->value_size << (new_deque->block_shift + 1)) <=
+            DEQUE_BLOCK_BYTES ) {
+        new_deque->block_shift += 1;
+    }
+    new_deque->block_mask = ((size_t) 1 << new_deque->block_shift) - 1;
+
+    new_deque->map_size = DEQUE_INITIAL_MAP_SIZE;
+    new_deque->map = calloc(new_deque->map_size, sizeof *new_deque->map);
+    if ( !new_deque->map ) {
+        free(new_deque);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+        }
+        return NULL;
+    }
+
+    /*  Start in the middle of the map, to leave room at both ends  */
+
+    new_deque->front = (new_deque->map_size / 2) << new_deque->block_shift;
+    new_deque->size = 0;
+    new_deque->spare = NULL;
+    new_deque->type = type;
+    new_deque->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_deque->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    return new_deque;
+}
+
+void deque_destroy(Deque deque)
+{
+    if ( deque->free_on_destroy ) {
+        struct gdt_generic_datatype value;
+
+        for ( size_t i = 0; i < deque->size; ++i ) {
+            gdt_load_raw(&value, deque->type,
+                         deque_value_at(deque, deque->front + i),
+                         deque->value_size);
+            gdt_free(&value);
+        }
+    }
+
+    for ( size_t i = 0; i < deque->map_size; ++i ) {
+        free(deque->map[i]);
+    }
+
+    free(deque->spare);
+    free(deque->map);
+    free(deque);
+}
+
+bool deque_push_back(Deque deque, ...)
+{
+    size_t pos = deque->front + deque->size;
+    if ( (pos >> deque->block_shift) >= deque->map_size ) {
+        if ( !deque_remap(deque) ) {
+            return false;
+        }
+        pos = deque->front + deque->size;
+    }
+
+    if ( !deque_acquire_block(deque, pos) ) {
+        return false;
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, deque);
+    gdt_set_value(&value, deque->type, NULL, ap);
+    va_end(ap);
+
+    gdt_store_raw(&value, deque_value_at(deque, pos), deque->value_size);
+    deque->size += 1;
+
+    return true;
+}
+
+bool deque_push_front(Deque deque, ...)
+{
+    if ( deque->front == 0 ) {
+        if ( !deque_remap(deque) ) {
+            return false;
+        }
+    }
+
+    const size_t pos = deque->front - 1;
+    if ( !deque_acquire_block(deque, pos) ) {
+        return false;
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, deque);
+    gdt_set_value(&value, deque->type, NULL, ap);
+    va_end(ap);
+
+    gdt_store_raw(&value, deque_value_at(deque, pos), deque->value_size);
+    deque->front = pos;
+    deque->size += 1;
+
+    return true;
+}
+
+bool deque_pop_back(Deque deque, void * p)
+{
+    if ( !deque_check_not_empty(deque) ) {
+        return false;
+    }
+
+    const size_t pos = deque->front + deque->size - 1;
+    memcpy(p, deque_value_at(deque, pos), deque->value_size);
+    deque->size -= 1;
+
+    /*  Release the block if this was the only value left in it  */
+
+    if ( (pos & deque->block_mask) == 0 || deque->size == 0 ) {
+        deque_release_block(deque, pos);
+    }
+
+    return true;
+}
+
+bool deque_pop_front(Deque deque, void * p)
+{
+    if ( !deque_check_not_empty(deque) ) {
+        return false;
+    }
+
+    const size_t pos = deque->front;
+    memcpy(p, deque_value_at(deque, pos), deque->value_size);
+    deque->front += 1;
+    deque->size -= 1;
+
+    /*  Release the block if this was the only value left in it  */
+
+    if ( (pos & deque->block_mask) == deque->block_mask ||
+         deque->size == 0 ) {
+        deque_release_block(deque, pos);
+    }
+
+    return true;
+}
+
+bool deque_element_at_index(Deque deque, const size_t index, void * p)
+{
+    if ( !deque_check_index(deque, index) ) {
+        return false;
+    }
+
+    memcpy(p, deque_value_at(deque, deque->front + index),
+           deque->value_size);
+
+    return true;
+}
+
+bool deque_set_element_at_index(Deque deque, const size_t index, ...)
+{
+    if ( !deque_check_index(deque, index) ) {
+        return false;
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, index);
+    gdt_set_value(&value, deque->type, NULL, ap);
+    va_end(ap);
+
+    gdt_store_raw(&value, deque_value_at(deque, deque->front + index),
+                  deque->value_size);
+
+    return true;
+}
+
+void * deque_element_address(Deque deque, const size_t index)
+{
+    if ( !deque_check_index(deque, index) ) {
+        return NULL;
+    }
+
+    return deque_value_at(deque, deque->front + index);
+}
+
+bool deque_is_empty(Deque deque)
+{
+    return deque->size == 0;
+}
+
+size_t deque_size(Deque deque)
+{
+    return deque->size;
+}
+
+static char * deque_value_at(Deque deque, const size_t pos)
+{
+    return deque->map[pos >> deque->block_shift] +
+           (pos & deque->block_mask) * deque->value_size;
+}
+
+static bool deque_acquire_block(Deque deque, const size_t pos)
+{
+    char ** entry = &deque->map[pos >> deque->block_shift];
+    if ( *entry ) {
+        return true;
+    }
+
+    if ( deque->spare ) {
+        *entry = deque->spare;
+        deque->spare = NULL;
+        return true;
+    }
+
+    *entry = malloc((deque->block_mask + 1) * deque->value_size);
+    if ( !*entry ) {
+        if ( deque->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void deque_release_block(Deque deque, const size_t pos)
+{
+    char ** entry = &deque->map[pos >> deque->block_shift];
+
+    if ( deque->spare ) {
+        free(*entry);
+    }
+    else {
+        deque->spare = *entry;
+    }
+    *entry = NULL;
+}
+
+static bool deque_remap(Deque deque)
+{
+    const size_t first = deque->front >> deque->block_shift;
+    const size_t num_blocks = deque->size ?
+        ((deque->front + deque->size - 1) >> deque->block_shift) -
+        first + 1 : 0;
+
+    /*  Double the map if the blocks fill more than half of it, so
+     *  that recentring is needed only after many more pushes.      */
+
+    size_t new_size = deque->map_size;
+    if ( (num_blocks + 2) * 2 > new_size ) {
+        new_size *= 2;
+    }
+    const size_t new_first = (new_size - num_blocks) / 2;
+
+    if ( new_size != deque->map_size ) {
+        char ** new_map = calloc(new_size, sizeof *new_map);
+        if ( !new_map ) {
+            if ( deque->exit_on_error ) {
+                quit_strerror("gds library", "memory allocation failed");
+            }
+            else {
+                log_strerror("gds library", "memory allocation failed");
+                return false;
+            }
+        }
+
+        memcpy(new_map + new_first, deque->map + first,
+               num_blocks * sizeof *new_map);
+        free(deque->map);
+        deque->map = new_map;
+        deque->map_size = new_size;
+    }
+    else {
+        memmove(deque->map + new_first, deque->map + first,
+                num_blocks * sizeof *deque->map);
+
+        /*  Clear the entries the blocks no longer occupy  */
+
+        for ( size_t i = 0; i < new_first; ++i ) {
+            deque->map[i] = NULL;
+        }
+        for ( size_t i = new_first + num_blocks; i < new_size; ++i ) {
+            deque->map[i] = NULL;
+        }
+    }
+
+    deque->front = (new_first << deque->block_shift) |
+                   (deque->front & deque->block_mask);
+
+    return true;
+}
+
+static bool deque_check_index(Deque deque, const size_t index)
+{
+    if ( index >= deque->size ) {
+        if ( deque->exit_on_error ) {
+            quit_error("gds library", "index %zu out of range", index);
+        }
+        else {
+            log_error("gds library", "index %zu out of range", index);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool deque_check_not_empty(Deque deque)
+{
+    if ( deque->size == 0 ) {
+        if ( deque->exit_on_error ) {
+            quit_error("gds library", "deque empty");
+        }
+        else {
+            log_error("gds library", "deque empty");
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -1,60 +1,199 @@
 /*!
  * \file            dict.c
  * \brief           Implementation of generic dictionary data structure.
+ * \details         The dictionary is implemented as an open-addressed hash
+ * table with linear probing. Each slot caches the full hash of its key
+ * alongside a pointer to the key-value pair, so most probes can be
+ * rejected without touching the pair itself. If requested, a blocked
+ * Bloom filter is kept alongside the table. Each key sets a handful of
+ * bits within one cache-line sized block of the filter, so a lookup can
+ * rule out an absent key by reading a single cache line.
  * \author          Paul Griffiths
  * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
  * of the GNU General Public License. <http://www.gnu.org/licenses/>
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
 #include <pggds/gds_util.h>
 #include <pggds/dict.h>
-#include <pggds/list.h>
 #include <pggds/kvpair.h>
+#include <pggds_internal/dict_internal.h>
+
+/*!  Initial number of slots, must be a power of two  */
+static const size_t INITIAL_SLOTS = 256;
+
+/*!  Growth factor for dynamic memory allocation  */
+static const size_t GROWTH = 2;
+
+/*!
+ * \brief           Number of keys processed per stage by dict_lookup_many().
+ * \details         This bounds the number of prefetches in flight at once,
+ * and should be roughly the number of outstanding cache misses the
+ * hardware can track.
+ */
+#define LOOKUP_BATCH 16
+
+/*!  Hints to the processor that an address will shortly be read  */
+#if defined(__GNUC__)
+#define DICT_PREFETCH(addr) __builtin_prefetch((addr))
+#else
+#define DICT_PREFETCH(addr) ((void) (addr))
+#endif
+
+/*!  Number of bits in a Bloom filter block  */
+#define BLOOM_BLOCK_BITS (GDS_CACHE_LINE * 8)
 
-/*!  Number of buckets  */
-static const size_t BUCKETS = 256;
+/*!  Number of 64-bit words in a Bloom filter block  */
+#define BLOOM_BLOCK_WORDS (BLOOM_BLOCK_BITS / 64)
+
+/*!
+ * \brief           Number of slots per Bloom filter block.
+ * \details         This gives eight filter bits, one byte, per slot. The
+ * table is at most three quarters full, so that is at least ten and two
+ * thirds bits per key, and sixteen bits per key when it is half full, as
+ * it is straight after growing.
+ */
+#define BLOOM_SLOTS_PER_BLOCK (BLOOM_BLOCK_BITS / 8)
+
+/*!
+ * \brief           Number of bits set in the Bloom filter for each key.
+ * \details         This is about optimal for ten to fifteen bits per key,
+ * and each bit index takes nine bits of a single 64-bit mixed hash.
+ */
+#define BLOOM_NUM_BITS 7
+
+/*!  Bloom filter block structure  */
+struct dict_bloom_block {
+    uint64_t words[BLOOM_BLOCK_WORDS];      /*!<  The filter bits           */
+};
+
+/*!  Dict slot structure  */
+struct dict_slot {
+    size_t hash;                    /*!<  Full hash of the key              */
+    struct gds_kvpair * pair;       /*!<  Key-value pair, or NULL if empty  */
+};
 
 /*!  Dict structure  */
 struct dict {
-    size_t num_buckets;                         /*!<  Number of buckets     */
-    List * buckets;                             /*!<  The buckets           */
+    size_t num_slots;       /*!<  Number of slots, always a power of two    */
+    size_t num_keys;        /*!<  Number of keys in the dictionary          */
+    size_t num_used;        /*!<  Number of keys plus deleted slots         */
+    struct dict_slot * slots;                   /*!<  The slots             */
+    size_t num_blocks;      /*!<  Number of Bloom filter blocks, or zero    */
+    struct dict_bloom_block * bloom;    /*!<  Bloom filter, or NULL if none */
     enum gds_datatype type;                     /*!<  Dict datatype         */
     bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
     bool exit_on_error;     /*!<  Exit on error if true                     */
 };
 
 /*!
- * \brief               Internal function to check for the existence of a key.
- * \details             If the key is present, `pair` will be modified to
- * contain the address of the key-value pair containing it.
+ * \brief           Marker for a slot whose key has been deleted.
+ * \details         Deleted slots cannot simply be emptied, since that would
+ * break the probe sequence for any keys stored beyond them.
+ */
+static struct gds_kvpair deleted_pair;
+
+/*!  Convenience macro for the deleted slot marker  */
+#define DELETED (&deleted_pair)
+
+/*!
+ * \brief               Internal function to find the slot containing a key.
  * \param dict          A pointer to the dictionary.
  * \param key           The key for which to search.
- * \param pitr          A pointer to a list iterator. If the key is found,
- * the iterator at this address will be modified to point to the list
- * element containing the corresponding key-value pair.
- * \retval true         Key was found
- * \retval false        Key was not found
+ * \param hash          The hash of the key.
+ * \retval NULL         Key was not found
+ * \retval non-NULL     A pointer to the slot containing the key
  */
-static bool dict_has_key_internal(Dict dict, const char * key, ListItr * pitr);
+static struct dict_slot * dict_find_slot(Dict dict, const char * key,
+                                         const size_t hash);
 
 /*!
- * \brief               Helper function to create the dictionary buckets.
+ * \brief               Internal function to find the next occupied slot.
+ * \param dict          A pointer to the dictionary.
+ * \param index         The index from which to start searching.
+ * \retval NULL         There are no occupied slots at or after `index`
+ * \retval non-NULL     A pointer to the first occupied slot at or after
+ * `index`
+ */
+static struct dict_slot * dict_next_live_slot(Dict dict, size_t index);
+
+/*!
+ * \brief               Internal function to delete the key in a slot.
+ * \details             The slot is marked as deleted rather than emptied,
+ * so neither probe sequences nor iteration are disturbed.
+ * \param dict          A pointer to the dictionary.
+ * \param slot          A pointer to the occupied slot.
+ */
+static void dict_delete_slot(Dict dict, struct dict_slot * slot);
+
+/*!
+ * \brief               Helper function to allocate an empty slot array.
+ * \param dict          A pointer to the dictionary.
+ * \param num_slots     The number of slots to allocate.
+ * \retval NULL         Failure, dynamic memory allocation failed.
+ * \retval non-NULL     A pointer to the new slot array.
+ */
+static struct dict_slot * dict_slots_create(Dict dict, const size_t num_slots);
+
+/*!
+ * \brief               Helper function to grow or clean the slot array.
+ * \details             All the keys are rehashed into a new slot array,
+ * which discards any deleted slot markers. The array doubles in size only
+ * if the live keys alone would otherwise exceed the load factor.
  * \param dict          A pointer to the dictionary.
  * \retval true         Success
  * \retval false        Failure, dynamic memory allocation failed.
  */
-static bool dict_buckets_create(Dict dict);
+static bool dict_rehash(Dict dict);
+
+/*!
+ * \brief               Helper function to allocate an empty Bloom filter.
+ * \param dict          A pointer to the dictionary.
+ * \param num_blocks    The number of blocks in the filter.
+ * \retval NULL         Failure, dynamic memory allocation failed.
+ * \retval non-NULL     A pointer to the new filter.
+ */
+static struct dict_bloom_block * dict_bloom_create(Dict dict,
+                                                   const size_t num_blocks);
+
+/*!
+ * \brief               Helper function to add a hash to the Bloom filter.
+ * \param dict          A pointer to the dictionary.
+ * \param hash          The hash of the key.
+ */
+static void dict_bloom_add(Dict dict, const size_t hash);
+
+/*!
+ * \brief               Helper function to test a hash against the filter.
+ * \param dict          A pointer to the dictionary.
+ * \param hash          The hash of the key.
+ * \retval true         The key may be in the dictionary.
+ * \retval false        The key is definitely not in the dictionary.
+ */
+static bool dict_bloom_test(Dict dict, const size_t hash);
 
 /*!
- * \brief               Helper function to destroy the dictionary buckets.
+ * \brief               Helper function to find a key's Bloom filter block.
+ * \details             djb2 hashes of similar keys differ mostly in their
+ * low bits, which also choose the key's slot, so the hash is remixed to
+ * spread it across the block index and the bit indices.
  * \param dict          A pointer to the dictionary.
+ * \param hash          The hash of the key.
+ * \param bits          A pointer to an object which will be modified to
+ * contain the mixed hash from which the bit indices are taken.
+ * \returns             A pointer to the block.
  */
-static void dict_buckets_destroy(Dict dict);
+static struct dict_bloom_block * dict_bloom_block(Dict dict,
+                                                  const size_t hash,
+                                                  uint64_t * bits);
 
 /*!
  * \brief           Calculates a hash of a string.
@@ -77,52 +216,71 @@ Dict dict_create(const enum gds_datatype type, const int opts)
         }
     }
 
-    new_dict->num_buckets = BUCKETS;
+    new_dict->num_slots = INITIAL_SLOTS;
+    new_dict->num_keys = 0;
+    new_dict->num_used = 0;
     new_dict->type = type;
     new_dict->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
     new_dict->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
 
-    new_dict->buckets = malloc(sizeof *new_dict->buckets *
-                               new_dict->num_buckets);
-    if ( !new_dict->buckets ) {
-        if ( new_dict->exit_on_error ) {
-            quit_strerror("gds library", "memory allocation failed");
-        }
-        else {
-            log_strerror("gds library", "memory allocation failed");
+    new_dict->slots = dict_slots_create(new_dict, new_dict->num_slots);
+    if ( !new_dict->slots ) {
+        free(new_dict);
+        return NULL;
+    }
+
+    new_dict->num_blocks = 0;
+    new_dict->bloom = NULL;
+    if ( opts & GDS_BLOOM_FILTER ) {
+        const size_t num_blocks = new_dict->num_slots / BLOOM_SLOTS_PER_BLOCK;
+        new_dict->bloom = dict_bloom_create(new_dict, num_blocks);
+        if ( !new_dict->bloom ) {
+            free(new_dict->slots);
             free(new_dict);
             return NULL;
         }
+        new_dict->num_blocks = num_blocks;
     }
 
-    if ( !dict_buckets_create(new_dict) ) {
-        dict_buckets_destroy(new_dict);
-        free(new_dict->buckets);
-        free(new_dict);
-        return NULL;
-    }
-                                           
     return new_dict;
 }
 
 void dict_destroy(Dict dict)
 {
-    dict_buckets_destroy(dict);
-    free(dict->buckets);
+    for ( size_t i = 0; i < dict->num_slots; ++i ) {
+        struct gds_kvpair * pair = dict->slots[i].pair;
+        if ( pair && pair != DELETED ) {
+            gds_kvpair_destroy(pair, dict->free_on_destroy);
+        }
+    }
+
+    free(dict->bloom);
+    free(dict->slots);
     free(dict);
 }
 
 bool dict_has_key(Dict dict, const char * key)
 {
-    return dict_has_key_internal(dict, key, NULL);
+    return dict_find_slot(dict, key, djb2hash(key)) != NULL;
 }
 
 bool dict_insert(Dict dict, const char * key, ...)
 {
-    ListItr itr;
-    if ( dict_has_key_internal(dict, key, &itr) ) {
-        struct gds_kvpair * pair;
-        list_get_value_itr(itr, &pair);
+    va_list ap;
+    va_start(ap, key);
+    bool status = dict_insert_hashed(dict, key, djb2hash(key), ap);
+    va_end(ap);
+
+    return status;
+}
+
+bool dict_insert_hashed(Dict dict, const char * key,
+                        const size_t hash, va_list ap)
+{
+    struct dict_slot * slot = dict_find_slot(dict, key, hash);
+
+    if ( slot ) {
+        struct gds_kvpair * pair = slot->pair;
 
         if ( dict->free_on_destroy ) {
 
@@ -131,115 +289,418 @@ bool dict_insert(Dict dict, const char * key, ...)
             gdt_free(&pair->value);
         }
 
-        va_list ap;
-        va_start(ap, key);
         gdt_set_value(&pair->value, dict->type, NULL, ap);
-        va_end(ap);
+
+        return true;
     }
-    else {
-        va_list ap;
-        va_start(ap, key);
-        struct gds_kvpair * new_pair = gds_kvpair_create(key, dict->type, ap);
-        va_end(ap);
 
-        if ( !new_pair ) {
-            return false;
-        }
+    /*  Keep the table at most three-quarters full, counting deleted
+     *  slots, so that probe sequences always find an empty slot and
+     *  stay short.                                                    */
 
-        const size_t hash = djb2hash(key) % dict->num_buckets;
-        if ( !list_append(dict->buckets[hash], (void *) new_pair) ) {
-            gds_kvpair_destroy(new_pair, dict->free_on_destroy);
+    if ( (dict->num_used + 1) * 4 > dict->num_slots * 3 ) {
+        if ( !dict_rehash(dict) ) {
             return false;
         }
     }
 
+    struct gds_kvpair * new_pair = gds_kvpair_create(key, dict->type, ap);
+
+    if ( !new_pair ) {
+        return false;
+    }
+
+    /*  The key is known to be absent, so reuse the first deleted
+     *  or empty slot in its probe sequence.                       */
+
+    const size_t mask = dict->num_slots - 1;
+    size_t index = hash & mask;
+    while ( dict->slots[index].pair && dict->slots[index].pair != DELETED ) {
+        index = (index + 1) & mask;
+    }
+
+    if ( !dict->slots[index].pair ) {
+        dict->num_used += 1;
+    }
+
+    dict->slots[index].hash = hash;
+    dict->slots[index].pair = new_pair;
+    dict->num_keys += 1;
+
+    if ( dict->bloom ) {
+        dict_bloom_add(dict, hash);
+    }
+
     return true;
 }
 
 bool dict_value_for_key(Dict dict, const char * key, void * p)
 {
-    struct gds_kvpair * pair;
-    ListItr itr;
-    if ( !dict_has_key_internal(dict, key, &itr) ) {
+    return dict_value_for_key_hashed(dict, key, djb2hash(key), p);
+}
+
+bool dict_value_for_key_hashed(Dict dict, const char * key,
+                               const size_t hash, void * p)
+{
+    struct dict_slot * slot = dict_find_slot(dict, key, hash);
+    if ( !slot ) {
         return false;
     }
 
-    list_get_value_itr(itr, &pair);
-    gdt_get_value(&pair->value, p);
+    if ( p ) {
+        gdt_get_value(&slot->pair->value, p);
+    }
 
     return true;
 }
 
+size_t dict_lookup_many(Dict dict, const char * const * keys, const size_t n,
+                        void * out_values, bool * out_found)
+{
+    const size_t mask = dict->num_slots - 1;
+    const size_t value_size = gdt_size_of_type(dict->type);
+    char * values = out_values;
+    size_t num_found = 0;
+
+    for ( size_t base = 0; base < n; base += LOOKUP_BATCH ) {
+        const size_t count = (n - base < LOOKUP_BATCH) ?
+                             n - base : LOOKUP_BATCH;
+        size_t hashes[LOOKUP_BATCH];
+
+        /*  Stage one: hash every key in the batch and prefetch its
+         *  home slot, so all the slot misses are in flight at once.  */
+
+        for ( size_t i = 0; i < count; ++i ) {
+            hashes[i] = djb2hash(keys[base + i]);
+            DICT_PREFETCH(&dict->slots[hashes[i] & mask]);
+            if ( dict->bloom ) {
+                uint64_t bits;
+                DICT_PREFETCH(dict_bloom_block(dict, hashes[i], &bits));
+            }
+        }
+
+        /*  Stage two: the home slots should now be arriving, so
+         *  prefetch the pair in each one whose cached hash matches,
+         *  which holds the pointer to the key to be compared.        */
+
+        for ( size_t i = 0; i < count; ++i ) {
+            const struct dict_slot * slot = &dict->slots[hashes[i] & mask];
+            if ( slot->pair && slot->hash == hashes[i] ) {
+                DICT_PREFETCH(slot->pair);
+            }
+        }
+
+        /*  Stage three: the pairs should now be arriving, so prefetch
+         *  their keys, which are separate allocations, and which the
+         *  comparison below will touch.                                */
+
+        for ( size_t i = 0; i < count; ++i ) {
+            const struct dict_slot * slot = &dict->slots[hashes[i] & mask];
+            if ( slot->pair && slot->hash == hashes[i] ) {
+                DICT_PREFETCH(slot->pair->key);
+            }
+        }
+
+        /*  Stage four: probe and compare keys as normal.  */
+
+        for ( size_t i = 0; i < count; ++i ) {
+            const size_t k = base + i;
+            struct dict_slot * slot = dict_find_slot(dict, keys[k], hashes[i]);
+
+            if ( slot ) {
+                gdt_get_value(&slot->pair->value, values + k * value_size);
+                num_found += 1;
+            }
+
+            if ( out_found ) {
+                out_found[k] = slot ? true : false;
+            }
+        }
+    }
+
+    return num_found;
+}
+
 bool dict_delete(Dict dict, const char * key)
 {
-    ListItr itr;
-    if ( dict_has_key_internal(dict, key, &itr) ) {
-        KVPair pair;
-        list_get_value_itr(itr, &pair);
-        gds_kvpair_destroy(pair, dict->free_on_destroy);
-        list_delete_itr(itr);
-        return true;
+    return dict_delete_hashed(dict, key, djb2hash(key));
+}
+
+bool dict_delete_hashed(Dict dict, const char * key, const size_t hash)
+{
+    struct dict_slot * slot = dict_find_slot(dict, key, hash);
+    if ( !slot ) {
+        return false;
     }
-    return false;
+
+    dict_delete_slot(dict, slot);
+
+    return true;
 }
 
-static bool dict_buckets_create(Dict dict)
+DictItr dict_itr_first(Dict dict)
 {
-    for ( size_t i = 0; i < dict->num_buckets; ++i ) {
-        dict->buckets[i] = list_create(DATATYPE_POINTER, 0, gds_kvpair_compare);
-        if ( !dict->buckets[i] ) {
-            if ( dict->exit_on_error ) {
-                quit_strerror("gds library", "memory allocation failed");
-            }
-            else {
-                log_strerror("gds library", "memory allocation failed");
-                return false;
-            }
+    return dict_next_live_slot(dict, 0);
+}
+
+DictItr dict_itr_next(Dict dict, DictItr itr)
+{
+    return dict_next_live_slot(dict, (size_t) (itr - dict->slots) + 1);
+}
+
+const char * dict_itr_key(DictItr itr)
+{
+    return itr->pair->key;
+}
+
+void dict_itr_value(DictItr itr, void * p)
+{
+    gdt_get_value(&itr->pair->value, p);
+}
+
+DictItr dict_delete_itr(Dict dict, DictItr itr)
+{
+    dict_delete_slot(dict, itr);
+
+    return dict_itr_next(dict, itr);
+}
+
+bool dict_foreach(Dict dict, dict_foreach_func fn, void * ctx)
+{
+    const size_t value_size = gdt_size_of_type(dict->type);
+
+    for ( DictItr itr = dict_itr_first(dict); itr;
+          itr = dict_itr_next(dict, itr) ) {
+        struct gdt_generic_datatype value;
+        gdt_store_raw(&itr->pair->value, &value.data, value_size);
+
+        if ( !fn(itr->pair->key, &value.data, ctx) ) {
+            return false;
         }
     }
 
     return true;
 }
 
-static void dict_buckets_destroy(Dict dict)
+double dict_bloom_fp_rate(Dict dict)
 {
-    /*  If dict_buckets_create() failed, then the first pointer
-     *  in dict->buckets[] corresponding to a failed list
-     *  creation is set to NULL. Therefore loop over the total
-     *  number of buckets, or until we encounter NULL, whichever
-     *  comes first.                                              */
+    if ( !dict->bloom ) {
+        return 1.0;
+    }
 
-    for ( size_t i = 0; i < dict->num_buckets && dict->buckets[i]; ++i ) {
-        ListItr itr = list_itr_first(dict->buckets[i]);
-        while ( itr ) {
-            struct gds_kvpair * pair;
-            list_get_value_itr(itr, &pair);
-            gds_kvpair_destroy(pair, dict->free_on_destroy);
-            itr = list_itr_next(itr);
+    /*  An absent key passes only if all its bits are set, and all
+     *  its bits lie in one block, so average over the blocks.       */
+
+    double total = 0.0;
+    for ( size_t i = 0; i < dict->num_blocks; ++i ) {
+        size_t set = 0;
+        for ( size_t w = 0; w < BLOOM_BLOCK_WORDS; ++w ) {
+            for ( uint64_t word = dict->bloom[i].words[w]; word;
+                  word &= word - 1 ) {
+                set += 1;
+            }
+        }
+
+        double rate = 1.0;
+        for ( size_t k = 0; k < BLOOM_NUM_BITS; ++k ) {
+            rate *= (double) set / BLOOM_BLOCK_BITS;
         }
-        list_destroy(dict->buckets[i]);
+        total += rate;
     }
+
+    return total / dict->num_blocks;
 }
 
-static bool dict_has_key_internal(Dict dict, const char * key, ListItr * pitr)
+static struct dict_slot * dict_find_slot(Dict dict, const char * key,
+                                         const size_t hash)
 {
-    struct gds_kvpair needle = { .key = (char *) key };
-    const size_t hash = djb2hash(key) % dict->num_buckets;
-    List list = dict->buckets[hash];
-    ListItr itr;
+    if ( dict->bloom && !dict_bloom_test(dict, hash) ) {
+        return NULL;
+    }
+
+    const size_t mask = dict->num_slots - 1;
+    size_t index = hash & mask;
 
-    if ( (itr = list_find_itr(list, (void *) &needle)) ) {
-        if ( pitr ) {
-            *pitr = itr;
+    /*  The load factor guarantees at least one empty slot, so this
+     *  loop always terminates.                                       */
+
+    while ( dict->slots[index].pair ) {
+        struct dict_slot * slot = &dict->slots[index];
+        if ( slot->pair != DELETED && slot->hash == hash &&
+             !strcmp(slot->pair->key, key) ) {
+            return slot;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return NULL;
+}
+
+static struct dict_slot * dict_next_live_slot(Dict dict, size_t index)
+{
+    for ( ; index < dict->num_slots; ++index ) {
+        struct gds_kvpair * pair = dict->slots[index].pair;
+        if ( pair && pair != DELETED ) {
+            return &dict->slots[index];
         }
-        return true;
     }
-    else {
-        if ( pitr ) {
-            *pitr = NULL;
+
+    return NULL;
+}
+
+static void dict_delete_slot(Dict dict, struct dict_slot * slot)
+{
+    gds_kvpair_destroy(slot->pair, dict->free_on_destroy);
+    slot->pair = DELETED;
+    dict->num_keys -= 1;
+}
+
+static struct dict_slot * dict_slots_create(Dict dict, const size_t num_slots)
+{
+    struct dict_slot * slots = calloc(num_slots, sizeof *slots);
+    if ( !slots ) {
+        if ( dict->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
         }
+    }
+
+    return slots;
+}
+
+static bool dict_rehash(Dict dict)
+{
+    size_t new_num_slots = dict->num_slots;
+    if ( (dict->num_keys + 1) * 2 > dict->num_slots ) {
+        new_num_slots *= GROWTH;
+    }
+
+    struct dict_slot * new_slots = dict_slots_create(dict, new_num_slots);
+    if ( !new_slots ) {
         return false;
     }
+
+    /*  Rebuild the Bloom filter from the live keys, which both sizes
+     *  it for the new table and clears the bits of deleted keys.      */
+
+    struct dict_bloom_block * new_bloom = NULL;
+    const size_t new_num_blocks = dict->bloom ?
+                                  new_num_slots / BLOOM_SLOTS_PER_BLOCK : 0;
+    if ( dict->bloom ) {
+        new_bloom = dict_bloom_create(dict, new_num_blocks);
+        if ( !new_bloom ) {
+            free(new_slots);
+            return false;
+        }
+    }
+
+    const size_t mask = new_num_slots - 1;
+    for ( size_t i = 0; i < dict->num_slots; ++i ) {
+        const struct dict_slot * slot = &dict->slots[i];
+        if ( slot->pair && slot->pair != DELETED ) {
+            size_t index = slot->hash & mask;
+            while ( new_slots[index].pair ) {
+                index = (index + 1) & mask;
+            }
+            new_slots[index] = *slot;
+        }
+    }
+
+    free(dict->slots);
+    dict->slots = new_slots;
+    dict->num_slots = new_num_slots;
+    dict->num_used = dict->num_keys;
+
+    if ( new_bloom ) {
+        free(dict->bloom);
+        dict->bloom = new_bloom;
+        dict->num_blocks = new_num_blocks;
+        for ( size_t i = 0; i < new_num_slots; ++i ) {
+            if ( new_slots[i].pair ) {
+                dict_bloom_add(dict, new_slots[i].hash);
+            }
+        }
+    }
+
+    return true;
+}
+
+static struct dict_bloom_block * dict_bloom_create(Dict dict,
+                                                   const size_t num_blocks)
+{
+    const size_t size = num_blocks * sizeof(struct dict_bloom_block);
+    void * p;
+    if ( posix_memalign(&p, GDS_CACHE_LINE, size) ) {
+        if ( dict->exit_on_error ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    memset(p, 0, size);
+
+    return p;
+}
+
+static void dict_bloom_add(Dict dict, const size_t hash)
+{
+    uint64_t bits;
+    struct dict_bloom_block * block = dict_bloom_block(dict, hash, &bits);
+
+    for ( size_t k = 0; k < BLOOM_NUM_BITS; ++k, bits >>= 9 ) {
+        const unsigned int bit = bits & (BLOOM_BLOCK_BITS - 1);
+        block->words[bit / 64] |= (uint64_t) 1 << (bit % 64);
+    }
+}
+
+static bool dict_bloom_test(Dict dict, const size_t hash)
+{
+    uint64_t bits;
+    const struct dict_bloom_block * block = dict_bloom_block(dict, hash, &bits);
+
+    for ( size_t k = 0; k < BLOOM_NUM_BITS; ++k, bits >>= 9 ) {
+        const unsigned int bit = bits & (BLOOM_BLOCK_BITS - 1);
+        if ( !(block->words[bit / 64] & ((uint64_t) 1 << (bit % 64))) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static struct dict_bloom_block * dict_bloom_block(Dict dict,
+                                                  const size_t hash,
+                                                  uint64_t * bits)
+{
+    const uint64_t mix = (uint64_t) hash * 0x9E3779B97F4A7C15ULL;
+    *bits = (mix ^ (mix >> 31)) * 0xBF58476D1CE4E5B9ULL;
+
+    return &dict->bloom[(size_t) (mix >> 32) & (dict->num_blocks - 1)];
+}
+
+size_t dict_hash_key(const char * key)
+{
+    return djb2hash(key);
+}
+
+enum gds_datatype dict_datatype(Dict dict)
+{
+    return dict->type;
+}
+
+size_t dict_num_keys(Dict dict)
+{
+    return dict->num_keys;
+}
+
+bool dict_exit_on_error(Dict dict)
+{
+    return dict->exit_on_error;
 }
 
 static size_t djb2hash(const char * str)
@@ -0,0 +1,556 @@
+/*!
+ * \file            dict_mapped.c
+ * \brief           Implementation of memory-mapped dictionary snapshots.
+ * \details         An image consists of a fixed-size header, followed by an
+ * open-addressed hash table of slots, followed by the entries. Each slot
+ * holds the full hash of its key and the offset of its entry from the start
+ * of the file, or zero if it is empty. Each entry holds the lengths of its
+ * value and key, followed by the value and the null-terminated key. Entries
+ * start on eight-byte boundaries so that values are suitably aligned. The
+ * header records a checksum of everything which follows it.
+ *
+ * Opening an image checks only its header, so that a process touches just
+ * the pages its lookups need. Each entry is bounds-checked as a lookup
+ * reaches it, and the checksum is verified only on request.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/dict_internal.h>
+#include <pggds/dict_mapped.h>
+
+/*!  Magic number identifying an image  */
+static const char IMAGE_MAGIC[8] = { 'P', 'G', 'G', 'D', 'S', 'D', 'C', 'T' };
+
+/*!  Image format version  */
+#define IMAGE_VERSION 1
+
+/*!  Byte order tag, which reads differently on a machine of other order  */
+#define IMAGE_ENDIAN_TAG 0x01020304U
+
+/*!  Suffix template for the temporary file written by a save  */
+#define IMAGE_TMP_SUFFIX ".XXXXXX"
+
+/*!  Alignment of entries within an image  */
+#define IMAGE_ALIGN 8
+
+/*!  Image header structure  */
+struct image_header {
+    char magic[8];                  /*!<  Magic number                      */
+    uint32_t endian_tag;            /*!<  Byte order tag                    */
+    uint32_t version;               /*!<  Format version                    */
+    uint32_t hash_bits;             /*!<  Width of key hashes, in bits      */
+    uint32_t type;                  /*!<  Datatype of the dictionary        */
+    uint64_t value_size;    /*!<  Size of each value, or zero for strings   */
+    uint64_t num_slots;     /*!<  Number of slots, always a power of two    */
+    uint64_t num_keys;              /*!<  Number of keys                    */
+    uint64_t file_size;             /*!<  Total size of the image           */
+    uint64_t checksum;      /*!<  Checksum of everything after the header   */
+};
+
+/*!  Image slot structure  */
+struct image_slot {
+    uint64_t hash;                  /*!<  Full hash of the key              */
+    uint64_t offset;        /*!<  Offset of the entry, or zero if empty     */
+};
+
+/*!  Image entry header structure  */
+struct image_entry {
+    uint32_t value_len;             /*!<  Length of the value in bytes      */
+    uint32_t key_len;       /*!<  Length of the key, excluding terminator   */
+};
+
+/*!  Mapped dictionary structure  */
+struct dict_mapped {
+    const unsigned char * base;     /*!<  Start of the mapping              */
+    size_t size;                    /*!<  Size of the mapping               */
+    const struct image_slot * slots;    /*!<  The slots                     */
+    size_t data_start;              /*!<  Offset of the first entry         */
+    size_t num_slots;               /*!<  Number of slots                   */
+    size_t num_keys;                /*!<  Number of keys                    */
+    size_t value_size;      /*!<  Size of each value, or zero for strings   */
+    enum gds_datatype type;         /*!<  Dictionary datatype               */
+};
+
+/*!
+ * \brief           Reports a failure to save a dictionary.
+ * \param dict      A pointer to the dictionary being saved.
+ * \param msg       The message to report.
+ * \param use_errno True to report the error described by `errno`.
+ * \returns         `false`, unless the dictionary exits on error.
+ */
+static bool dict_save_error(Dict dict, const char * msg,
+                            const bool use_errno);
+
+/*!
+ * \brief           Updates an FNV-1a checksum with a block of bytes.
+ * \param sum       The checksum so far.
+ * \param data      A pointer to the bytes.
+ * \param len       The number of bytes.
+ * \returns         The updated checksum.
+ */
+static uint64_t image_checksum(uint64_t sum, const void * data,
+                               const size_t len);
+
+/*!
+ * \brief           Writes a block of bytes to an image file.
+ * \param fp        The file.
+ * \param data      A pointer to the bytes.
+ * \param len       The number of bytes.
+ * \param sum       A pointer to the checksum to update.
+ * \retval true     Success
+ * \retval false    Failure, the bytes could not be written.
+ */
+static bool image_write(FILE * fp, const void * data, const size_t len,
+                        uint64_t * sum);
+
+/*!
+ * \brief           Rounds an offset up to the entry alignment.
+ * \param n         The offset.
+ * \returns         The rounded offset.
+ */
+static uint64_t image_align(const uint64_t n);
+
+/*!
+ * \brief           Checks that an image's header and geometry are
+ * consistent.
+ * \details         This reads only the header, so that opening an image
+ * does not touch the rest of its pages.
+ * \param dict      A pointer to the mapped dictionary.
+ * \retval true     The header is valid.
+ * \retval false    The image is corrupt, or not for this machine.
+ */
+static bool image_check_header(DictMapped dict);
+
+/*!
+ * \brief           Returns the entry at an offset, if it is well-formed.
+ * \details         The entry, its key and its value must lie within the
+ * image, the key must be terminated, and the value must be the right
+ * size for the datatype.
+ * \param dict      A pointer to the mapped dictionary.
+ * \param offset    The offset of the entry from the start of the image.
+ * \retval NULL     The entry is corrupt.
+ * \retval non-NULL A pointer to the entry.
+ */
+static const struct image_entry * image_entry_at(DictMapped dict,
+                                                 const uint64_t offset);
+
+/*!
+ * \brief           Finds the entry for a key in a mapped dictionary.
+ * \param dict      A pointer to the mapped dictionary.
+ * \param key       The key for which to search.
+ * \retval NULL     The key was not found.
+ * \retval non-NULL A pointer to the entry.
+ */
+static const struct image_entry * image_find(DictMapped dict,
+                                             const char * key);
+
+bool dict_save(Dict dict, const char * path)
+{
+    const enum gds_datatype type = dict_datatype(dict);
+    if ( type == DATATYPE_GDSSTRING || type == DATATYPE_POINTER ) {
+        return dict_save_error(dict, "datatype cannot be saved", false);
+    }
+
+    const size_t num_keys = dict_num_keys(dict);
+    const size_t value_size = (type == DATATYPE_STRING) ?
+                              0 : gdt_size_of_type(type);
+
+    /*  Keep the table at most half full, so probes stay short
+     *  and always reach an empty slot.                         */
+
+    size_t num_slots = 1;
+    while ( num_slots < num_keys * 2 ) {
+        num_slots *= 2;
+    }
+
+    struct image_slot * slots = calloc(num_slots, sizeof *slots);
+    if ( !slots ) {
+        return dict_save_error(dict, "memory allocation failed", true);
+    }
+
+    /*  Lay out the entries, and place each in the table  */
+
+    const size_t mask = num_slots - 1;
+    uint64_t offset = sizeof(struct image_header) +
+                      num_slots * sizeof(struct image_slot);
+
+    for ( DictItr itr = dict_itr_first(dict); itr;
+          itr = dict_itr_next(dict, itr) ) {
+        const char * key = dict_itr_key(itr);
+        size_t value_len = value_size;
+        if ( type == DATATYPE_STRING ) {
+            char * str;
+            dict_itr_value(itr, &str);
+            value_len = strlen(str) + 1;
+        }
+
+        const size_t hash = dict_hash_key(key);
+        size_t index = hash & mask;
+        while ( slots[index].offset ) {
+            index = (index + 1) & mask;
+        }
+
+        slots[index].hash = hash;
+        slots[index].offset = offset;
+        offset = image_align(offset + sizeof(struct image_entry) +
+                             value_len + strlen(key) + 1);
+    }
+
+    /*  Write to a temporary file in the same directory and rename it
+     *  over the target, so processes which still map the old image
+     *  keep its inode, and a failed save leaves the old image intact.  */
+
+    char * tmp_path = malloc(strlen(path) + sizeof IMAGE_TMP_SUFFIX);
+    if ( !tmp_path ) {
+        free(slots);
+        return dict_save_error(dict, "memory allocation failed", true);
+    }
+    strcpy(tmp_path, path);
+    strcat(tmp_path, IMAGE_TMP_SUFFIX);
+
+    FILE * fp = NULL;
+    const int fd = mkstemp(tmp_path);
+    if ( fd != -1 ) {
+        struct stat st;
+        const mode_t mode = stat(path, &st) == 0 ? (st.st_mode & 07777) :
+                            (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if ( fchmod(fd, mode) == -1 || !(fp = fdopen(fd, "wb")) ) {
+            close(fd);
+            unlink(tmp_path);
+        }
+    }
+    if ( !fp ) {
+        free(tmp_path);
+        free(slots);
+        return dict_save_error(dict, "couldn't open file for writing", true);
+    }
+
+    /*  Write a blank header to reserve its space, then write
+     *  the slots and the entries in the order they were laid
+     *  out, and finally go back and fill in the header.        */
+
+    struct image_header header;
+    memset(&header, 0, sizeof header);
+    uint64_t sum = 0xcbf29ce484222325ULL;
+    bool ok = fwrite(&header, sizeof header, 1, fp) == 1 &&
+              image_write(fp, slots, num_slots * sizeof *slots, &sum);
+
+    static const char padding[IMAGE_ALIGN];
+    uint64_t written = sizeof(struct image_header) +
+                       num_slots * sizeof(struct image_slot);
+
+    for ( DictItr itr = dict_itr_first(dict); ok && itr;
+          itr = dict_itr_next(dict, itr) ) {
+        const char * key = dict_itr_key(itr);
+        struct gdt_generic_datatype value;
+        dict_itr_value(itr, &value.data);
+
+        const void * value_data = &value.data;
+        struct image_entry entry;
+        entry.key_len = strlen(key);
+        entry.value_len = value_size;
+        if ( type == DATATYPE_STRING ) {
+            value_data = value.data.pc;
+            entry.value_len = strlen(value.data.pc) + 1;
+        }
+
+        const uint64_t length = sizeof entry + entry.value_len +
+                                entry.key_len + 1;
+        ok = image_write(fp, &entry, sizeof entry, &sum) &&
+             image_write(fp, value_data, entry.value_len, &sum) &&
+             image_write(fp, key, entry.key_len + 1, &sum) &&
+             image_write(fp, padding, image_align(length) - length, &sum);
+        written += image_align(length);
+    }
+
+    free(slots);
+
+    memcpy(header.magic, IMAGE_MAGIC, sizeof header.magic);
+    header.endian_tag = IMAGE_ENDIAN_TAG;
+    header.version = IMAGE_VERSION;
+    header.hash_bits = sizeof(size_t) * 8;
+    header.type = type;
+    header.value_size = value_size;
+    header.num_slots = num_slots;
+    header.num_keys = num_keys;
+    header.file_size = written;
+    header.checksum = sum;
+
+    ok = ok && fseek(fp, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof header, 1, fp) == 1 &&
+         fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    ok = fclose(fp) == 0 && ok && rename(tmp_path, path) == 0;
+
+    if ( !ok ) {
+        const int saved_errno = errno;
+        unlink(tmp_path);
+        free(tmp_path);
+        errno = saved_errno;
+        return dict_save_error(dict, "couldn't write file", true);
+    }
+
+    free(tmp_path);
+    return true;
+}
+
+DictMapped dict_open_mapped(const char * path)
+{
+    const int fd = open(path, O_RDONLY);
+    if ( fd == -1 ) {
+        log_strerror("gds library", "couldn't open file");
+        return NULL;
+    }
+
+    struct stat st;
+    if ( fstat(fd, &st) == -1 ) {
+        log_strerror("gds library", "couldn't get file status");
+        close(fd);
+        return NULL;
+    }
+
+    if ( (size_t) st.st_size < sizeof(struct image_header) ) {
+        log_error("gds library", "file is not a dictionary image");
+        close(fd);
+        return NULL;
+    }
+
+    void * base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if ( base == MAP_FAILED ) {
+        log_strerror("gds library", "couldn't map file");
+        return NULL;
+    }
+
+    struct dict_mapped * new_dict = malloc(sizeof *new_dict);
+    if ( !new_dict ) {
+        log_strerror("gds library", "memory allocation failed");
+        munmap(base, st.st_size);
+        return NULL;
+    }
+
+    const struct image_header * header = base;
+    new_dict->base = base;
+    new_dict->size = st.st_size;
+    new_dict->slots = (const struct image_slot *) (header + 1);
+    new_dict->num_slots = header->num_slots;
+    new_dict->num_keys = header->num_keys;
+    new_dict->value_size = header->value_size;
+    new_dict->type = header->type;
+
+    new_dict->data_start = sizeof *header +
+                           new_dict->num_slots * sizeof(struct image_slot);
+
+    if ( !image_check_header(new_dict) ) {
+        log_error("gds library", "file is not a valid dictionary image");
+        dict_mapped_close(new_dict);
+        return NULL;
+    }
+
+    return new_dict;
+}
+
+void dict_mapped_close(DictMapped dict)
+{
+    munmap((void *) dict->base, dict->size);
+    free(dict);
+}
+
+bool dict_verify_mapped(DictMapped dict)
+{
+    const struct image_header * header = (const void *) dict->base;
+    if ( image_checksum(0xcbf29ce484222325ULL, dict->base + sizeof *header,
+                        dict->size - sizeof *header) != header->checksum ) {
+        return false;
+    }
+
+    size_t num_keys = 0;
+    for ( size_t i = 0; i < dict->num_slots; ++i ) {
+        const uint64_t offset = dict->slots[i].offset;
+        if ( offset ) {
+            if ( !image_entry_at(dict, offset) ) {
+                return false;
+            }
+            num_keys += 1;
+        }
+    }
+
+    return num_keys == dict->num_keys;
+}
+
+bool dict_mapped_has_key(DictMapped dict, const char * key)
+{
+    return image_find(dict, key) != NULL;
+}
+
+bool dict_mapped_value_for_key(DictMapped dict, const char * key, void * p)
+{
+    const struct image_entry * entry = image_find(dict, key);
+    if ( !entry ) {
+        return false;
+    }
+
+    const unsigned char * value = (const unsigned char *) (entry + 1);
+    if ( dict->type == DATATYPE_STRING ) {
+        const char * str = (const char *) value;
+        memcpy(p, &str, sizeof str);
+    }
+    else {
+        memcpy(p, value, dict->value_size);
+    }
+
+    return true;
+}
+
+size_t dict_mapped_size(DictMapped dict)
+{
+    return dict->num_keys;
+}
+
+enum gds_datatype dict_mapped_type(DictMapped dict)
+{
+    return dict->type;
+}
+
+static bool dict_save_error(Dict dict, const char * msg,
+                            const bool use_errno)
+{
+    if ( dict_exit_on_error(dict) ) {
+        if ( use_errno ) {
+            quit_strerror("gds library", msg);
+        }
+        else {
+            quit_error("gds library", msg);
+        }
+    }
+    else if ( use_errno ) {
+        log_strerror("gds library", msg);
+    }
+    else {
+        log_error("gds library", msg);
+    }
+
+    return false;
+}
+
+static uint64_t image_checksum(uint64_t sum, const void * data,
+                               const size_t len)
+{
+    const unsigned char * p = data;
+    for ( size_t i = 0; i < len; ++i ) {
+        sum = (sum ^ p[i]) * 0x100000001b3ULL;
+    }
+
+    return sum;
+}
+
+static bool image_write(FILE * fp, const void * data, const size_t len,
+                        uint64_t * sum)
+{
+    *sum = image_checksum(*sum, data, len);
+    return len == 0 || fwrite(data, len, 1, fp) == 1;
+}
+
+static uint64_t image_align(const uint64_t n)
+{
+    return (n + IMAGE_ALIGN - 1) & ~(uint64_t) (IMAGE_ALIGN - 1);
+}
+
+static bool image_check_header(DictMapped dict)
+{
+    const struct image_header * header = (const void *) dict->base;
+
+    if ( memcmp(header->magic, IMAGE_MAGIC, sizeof header->magic) ||
+         header->endian_tag != IMAGE_ENDIAN_TAG ||
+         header->version != IMAGE_VERSION ||
+         header->hash_bits != sizeof(size_t) * 8 ||
+         header->file_size != dict->size ) {
+        return false;
+    }
+
+    if ( header->type > DATATYPE_STRING ||
+         (header->type == DATATYPE_STRING && header->value_size != 0) ||
+         (header->type != DATATYPE_STRING &&
+          header->value_size != gdt_size_of_type(header->type)) ) {
+        return false;
+    }
+
+    /*  The slot count must be a power of two, large enough to leave
+     *  an empty slot, and the slots must fit within the file.         */
+
+    const uint64_t num_slots = header->num_slots;
+    return num_slots != 0 && (num_slots & (num_slots - 1)) == 0 &&
+           num_slots >= header->num_keys * 2 &&
+           num_slots <= (dict->size - sizeof *header) /
+                        sizeof(struct image_slot);
+}
+
+static const struct image_entry * image_entry_at(DictMapped dict,
+                                                 const uint64_t offset)
+{
+    if ( offset < dict->data_start || offset % IMAGE_ALIGN ||
+         offset > dict->size - sizeof(struct image_entry) ) {
+        return NULL;
+    }
+
+    const struct image_entry * entry = (const void *) (dict->base + offset);
+    const uint64_t end = offset + sizeof *entry +
+                         (uint64_t) entry->value_len + entry->key_len;
+    if ( end >= dict->size || dict->base[end] != '\0' ) {
+        return NULL;
+    }
+
+    const char * value = (const char *) (entry + 1);
+    if ( dict->type == DATATYPE_STRING ) {
+        if ( entry->value_len == 0 || value[entry->value_len - 1] != '\0' ) {
+            return NULL;
+        }
+    }
+    else if ( entry->value_len != dict->value_size ) {
+        return NULL;
+    }
+
+    return entry;
+}
+
+static const struct image_entry * image_find(DictMapped dict,
+                                             const char * key)
+{
+    const size_t hash = dict_hash_key(key);
+    const size_t mask = dict->num_slots - 1;
+    size_t index = hash & mask;
+
+    /*  The probe is bounded by the slot count in case a corrupt
+     *  image has no empty slot, and each entry is checked before
+     *  use, since the image is not verified when it is opened.    */
+
+    for ( size_t probes = 0; probes < dict->num_slots &&
+                             dict->slots[index].offset; ++probes ) {
+        const struct image_slot * slot = &dict->slots[index];
+        if ( slot->hash == hash ) {
+            const struct image_entry * entry = image_entry_at(dict,
+                                                              slot->offset);
+            if ( entry && !strcmp((const char *) (entry + 1) +
+                                  entry->value_len, key) ) {
+                return entry;
+            }
+        }
+        index = (index + 1) & mask;
+    }
+
+    return NULL;
+}
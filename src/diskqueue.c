@@ -0,0 +1,852 @@
+/*!
+ * \file            diskqueue.c
+ * \brief           Implementation of persistent disk-backed queue.
+ * \details         The header file holds the position of the front record,
+ * read by the consumer, and of the end of the last record, written by the
+ * producer. A position is a segment number, an offset within the segment,
+ * and the sequence number of the record there, which counts every record
+ * ever pushed. Each record starts on an eight-byte boundary with its
+ * sequence number, its size, and a checksum of both and of its data. When
+ * a record will not fit in the rest of a segment, an end-of-segment marker
+ * is written if there is room, and the record goes at the start of the
+ * next segment.
+ *
+ * Only the front and back segments are mapped. Once the front has moved
+ * past a segment and the header saying so has been synced, its file is
+ * renamed to become a spare, which is renamed back into place for the
+ * next new segment, so a queue whose consumer keeps up with its producer
+ * uses the same two files over and over. The sequence
+ * numbers mean stale records left in a reused file are never mistaken for
+ * new ones.
+ *
+ * To sync, the part of the back segment written since the last sync is
+ * flushed first, then the directory if files have been created or
+ * renamed, and then the header, so a synced header never refers to data
+ * which is not yet on disk. On opening, the records are walked from the
+ * front, following the segments, for as long as their sequence numbers
+ * and checksums are correct, which finds both records pushed after the
+ * header was last written, and the end of any records which were lost.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds/diskqueue.h>
+
+/*!  Magic number identifying a queue header  */
+static const uint64_t DISKQUEUE_MAGIC = 0x4555455551445047ULL;
+
+/*!  Queue format version  */
+#define DISKQUEUE_VERSION 1
+
+/*!  Alignment of records within a segment  */
+#define DISKQUEUE_ALIGN 8
+
+/*!  Record size which marks the end of a segment  */
+static const uint32_t DISKQUEUE_END_OF_SEGMENT = UINT32_MAX;
+
+/*!  Name of the header file  */
+static const char DISKQUEUE_HEADER_NAME[] = "queue.hdr";
+
+/*!  Name of the spare segment file  */
+static const char DISKQUEUE_SPARE_NAME[] = "spare.seg";
+
+/*!  Position in the queue structure  */
+struct diskqueue_position {
+    uint64_t segment;               /*!<  Segment number                    */
+    uint64_t offset;                /*!<  Offset within the segment         */
+    uint64_t sequence;              /*!<  Sequence number of the record     */
+};
+
+/*!  Queue header structure, mapped from the header file  */
+struct diskqueue_header {
+    uint64_t magic;                 /*!<  Magic number                      */
+    uint32_t version;               /*!<  Format version                    */
+    uint32_t reserved;              /*!<  Unused, always zero               */
+    uint64_t segment_size;          /*!<  Size of each segment file         */
+    struct diskqueue_position head;     /*!<  Position of front record      */
+    struct diskqueue_position tail;     /*!<  Position after last record    */
+};
+
+/*!  Record header structure, followed by the record data  */
+struct diskqueue_record {
+    uint64_t sequence;              /*!<  Sequence number                   */
+    uint32_t size;          /*!<  Size of data, or end-of-segment marker    */
+    uint32_t checksum;              /*!<  Checksum of record                */
+};
+
+/*!  Disk queue structure  */
+struct diskqueue {
+    struct diskqueue_header * header;   /*!<  Mapped header file            */
+    char * head_map;                /*!<  Mapped front segment              */
+    char * tail_map;                /*!<  Mapped back segment               */
+    char * dir;                     /*!<  Path of queue directory           */
+    char * path;                    /*!<  Buffer for file paths             */
+    size_t path_size;               /*!<  Size of path buffer               */
+    int dir_fd;                     /*!<  Open queue directory              */
+    size_t segment_size;            /*!<  Size of each segment file         */
+    size_t page_size;               /*!<  Size of a memory page             */
+    size_t tail_synced;     /*!<  Offset in back segment synced so far      */
+    size_t sync_interval;           /*!<  Changes between automatic syncs   */
+    size_t unsynced;                /*!<  Changes since last sync           */
+    size_t count;                   /*!<  Number of records                 */
+    uint64_t recycle_from;  /*!<  First consumed segment not yet recycled  */
+    bool has_spare;                 /*!<  True if a spare segment exists    */
+    bool dir_dirty;         /*!<  True if directory changed since sync      */
+    bool exit_on_error;             /*!<  Exit on error if true             */
+};
+
+/*!
+ * \brief           Private function to report an error.
+ * \param exit_on_error True to exit rather than return.
+ * \param msg       The error message.
+ * \param with_errno    True to include the description of `errno`.
+ */
+static void diskqueue_report(const bool exit_on_error, const char * msg,
+                             const bool with_errno);
+
+/*!
+ * \brief           Private function to release a partly opened queue.
+ * \param queue     A pointer to the queue, whose members are either
+ * valid or null.
+ */
+static void diskqueue_release(DiskQueue queue);
+
+/*!
+ * \brief           Private function to build the path of a file.
+ * \param queue     A pointer to the queue.
+ * \param name      The file name, or `NULL` for a segment file.
+ * \param segment   The segment number, if `name` is `NULL`.
+ * \returns         A pointer to the path, which is overwritten by the
+ * next call.
+ */
+static const char * diskqueue_path(DiskQueue queue, const char * name,
+                                   const uint64_t segment);
+
+/*!
+ * \brief           Private function to map a segment file.
+ * \param queue     A pointer to the queue.
+ * \param segment   The segment number.
+ * \param create    True to create the file, from the spare if there is
+ * one, if it does not exist. If false, a missing file is not an error.
+ * \retval NULL     Failure, the file does not exist or could not be mapped.
+ * \retval non-NULL A pointer to the mapped segment.
+ */
+static char * diskqueue_map_segment(DiskQueue queue, const uint64_t segment,
+                                    const bool create);
+
+/*!
+ * \brief           Private function to keep or remove a consumed segment.
+ * \param queue     A pointer to the queue.
+ * \param segment   The segment number.
+ */
+static void diskqueue_recycle_segment(DiskQueue queue,
+                                      const uint64_t segment);
+
+/*!
+ * \brief           Private function to calculate a record's checksum.
+ * \param record    A pointer to the record header.
+ * \param data      A pointer to the record data.
+ * \returns         The checksum.
+ */
+static uint32_t diskqueue_checksum(const struct diskqueue_record * record,
+                                   const void * data);
+
+/*!
+ * \brief           Private function to calculate the space a record uses.
+ * \param size      The size of the record data.
+ * \returns         The space used by the record and its header.
+ */
+static size_t diskqueue_record_span(const size_t size);
+
+/*!
+ * \brief           Private function to check for the end of a segment.
+ * \param queue     A pointer to the queue.
+ * \param map       A pointer to the mapped segment.
+ * \param pos       A pointer to a position in the segment.
+ * \retval true     The segment holds no more records after `pos`
+ * \retval false    The segment may hold a record at `pos`
+ */
+static bool diskqueue_at_segment_end(DiskQueue queue, const char * map,
+                                     const struct diskqueue_position * pos);
+
+/*!
+ * \brief           Private function to check a record is intact.
+ * \param queue     A pointer to the queue.
+ * \param map       A pointer to the mapped segment.
+ * \param pos       A pointer to the position of the record.
+ * \retval true     The record is intact
+ * \retval false    The record is stale, torn, or was never written
+ */
+static bool diskqueue_record_valid(DiskQueue queue, const char * map,
+                                   const struct diskqueue_position * pos);
+
+/*!
+ * \brief           Private function to recover records on opening.
+ * \details         Sets the back of the queue and the record count.
+ * \param queue     A pointer to the queue, with the front segment mapped.
+ * \retval true     Success
+ * \retval false    Failure, the back segment could not be mapped.
+ */
+static bool diskqueue_recover(DiskQueue queue);
+
+/*!
+ * \brief           Private function to move the front past used segments.
+ * \param queue     A pointer to the queue.
+ * \retval true     Success
+ * \retval false    Failure, the next segment could not be mapped.
+ */
+static bool diskqueue_advance_head(DiskQueue queue);
+
+/*!
+ * \brief           Private function to start a new back segment.
+ * \param queue     A pointer to the queue.
+ * \retval true     Success
+ * \retval false    Failure, the old segment could not be synced, or the
+ * new segment could not be created.
+ */
+static bool diskqueue_roll_tail(DiskQueue queue);
+
+/*!
+ * \brief           Private function to count a change towards a sync.
+ * \param queue     A pointer to the queue.
+ * \retval true     Success
+ * \retval false    Failure, an automatic sync failed.
+ */
+static bool diskqueue_note_change(DiskQueue queue);
+
+DiskQueue diskqueue_open(const char * dir, const size_t segment_size,
+                         const size_t sync_interval, const int opts)
+{
+    const bool exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    struct diskqueue * queue = calloc(1, sizeof *queue);
+    if ( !queue ) {
+        diskqueue_report(exit_on_error, "memory allocation failed", true);
+        return NULL;
+    }
+
+    queue->dir_fd = -1;
+    queue->sync_interval = sync_interval;
+    queue->exit_on_error = exit_on_error;
+    queue->page_size = sysconf(_SC_PAGESIZE);
+    queue->path_size = strlen(dir) + 32;
+    queue->dir = malloc(strlen(dir) + 1);
+    queue->path = malloc(queue->path_size);
+    if ( !queue->dir || !queue->path ) {
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "memory allocation failed", true);
+        return NULL;
+    }
+    strcpy(queue->dir, dir);
+
+    if ( mkdir(dir, 0700) == -1 && errno != EEXIST ) {
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "couldn't create directory", true);
+        return NULL;
+    }
+
+    queue->dir_fd = open(dir, O_RDONLY);
+    if ( queue->dir_fd == -1 ) {
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "couldn't open directory", true);
+        return NULL;
+    }
+
+    /*  Open the header, giving a new one the right size  */
+
+    const int fd = open(diskqueue_path(queue, DISKQUEUE_HEADER_NAME, 0),
+                        O_RDWR | O_CREAT, 0600);
+    struct stat st;
+    if ( fd == -1 || fstat(fd, &st) == -1 ||
+         (st.st_size == 0 &&
+          ftruncate(fd, sizeof(struct diskqueue_header)) == -1) ) {
+        if ( fd != -1 ) {
+            close(fd);
+        }
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "couldn't open header file", true);
+        return NULL;
+    }
+
+    if ( st.st_size != 0 &&
+         (size_t) st.st_size != sizeof(struct diskqueue_header) ) {
+        close(fd);
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "not a disk queue", false);
+        return NULL;
+    }
+
+    void * base = mmap(NULL, sizeof(struct diskqueue_header),
+                       PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if ( base == MAP_FAILED ) {
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "couldn't map header file", true);
+        return NULL;
+    }
+    queue->header = base;
+
+    /*  A header without its magic number was never finished, so it
+     *  is initialised afresh, and its magic number is written last.  */
+
+    struct diskqueue_header * header = queue->header;
+    const bool is_new = header->magic != DISKQUEUE_MAGIC;
+    if ( is_new ) {
+        memset(header, 0, sizeof *header);
+        header->version = DISKQUEUE_VERSION;
+        header->segment_size = (segment_size + queue->page_size - 1) /
+                               queue->page_size * queue->page_size;
+        if ( header->segment_size == 0 ) {
+            header->segment_size = queue->page_size;
+        }
+        header->magic = DISKQUEUE_MAGIC;
+        queue->dir_dirty = true;
+    }
+    else if ( header->version != DISKQUEUE_VERSION ||
+              header->segment_size < queue->page_size ||
+              header->segment_size % DISKQUEUE_ALIGN ||
+              header->head.segment > header->tail.segment ) {
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "not a valid disk queue", false);
+        return NULL;
+    }
+    queue->segment_size = header->segment_size;
+
+    /*  Keep a spare segment only if it is the right size, and
+     *  never for a new queue, whose sequence numbers restart.  */
+
+    const char * spare = diskqueue_path(queue, DISKQUEUE_SPARE_NAME, 0);
+    if ( stat(spare, &st) == 0 ) {
+        if ( !is_new && (size_t) st.st_size == queue->segment_size ) {
+            queue->has_spare = true;
+        }
+        else {
+            unlink(spare);
+        }
+    }
+
+    queue->head_map = diskqueue_map_segment(queue, header->head.segment,
+                                            is_new);
+    if ( !queue->head_map ) {
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "couldn't map front segment",
+                         false);
+        return NULL;
+    }
+
+    /*  Recovery may move the front on, but segments may only be
+     *  recycled up to the front recorded in the header on disk.  */
+
+    const uint64_t synced_head = header->head.segment;
+    if ( !diskqueue_recover(queue) ) {
+        diskqueue_release(queue);
+        diskqueue_report(exit_on_error, "couldn't map back segment", false);
+        return NULL;
+    }
+
+    /*  Finish recycling consumed segments, in case the last run
+     *  stopped between syncing the header and recycling the files.  */
+
+    queue->recycle_from = synced_head;
+    while ( queue->recycle_from > 0 &&
+            access(diskqueue_path(queue, NULL, queue->recycle_from - 1),
+                   F_OK) == 0 ) {
+        queue->recycle_from -= 1;
+    }
+    while ( queue->recycle_from < synced_head ) {
+        diskqueue_recycle_segment(queue, queue->recycle_from++);
+    }
+
+    if ( is_new && !diskqueue_sync(queue) ) {
+        diskqueue_release(queue);
+        return NULL;
+    }
+
+    return queue;
+}
+
+bool diskqueue_close(DiskQueue queue)
+{
+    const bool synced = diskqueue_sync(queue);
+    diskqueue_release(queue);
+    return synced;
+}
+
+bool diskqueue_push(DiskQueue queue, const void * data, const size_t size)
+{
+    const size_t span = diskqueue_record_span(size);
+    if ( size >= DISKQUEUE_END_OF_SEGMENT || span > queue->segment_size ) {
+        diskqueue_report(queue->exit_on_error,
+                         "record too large for segment", false);
+        return false;
+    }
+
+    struct diskqueue_position * tail = &queue->header->tail;
+    if ( tail->offset + span > queue->segment_size ) {
+        if ( !diskqueue_roll_tail(queue) ) {
+            return false;
+        }
+    }
+
+    struct diskqueue_record * record =
+        (struct diskqueue_record *) (queue->tail_map + tail->offset);
+    memcpy(record + 1, data, size);
+    record->sequence = tail->sequence;
+    record->size = size;
+    record->checksum = diskqueue_checksum(record, data);
+
+    tail->offset += span;
+    tail->sequence += 1;
+    queue->count += 1;
+
+    return diskqueue_note_change(queue);
+}
+
+bool diskqueue_front(DiskQueue queue, const void ** data, size_t * size)
+{
+    if ( queue->count == 0 ) {
+        diskqueue_report(queue->exit_on_error, "queue empty", false);
+        return false;
+    }
+
+    if ( !diskqueue_advance_head(queue) ) {
+        return false;
+    }
+
+    const struct diskqueue_record * record =
+        (const struct diskqueue_record *) (queue->head_map +
+                                           queue->header->head.offset);
+    *data = record + 1;
+    *size = record->size;
+
+    return true;
+}
+
+bool diskqueue_pop(DiskQueue queue)
+{
+    if ( queue->count == 0 ) {
+        diskqueue_report(queue->exit_on_error, "queue empty", false);
+        return false;
+    }
+
+    if ( !diskqueue_advance_head(queue) ) {
+        return false;
+    }
+
+    struct diskqueue_position * head = &queue->header->head;
+    const struct diskqueue_record * record =
+        (const struct diskqueue_record *) (queue->head_map + head->offset);
+    head->offset += diskqueue_record_span(record->size);
+    head->sequence += 1;
+    queue->count -= 1;
+
+    /*  Move on now, so a consumed segment is recycled at the next sync  */
+
+    if ( !diskqueue_advance_head(queue) ) {
+        return false;
+    }
+
+    return diskqueue_note_change(queue);
+}
+
+bool diskqueue_sync(DiskQueue queue)
+{
+    /*  Flush only the pages written since the last sync  */
+
+    const size_t start = queue->tail_synced / queue->page_size *
+                         queue->page_size;
+    const size_t end = queue->header->tail.offset;
+    if ( end > start &&
+         msync(queue->tail_map + start, end - start, MS_SYNC) == -1 ) {
+        diskqueue_report(queue->exit_on_error,
+                         "couldn't sync segment file", true);
+        return false;
+    }
+    queue->tail_synced = end;
+
+    if ( queue->dir_dirty ) {
+        if ( fsync(queue->dir_fd) == -1 ) {
+            diskqueue_report(queue->exit_on_error,
+                             "couldn't sync directory", true);
+            return false;
+        }
+        queue->dir_dirty = false;
+    }
+
+    if ( msync(queue->header, sizeof *queue->header, MS_SYNC) == -1 ) {
+        diskqueue_report(queue->exit_on_error,
+                         "couldn't sync header file", true);
+        return false;
+    }
+
+    /*  Only a synced header no longer refers to consumed segments, so
+     *  recycling them earlier could leave a header naming a missing
+     *  front segment after a crash. The directory changes are synced
+     *  next time, and if they are lost, opening the queue redoes them.  */
+
+    while ( queue->recycle_from < queue->header->head.segment ) {
+        diskqueue_recycle_segment(queue, queue->recycle_from++);
+    }
+
+    queue->unsynced = 0;
+
+    return true;
+}
+
+bool diskqueue_is_empty(DiskQueue queue)
+{
+    return queue->count == 0;
+}
+
+size_t diskqueue_size(DiskQueue queue)
+{
+    return queue->count;
+}
+
+static void diskqueue_report(const bool exit_on_error, const char * msg,
+                             const bool with_errno)
+{
+    if ( exit_on_error ) {
+        if ( with_errno ) {
+            quit_strerror("gds library", msg);
+        }
+        else {
+            quit_error("gds library", msg);
+        }
+    }
+    else if ( with_errno ) {
+        log_strerror("gds library", msg);
+    }
+    else {
+        log_error("gds library", msg);
+    }
+}
+
+static void diskqueue_release(DiskQueue queue)
+{
+    if ( queue->head_map ) {
+        munmap(queue->head_map, queue->segment_size);
+    }
+    if ( queue->tail_map ) {
+        munmap(queue->tail_map, queue->segment_size);
+    }
+    if ( queue->header ) {
+        munmap(queue->header, sizeof *queue->header);
+    }
+    if ( queue->dir_fd != -1 ) {
+        close(queue->dir_fd);
+    }
+
+    free(queue->path);
+    free(queue->dir);
+    free(queue);
+}
+
+static const char * diskqueue_path(DiskQueue queue, const char * name,
+                                   const uint64_t segment)
+{
+    if ( name ) {
+        snprintf(queue->path, queue->path_size, "%s/%s", queue->dir, name);
+    }
+    else {
+        snprintf(queue->path, queue->path_size, "%s/%016llx.seg",
+                 queue->dir, (unsigned long long) segment);
+    }
+
+    return queue->path;
+}
+
+static char * diskqueue_map_segment(DiskQueue queue, const uint64_t segment,
+                                    const bool create)
+{
+    int fd;
+    if ( create && queue->has_spare ) {
+        char * spare = malloc(queue->path_size);
+        if ( !spare ) {
+            diskqueue_report(queue->exit_on_error,
+                             "memory allocation failed", true);
+            return NULL;
+        }
+        strcpy(spare, diskqueue_path(queue, DISKQUEUE_SPARE_NAME, 0));
+        const int status = rename(spare,
+                                  diskqueue_path(queue, NULL, segment));
+        free(spare);
+        if ( status == -1 ) {
+            diskqueue_report(queue->exit_on_error,
+                             "couldn't reuse spare segment", true);
+            return NULL;
+        }
+
+        queue->has_spare = false;
+        queue->dir_dirty = true;
+        fd = open(queue->path, O_RDWR);
+    }
+    else if ( create ) {
+        /*  Empty any file left from an earlier queue before sizing it  */
+
+        fd = open(diskqueue_path(queue, NULL, segment), O_RDWR | O_CREAT,
+                  0600);
+        if ( fd != -1 && (ftruncate(fd, 0) == -1 ||
+                          ftruncate(fd, queue->segment_size) == -1) ) {
+            close(fd);
+            fd = -1;
+        }
+        queue->dir_dirty = true;
+    }
+    else {
+        fd = open(diskqueue_path(queue, NULL, segment), O_RDWR);
+        if ( fd == -1 && errno == ENOENT ) {
+            return NULL;
+        }
+    }
+
+    if ( fd == -1 ) {
+        diskqueue_report(queue->exit_on_error,
+                         "couldn't open segment file", true);
+        return NULL;
+    }
+
+    struct stat st;
+    if ( fstat(fd, &st) == -1 ||
+         (size_t) st.st_size != queue->segment_size ) {
+        close(fd);
+        diskqueue_report(queue->exit_on_error,
+                         "segment file has wrong size", false);
+        return NULL;
+    }
+
+    void * map = mmap(NULL, queue->segment_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if ( map == MAP_FAILED ) {
+        diskqueue_report(queue->exit_on_error,
+                         "couldn't map segment file", true);
+        return NULL;
+    }
+
+    return map;
+}
+
+static void diskqueue_recycle_segment(DiskQueue queue,
+                                      const uint64_t segment)
+{
+    char * old = malloc(queue->path_size);
+    if ( !old ) {
+        diskqueue_report(queue->exit_on_error,
+                         "memory allocation failed", true);
+        return;
+    }
+    strcpy(old, diskqueue_path(queue, NULL, segment));
+
+    /*  A failure here only leaves a stray file, so is not reported
+     *  to the caller, which has already moved past the segment.     */
+
+    if ( !queue->has_spare &&
+         rename(old, diskqueue_path(queue, DISKQUEUE_SPARE_NAME, 0)) == 0 ) {
+        queue->has_spare = true;
+    }
+    else if ( unlink(old) == -1 ) {
+        log_strerror("gds library", "couldn't remove segment file");
+    }
+
+    queue->dir_dirty = true;
+    free(old);
+}
+
+static uint32_t diskqueue_checksum(const struct diskqueue_record * record,
+                                   const void * data)
+{
+    /*  64-bit FNV-1a over the sequence number, size and data, folded  */
+
+    uint64_t sum = 0xcbf29ce484222325ULL;
+    const unsigned char * parts[3] = {
+        (const unsigned char *) &record->sequence,
+        (const unsigned char *) &record->size,
+        data
+    };
+    const size_t lengths[3] = {
+        sizeof record->sequence, sizeof record->size, record->size
+    };
+
+    for ( size_t p = 0; p < 3; ++p ) {
+        for ( size_t i = 0; i < lengths[p]; ++i ) {
+            sum ^= parts[p][i];
+            sum *= 0x100000001b3ULL;
+        }
+    }
+
+    return (uint32_t) (sum ^ (sum >> 32));
+}
+
+static size_t diskqueue_record_span(const size_t size)
+{
+    return sizeof(struct diskqueue_record) +
+           (size + DISKQUEUE_ALIGN - 1) / DISKQUEUE_ALIGN * DISKQUEUE_ALIGN;
+}
+
+static bool diskqueue_at_segment_end(DiskQueue queue, const char * map,
+                                     const struct diskqueue_position * pos)
+{
+    if ( pos->offset + sizeof(struct diskqueue_record) >
+         queue->segment_size ) {
+        return true;
+    }
+
+    const struct diskqueue_record * record =
+        (const struct diskqueue_record *) (map + pos->offset);
+    return record->size == DISKQUEUE_END_OF_SEGMENT &&
+           record->sequence == pos->sequence;
+}
+
+static bool diskqueue_record_valid(DiskQueue queue, const char * map,
+                                   const struct diskqueue_position * pos)
+{
+    const struct diskqueue_record * record =
+        (const struct diskqueue_record *) (map + pos->offset);
+
+    return record->sequence == pos->sequence &&
+           record->size <= queue->segment_size - pos->offset -
+                           sizeof *record &&
+           record->checksum == diskqueue_checksum(record, record + 1);
+}
+
+static bool diskqueue_recover(DiskQueue queue)
+{
+    struct diskqueue_position pos = queue->header->head;
+    char * map = queue->head_map;
+    size_t count = 0;
+
+    while ( true ) {
+        if ( diskqueue_at_segment_end(queue, map, &pos) ) {
+            char * next = diskqueue_map_segment(queue, pos.segment + 1,
+                                                false);
+            if ( !next ) {
+                break;
+            }
+
+            if ( map != queue->head_map ) {
+                munmap(map, queue->segment_size);
+            }
+            map = next;
+            pos.segment += 1;
+            pos.offset = 0;
+        }
+        else if ( diskqueue_record_valid(queue, map, &pos) ) {
+            const struct diskqueue_record * record =
+                (const struct diskqueue_record *) (map + pos.offset);
+            pos.offset += diskqueue_record_span(record->size);
+            pos.sequence += 1;
+            count += 1;
+        }
+        else {
+            break;
+        }
+    }
+
+    /*  The back segment is always mapped separately from the front  */
+
+    if ( map == queue->head_map ) {
+        map = diskqueue_map_segment(queue, pos.segment, false);
+        if ( !map ) {
+            return false;
+        }
+    }
+
+    queue->tail_map = map;
+    queue->header->tail = pos;
+    queue->tail_synced = pos.offset;
+    queue->count = count;
+
+    return diskqueue_advance_head(queue);
+}
+
+static bool diskqueue_advance_head(DiskQueue queue)
+{
+    struct diskqueue_header * header = queue->header;
+
+    while ( header->head.segment < header->tail.segment &&
+            diskqueue_at_segment_end(queue, queue->head_map,
+                                     &header->head) ) {
+        const uint64_t old = header->head.segment;
+        char * next = diskqueue_map_segment(queue, old + 1, false);
+        if ( !next ) {
+            diskqueue_report(queue->exit_on_error,
+                             "couldn't map next segment", false);
+            return false;
+        }
+
+        munmap(queue->head_map, queue->segment_size);
+        queue->head_map = next;
+        header->head.segment = old + 1;
+        header->head.offset = 0;
+    }
+
+    return true;
+}
+
+static bool diskqueue_roll_tail(DiskQueue queue)
+{
+    struct diskqueue_position * tail = &queue->header->tail;
+    size_t end = tail->offset;
+
+    if ( tail->offset + sizeof(struct diskqueue_record) <=
+         queue->segment_size ) {
+        struct diskqueue_record * marker =
+            (struct diskqueue_record *) (queue->tail_map + tail->offset);
+        marker->sequence = tail->sequence;
+        marker->size = DISKQUEUE_END_OF_SEGMENT;
+        marker->checksum = 0;
+        end += sizeof *marker;
+    }
+
+    /*  The old segment is unmapped, so flush everything written since
+     *  the last sync now, including the marker. Without the marker on
+     *  disk, recovery would stop at the end of this segment, and lose
+     *  records later synced in the next one.                           */
+
+    const size_t start = queue->tail_synced / queue->page_size *
+                         queue->page_size;
+    if ( end > queue->tail_synced &&
+         msync(queue->tail_map + start, end - start, MS_SYNC) == -1 ) {
+        diskqueue_report(queue->exit_on_error,
+                         "couldn't sync segment file", true);
+        return false;
+    }
+
+    char * next = diskqueue_map_segment(queue, tail->segment + 1, true);
+    if ( !next ) {
+        return false;
+    }
+
+    munmap(queue->tail_map, queue->segment_size);
+    queue->tail_map = next;
+    queue->tail_synced = 0;
+    tail->segment += 1;
+    tail->offset = 0;
+
+    return true;
+}
+
+static bool diskqueue_note_change(DiskQueue queue)
+{
+    queue->unsynced += 1;
+    if ( queue->sync_interval && queue->unsynced >= queue->sync_interval ) {
+        return diskqueue_sync(queue);
+    }
+
+    return true;
+}
@@ -0,0 +1,307 @@
+/*!
+ * \file            disruptor.c
+ * \brief           Implementation of broadcast ring buffer.
+ * \details         The producer keeps a count of entries claimed, which
+ * only it reads, and a cursor counting entries published, which the
+ * consumers read. Each consumer keeps a count of entries it has released,
+ * which the producer reads to find the slowest consumer, the gating
+ * sequence past which it may not write. Each of these counters sits on
+ * its own cache line, and each side keeps a cached copy of the last
+ * value it read of the other side's counters, so it only touches a
+ * shared cache line when it appears to have run out of entries or room.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/disruptor.h>
+
+/*!  Number of spins before a waiting thread starts yielding  */
+static const int SPINS_BEFORE_YIELD = 64;
+
+/*!  Consumer structure, padded to a cache line  */
+union disruptor_consumer {
+    struct {
+        size_t sequence;            /*!<  Count of entries released         */
+        size_t cached_cursor;       /*!<  Last cursor seen by consumer      */
+    } c;                                        /*!<  Consumer contents     */
+    char pad[GDS_CACHE_LINE];                   /*!<  Padding               */
+};
+
+/*!  Broadcast ring buffer structure  */
+struct disruptor {
+
+    /*!  Members written and read only by the producer  */
+    union {
+        struct {
+            size_t claimed;         /*!<  Count of entries claimed          */
+            size_t cached_gate;     /*!<  Last gating sequence seen         */
+        } p;                                    /*!<  Producer contents     */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } producer;
+
+    /*!  Members written by the producer and read by consumers  */
+    union {
+        struct {
+            size_t cursor;          /*!<  Count of entries published        */
+            bool closed;            /*!<  True if the producer has finished */
+        } p;                                    /*!<  Published contents    */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } published;
+
+    union disruptor_consumer * consumers;       /*!<  Consumers             */
+    char * entries;                 /*!<  Circular buffer of entries        */
+    size_t mask;                    /*!<  Capacity less one                 */
+    size_t entry_size;              /*!<  Size of each entry                */
+    size_t num_consumers;           /*!<  Number of consumers               */
+};
+
+/*!
+ * \brief           Finds the sequence of the slowest consumer.
+ * \param ring      A pointer to the ring buffer.
+ * \returns         The smallest count of entries released by a consumer.
+ */
+static size_t disruptor_gate(Disruptor ring);
+
+/*!
+ * \brief           Returns a consumer, checking the consumer number.
+ * \param ring      A pointer to the ring buffer.
+ * \param consumer  The consumer number.
+ * \returns         A pointer to the consumer.
+ */
+static union disruptor_consumer * disruptor_consumer_at(Disruptor ring,
+                                                       const size_t consumer);
+
+/*!
+ * \brief           Backs off while waiting for another thread.
+ * \param spins     A pointer to the number of times the caller has
+ * already backed off, which is incremented.
+ */
+static void disruptor_backoff(int * spins);
+
+Disruptor disruptor_create(const size_t capacity, const size_t entry_size,
+                           const size_t num_consumers, const int opts)
+{
+    if ( entry_size == 0 ) {
+        abort_error("gds library", "entry size must not be zero");
+    }
+    else if ( num_consumers == 0 ) {
+        abort_error("gds library", "ring buffer needs a consumer");
+    }
+
+    size_t actual_capacity = 2;
+    while ( actual_capacity < capacity ) {
+        actual_capacity *= 2;
+    }
+
+    void * p;
+    if ( posix_memalign(&p, GDS_CACHE_LINE, sizeof(struct disruptor)) ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+    struct disruptor * new_ring = p;
+
+    void * c = NULL, * e = NULL;
+    if ( posix_memalign(&c, GDS_CACHE_LINE,
+                        num_consumers * sizeof *new_ring->consumers) ||
+         posix_memalign(&e, GDS_CACHE_LINE,
+                        actual_capacity * entry_size) ) {
+        free(c);
+        free(new_ring);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_ring->consumers = c;
+    new_ring->entries = e;
+    for ( size_t i = 0; i < num_consumers; ++i ) {
+        new_ring->consumers[i].c.sequence = 0;
+        new_ring->consumers[i].c.cached_cursor = 0;
+    }
+
+    new_ring->producer.p.claimed = 0;
+    new_ring->producer.p.cached_gate = 0;
+    new_ring->published.p.cursor = 0;
+    new_ring->published.p.closed = false;
+    new_ring->mask = actual_capacity - 1;
+    new_ring->entry_size = entry_size;
+    new_ring->num_consumers = num_consumers;
+
+    return new_ring;
+}
+
+void disruptor_destroy(Disruptor ring)
+{
+    free(ring->entries);
+    free(ring->consumers);
+    free(ring);
+}
+
+bool disruptor_try_claim(Disruptor ring, const size_t n, size_t * first)
+{
+    if ( n > ring->mask + 1 ) {
+        abort_error("gds library", "claim exceeds ring capacity");
+    }
+
+    const size_t claimed = ring->producer.p.claimed;
+    const size_t end = claimed + n;
+
+    /*  The entries up to end overwrite those of the previous lap, which
+     *  every consumer must have released. Check the cached gate first,
+     *  and only read the consumers' cache lines if that is too far back.  */
+
+    if ( end - ring->producer.p.cached_gate > ring->mask + 1 ) {
+        ring->producer.p.cached_gate = disruptor_gate(ring);
+        if ( end - ring->producer.p.cached_gate > ring->mask + 1 ) {
+            return false;
+        }
+    }
+
+    *first = claimed;
+    ring->producer.p.claimed = end;
+
+    return true;
+}
+
+size_t disruptor_claim(Disruptor ring, const size_t n)
+{
+    size_t first;
+    int spins = 0;
+    while ( !disruptor_try_claim(ring, n, &first) ) {
+        disruptor_backoff(&spins);
+    }
+
+    return first;
+}
+
+void disruptor_publish(Disruptor ring, const size_t n)
+{
+    const size_t cursor = ring->published.p.cursor;
+    if ( ring->producer.p.claimed - cursor < n ) {
+        abort_error("gds library", "publishing unclaimed entries");
+    }
+
+    /*  Release ordering makes the entries visible before the cursor  */
+
+    __atomic_store_n(&ring->published.p.cursor, cursor + n,
+                     __ATOMIC_RELEASE);
+}
+
+void disruptor_close(Disruptor ring)
+{
+    __atomic_store_n(&ring->published.p.closed, true, __ATOMIC_RELEASE);
+}
+
+size_t disruptor_available(Disruptor ring, const size_t consumer,
+                           size_t * first)
+{
+    union disruptor_consumer * c = disruptor_consumer_at(ring, consumer);
+    const size_t sequence = c->c.sequence;
+
+    if ( c->c.cached_cursor == sequence ) {
+        c->c.cached_cursor = __atomic_load_n(&ring->published.p.cursor,
+                                             __ATOMIC_ACQUIRE);
+    }
+
+    *first = sequence;
+    return c->c.cached_cursor - sequence;
+}
+
+size_t disruptor_wait(Disruptor ring, const size_t consumer,
+                      size_t * first)
+{
+    int spins = 0;
+    while ( true ) {
+        const size_t n = disruptor_available(ring, consumer, first);
+        if ( n ) {
+            return n;
+        }
+
+        /*  The producer publishes its last entries before closing,
+         *  so look once more after seeing the ring closed.          */
+
+        if ( __atomic_load_n(&ring->published.p.closed, __ATOMIC_ACQUIRE) ) {
+            return disruptor_available(ring, consumer, first);
+        }
+
+        disruptor_backoff(&spins);
+    }
+}
+
+void disruptor_release(Disruptor ring, const size_t consumer,
+                       const size_t n)
+{
+    union disruptor_consumer * c = disruptor_consumer_at(ring, consumer);
+    const size_t sequence = c->c.sequence;
+    if ( c->c.cached_cursor - sequence < n ) {
+        abort_error("gds library", "releasing unavailable entries");
+    }
+
+    /*  Release ordering keeps the consumer's reads of the
+     *  entries before the producer may overwrite them.     */
+
+    __atomic_store_n(&c->c.sequence, sequence + n, __ATOMIC_RELEASE);
+}
+
+void * disruptor_entry(Disruptor ring, const size_t sequence)
+{
+    return ring->entries + (sequence & ring->mask) * ring->entry_size;
+}
+
+size_t disruptor_capacity(Disruptor ring)
+{
+    return ring->mask + 1;
+}
+
+static size_t disruptor_gate(Disruptor ring)
+{
+    size_t gate = __atomic_load_n(&ring->consumers[0].c.sequence,
+                                  __ATOMIC_ACQUIRE);
+    for ( size_t i = 1; i < ring->num_consumers; ++i ) {
+        const size_t sequence = __atomic_load_n(&ring->consumers[i].c.sequence,
+                                                __ATOMIC_ACQUIRE);
+        if ( sequence < gate ) {
+            gate = sequence;
+        }
+    }
+
+    return gate;
+}
+
+static union disruptor_consumer * disruptor_consumer_at(Disruptor ring,
+                                                       const size_t consumer)
+{
+    if ( consumer >= ring->num_consumers ) {
+        abort_error("gds library", "consumer number out of range");
+    }
+
+    return &ring->consumers[consumer];
+}
+
+static void disruptor_backoff(int * spins)
+{
+    if ( *spins < SPINS_BEFORE_YIELD ) {
+        *spins += 1;
+        gds_cpu_relax();
+    }
+    else {
+        sched_yield();
+    }
+}
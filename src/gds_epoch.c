@@ -0,0 +1,418 @@
+/*!
+ * \file            gds_epoch.c
+ * \brief           Implementation of epoch-based memory reclamation.
+ * \details         Each thread has a record on its own cache line, in
+ * which it announces the global epoch it observed on entering a critical
+ * section, or zero when it is outside one. A retired object is tagged with
+ * the global epoch at the time it was retired, and added to the retiring
+ * thread's list. The global epoch advances from `e` to `e + 1` only once
+ * every thread in a critical section has announced `e`, so once it has
+ * reached `e + 2`, every thread which was in a critical section when an
+ * object tagged `e` was retired has since left it, and the object is
+ * freed.
+ *
+ * The global epoch is only ever written by read-modify-write operations,
+ * and records are announced and checked with read-modify-write operations,
+ * so the ordering argument rests on release sequences rather than on
+ * fences. A thread which unlinks and retires an object reads the epoch
+ * with an atomic read-modify-write, which synchronizes with whichever
+ * thread next advances it, and a thread checking a record synchronizes
+ * with any later announcement in that record. A thread entering a critical
+ * section after an object's epoch has been passed, or after its record was
+ * checked, therefore sees the object already unlinked.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/gds_epoch.h>
+
+/*!  Initial capacity of a thread's list of retired objects  */
+static const size_t RETIRED_CAPACITY = 16;
+
+/*!  Growth factor for dynamic memory allocation  */
+static const size_t GROWTH = 2;
+
+/*!  Number of retirements between attempts to free objects  */
+static const size_t RECLAIM_INTERVAL = 64;
+
+/*!  Retired object structure  */
+struct gds_epoch_retired {
+    void * ptr;                     /*!<  Pointer to the object             */
+    void (*free_fn)(void *);        /*!<  Function to free the object       */
+    unsigned long epoch;            /*!<  Global epoch when retired         */
+};
+
+/*!
+ * \brief           Thread record structure.
+ * \details         Each record is padded to a cache line, so that threads
+ * announcing their epochs never write to a line shared with another
+ * thread. The list of retired objects is used only by the thread owning
+ * the record.
+ */
+union gds_epoch_record {
+    struct {
+        unsigned long epoch;    /*!<  Epoch observed, or zero if outside    */
+        unsigned int depth;     /*!<  Critical section nesting depth        */
+        bool in_use;            /*!<  True if owned by a live thread        */
+        union gds_epoch_record * next;  /*!<  Next record in list           */
+        struct gds_epoch_retired * retired; /*!<  Retired objects           */
+        size_t head;            /*!<  Index of oldest retired object        */
+        size_t count;           /*!<  Index after newest retired object     */
+        size_t capacity;        /*!<  Capacity of list of retired objects   */
+    } r;                                        /*!<  Record contents       */
+    char pad[GDS_CACHE_LINE];                   /*!<  Padding               */
+};
+
+/*!  Reclamation domain structure  */
+struct gds_epoch {
+    unsigned long epoch;                /*!<  Global epoch                  */
+    union gds_epoch_record * records;   /*!<  List of thread records        */
+    pthread_key_t key;                  /*!<  Key for this thread's record  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Returns the calling thread's record.
+ * \details         A record is created or reused on a thread's first
+ * use of a domain, and released when the thread exits.
+ * \param domain    A pointer to the domain.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the record.
+ */
+static union gds_epoch_record * gds_epoch_record_get(GDSEpoch domain);
+
+/*!
+ * \brief           Releases a thread record on thread exit.
+ * \details         Objects retired by the thread stay in the record, and
+ * are freed by the next thread to use it.
+ * \param p         A pointer to the record.
+ */
+static void gds_epoch_record_release(void * p);
+
+/*!
+ * \brief           Tries to advance the global epoch.
+ * \param domain    A pointer to the domain.
+ * \returns         The global epoch after the attempt.
+ */
+static unsigned long gds_epoch_advance(GDSEpoch domain);
+
+/*!
+ * \brief           Frees retired objects which no thread can be using.
+ * \details         A free function may itself retire objects.
+ * \param record    A pointer to the calling thread's record.
+ * \param epoch     The current global epoch.
+ * \returns         The number of objects freed.
+ */
+static size_t gds_epoch_free_retired(union gds_epoch_record * record,
+                                     const unsigned long epoch);
+
+GDSEpoch gds_epoch_create(const int opts)
+{
+    struct gds_epoch * new_domain = malloc(sizeof *new_domain);
+    if ( !new_domain ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_domain->epoch = 1;
+    new_domain->records = NULL;
+    new_domain->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    if ( pthread_key_create(&new_domain->key,
+                            gds_epoch_record_release) != 0 ) {
+        free(new_domain);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "couldn't create thread key");
+        }
+        else {
+            log_error("gds library", "couldn't create thread key");
+        }
+        return NULL;
+    }
+
+    return new_domain;
+}
+
+void gds_epoch_destroy(GDSEpoch domain)
+{
+    /*  Deleting the key first ensures no thread exit
+     *  destructor can touch a record after it is freed.  */
+
+    pthread_key_delete(domain->key);
+
+    union gds_epoch_record * record = domain->records;
+    while ( record ) {
+        union gds_epoch_record * next = record->r.next;
+        gds_epoch_free_retired(record, ULONG_MAX);
+        free(record->r.retired);
+        free(record);
+        record = next;
+    }
+
+    free(domain);
+}
+
+bool gds_epoch_enter(GDSEpoch domain)
+{
+    union gds_epoch_record * record = gds_epoch_record_get(domain);
+    if ( !record ) {
+        return false;
+    }
+
+    if ( record->r.depth++ == 0 ) {
+        const unsigned long epoch = __atomic_load_n(&domain->epoch,
+                                                    __ATOMIC_ACQUIRE);
+        __atomic_exchange_n(&record->r.epoch, epoch, __ATOMIC_ACQ_REL);
+    }
+
+    return true;
+}
+
+void gds_epoch_exit(GDSEpoch domain)
+{
+    union gds_epoch_record * record = pthread_getspecific(domain->key);
+    if ( !record || !record->r.depth ) {
+        abort_error("gds library", "exit without matching enter");
+    }
+
+    if ( --record->r.depth == 0 ) {
+        __atomic_store_n(&record->r.epoch, 0, __ATOMIC_RELEASE);
+    }
+}
+
+bool gds_epoch_retire(GDSEpoch domain, void * ptr, void (*free_fn)(void *))
+{
+    union gds_epoch_record * record = gds_epoch_record_get(domain);
+    if ( !record ) {
+        return false;
+    }
+
+    if ( record->r.count == record->r.capacity ) {
+        if ( record->r.head ) {
+            memmove(record->r.retired, record->r.retired + record->r.head,
+                    (record->r.count - record->r.head) *
+                    sizeof *record->r.retired);
+            record->r.count -= record->r.head;
+            record->r.head = 0;
+        }
+        else {
+            const size_t new_capacity = record->r.capacity ?
+                                        record->r.capacity * GROWTH :
+                                        RETIRED_CAPACITY;
+            struct gds_epoch_retired * new_retired;
+            new_retired = realloc(record->r.retired,
+                                  new_capacity * sizeof *new_retired);
+            if ( !new_retired ) {
+                if ( domain->exit_on_error ) {
+                    quit_strerror("gds library", "memory allocation failed");
+                }
+                else {
+                    log_strerror("gds library", "memory allocation failed");
+                    return false;
+                }
+            }
+            record->r.retired = new_retired;
+            record->r.capacity = new_capacity;
+        }
+    }
+
+    struct gds_epoch_retired * retired = record->r.retired +
+                                         record->r.count++;
+    retired->ptr = ptr;
+    retired->free_fn = free_fn ? free_fn : free;
+
+    /*  The read-modify-write orders the caller's unlinking of the
+     *  object before any later advance of the global epoch.        */
+
+    retired->epoch = __atomic_fetch_add(&domain->epoch, 0, __ATOMIC_ACQ_REL);
+
+    if ( record->r.count % RECLAIM_INTERVAL == 0 ) {
+        gds_epoch_free_retired(record, gds_epoch_advance(domain));
+    }
+
+    return true;
+}
+
+void gds_epoch_synchronize(GDSEpoch domain)
+{
+    union gds_epoch_record * record = pthread_getspecific(domain->key);
+    if ( record && record->r.depth ) {
+
+        /*  The epoch could never advance past this
+         *  thread's own announcement.               */
+
+        abort_error("gds library", "synchronize within critical section");
+    }
+
+    /*  As in gds_epoch_retire(), the read-modify-write orders the caller's
+     *  unlinking before the advances, so two advances are enough.          */
+
+    const unsigned long target = __atomic_fetch_add(&domain->epoch, 0,
+                                                    __ATOMIC_ACQ_REL) + 2;
+    unsigned long epoch;
+    while ( (epoch = gds_epoch_advance(domain)) < target ) {
+        sched_yield();
+    }
+
+    if ( record ) {
+        gds_epoch_free_retired(record, epoch);
+    }
+}
+
+size_t gds_epoch_reclaim(GDSEpoch domain)
+{
+    union gds_epoch_record * record = gds_epoch_record_get(domain);
+    if ( !record ) {
+        return 0;
+    }
+
+    return gds_epoch_free_retired(record, gds_epoch_advance(domain));
+}
+
+static union gds_epoch_record * gds_epoch_record_get(GDSEpoch domain)
+{
+    union gds_epoch_record * record = pthread_getspecific(domain->key);
+    if ( record ) {
+        return record;
+    }
+
+    /*  Try to reuse a record released by an exited thread  */
+
+    for ( record = __atomic_load_n(&domain->records, __ATOMIC_ACQUIRE);
+          record; record = record->r.next ) {
+        bool expected = false;
+        if ( __atomic_compare_exchange_n(&record->r.in_use, &expected, true,
+                                         false, __ATOMIC_ACQUIRE,
+                                         __ATOMIC_RELAXED) ) {
+            break;
+        }
+    }
+
+    if ( !record ) {
+        void * p;
+        if ( posix_memalign(&p, GDS_CACHE_LINE, sizeof *record) ) {
+            if ( domain->exit_on_error ) {
+                quit_error("gds library", "memory allocation failed");
+            }
+            else {
+                log_error("gds library", "memory allocation failed");
+            }
+            return NULL;
+        }
+
+        record = p;
+        record->r.epoch = 0;
+        record->r.depth = 0;
+        record->r.in_use = true;
+        record->r.retired = NULL;
+        record->r.head = 0;
+        record->r.count = 0;
+        record->r.capacity = 0;
+        record->r.next = __atomic_load_n(&domain->records, __ATOMIC_RELAXED);
+
+        while ( !__atomic_compare_exchange_n(&domain->records,
+                                             &record->r.next, record, true,
+                                             __ATOMIC_RELEASE,
+                                             __ATOMIC_RELAXED) ) {
+            /*  Empty  */
+        }
+
+        /*  A thread advancing the epoch may have loaded the list before
+         *  this record was added. This read-modify-write ensures that
+         *  either the next advance sees the record, or this thread sees
+         *  every object retired before that advance as already unlinked.  */
+
+        __atomic_fetch_add(&domain->epoch, 0, __ATOMIC_ACQ_REL);
+    }
+
+    /*  Once the record is in the list it is released on failure,
+     *  and can be reused by the next call.                         */
+
+    if ( pthread_setspecific(domain->key, record) != 0 ) {
+        gds_epoch_record_release(record);
+        if ( domain->exit_on_error ) {
+            quit_error("gds library", "couldn't set thread-specific data");
+        }
+        else {
+            log_error("gds library", "couldn't set thread-specific data");
+        }
+        return NULL;
+    }
+
+    return record;
+}
+
+static void gds_epoch_record_release(void * p)
+{
+    union gds_epoch_record * record = p;
+    record->r.depth = 0;
+    __atomic_store_n(&record->r.epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&record->r.in_use, false, __ATOMIC_RELEASE);
+}
+
+static unsigned long gds_epoch_advance(GDSEpoch domain)
+{
+    unsigned long epoch = __atomic_load_n(&domain->epoch, __ATOMIC_ACQUIRE);
+
+    /*  Checking a record with a read-modify-write, rather than a load,
+     *  makes any later announcement in it synchronize with this thread.  */
+
+    union gds_epoch_record * record = __atomic_load_n(&domain->records,
+                                                      __ATOMIC_ACQUIRE);
+    for ( ; record; record = record->r.next ) {
+        const unsigned long announced = __atomic_fetch_add(&record->r.epoch,
+                                                           0,
+                                                           __ATOMIC_ACQ_REL);
+        if ( announced && announced != epoch ) {
+            return epoch;
+        }
+    }
+
+    if ( __atomic_compare_exchange_n(&domain->epoch, &epoch, epoch + 1,
+                                     false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE) ) {
+        return epoch + 1;
+    }
+
+    /*  Another thread has already advanced the
+     *  epoch, and `epoch` now holds the newer value.  */
+
+    return epoch;
+}
+
+static size_t gds_epoch_free_retired(union gds_epoch_record * record,
+                                     const unsigned long epoch)
+{
+    size_t freed = 0;
+
+    while ( record->r.head < record->r.count &&
+            record->r.retired[record->r.head].epoch + 2 <= epoch ) {
+        struct gds_epoch_retired * retired = record->r.retired +
+                                             record->r.head++;
+        retired->free_fn(retired->ptr);
+        ++freed;
+    }
+
+    if ( record->r.head == record->r.count ) {
+        record->r.head = 0;
+        record->r.count = 0;
+    }
+
+    return freed;
+}
@@ -11,7 +11,26 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <pggds_internal/gds_common.h>
+#include <pggds/gds_string.h>
+
+/*!
+ * \brief           Mixes the bits of an integer into a hash value.
+ * \details         Uses the finalizer of the SplitMix64 generator, so that
+ * nearby integers give unrelated hashes.
+ * \param x         The integer.
+ * \returns         The hash value.
+ */
+static size_t gdt_hash_integer(uint64_t x);
+
+/*!
+ * \brief           Calculates a hash of a string.
+ * \details         Uses the 64-bit FNV-1a algorithm.
+ * \param str       A pointer to a string.
+ * \returns         The hash value.
+ */
+static size_t gdt_hash_string(const char * str);
 
 /*!
  * \brief           Compare function for char
@@ -145,78 +164,88 @@ static int gdt_compare_gds_str(const void * p1, const void * p2);
 
 void gdt_set_value(struct gdt_generic_datatype * data,
                    const enum gds_datatype type, gds_cfunc cfunc, va_list ap)
+{
+    va_list aq;
+    va_copy(aq, ap);
+    gdt_set_value_next(data, type, cfunc, &aq);
+    va_end(aq);
+}
+
+void gdt_set_value_next(struct gdt_generic_datatype * data,
+                        const enum gds_datatype type,
+                        gds_cfunc cfunc, va_list * ap)
 {
     data->type = type;
 
     switch ( type ) {
         case DATATYPE_CHAR:
             data->compfunc = gdt_compare_char;
-            data->data.c = (char) va_arg(ap, int);
+            data->data.c = (char) va_arg(*ap, int);
             break;
 
         case DATATYPE_SIGNED_CHAR:
             data->compfunc = gdt_compare_schar;
-            data->data.sc = (signed char) va_arg(ap, int);
+            data->data.sc = (signed char) va_arg(*ap, int);
             break;
 
         case DATATYPE_UNSIGNED_CHAR:
             data->compfunc = gdt_compare_uchar;
-            data->data.uc = (unsigned char) va_arg(ap, int);
+            data->data.uc = (unsigned char) va_arg(*ap, int);
             break;
 
         case DATATYPE_INT:
             data->compfunc = gdt_compare_int;
-            data->data.i = va_arg(ap, int);
+            data->data.i = va_arg(*ap, int);
             break;
 
         case DATATYPE_UNSIGNED_INT:
             data->compfunc = gdt_compare_uint;
-            data->data.ui = va_arg(ap, unsigned int);
+            data->data.ui = va_arg(*ap, unsigned int);
             break;
 
         case DATATYPE_LONG:
             data->compfunc = gdt_compare_long;
-            data->data.l = va_arg(ap, long);
+            data->data.l = va_arg(*ap, long);
             break;
 
         case DATATYPE_UNSIGNED_LONG:
             data->compfunc = gdt_compare_ulong;
-            data->data.ul = va_arg(ap, unsigned long);
+            data->data.ul = va_arg(*ap, unsigned long);
             break;
 
         case DATATYPE_LONG_LONG:
             data->compfunc = gdt_compare_longlong;
-            data->data.ll = va_arg(ap, long long);
+            data->data.ll = va_arg(*ap, long long);
             break;
 
         case DATATYPE_UNSIGNED_LONG_LONG:
             data->compfunc = gdt_compare_ulonglong;
-            data->data.ull = va_arg(ap, unsigned long long);
+            data->data.ull = va_arg(*ap, unsigned long long);
             break;
 
         case DATATYPE_SIZE_T:
             data->compfunc = gdt_compare_sizet;
-            data->data.st = va_arg(ap, size_t);
+            data->data.st = va_arg(*ap, size_t);
             break;
 
         case DATATYPE_DOUBLE:
             data->compfunc = gdt_compare_double;
-            data->data.d = va_arg(ap, double);
+            data->data.d = va_arg(*ap, double);
             break;
 
         case DATATYPE_STRING:
             data->compfunc = gdt_compare_string;
-            data->data.pc = va_arg(ap, char *);
+            data->data.pc = va_arg(*ap, char *);
             break;
 
         case DATATYPE_GDSSTRING:
             data->compfunc = gdt_compare_gds_str;
-            data->data.gdsstr = va_arg(ap, GDSString);
+            data->data.gdsstr = va_arg(*ap, GDSString);
             break;
 
         case DATATYPE_POINTER:
             data->compfunc = cfunc;
-            data->data.p = va_arg(ap, void *);
+            data->data.p = va_arg(*ap, void *);
             break;
 
         default:
@@ -290,6 +319,194 @@ void gdt_get_value(const struct gdt_generic_datatype * data, void * p)
     }
 }
 
+size_t gdt_size_of_type(const enum gds_datatype type)
+{
+    switch ( type ) {
+        case DATATYPE_CHAR:
+            return sizeof(char);
+
+        case DATATYPE_SIGNED_CHAR:
+            return sizeof(signed char);
+
+        case DATATYPE_UNSIGNED_CHAR:
+            return sizeof(unsigned char);
+
+        case DATATYPE_INT:
+            return sizeof(int);
+
+        case DATATYPE_UNSIGNED_INT:
+            return sizeof(unsigned int);
+
+        case DATATYPE_LONG:
+            return sizeof(long);
+
+        case DATATYPE_UNSIGNED_LONG:
+            return sizeof(unsigned long);
+
+        case DATATYPE_LONG_LONG:
+            return sizeof(long long);
+
+        case DATATYPE_UNSIGNED_LONG_LONG:
+            return sizeof(unsigned long long);
+
+        case DATATYPE_SIZE_T:
+            return sizeof(size_t);
+
+        case DATATYPE_DOUBLE:
+            return sizeof(double);
+
+        case DATATYPE_STRING:
+            return sizeof(char *);
+
+        case DATATYPE_GDSSTRING:
+            return sizeof(GDSString);
+
+        case DATATYPE_POINTER:
+            return sizeof(void *);
+
+        default:
+            abort_error("gds library", "unrecognized datatype");
+            break;
+    }
+
+    return 0;
+}
+
+void gdt_store_raw(const struct gdt_generic_datatype * data, void * p,
+                   const size_t size)
+{
+    memcpy(p, &data->data, size);
+}
+
+void gdt_load_raw(struct gdt_generic_datatype * data,
+                  const enum gds_datatype type, const void * p,
+                  const size_t size)
+{
+    data->type = type;
+    data->compfunc = NULL;
+    memcpy(&data->data, p, size);
+}
+
+gds_cfunc gdt_compfunc_for_type(const enum gds_datatype type,
+                                gds_cfunc cfunc)
+{
+    switch ( type ) {
+        case DATATYPE_CHAR:
+            return gdt_compare_char;
+
+        case DATATYPE_SIGNED_CHAR:
+            return gdt_compare_schar;
+
+        case DATATYPE_UNSIGNED_CHAR:
+            return gdt_compare_uchar;
+
+        case DATATYPE_INT:
+            return gdt_compare_int;
+
+        case DATATYPE_UNSIGNED_INT:
+            return gdt_compare_uint;
+
+        case DATATYPE_LONG:
+            return gdt_compare_long;
+
+        case DATATYPE_UNSIGNED_LONG:
+            return gdt_compare_ulong;
+
+        case DATATYPE_LONG_LONG:
+            return gdt_compare_longlong;
+
+        case DATATYPE_UNSIGNED_LONG_LONG:
+            return gdt_compare_ulonglong;
+
+        case DATATYPE_SIZE_T:
+            return gdt_compare_sizet;
+
+        case DATATYPE_DOUBLE:
+            return gdt_compare_double;
+
+        case DATATYPE_STRING:
+            return gdt_compare_string;
+
+        case DATATYPE_GDSSTRING:
+            return gdt_compare_gds_str;
+
+        case DATATYPE_POINTER:
+            return cfunc;
+
+        default:
+            abort_error("gds library", "unrecognized datatype");
+            break;
+    }
+
+    return NULL;
+}
+
+size_t gdt_hash(const struct gdt_generic_datatype * data, gds_hfunc hfunc)
+{
+    switch ( data->type ) {
+        case DATATYPE_CHAR:
+            return gdt_hash_integer(data->data.c);
+
+        case DATATYPE_SIGNED_CHAR:
+            return gdt_hash_integer(data->data.sc);
+
+        case DATATYPE_UNSIGNED_CHAR:
+            return gdt_hash_integer(data->data.uc);
+
+        case DATATYPE_INT:
+            return gdt_hash_integer(data->data.i);
+
+        case DATATYPE_UNSIGNED_INT:
+            return gdt_hash_integer(data->data.ui);
+
+        case DATATYPE_LONG:
+            return gdt_hash_integer(data->data.l);
+
+        case DATATYPE_UNSIGNED_LONG:
+            return gdt_hash_integer(data->data.ul);
+
+        case DATATYPE_LONG_LONG:
+            return gdt_hash_integer(data->data.ll);
+
+        case DATATYPE_UNSIGNED_LONG_LONG:
+            return gdt_hash_integer(data->data.ull);
+
+        case DATATYPE_SIZE_T:
+            return gdt_hash_integer(data->data.st);
+
+        case DATATYPE_DOUBLE:
+        {
+
+            /*  Positive and negative zero compare equal, so
+             *  must hash equally, but have different bits.   */
+
+            uint64_t bits = 0;
+            if ( data->data.d != 0.0 ) {
+                memcpy(&bits, &data->data.d, sizeof bits);
+            }
+            return gdt_hash_integer(bits);
+        }
+
+        case DATATYPE_STRING:
+            return gdt_hash_string(data->data.pc);
+
+        case DATATYPE_GDSSTRING:
+            return gdt_hash_string(gds_str_cstr(data->data.gdsstr));
+
+        case DATATYPE_POINTER:
+            if ( hfunc ) {
+                return hfunc(&data->data.p);
+            }
+            return gdt_hash_integer((uintptr_t) data->data.p);
+
+        default:
+            abort_error("gds library", "unrecognized datatype");
+            break;
+    }
+
+    return 0;
+}
+
 void gdt_free(struct gdt_generic_datatype * data)
 {
     /*  There's no functional reason to NULL the pointers after
@@ -576,3 +793,26 @@ static int gdt_compare_gds_str(const void * p1, const void * p2)
 
     return gds_str_compare(s1, s2);
 }
+
+static size_t gdt_hash_integer(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+
+    return (size_t) x;
+}
+
+static size_t gdt_hash_string(const char * str)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const unsigned char * p = (const unsigned char *) str;
+
+    while ( *p ) {
+        hash = (hash ^ *p++) * 0x100000001b3ULL;
+    }
+
+    return (size_t) hash;
+}
@@ -0,0 +1,258 @@
+/*!
+ * \file            lfstack.c
+ * \brief           Implementation of lock-free stack.
+ * \details         This is a Treiber stack. The values live in nodes taken
+ * from a fixed array, and each node holds the index of the node below it.
+ * A thread pushes by pointing a node at the current top and swinging the
+ * top to the new node with a compare-and-swap, and pops by swinging the
+ * top to the node below. Unused nodes are kept on a second Treiber stack,
+ * the free list, in the same way.
+ *
+ * A plain Treiber stack suffers from the ABA problem: a thread about to
+ * pop node A, with B below it, may be delayed while other threads pop A
+ * and B and push A back, after which its compare-and-swap succeeds and
+ * makes the popped B the top. Here each top is a 64-bit word holding a
+ * 32-bit node index and a 32-bit tag which is incremented by every
+ * successful compare-and-swap, so the delayed thread's compare-and-swap
+ * fails because the tag has changed, even though the index has not,
+ * unless a multiple of 2<sup>32</sup> operations have happened meanwhile.
+ * Nodes are never freed while the stack exists, so reading the link of
+ * a node which another thread has just popped is always safe.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/lfstack.h>
+
+/*!  Node index meaning no node  */
+static const uint32_t LFSTACK_NIL = UINT32_MAX;
+
+/*!  Stack node structure, followed by the value  */
+struct lfstack_node {
+    uint32_t next;                  /*!<  Index of node below, or NIL       */
+    uint32_t unused;                /*!<  Padding to align the value        */
+};
+
+/*!  Tagged top of stack, padded to a cache line  */
+union lfstack_top {
+    uint64_t word;                  /*!<  Tag in high half, index in low    */
+    char pad[GDS_CACHE_LINE];                   /*!<  Padding               */
+};
+
+/*!  Lock-free stack structure  */
+struct lfstack {
+    union lfstack_top top;          /*!<  Top of stack of values            */
+    union lfstack_top free;         /*!<  Top of free list                  */
+    char * nodes;                   /*!<  Array of nodes                    */
+    size_t node_size;               /*!<  Size of each node                 */
+    size_t capacity;                /*!<  Number of nodes                   */
+    size_t value_size;              /*!<  Size of each value                */
+    enum gds_datatype type;         /*!<  Stack datatype                    */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+};
+
+/*!
+ * \brief           Returns a pointer to a node.
+ * \param stack     A pointer to the stack.
+ * \param index     The index of the node.
+ * \returns         A pointer to the node.
+ */
+static struct lfstack_node * lfstack_node_at(LFStack stack,
+                                             const uint32_t index);
+
+/*!
+ * \brief           Pushes a node onto a tagged stack.
+ * \param stack     A pointer to the stack owning the nodes.
+ * \param top       A pointer to the top of the tagged stack.
+ * \param index     The index of the node, which the caller owns.
+ */
+static void lfstack_push_node(LFStack stack, union lfstack_top * top,
+                              const uint32_t index);
+
+/*!
+ * \brief           Pops a node from a tagged stack.
+ * \param stack     A pointer to the stack owning the nodes.
+ * \param top       A pointer to the top of the tagged stack.
+ * \returns         The index of the node, which the caller then owns,
+ * or `LFSTACK_NIL` if the tagged stack was empty.
+ */
+static uint32_t lfstack_pop_node(LFStack stack, union lfstack_top * top);
+
+LFStack lfstack_create(const size_t capacity, const enum gds_datatype type,
+                       const int opts)
+{
+    if ( capacity >= LFSTACK_NIL ) {
+        abort_error("gds library", "lock-free stack capacity too large");
+    }
+
+    void * p;
+    if ( posix_memalign(&p, GDS_CACHE_LINE, sizeof(struct lfstack)) ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    struct lfstack * new_stack = p;
+    new_stack->value_size = gdt_size_of_type(type);
+    new_stack->node_size = sizeof(struct lfstack_node) +
+                           (new_stack->value_size + 7) / 8 * 8;
+    new_stack->nodes = malloc(capacity * new_stack->node_size);
+    if ( !new_stack->nodes && capacity ) {
+        free(new_stack);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    /*  Every node starts on the free list, linked in index order  */
+
+    for ( size_t i = 0; i < capacity; ++i ) {
+        lfstack_node_at(new_stack, i)->next = i + 1 < capacity ?
+                                              (uint32_t) (i + 1) :
+                                              LFSTACK_NIL;
+    }
+
+    new_stack->top.word = LFSTACK_NIL;
+    new_stack->free.word = capacity ? 0 : LFSTACK_NIL;
+    new_stack->capacity = capacity;
+    new_stack->type = type;
+    new_stack->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+
+    return new_stack;
+}
+
+void lfstack_destroy(LFStack stack)
+{
+    if ( stack->free_on_destroy ) {
+        struct gdt_generic_datatype value;
+
+        uint32_t index = (uint32_t) stack->top.word;
+        while ( index != LFSTACK_NIL ) {
+            struct lfstack_node * node = lfstack_node_at(stack, index);
+            gdt_load_raw(&value, stack->type, node + 1, stack->value_size);
+            gdt_free(&value);
+            index = node->next;
+        }
+    }
+
+    free(stack->nodes);
+    free(stack);
+}
+
+bool lfstack_push(LFStack stack, ...)
+{
+    const uint32_t index = lfstack_pop_node(stack, &stack->free);
+    if ( index == LFSTACK_NIL ) {
+        return false;
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, stack);
+    gdt_set_value(&value, stack->type, NULL, ap);
+    va_end(ap);
+
+    gdt_store_raw(&value, lfstack_node_at(stack, index) + 1,
+                  stack->value_size);
+    lfstack_push_node(stack, &stack->top, index);
+
+    return true;
+}
+
+bool lfstack_pop(LFStack stack, void * p)
+{
+    const uint32_t index = lfstack_pop_node(stack, &stack->top);
+    if ( index == LFSTACK_NIL ) {
+        return false;
+    }
+
+    memcpy(p, lfstack_node_at(stack, index) + 1, stack->value_size);
+    lfstack_push_node(stack, &stack->free, index);
+
+    return true;
+}
+
+bool lfstack_is_empty(LFStack stack)
+{
+    const uint64_t top = __atomic_load_n(&stack->top.word, __ATOMIC_RELAXED);
+    return (uint32_t) top == LFSTACK_NIL;
+}
+
+size_t lfstack_capacity(LFStack stack)
+{
+    return stack->capacity;
+}
+
+static struct lfstack_node * lfstack_node_at(LFStack stack,
+                                             const uint32_t index)
+{
+    return (struct lfstack_node *) (stack->nodes +
+                                    (size_t) index * stack->node_size);
+}
+
+static void lfstack_push_node(LFStack stack, union lfstack_top * top,
+                              const uint32_t index)
+{
+    struct lfstack_node * node = lfstack_node_at(stack, index);
+    uint64_t old = __atomic_load_n(&top->word, __ATOMIC_RELAXED);
+    uint64_t new_top;
+
+    do {
+
+        /*  Another thread may read the link at any time after
+         *  popping this node before, so it is written atomically.  */
+
+        __atomic_store_n(&node->next, (uint32_t) old, __ATOMIC_RELAXED);
+        new_top = ((old >> 32) + 1) << 32 | index;
+
+        /*  Release ordering publishes the node's value and link  */
+
+    } while ( !__atomic_compare_exchange_n(&top->word, &old, new_top, true,
+                                           __ATOMIC_RELEASE,
+                                           __ATOMIC_RELAXED) );
+}
+
+static uint32_t lfstack_pop_node(LFStack stack, union lfstack_top * top)
+{
+    uint64_t old = __atomic_load_n(&top->word, __ATOMIC_ACQUIRE);
+    uint64_t new_top;
+
+    do {
+        const uint32_t index = (uint32_t) old;
+        if ( index == LFSTACK_NIL ) {
+            return LFSTACK_NIL;
+        }
+
+        /*  The node may be popped and reused by another thread before
+         *  the compare-and-swap, in which case the link read here is
+         *  stale, but the tag will have changed and the swap fails.    */
+
+        const uint32_t next = __atomic_load_n(&lfstack_node_at(stack,
+                                                                index)->next,
+                                              __ATOMIC_RELAXED);
+        new_top = ((old >> 32) + 1) << 32 | next;
+
+    } while ( !__atomic_compare_exchange_n(&top->word, &old, new_top, true,
+                                           __ATOMIC_ACQUIRE,
+                                           __ATOMIC_ACQUIRE) );
+
+    return (uint32_t) old;
+}
@@ -0,0 +1,442 @@
+/*!
+ * \file            lrucache.c
+ * \brief           Implementation of generic LRU cache data structure.
+ * \details         The entries are allocated as a single array when the
+ * cache is created. Each entry holds its key, its value, its cached hash
+ * and its links in the recency list, so promoting or evicting a key
+ * touches only the entry and its neighbours. The entries are indexed by an
+ * open-addressed hash table with linear probing, sized so that it is never
+ * more than half full and never needs to grow. Deleted slots are filled by
+ * shifting back later entries in the same probe run, so the table never
+ * accumulates deleted slot markers.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/dict_internal.h>
+#include <pggds/lrucache.h>
+
+/*!  LRU cache entry structure  */
+struct lru_entry {
+    size_t hash;                    /*!<  Full hash of the key              */
+    char * key;                     /*!<  The key                           */
+    size_t key_size;                /*!<  Bytes allocated for the key       */
+    struct gdt_generic_datatype value;      /*!<  The value                 */
+    struct lru_entry * prev;        /*!<  Next more recently used entry     */
+    struct lru_entry * next;        /*!<  Next less recently used entry     */
+};
+
+/*!  LRU cache hash table slot structure  */
+struct lru_slot {
+    size_t hash;                    /*!<  Full hash of the key              */
+    struct lru_entry * entry;       /*!<  The entry, or NULL if empty       */
+};
+
+/*!  LRU cache structure  */
+struct lrucache {
+    size_t capacity;                /*!<  Maximum number of keys            */
+    size_t size;                    /*!<  Number of keys                    */
+    size_t num_slots;       /*!<  Number of slots, always a power of two    */
+    struct lru_slot * slots;        /*!<  The hash table slots              */
+    struct lru_entry * entries;     /*!<  The entries                       */
+    struct lru_entry * unused;      /*!<  List of unused entries            */
+    struct lru_entry * mru;         /*!<  Most recently used entry          */
+    struct lru_entry * lru;         /*!<  Least recently used entry         */
+    size_t hits;                    /*!<  Number of lookup hits             */
+    size_t misses;                  /*!<  Number of lookup misses           */
+    lrucache_evict_func evict;      /*!<  Eviction function                 */
+    void * evict_ctx;               /*!<  Eviction function context         */
+    enum gds_datatype type;         /*!<  Cache datatype                    */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Finds the slot containing a key.
+ * \param cache     A pointer to the cache.
+ * \param key       The key for which to search.
+ * \param hash      The hash of the key.
+ * \returns         The index of the slot containing the key, or of the
+ * empty slot at which the search stopped if the key is not in the cache.
+ */
+static size_t lrucache_find_slot(LRUCache cache, const char * key,
+                                 const size_t hash);
+
+/*!
+ * \brief           Empties a slot in the hash table.
+ * \details         Later entries in the same probe run are shifted back
+ * to fill the gap.
+ * \param cache     A pointer to the cache.
+ * \param index     The index of the slot to empty.
+ */
+static void lrucache_remove_slot(LRUCache cache, size_t index);
+
+/*!
+ * \brief           Unlinks an entry from the recency list.
+ * \param cache     A pointer to the cache.
+ * \param entry     A pointer to the entry.
+ */
+static void lrucache_unlink(LRUCache cache, struct lru_entry * entry);
+
+/*!
+ * \brief           Links an entry at the most recently used end of the list.
+ * \param cache     A pointer to the cache.
+ * \param entry     A pointer to the entry.
+ */
+static void lrucache_link_front(LRUCache cache, struct lru_entry * entry);
+
+/*!
+ * \brief           Removes the least recently used entry to make room.
+ * \details         The entry's key buffer is kept, so that it may be
+ * reused by the next key if it is large enough.
+ * \param cache     A pointer to the cache.
+ * \returns         A pointer to the now unused entry.
+ */
+static struct lru_entry * lrucache_evict(LRUCache cache);
+
+LRUCache lrucache_create(const size_t capacity,
+                         const enum gds_datatype type,
+                         const int opts)
+{
+    if ( capacity == 0 ) {
+        abort_error("gds library", "LRU cache capacity must be non-zero");
+    }
+
+    struct lrucache * new_cache = malloc(sizeof *new_cache);
+    if ( !new_cache ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    /*  Keep the table at most half full  */
+
+    size_t num_slots = 1;
+    while ( num_slots < capacity * 2 ) {
+        num_slots *= 2;
+    }
+
+    new_cache->slots = calloc(num_slots, sizeof *new_cache->slots);
+    new_cache->entries = malloc(capacity * sizeof *new_cache->entries);
+    if ( !new_cache->slots || !new_cache->entries ) {
+        free(new_cache->slots);
+        free(new_cache->entries);
+        free(new_cache);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+        }
+        return NULL;
+    }
+
+    /*  Thread every entry onto the unused list  */
+
+    for ( size_t i = 0; i < capacity; ++i ) {
+        new_cache->entries[i].key = NULL;
+        new_cache->entries[i].key_size = 0;
+        new_cache->entries[i].next = (i + 1 < capacity) ?
+                                     &new_cache->entries[i + 1] : NULL;
+    }
+
+    new_cache->capacity = capacity;
+    new_cache->size = 0;
+    new_cache->num_slots = num_slots;
+    new_cache->unused = new_cache->entries;
+    new_cache->mru = NULL;
+    new_cache->lru = NULL;
+    new_cache->hits = 0;
+    new_cache->misses = 0;
+    new_cache->evict = NULL;
+    new_cache->evict_ctx = NULL;
+    new_cache->type = type;
+    new_cache->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_cache->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    return new_cache;
+}
+
+void lrucache_destroy(LRUCache cache)
+{
+    for ( size_t i = 0; i < cache->capacity; ++i ) {
+        free(cache->entries[i].key);
+    }
+
+    if ( cache->free_on_destroy ) {
+        for ( struct lru_entry * entry = cache->mru; entry;
+              entry = entry->next ) {
+            gdt_free(&entry->value);
+        }
+    }
+
+    free(cache->entries);
+    free(cache->slots);
+    free(cache);
+}
+
+void lrucache_set_evict_func(LRUCache cache, lrucache_evict_func fn,
+                             void * ctx)
+{
+    cache->evict = fn;
+    cache->evict_ctx = ctx;
+}
+
+bool lrucache_put(LRUCache cache, const char * key, ...)
+{
+    const size_t hash = dict_hash_key(key);
+    size_t index = lrucache_find_slot(cache, key, hash);
+    struct lru_entry * entry = cache->slots[index].entry;
+
+    va_list ap;
+    va_start(ap, key);
+
+    if ( entry ) {
+        if ( cache->free_on_destroy ) {
+            gdt_free(&entry->value);
+        }
+        gdt_set_value(&entry->value, cache->type, NULL, ap);
+        va_end(ap);
+
+        if ( entry != cache->mru ) {
+            lrucache_unlink(cache, entry);
+            lrucache_link_front(cache, entry);
+        }
+
+        return true;
+    }
+
+    /*  Take an unused entry, or else the least recently used one,
+     *  and grow its key buffer before evicting anything, so that a
+     *  failed put leaves the cache unchanged. Growing the buffer
+     *  keeps its contents, so the entry remains valid until evicted.  */
+
+    entry = cache->unused ? cache->unused : cache->lru;
+
+    const size_t key_size = strlen(key) + 1;
+    if ( entry->key_size < key_size ) {
+        char * new_key = realloc(entry->key, key_size);
+        if ( !new_key ) {
+            va_end(ap);
+            if ( cache->exit_on_error ) {
+                quit_strerror("gds library", "memory allocation failed");
+            }
+            else {
+                log_strerror("gds library", "memory allocation failed");
+                return false;
+            }
+        }
+        entry->key = new_key;
+        entry->key_size = key_size;
+    }
+
+    if ( cache->unused ) {
+        cache->unused = entry->next;
+    }
+    else {
+        lrucache_evict(cache);
+
+        /*  Eviction may have shifted entries into the empty slot  */
+
+        index = lrucache_find_slot(cache, key, hash);
+    }
+
+    memcpy(entry->key, key, key_size);
+    entry->hash = hash;
+    gdt_set_value(&entry->value, cache->type, NULL, ap);
+    va_end(ap);
+
+    cache->slots[index].hash = hash;
+    cache->slots[index].entry = entry;
+    lrucache_link_front(cache, entry);
+    cache->size += 1;
+
+    return true;
+}
+
+bool lrucache_get(LRUCache cache, const char * key, void * p)
+{
+    const size_t hash = dict_hash_key(key);
+    struct lru_entry * entry =
+        cache->slots[lrucache_find_slot(cache, key, hash)].entry;
+
+    if ( !entry ) {
+        cache->misses += 1;
+        return false;
+    }
+
+    cache->hits += 1;
+
+    if ( entry != cache->mru ) {
+        lrucache_unlink(cache, entry);
+        lrucache_link_front(cache, entry);
+    }
+
+    if ( p ) {
+        gdt_get_value(&entry->value, p);
+    }
+
+    return true;
+}
+
+bool lrucache_has_key(LRUCache cache, const char * key)
+{
+    const size_t hash = dict_hash_key(key);
+    return cache->slots[lrucache_find_slot(cache, key, hash)].entry != NULL;
+}
+
+bool lrucache_delete(LRUCache cache, const char * key)
+{
+    const size_t hash = dict_hash_key(key);
+    const size_t index = lrucache_find_slot(cache, key, hash);
+    struct lru_entry * entry = cache->slots[index].entry;
+
+    if ( !entry ) {
+        return false;
+    }
+
+    if ( cache->free_on_destroy ) {
+        gdt_free(&entry->value);
+    }
+
+    lrucache_remove_slot(cache, index);
+    lrucache_unlink(cache, entry);
+    entry->next = cache->unused;
+    cache->unused = entry;
+    cache->size -= 1;
+
+    return true;
+}
+
+size_t lrucache_size(LRUCache cache)
+{
+    return cache->size;
+}
+
+size_t lrucache_capacity(LRUCache cache)
+{
+    return cache->capacity;
+}
+
+size_t lrucache_hits(LRUCache cache)
+{
+    return cache->hits;
+}
+
+size_t lrucache_misses(LRUCache cache)
+{
+    return cache->misses;
+}
+
+void lrucache_reset_stats(LRUCache cache)
+{
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+static size_t lrucache_find_slot(LRUCache cache, const char * key,
+                                 const size_t hash)
+{
+    const size_t mask = cache->num_slots - 1;
+    size_t index = hash & mask;
+
+    while ( cache->slots[index].entry ) {
+        const struct lru_slot * slot = &cache->slots[index];
+        if ( slot->hash == hash && !strcmp(slot->entry->key, key) ) {
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return index;
+}
+
+static void lrucache_remove_slot(LRUCache cache, size_t index)
+{
+    const size_t mask = cache->num_slots - 1;
+    size_t next = index;
+
+    while ( true ) {
+        next = (next + 1) & mask;
+        if ( !cache->slots[next].entry ) {
+            break;
+        }
+
+        /*  The entry at 'next' may move back into the gap only if
+         *  its home slot does not lie cyclically in (index, next].  */
+
+        const size_t home = cache->slots[next].hash & mask;
+        const bool stays = (index <= next) ?
+                           (index < home && home <= next) :
+                           (index < home || home <= next);
+        if ( !stays ) {
+            cache->slots[index] = cache->slots[next];
+            index = next;
+        }
+    }
+
+    cache->slots[index].entry = NULL;
+}
+
+static void lrucache_unlink(LRUCache cache, struct lru_entry * entry)
+{
+    if ( entry->prev ) {
+        entry->prev->next = entry->next;
+    }
+    else {
+        cache->mru = entry->next;
+    }
+
+    if ( entry->next ) {
+        entry->next->prev = entry->prev;
+    }
+    else {
+        cache->lru = entry->prev;
+    }
+}
+
+static void lrucache_link_front(LRUCache cache, struct lru_entry * entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->mru;
+    if ( cache->mru ) {
+        cache->mru->prev = entry;
+    }
+    else {
+        cache->lru = entry;
+    }
+    cache->mru = entry;
+}
+
+static struct lru_entry * lrucache_evict(LRUCache cache)
+{
+    struct lru_entry * entry = cache->lru;
+
+    if ( cache->evict ) {
+        struct gdt_generic_datatype value;
+        gdt_store_raw(&entry->value, &value.data,
+                      gdt_size_of_type(cache->type));
+        cache->evict(entry->key, &value.data, cache->evict_ctx);
+    }
+
+    if ( cache->free_on_destroy ) {
+        gdt_free(&entry->value);
+    }
+
+    lrucache_remove_slot(cache,
+                         lrucache_find_slot(cache, entry->key, entry->hash));
+    lrucache_unlink(cache, entry);
+    cache->size -= 1;
+
+    return entry;
+}
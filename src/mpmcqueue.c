@@ -0,0 +1,325 @@
+/*!
+ * \file            mpmcqueue.c
+ * \brief           Implementation of multi-producer multi-consumer queue.
+ * \details         This is Dmitry Vyukov's bounded array queue. Each cell
+ * of a circular buffer carries a sequence number which says whether it is
+ * ready to be written for a given lap of the buffer, or ready to be read.
+ * A producer claims the cell at the enqueue position by advancing that
+ * position with a compare-and-swap, writes its value, and then publishes
+ * it by advancing the cell's sequence number; consumers do the same with
+ * the dequeue position. Producers and consumers therefore contend only
+ * with each other, on separate cache lines, and touch a shared cell only
+ * when handing a value over.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <sched.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/mpmcqueue.h>
+
+/*!  Number of spins before a waiting thread starts yielding  */
+static const int SPINS_BEFORE_YIELD = 64;
+
+/*!  Queue cell header structure, followed by the value  */
+struct mpmc_cell {
+    size_t sequence;                /*!<  Sequence number                   */
+};
+
+/*!  Multi-producer multi-consumer queue structure  */
+struct mpmcqueue {
+
+    /*!  Position of next cell to push, shared by producers  */
+    union {
+        size_t pos;                             /*!<  Enqueue position      */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } enqueue;
+
+    /*!  Position of next cell to pop, shared by consumers  */
+    union {
+        size_t pos;                             /*!<  Dequeue position      */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } dequeue;
+
+    char * cells;                   /*!<  Circular buffer of cells          */
+    size_t mask;                    /*!<  Capacity less one                 */
+    size_t cell_size;               /*!<  Size of each cell                 */
+    size_t value_size;              /*!<  Size of each value                */
+    enum gds_datatype type;         /*!<  Queue datatype                    */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Private function to try to push a value.
+ * \param queue     A pointer to the queue.
+ * \param value     A pointer to the value.
+ * \retval true     Success
+ * \retval false    Failure, the queue is full.
+ */
+static bool mpmcqueue_try_push_internal(MPMCQueue queue,
+                                 const struct gdt_generic_datatype * value);
+
+/*!
+ * \brief           Private function to find a cell.
+ * \param queue     A pointer to the queue.
+ * \param pos       The position of the cell.
+ * \returns         A pointer to the cell.
+ */
+static struct mpmc_cell * mpmcqueue_cell_at(MPMCQueue queue,
+                                            const size_t pos);
+
+/*!
+ * \brief           Backs off while waiting for another thread.
+ * \param spins     A pointer to the number of times the caller has
+ * already backed off, which is incremented.
+ */
+static void mpmcqueue_backoff(int * spins);
+
+MPMCQueue mpmcqueue_create(const size_t capacity,
+                           const enum gds_datatype type,
+                           const int opts)
+{
+    size_t actual_capacity = 2;
+    while ( actual_capacity < capacity ) {
+        actual_capacity *= 2;
+    }
+
+    void * p;
+    if ( posix_memalign(&p, GDS_CACHE_LINE, sizeof(struct mpmcqueue)) ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    /*  Pad each cell so the sequence number of the next is aligned  */
+
+    const size_t align = sizeof(struct mpmc_cell);
+    const size_t value_size = gdt_size_of_type(type);
+    const size_t cell_size = (align + value_size + align - 1) /
+                             align * align;
+
+    struct mpmcqueue * new_queue = p;
+    new_queue->cells = malloc(actual_capacity * cell_size);
+    if ( !new_queue->cells ) {
+        free(new_queue);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_queue->enqueue.pos = 0;
+    new_queue->dequeue.pos = 0;
+    new_queue->mask = actual_capacity - 1;
+    new_queue->cell_size = cell_size;
+    new_queue->value_size = value_size;
+
+    /*  Each cell is initially ready to be written on the first lap  */
+
+    for ( size_t i = 0; i < actual_capacity; ++i ) {
+        mpmcqueue_cell_at(new_queue, i)->sequence = i;
+    }
+
+    new_queue->type = type;
+    new_queue->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_queue->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    return new_queue;
+}
+
+void mpmcqueue_destroy(MPMCQueue queue)
+{
+    if ( queue->free_on_destroy ) {
+        for ( size_t pos = queue->dequeue.pos;
+              pos != queue->enqueue.pos; ++pos ) {
+            struct gdt_generic_datatype value;
+            gdt_load_raw(&value, queue->type,
+                         mpmcqueue_cell_at(queue, pos) + 1,
+                         queue->value_size);
+            gdt_free(&value);
+        }
+    }
+
+    free(queue->cells);
+    free(queue);
+}
+
+void mpmcqueue_push(MPMCQueue queue, ...)
+{
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, queue);
+    gdt_set_value(&value, queue->type, NULL, ap);
+    va_end(ap);
+
+    int spins = 0;
+    while ( !mpmcqueue_try_push_internal(queue, &value) ) {
+        mpmcqueue_backoff(&spins);
+    }
+}
+
+bool mpmcqueue_try_push(MPMCQueue queue, ...)
+{
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, queue);
+    gdt_set_value(&value, queue->type, NULL, ap);
+    va_end(ap);
+
+    return mpmcqueue_try_push_internal(queue, &value);
+}
+
+void mpmcqueue_pop(MPMCQueue queue, void * p)
+{
+    int spins = 0;
+    while ( !mpmcqueue_try_pop(queue, p) ) {
+        mpmcqueue_backoff(&spins);
+    }
+}
+
+bool mpmcqueue_try_pop(MPMCQueue queue, void * p)
+{
+    size_t pos = __atomic_load_n(&queue->dequeue.pos, __ATOMIC_RELAXED);
+    struct mpmc_cell * cell;
+
+    while ( true ) {
+        cell = mpmcqueue_cell_at(queue, pos);
+        const size_t seq = __atomic_load_n(&cell->sequence,
+                                           __ATOMIC_ACQUIRE);
+        const intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+
+        if ( diff == 0 ) {
+
+            /*  The cell holds a value for this lap, so try to claim it  */
+
+            if ( __atomic_compare_exchange_n(&queue->dequeue.pos, &pos,
+                                             pos + 1, true, __ATOMIC_RELAXED,
+                                             __ATOMIC_RELAXED) ) {
+                break;
+            }
+        }
+        else if ( diff < 0 ) {
+
+            /*  The cell has not been written for this lap  */
+
+            return false;
+        }
+        else {
+
+            /*  Another consumer claimed the cell first  */
+
+            pos = __atomic_load_n(&queue->dequeue.pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(p, cell + 1, queue->value_size);
+
+    /*  Mark the cell ready to be written on the next lap  */
+
+    __atomic_store_n(&cell->sequence, pos + queue->mask + 1,
+                     __ATOMIC_RELEASE);
+
+    return true;
+}
+
+size_t mpmcqueue_size(MPMCQueue queue)
+{
+    const size_t head = __atomic_load_n(&queue->dequeue.pos,
+                                        __ATOMIC_RELAXED);
+    const size_t tail = __atomic_load_n(&queue->enqueue.pos,
+                                        __ATOMIC_RELAXED);
+    const size_t size = tail - head;
+
+    /*  The positions are read separately, so may briefly
+     *  appear to cross, or to exceed the capacity.         */
+
+    if ( (intptr_t) size < 0 ) {
+        return 0;
+    }
+    return size > queue->mask + 1 ? queue->mask + 1 : size;
+}
+
+size_t mpmcqueue_capacity(MPMCQueue queue)
+{
+    return queue->mask + 1;
+}
+
+static bool mpmcqueue_try_push_internal(MPMCQueue queue,
+                                 const struct gdt_generic_datatype * value)
+{
+    size_t pos = __atomic_load_n(&queue->enqueue.pos, __ATOMIC_RELAXED);
+    struct mpmc_cell * cell;
+
+    while ( true ) {
+        cell = mpmcqueue_cell_at(queue, pos);
+        const size_t seq = __atomic_load_n(&cell->sequence,
+                                           __ATOMIC_ACQUIRE);
+        const intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+        if ( diff == 0 ) {
+
+            /*  The cell is free for this lap, so try to claim it  */
+
+            if ( __atomic_compare_exchange_n(&queue->enqueue.pos, &pos,
+                                             pos + 1, true, __ATOMIC_RELAXED,
+                                             __ATOMIC_RELAXED) ) {
+                break;
+            }
+        }
+        else if ( diff < 0 ) {
+
+            /*  The cell still holds a value from the previous lap  */
+
+            return false;
+        }
+        else {
+
+            /*  Another producer claimed the cell first  */
+
+            pos = __atomic_load_n(&queue->enqueue.pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    gdt_store_raw(value, cell + 1, queue->value_size);
+
+    /*  Publish the value to consumers  */
+
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static struct mpmc_cell * mpmcqueue_cell_at(MPMCQueue queue,
+                                            const size_t pos)
+{
+    return (struct mpmc_cell *) (queue->cells +
+                                 (pos & queue->mask) * queue->cell_size);
+}
+
+static void mpmcqueue_backoff(int * spins)
+{
+    if ( *spins < SPINS_BEFORE_YIELD ) {
+        *spins += 1;
+        gds_cpu_relax();
+    }
+    else {
+        sched_yield();
+    }
+}
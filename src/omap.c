@@ -0,0 +1,1039 @@
+/*!
+ * \file            omap.c
+ * \brief           Implementation of generic ordered map data structure.
+ * \details         Internal nodes hold up to `MAX_KEYS` separator keys.
+ * The subtree to the left of a separator holds only smaller keys, and the
+ * subtree to its right only keys greater than or equal to it. Every
+ * separator is a copy of a key which is also present in a leaf. Leaves
+ * hold the key-values, and are doubly linked in key order. Every node other
+ * than the root holds at least `MIN_KEYS` keys.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/omap.h>
+
+/*!
+ * \brief           Number of cache lines spanned by the keys of a node.
+ * \details         This holds for word-sized keys. Narrower keys are packed
+ * more densely, and span fewer.
+ */
+#define KEY_LINES 8
+
+/*!
+ * \brief           Maximum number of keys in a node.
+ * \details         Must be even. Keys are packed at their natural size, so
+ * a binary search over the keys of a node touches only a handful of the
+ * `KEY_LINES` cache lines they span.
+ */
+#define MAX_KEYS (KEY_LINES * GDS_CACHE_LINE / sizeof(void *))
+
+/*!  Minimum number of keys in a node other than the root  */
+#define MIN_KEYS (MAX_KEYS / 2)
+
+/*!
+ * \brief           Maximum height of the tree.
+ * \details         Every internal node but the root has at least
+ * `MIN_KEYS + 1` children, so this is far more than can ever be needed.
+ */
+#define MAX_HEIGHT 32
+
+/*!
+ * \brief           Common node header structure
+ * \details         Each node is a single allocation. Its keys are packed
+ * immediately after the header, and for a leaf its values follow the keys.
+ */
+struct omap_node {
+    bool leaf;                          /*!<  True if node is a leaf        */
+    size_t num_keys;                    /*!<  Number of keys in node        */
+    unsigned char * keys;               /*!<  Packed keys                   */
+};
+
+/*!  Internal node structure  */
+struct omap_inner {
+    struct omap_node node;              /*!<  Common node header            */
+    struct omap_node * children[MAX_KEYS + 1];      /*!<  Child nodes       */
+};
+
+/*!  Leaf node structure  */
+struct omap_leaf {
+    struct omap_node node;              /*!<  Common node header            */
+    unsigned char * values;             /*!<  Packed values                 */
+    struct omap_leaf * prev;            /*!<  Previous leaf in key order    */
+    struct omap_leaf * next;            /*!<  Next leaf in key order        */
+    const struct omap * omap;           /*!<  Map, for iterators            */
+};
+
+/*!  Ordered map structure  */
+struct omap {
+    struct omap_node * root;            /*!<  Root node                     */
+    struct omap_leaf * first;           /*!<  Leaf with smallest keys       */
+    struct omap_leaf * last;            /*!<  Leaf with largest keys        */
+    size_t size;                        /*!<  Number of keys                */
+    enum gds_datatype key_type;         /*!<  Key datatype                  */
+    enum gds_datatype value_type;       /*!<  Value datatype                */
+    size_t key_size;                    /*!<  Size of a key                 */
+    size_t value_size;                  /*!<  Size of a value               */
+    gds_cfunc compfunc;                 /*!<  Key comparison function       */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!  Path from the root to a leaf, recorded during descent  */
+struct omap_path {
+    size_t height;                      /*!<  Number of internal nodes      */
+    struct omap_inner * nodes[MAX_HEIGHT];  /*!<  Internal nodes, from root */
+    size_t indices[MAX_HEIGHT];         /*!<  Child index taken at each     */
+};
+
+/*!
+ * \brief           Returns a pointer to a key in a node.
+ * \param omap      A pointer to the map.
+ * \param node      A pointer to the node.
+ * \param index     The index of the key.
+ * \returns         A pointer to the key.
+ */
+static unsigned char * omap_key(const struct omap * omap,
+                                const struct omap_node * node,
+                                const size_t index);
+
+/*!
+ * \brief           Returns a pointer to a value in a leaf.
+ * \param omap      A pointer to the map.
+ * \param leaf      A pointer to the leaf.
+ * \param index     The index of the value.
+ * \returns         A pointer to the value.
+ */
+static unsigned char * omap_value(const struct omap * omap,
+                                  const struct omap_leaf * leaf,
+                                  const size_t index);
+
+/*!
+ * \brief           Moves keys within or between nodes.
+ * \details         The source and destination ranges may overlap.
+ * \param omap      A pointer to the map.
+ * \param dst       A pointer to the destination node.
+ * \param dst_index The index of the first destination key.
+ * \param src       A pointer to the source node.
+ * \param src_index The index of the first source key.
+ * \param n         The number of keys to move.
+ */
+static void omap_move_keys(OMap omap, struct omap_node * dst,
+                           const size_t dst_index,
+                           const struct omap_node * src,
+                           const size_t src_index, const size_t n);
+
+/*!
+ * \brief           Moves values within or between leaves.
+ * \details         The source and destination ranges may overlap.
+ * \param omap      A pointer to the map.
+ * \param dst       A pointer to the destination leaf.
+ * \param dst_index The index of the first destination value.
+ * \param src       A pointer to the source leaf.
+ * \param src_index The index of the first source value.
+ * \param n         The number of values to move.
+ */
+static void omap_move_values(OMap omap, struct omap_leaf * dst,
+                             const size_t dst_index,
+                             const struct omap_leaf * src,
+                             const size_t src_index, const size_t n);
+
+/*!
+ * \brief           Returns the index of the first key not less than a key.
+ * \param omap      A pointer to the map.
+ * \param node      A pointer to the node.
+ * \param key       A pointer to the key.
+ * \returns         The index, which is `num_keys` if every key is less.
+ */
+static size_t omap_lower_index(OMap omap, const struct omap_node * node,
+                               const void * key);
+
+/*!
+ * \brief           Returns the index of the first key greater than a key.
+ * \param omap      A pointer to the map.
+ * \param node      A pointer to the node.
+ * \param key       A pointer to the key.
+ * \returns         The index, which is `num_keys` if no key is greater.
+ */
+static size_t omap_upper_index(OMap omap, const struct omap_node * node,
+                               const void * key);
+
+/*!
+ * \brief           Descends from the root to the leaf which would hold a key.
+ * \param omap      A pointer to the map.
+ * \param key       A pointer to the key.
+ * \param path      A pointer to a path structure to record the descent, or
+ * `NULL` if it is not required.
+ * \returns         A pointer to the leaf.
+ */
+static struct omap_leaf * omap_find_leaf(OMap omap, const void * key,
+                                         struct omap_path * path);
+
+/*!
+ * \brief           Allocates a new, empty node.
+ * \param omap      A pointer to the map.
+ * \param leaf      True to allocate a leaf, false for an internal node.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the new node.
+ */
+static struct omap_node * omap_node_create(OMap omap, const bool leaf);
+
+/*!
+ * \brief           Destroys a subtree.
+ * \param omap      A pointer to the map.
+ * \param node      A pointer to the root of the subtree.
+ */
+static void omap_node_destroy(OMap omap, struct omap_node * node);
+
+/*!
+ * \brief           Inserts a new key-value which is known to be absent.
+ * \details         All the nodes any resulting splits need are allocated
+ * before the tree is modified, so a failed allocation leaves the tree
+ * unchanged.
+ * \param omap      A pointer to the map.
+ * \param path      A pointer to the path to the leaf.
+ * \param leaf      A pointer to the leaf.
+ * \param index     The index in the leaf at which to insert.
+ * \param key       A pointer to the key.
+ * \param value     A pointer to the value.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed.
+ */
+static bool omap_insert_new(OMap omap, struct omap_path * path,
+                            struct omap_leaf * leaf, const size_t index,
+                            const void * key, const void * value);
+
+/*!
+ * \brief           Inserts a key-value into a leaf which is not full.
+ * \param omap      A pointer to the map.
+ * \param leaf      A pointer to the leaf.
+ * \param index     The index in the leaf at which to insert.
+ * \param key       A pointer to the key.
+ * \param value     A pointer to the value.
+ */
+static void omap_leaf_insert(OMap omap, struct omap_leaf * leaf,
+                             const size_t index, const void * key,
+                             const void * value);
+
+/*!
+ * \brief           Inserts a key and child into a node which is not full.
+ * \param omap      A pointer to the map.
+ * \param inner     A pointer to the internal node.
+ * \param index     The index in the node at which to insert the key. The
+ * child is inserted to the right of it.
+ * \param key       A pointer to the key.
+ * \param child     A pointer to the child.
+ */
+static void omap_inner_insert(OMap omap, struct omap_inner * inner,
+                              const size_t index, const void * key,
+                              struct omap_node * child);
+
+/*!
+ * \brief           Restores the minimum occupancy of an underfull node.
+ * \details         Borrows a key from a sibling if one can spare it, or
+ * otherwise merges with a sibling, which may leave the parent underfull in
+ * turn, in which case the process repeats one level up.
+ * \param omap      A pointer to the map.
+ * \param path      A pointer to the path to the leaf.
+ * \param leaf      A pointer to the leaf from which a key was deleted.
+ */
+static void omap_rebalance(OMap omap, struct omap_path * path,
+                           struct omap_leaf * leaf);
+
+/*!
+ * \brief           Replaces any separator equal to a deleted key.
+ * \details         The separator is replaced with the smallest key in the
+ * subtree to its right, which is the deleted key's successor.
+ * \param omap      A pointer to the map.
+ * \param key       A pointer to the deleted key.
+ */
+static void omap_replace_separator(OMap omap, const void * key);
+
+OMap omap_create(const enum gds_datatype key_type,
+                 const enum gds_datatype value_type,
+                 const int opts, ...)
+{
+    struct omap * new_omap = malloc(sizeof *new_omap);
+    if ( !new_omap ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_omap->size = 0;
+    new_omap->key_type = key_type;
+    new_omap->value_type = value_type;
+    new_omap->key_size = gdt_size_of_type(key_type);
+    new_omap->value_size = gdt_size_of_type(value_type);
+    new_omap->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_omap->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    gds_cfunc cfunc = NULL;
+    va_list ap;
+    va_start(ap, opts);
+    if ( key_type == DATATYPE_POINTER ) {
+
+        /*  Custom comparison function only needed for void * keys  */
+
+        cfunc = va_arg(ap, gds_cfunc);
+    }
+    va_end(ap);
+
+    new_omap->compfunc = gdt_compfunc_for_type(key_type, cfunc);
+
+    new_omap->root = omap_node_create(new_omap, true);
+    if ( !new_omap->root ) {
+        free(new_omap);
+        return NULL;
+    }
+
+    new_omap->first = (struct omap_leaf *) new_omap->root;
+    new_omap->last = new_omap->first;
+
+    return new_omap;
+}
+
+void omap_destroy(OMap omap)
+{
+    omap_node_destroy(omap, omap->root);
+    free(omap);
+}
+
+bool omap_insert(OMap omap, ...)
+{
+    struct gdt_generic_datatype key, value;
+    va_list ap;
+    va_start(ap, omap);
+    gdt_set_value_next(&key, omap->key_type, NULL, &ap);
+    gdt_set_value_next(&value, omap->value_type, NULL, &ap);
+    va_end(ap);
+
+    struct omap_path path;
+    struct omap_leaf * leaf = omap_find_leaf(omap, &key.data, &path);
+    const size_t index = omap_lower_index(omap, &leaf->node, &key.data);
+
+    if ( index < leaf->node.num_keys &&
+         !omap->compfunc(omap_key(omap, &leaf->node, index), &key.data) ) {
+        unsigned char * stored = omap_value(omap, leaf, index);
+        if ( omap->free_on_destroy ) {
+
+            /*  Free existing value, and the duplicate key  */
+
+            struct gdt_generic_datatype old_value;
+            gdt_load_raw(&old_value, omap->value_type, stored,
+                         omap->value_size);
+            gdt_free(&old_value);
+            gdt_free(&key);
+        }
+        gdt_store_raw(&value, stored, omap->value_size);
+        return true;
+    }
+
+    return omap_insert_new(omap, &path, leaf, index, &key.data, &value.data);
+}
+
+bool omap_delete(OMap omap, ...)
+{
+    struct gdt_generic_datatype key;
+    va_list ap;
+    va_start(ap, omap);
+    gdt_set_value_next(&key, omap->key_type, NULL, &ap);
+    va_end(ap);
+
+    struct omap_path path;
+    struct omap_leaf * leaf = omap_find_leaf(omap, &key.data, &path);
+    const size_t index = omap_lower_index(omap, &leaf->node, &key.data);
+
+    if ( index == leaf->node.num_keys ||
+         omap->compfunc(omap_key(omap, &leaf->node, index), &key.data) ) {
+        return false;
+    }
+
+    /*  Keep the stored key and value until the tree no longer
+     *  refers to them, since a separator may share the key's data.  */
+
+    struct gdt_generic_datatype dead_key, dead_value;
+    gdt_load_raw(&dead_key, omap->key_type,
+                 omap_key(omap, &leaf->node, index), omap->key_size);
+    gdt_load_raw(&dead_value, omap->value_type,
+                 omap_value(omap, leaf, index), omap->value_size);
+
+    const size_t nmove = leaf->node.num_keys - index - 1;
+    omap_move_keys(omap, &leaf->node, index, &leaf->node, index + 1, nmove);
+    omap_move_values(omap, leaf, index, leaf, index + 1, nmove);
+    leaf->node.num_keys -= 1;
+    omap->size -= 1;
+
+    omap_rebalance(omap, &path, leaf);
+    omap_replace_separator(omap, &dead_key.data);
+
+    if ( omap->free_on_destroy ) {
+        gdt_free(&dead_key);
+        gdt_free(&dead_value);
+    }
+
+    return true;
+}
+
+bool omap_find(OMap omap, void * p, ...)
+{
+    struct gdt_generic_datatype key;
+    va_list ap;
+    va_start(ap, p);
+    gdt_set_value_next(&key, omap->key_type, NULL, &ap);
+    va_end(ap);
+
+    struct omap_leaf * leaf = omap_find_leaf(omap, &key.data, NULL);
+    const size_t index = omap_lower_index(omap, &leaf->node, &key.data);
+
+    if ( index == leaf->node.num_keys ||
+         omap->compfunc(omap_key(omap, &leaf->node, index), &key.data) ) {
+        return false;
+    }
+
+    if ( p ) {
+        memcpy(p, omap_value(omap, leaf, index), omap->value_size);
+    }
+
+    return true;
+}
+
+bool omap_lower_bound(OMap omap, OMapItr * itr, ...)
+{
+    struct gdt_generic_datatype key;
+    va_list ap;
+    va_start(ap, itr);
+    gdt_set_value_next(&key, omap->key_type, NULL, &ap);
+    va_end(ap);
+
+    struct omap_leaf * leaf = omap_find_leaf(omap, &key.data, NULL);
+    const size_t index = omap_lower_index(omap, &leaf->node, &key.data);
+
+    if ( index < leaf->node.num_keys ) {
+        itr->leaf = leaf;
+        itr->index = index;
+        return true;
+    }
+
+    /*  Every key in this leaf is smaller, so the lower bound,
+     *  if there is one, is the first key in the next leaf.     */
+
+    if ( leaf->next ) {
+        itr->leaf = leaf->next;
+        itr->index = 0;
+        return true;
+    }
+
+    return false;
+}
+
+size_t omap_range(OMap omap, omap_visit_func fn, void * ctx, ...)
+{
+    struct gdt_generic_datatype lo, hi;
+    va_list ap;
+    va_start(ap, ctx);
+    gdt_set_value_next(&lo, omap->key_type, NULL, &ap);
+    gdt_set_value_next(&hi, omap->key_type, NULL, &ap);
+    va_end(ap);
+
+    struct omap_leaf * leaf = omap_find_leaf(omap, &lo.data, NULL);
+    size_t index = omap_lower_index(omap, &leaf->node, &lo.data);
+    size_t visited = 0;
+
+    while ( leaf ) {
+        for ( ; index < leaf->node.num_keys; ++index ) {
+            const unsigned char * key = omap_key(omap, &leaf->node, index);
+            if ( omap->compfunc(key, &hi.data) >= 0 ) {
+                return visited;
+            }
+
+            /*  Pass a copy of the value, so the visitor cannot
+             *  modify the map through it.                        */
+
+            struct gdt_generic_datatype value;
+            gdt_load_raw(&value, omap->value_type,
+                         omap_value(omap, leaf, index), omap->value_size);
+
+            visited += 1;
+            if ( !fn(key, &value.data, ctx) ) {
+                return visited;
+            }
+        }
+
+        leaf = leaf->next;
+        index = 0;
+    }
+
+    return visited;
+}
+
+bool omap_itr_first(OMap omap, OMapItr * itr)
+{
+    if ( omap->size == 0 ) {
+        return false;
+    }
+
+    itr->leaf = omap->first;
+    itr->index = 0;
+
+    return true;
+}
+
+bool omap_itr_last(OMap omap, OMapItr * itr)
+{
+    if ( omap->size == 0 ) {
+        return false;
+    }
+
+    itr->leaf = omap->last;
+    itr->index = omap->last->node.num_keys - 1;
+
+    return true;
+}
+
+bool omap_itr_next(OMapItr * itr)
+{
+    if ( ++itr->index == itr->leaf->node.num_keys ) {
+        itr->leaf = itr->leaf->next;
+        itr->index = 0;
+    }
+
+    return itr->leaf != NULL;
+}
+
+bool omap_itr_previous(OMapItr * itr)
+{
+    if ( itr->index-- == 0 ) {
+        itr->leaf = itr->leaf->prev;
+        if ( itr->leaf ) {
+            itr->index = itr->leaf->node.num_keys - 1;
+        }
+    }
+
+    return itr->leaf != NULL;
+}
+
+void omap_itr_key(const OMapItr * itr, void * p)
+{
+    const struct omap * omap = itr->leaf->omap;
+    memcpy(p, omap_key(omap, &itr->leaf->node, itr->index), omap->key_size);
+}
+
+void omap_itr_value(const OMapItr * itr, void * p)
+{
+    const struct omap * omap = itr->leaf->omap;
+    memcpy(p, omap_value(omap, itr->leaf, itr->index), omap->value_size);
+}
+
+size_t omap_size(OMap omap)
+{
+    return omap->size;
+}
+
+bool omap_is_empty(OMap omap)
+{
+    return omap->size == 0;
+}
+
+static unsigned char * omap_key(const struct omap * omap,
+                                const struct omap_node * node,
+                                const size_t index)
+{
+    return node->keys + index * omap->key_size;
+}
+
+static unsigned char * omap_value(const struct omap * omap,
+                                  const struct omap_leaf * leaf,
+                                  const size_t index)
+{
+    return leaf->values + index * omap->value_size;
+}
+
+static void omap_move_keys(OMap omap, struct omap_node * dst,
+                           const size_t dst_index,
+                           const struct omap_node * src,
+                           const size_t src_index, const size_t n)
+{
+    memmove(omap_key(omap, dst, dst_index), omap_key(omap, src, src_index),
+            n * omap->key_size);
+}
+
+static void omap_move_values(OMap omap, struct omap_leaf * dst,
+                             const size_t dst_index,
+                             const struct omap_leaf * src,
+                             const size_t src_index, const size_t n)
+{
+    memmove(omap_value(omap, dst, dst_index),
+            omap_value(omap, src, src_index), n * omap->value_size);
+}
+
+static size_t omap_lower_index(OMap omap, const struct omap_node * node,
+                               const void * key)
+{
+    size_t lo = 0, hi = node->num_keys;
+
+    while ( lo < hi ) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if ( omap->compfunc(omap_key(omap, node, mid), key) < 0 ) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static size_t omap_upper_index(OMap omap, const struct omap_node * node,
+                               const void * key)
+{
+    size_t lo = 0, hi = node->num_keys;
+
+    while ( lo < hi ) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if ( omap->compfunc(omap_key(omap, node, mid), key) <= 0 ) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static struct omap_leaf * omap_find_leaf(OMap omap, const void * key,
+                                         struct omap_path * path)
+{
+    struct omap_node * node = omap->root;
+    size_t height = 0;
+
+    while ( !node->leaf ) {
+        struct omap_inner * inner = (struct omap_inner *) node;
+        const size_t index = omap_upper_index(omap, node, key);
+
+        if ( path ) {
+            path->nodes[height] = inner;
+            path->indices[height] = index;
+        }
+
+        height += 1;
+        node = inner->children[index];
+    }
+
+    if ( path ) {
+        path->height = height;
+    }
+
+    return (struct omap_leaf *) node;
+}
+
+static struct omap_node * omap_node_create(OMap omap, const bool leaf)
+{
+    const size_t header_size = leaf ? sizeof(struct omap_leaf) :
+                                      sizeof(struct omap_inner);
+    const size_t keys_size = MAX_KEYS * omap->key_size;
+    const size_t values_size = leaf ? MAX_KEYS * omap->value_size : 0;
+
+    struct omap_node * node = malloc(header_size + keys_size + values_size);
+    if ( !node ) {
+        if ( omap->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    node->leaf = leaf;
+    node->num_keys = 0;
+    node->keys = (unsigned char *) node + header_size;
+
+    if ( leaf ) {
+        struct omap_leaf * new_leaf = (struct omap_leaf *) node;
+        new_leaf->values = node->keys + keys_size;
+        new_leaf->prev = NULL;
+        new_leaf->next = NULL;
+        new_leaf->omap = omap;
+    }
+
+    return node;
+}
+
+static void omap_node_destroy(OMap omap, struct omap_node * node)
+{
+    if ( node->leaf ) {
+        struct omap_leaf * leaf = (struct omap_leaf *) node;
+        if ( omap->free_on_destroy ) {
+            for ( size_t i = 0; i < node->num_keys; ++i ) {
+                struct gdt_generic_datatype key, value;
+                gdt_load_raw(&key, omap->key_type,
+                             omap_key(omap, node, i), omap->key_size);
+                gdt_load_raw(&value, omap->value_type,
+                             omap_value(omap, leaf, i), omap->value_size);
+                gdt_free(&key);
+                gdt_free(&value);
+            }
+        }
+    }
+    else {
+
+        /*  Separators share their data with leaf keys,
+         *  so only the leaves free anything.            */
+
+        struct omap_inner * inner = (struct omap_inner *) node;
+        for ( size_t i = 0; i <= node->num_keys; ++i ) {
+            omap_node_destroy(omap, inner->children[i]);
+        }
+    }
+
+    free(node);
+}
+
+static bool omap_insert_new(OMap omap, struct omap_path * path,
+                            struct omap_leaf * leaf, const size_t index,
+                            const void * key, const void * value)
+{
+    /*  Count the full nodes from the leaf upwards. Each of those
+     *  will split, and if they run all the way up to the root,
+     *  the tree grows a new root.                                 */
+
+    struct omap_node * spare[MAX_HEIGHT + 2];
+    size_t num_splits = 0;
+
+    if ( leaf->node.num_keys == MAX_KEYS ) {
+        num_splits = 1;
+        while ( num_splits <= path->height &&
+                path->nodes[path->height - num_splits]->node.num_keys ==
+                MAX_KEYS ) {
+            num_splits += 1;
+        }
+    }
+
+    const size_t num_spare = num_splits +
+                             (num_splits > path->height ? 1 : 0);
+    for ( size_t i = 0; i < num_spare; ++i ) {
+        spare[i] = omap_node_create(omap, i == 0);
+        if ( !spare[i] ) {
+            while ( i-- ) {
+                free(spare[i]);
+            }
+            return false;
+        }
+    }
+
+    omap->size += 1;
+
+    if ( num_splits == 0 ) {
+        omap_leaf_insert(omap, leaf, index, key, value);
+        return true;
+    }
+
+    /*  Split the full leaf, moving the upper half of its keys to the
+     *  new leaf, then insert into whichever half the new key is in.   */
+
+    struct omap_leaf * right = (struct omap_leaf *) spare[0];
+    size_t n = MAX_KEYS;
+    const size_t nleft = (n + 1) / 2;
+    const size_t nmove = index < nleft ? n - nleft + 1 : n - nleft;
+
+    omap_move_keys(omap, &right->node, 0, &leaf->node, n - nmove, nmove);
+    omap_move_values(omap, right, 0, leaf, n - nmove, nmove);
+    right->node.num_keys = nmove;
+    leaf->node.num_keys = n - nmove;
+
+    if ( index < nleft ) {
+        omap_leaf_insert(omap, leaf, index, key, value);
+    }
+    else {
+        omap_leaf_insert(omap, right, index - nleft, key, value);
+    }
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if ( leaf->next ) {
+        leaf->next->prev = right;
+    }
+    else {
+        omap->last = right;
+    }
+    leaf->next = right;
+
+    /*  Push the separator and new node up the tree  */
+
+    struct gdt_generic_datatype up_key;
+    gdt_load_raw(&up_key, omap->key_type, omap_key(omap, &right->node, 0),
+                 omap->key_size);
+    struct omap_node * up_node = &right->node;
+    size_t level = path->height;
+
+    for ( size_t s = 1; s < num_splits; ++s ) {
+        level -= 1;
+        struct omap_inner * inner = path->nodes[level];
+        struct omap_inner * new_inner = (struct omap_inner *) spare[s];
+        const size_t pos = path->indices[level];
+
+        /*  With the new key in place there would be one key too
+         *  many, and the middle one of those moves up, rather than
+         *  being copied. Work out which it is before moving the
+         *  upper keys out, then insert on the appropriate side.      */
+
+        n = inner->node.num_keys;
+        const size_t mid = (n + 1) / 2;
+        struct gdt_generic_datatype next_key;
+
+        if ( pos == mid ) {
+            next_key = up_key;
+            omap_move_keys(omap, &new_inner->node, 0,
+                           &inner->node, mid, n - mid);
+            new_inner->children[0] = up_node;
+            memcpy(new_inner->children + 1, inner->children + mid + 1,
+                   (n - mid) * sizeof *inner->children);
+            new_inner->node.num_keys = n - mid;
+            inner->node.num_keys = mid;
+        }
+        else {
+            const size_t split = pos < mid ? mid - 1 : mid;
+            gdt_load_raw(&next_key, omap->key_type,
+                         omap_key(omap, &inner->node, split),
+                         omap->key_size);
+            omap_move_keys(omap, &new_inner->node, 0,
+                           &inner->node, split + 1, n - split - 1);
+            memcpy(new_inner->children, inner->children + split + 1,
+                   (n - split) * sizeof *inner->children);
+            new_inner->node.num_keys = n - split - 1;
+            inner->node.num_keys = split;
+
+            if ( pos < mid ) {
+                omap_inner_insert(omap, inner, pos, &up_key.data, up_node);
+            }
+            else {
+                omap_inner_insert(omap, new_inner, pos - mid - 1,
+                                  &up_key.data, up_node);
+            }
+        }
+
+        up_key = next_key;
+        up_node = &new_inner->node;
+    }
+
+    if ( num_splits > path->height ) {
+
+        /*  The root split, so grow a new one  */
+
+        struct omap_inner * root = (struct omap_inner *) spare[num_splits];
+        gdt_store_raw(&up_key, omap_key(omap, &root->node, 0),
+                      omap->key_size);
+        root->children[0] = omap->root;
+        root->children[1] = up_node;
+        root->node.num_keys = 1;
+        omap->root = &root->node;
+    }
+    else {
+        level -= 1;
+        omap_inner_insert(omap, path->nodes[level], path->indices[level],
+                          &up_key.data, up_node);
+    }
+
+    return true;
+}
+
+static void omap_leaf_insert(OMap omap, struct omap_leaf * leaf,
+                             const size_t index, const void * key,
+                             const void * value)
+{
+    const size_t n = leaf->node.num_keys;
+
+    omap_move_keys(omap, &leaf->node, index + 1, &leaf->node, index,
+                   n - index);
+    omap_move_values(omap, leaf, index + 1, leaf, index, n - index);
+    memcpy(omap_key(omap, &leaf->node, index), key, omap->key_size);
+    memcpy(omap_value(omap, leaf, index), value, omap->value_size);
+    leaf->node.num_keys = n + 1;
+}
+
+static void omap_inner_insert(OMap omap, struct omap_inner * inner,
+                              const size_t index, const void * key,
+                              struct omap_node * child)
+{
+    const size_t n = inner->node.num_keys;
+
+    omap_move_keys(omap, &inner->node, index + 1, &inner->node, index,
+                   n - index);
+    memmove(inner->children + index + 2, inner->children + index + 1,
+            (n - index) * sizeof *inner->children);
+    memcpy(omap_key(omap, &inner->node, index), key, omap->key_size);
+    inner->children[index + 1] = child;
+    inner->node.num_keys = n + 1;
+}
+
+static void omap_rebalance(OMap omap, struct omap_path * path,
+                           struct omap_leaf * leaf)
+{
+    struct omap_node * node = &leaf->node;
+    size_t level = path->height;
+
+    while ( level > 0 && node->num_keys < MIN_KEYS ) {
+        level -= 1;
+        struct omap_inner * parent = path->nodes[level];
+        const size_t idx = path->indices[level];
+
+        /*  Work with the left sibling if there is one, otherwise
+         *  the right. 'sep' is the index of the separator between
+         *  the left and right nodes of the pair.                   */
+
+        const bool has_left = idx > 0;
+        const size_t sep = has_left ? idx - 1 : idx;
+        struct omap_node * left = parent->children[sep];
+        struct omap_node * right = parent->children[sep + 1];
+        struct omap_node * sibling = has_left ? left : right;
+        const size_t ln = left->num_keys;
+        const size_t rn = right->num_keys;
+
+        if ( sibling->num_keys > MIN_KEYS ) {
+
+            /*  Borrow one key from the sibling  */
+
+            if ( node->leaf ) {
+                struct omap_leaf * l = (struct omap_leaf *) left;
+                struct omap_leaf * r = (struct omap_leaf *) right;
+
+                if ( has_left ) {
+                    omap_move_keys(omap, right, 1, right, 0, rn);
+                    omap_move_values(omap, r, 1, r, 0, rn);
+                    omap_move_keys(omap, right, 0, left, ln - 1, 1);
+                    omap_move_values(omap, r, 0, l, ln - 1, 1);
+                }
+                else {
+                    omap_move_keys(omap, left, ln, right, 0, 1);
+                    omap_move_values(omap, l, ln, r, 0, 1);
+                    omap_move_keys(omap, right, 0, right, 1, rn - 1);
+                    omap_move_values(omap, r, 0, r, 1, rn - 1);
+                }
+                omap_move_keys(omap, &parent->node, sep, right, 0, 1);
+            }
+            else {
+                struct omap_inner * l = (struct omap_inner *) left;
+                struct omap_inner * r = (struct omap_inner *) right;
+
+                /*  Rotate through the parent separator  */
+
+                if ( has_left ) {
+                    omap_move_keys(omap, right, 1, right, 0, rn);
+                    memmove(r->children + 1, r->children,
+                            (rn + 1) * sizeof *r->children);
+                    omap_move_keys(omap, right, 0, &parent->node, sep, 1);
+                    r->children[0] = l->children[ln];
+                    omap_move_keys(omap, &parent->node, sep, left, ln - 1, 1);
+                }
+                else {
+                    omap_move_keys(omap, left, ln, &parent->node, sep, 1);
+                    l->children[ln + 1] = r->children[0];
+                    omap_move_keys(omap, &parent->node, sep, right, 0, 1);
+                    omap_move_keys(omap, right, 0, right, 1, rn - 1);
+                    memmove(r->children, r->children + 1,
+                            rn * sizeof *r->children);
+                }
+            }
+
+            if ( has_left ) {
+                left->num_keys -= 1;
+                right->num_keys += 1;
+            }
+            else {
+                left->num_keys += 1;
+                right->num_keys -= 1;
+            }
+
+            return;
+        }
+
+        /*  Neither sibling can spare a key, so merge the right node
+         *  of the pair into the left, and drop the separator.        */
+
+        if ( node->leaf ) {
+            struct omap_leaf * l = (struct omap_leaf *) left;
+            struct omap_leaf * r = (struct omap_leaf *) right;
+
+            omap_move_keys(omap, left, ln, right, 0, rn);
+            omap_move_values(omap, l, ln, r, 0, rn);
+            left->num_keys += rn;
+
+            l->next = r->next;
+            if ( r->next ) {
+                r->next->prev = l;
+            }
+            else {
+                omap->last = l;
+            }
+        }
+        else {
+            struct omap_inner * l = (struct omap_inner *) left;
+            struct omap_inner * r = (struct omap_inner *) right;
+
+            omap_move_keys(omap, left, ln, &parent->node, sep, 1);
+            omap_move_keys(omap, left, ln + 1, right, 0, rn);
+            memcpy(l->children + ln + 1, r->children,
+                   (rn + 1) * sizeof *r->children);
+            left->num_keys += rn + 1;
+        }
+
+        free(right);
+
+        const size_t pn = parent->node.num_keys;
+        omap_move_keys(omap, &parent->node, sep, &parent->node, sep + 1,
+                       pn - sep - 1);
+        memmove(parent->children + sep + 1, parent->children + sep + 2,
+                (pn - sep - 1) * sizeof *parent->children);
+        parent->node.num_keys -= 1;
+
+        node = &parent->node;
+    }
+
+    if ( !omap->root->leaf && omap->root->num_keys == 0 ) {
+
+        /*  The root has a single child, so the tree shrinks  */
+
+        struct omap_node * old_root = omap->root;
+        omap->root = ((struct omap_inner *) old_root)->children[0];
+        free(old_root);
+    }
+}
+
+static void omap_replace_separator(OMap omap, const void * key)
+{
+    struct omap_node * node = omap->root;
+
+    while ( !node->leaf ) {
+        struct omap_inner * inner = (struct omap_inner *) node;
+        const size_t index = omap_upper_index(omap, node, key);
+
+        if ( index > 0 &&
+             !omap->compfunc(omap_key(omap, node, index - 1), key) ) {
+            struct omap_node * min = inner->children[index];
+            while ( !min->leaf ) {
+                min = ((struct omap_inner *) min)->children[0];
+            }
+            omap_move_keys(omap, node, index - 1, min, 0, 1);
+
+            /*  Separator values are unique among internal nodes  */
+
+            return;
+        }
+
+        node = inner->children[index];
+    }
+}
@@ -0,0 +1,579 @@
+/*!
+ * \file            phash.c
+ * \brief           Implementation of minimal perfect hash data structure.
+ * \details         The hash is built by hash-and-displace. The keys are
+ * hashed into buckets of about `LAMBDA` keys each. Then, taking the
+ * largest buckets first, a search is made for each bucket's pilot, a small
+ * integer which, mixed into the hashes of the bucket's keys, sends every
+ * one of them to a distinct free index. A lookup hashes the key, reads its
+ * bucket's pilot, and computes the index directly. If a search fails, the
+ * build restarts with a different hash seed.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds/phash.h>
+
+/*!
+ * \brief           Average number of keys per bucket.
+ * \details         More keys per bucket means fewer pilots to store, but
+ * longer searches to find them.
+ */
+#define LAMBDA 5
+
+/*!  Number of hash seeds to try before giving up  */
+#define MAX_SEEDS 32
+
+/*!  Minimal perfect hash structure  */
+struct phash {
+    size_t num_keys;                /*!<  Number of keys                    */
+    size_t num_buckets;             /*!<  Number of buckets                 */
+    uint64_t seed;                  /*!<  Hash seed                         */
+    size_t pilot_size;      /*!<  Size of each pilot: one, two or four      */
+    void * pilots;                  /*!<  Pilot for each bucket             */
+    size_t offset_size;     /*!<  Size of each key offset: two or four      */
+    void * offsets;                 /*!<  Offset of each key in 'keys'      */
+    char * keys;                    /*!<  The keys, in index order          */
+    size_t value_size;              /*!<  Size of each value in bytes       */
+    unsigned char * values;         /*!<  Packed values, in index order     */
+    enum gds_datatype type;         /*!<  Value datatype                    */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+};
+
+/*!  Temporary state for building a hash  */
+struct phash_build {
+    uint64_t * hashes;              /*!<  Hash of each key                  */
+    uint64_t * mixed;               /*!<  Remixed hash of each key          */
+    size_t * bucket_start;          /*!<  Start of each bucket's keys       */
+    size_t * bucket_keys;           /*!<  Key indices, grouped by bucket    */
+    size_t * order;                 /*!<  Buckets, largest first            */
+    uint32_t * pilots;              /*!<  Pilot for each bucket             */
+    unsigned char * taken;          /*!<  Flag for each used index          */
+    size_t * slot_key;              /*!<  Key at each index                 */
+    size_t * positions;             /*!<  Candidate indices for a bucket    */
+};
+
+/*!  Result of an attempt to build a hash with one seed  */
+enum phash_result {
+    PHASH_BUILT,                    /*!<  Every bucket was placed           */
+    PHASH_RETRY,                    /*!<  A different seed is needed        */
+    PHASH_DUPLICATE                 /*!<  Two keys were the same            */
+};
+
+/*!
+ * \brief           Reports an error creating a hash.
+ * \param opts      The options passed to `phash_create()`.
+ * \param msg       The message to report.
+ * \param use_errno True to report the error described by `errno`.
+ */
+static void phash_error(const int opts, const char * msg,
+                        const bool use_errno);
+
+/*!
+ * \brief           Mixes the bits of a 64-bit integer.
+ * \details         This is the finalizer of the SplitMix64 generator, and
+ * is a bijection, so distinct inputs give distinct outputs.
+ * \param x         The integer.
+ * \returns         The mixed integer.
+ */
+static uint64_t phash_mix(uint64_t x);
+
+/*!
+ * \brief           Calculates the seeded hash of a key.
+ * \param key       The key.
+ * \param seed      The seed.
+ * \returns         The hash.
+ */
+static uint64_t phash_hash_key(const char * key, const uint64_t seed);
+
+/*!
+ * \brief           Attempts to find pilots for every bucket with one seed.
+ * \param hash      A pointer to the hash being built.
+ * \param build     A pointer to the temporary build state.
+ * \param keys      The keys.
+ * \returns         The result of the attempt.
+ */
+static enum phash_result phash_try_seed(PHash hash,
+                                        struct phash_build * build,
+                                        const char * const * keys);
+
+/*!
+ * \brief           Returns the pilot for a bucket.
+ * \param hash      A pointer to the hash.
+ * \param bucket    The bucket.
+ * \returns         The pilot.
+ */
+static uint64_t phash_pilot(PHash hash, const size_t bucket);
+
+/*!
+ * \brief           Returns the key stored at an index.
+ * \param hash      A pointer to the hash.
+ * \param index     The index.
+ * \returns         The key.
+ */
+static const char * phash_key_at(PHash hash, const size_t index);
+
+/*!
+ * \brief           Frees the temporary build state.
+ * \param build     A pointer to the build state.
+ */
+static void phash_build_free(struct phash_build * build);
+
+/*!
+ * \brief           Frees a pointer value, if it is not `NULL`.
+ * \param hash      A pointer to the hash.
+ * \param index     The index of the value.
+ */
+static void phash_free_value(PHash hash, const size_t index);
+
+PHash phash_create(const char * const * keys, const size_t n,
+                   const enum gds_datatype type, const int opts)
+{
+    struct phash * new_hash = malloc(sizeof *new_hash);
+    if ( !new_hash ) {
+        phash_error(opts, "memory allocation failed", true);
+        return NULL;
+    }
+
+    size_t keys_size = 0;
+    for ( size_t i = 0; i < n; ++i ) {
+        keys_size += strlen(keys[i]) + 1;
+    }
+
+    /*  Key offsets are stored in 32 bits, or 16 when they fit  */
+
+    if ( keys_size > UINT32_MAX ) {
+        free(new_hash);
+        phash_error(opts, "keys too large for perfect hash", false);
+        return NULL;
+    }
+
+    new_hash->num_keys = n;
+    new_hash->num_buckets = (n + LAMBDA - 1) / LAMBDA;
+    new_hash->seed = 0;
+    new_hash->pilot_size = 1;
+    new_hash->pilots = NULL;
+    new_hash->value_size = gdt_size_of_type(type);
+    new_hash->offset_size = (keys_size <= UINT16_MAX + 1) ? 2 : 4;
+    new_hash->type = type;
+    new_hash->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+
+    /*  Allocate at least one byte each, so that an
+     *  empty hash is not mistaken for failure.       */
+
+    new_hash->offsets = malloc(n * new_hash->offset_size + 1);
+    new_hash->keys = malloc(keys_size + 1);
+    new_hash->values = calloc(n * new_hash->value_size + 1, 1);
+
+    struct phash_build build;
+    build.hashes = malloc(n * sizeof *build.hashes + 1);
+    build.mixed = malloc(n * sizeof *build.mixed + 1);
+    build.bucket_start = malloc((new_hash->num_buckets + 1) *
+                                sizeof *build.bucket_start);
+    build.bucket_keys = malloc(n * sizeof *build.bucket_keys + 1);
+    build.order = malloc(new_hash->num_buckets * sizeof *build.order + 1);
+    build.pilots = malloc(new_hash->num_buckets * sizeof *build.pilots + 1);
+    build.taken = malloc(n + 1);
+    build.slot_key = malloc(n * sizeof *build.slot_key + 1);
+    build.positions = malloc((n + 1) * sizeof *build.positions);
+
+    if ( !new_hash->offsets || !new_hash->keys || !new_hash->values ||
+         !build.hashes || !build.mixed || !build.bucket_start ||
+         !build.bucket_keys || !build.order || !build.pilots ||
+         !build.taken || !build.slot_key || !build.positions ) {
+        phash_build_free(&build);
+        phash_destroy(new_hash);
+        phash_error(opts, "memory allocation failed", true);
+        return NULL;
+    }
+
+    enum phash_result result = PHASH_RETRY;
+    for ( uint64_t seed = 0; seed < MAX_SEEDS; ++seed ) {
+        new_hash->seed = seed;
+        result = phash_try_seed(new_hash, &build, keys);
+        if ( result != PHASH_RETRY ) {
+            break;
+        }
+    }
+
+    if ( result != PHASH_BUILT ) {
+        phash_build_free(&build);
+        phash_destroy(new_hash);
+        phash_error(opts, (result == PHASH_DUPLICATE) ?
+                          "keys are not distinct" :
+                          "couldn't build perfect hash", false);
+        return NULL;
+    }
+
+    /*  Store the pilots in the smallest width which holds them all  */
+
+    uint32_t max_pilot = 0;
+    for ( size_t b = 0; b < new_hash->num_buckets; ++b ) {
+        if ( build.pilots[b] > max_pilot ) {
+            max_pilot = build.pilots[b];
+        }
+    }
+
+    new_hash->pilot_size = (max_pilot <= UINT8_MAX) ? 1 :
+                           (max_pilot <= UINT16_MAX) ? 2 : 4;
+    new_hash->pilots = malloc(new_hash->num_buckets *
+                              new_hash->pilot_size + 1);
+    if ( !new_hash->pilots ) {
+        phash_build_free(&build);
+        phash_destroy(new_hash);
+        phash_error(opts, "memory allocation failed", true);
+        return NULL;
+    }
+
+    for ( size_t b = 0; b < new_hash->num_buckets; ++b ) {
+        if ( new_hash->pilot_size == 1 ) {
+            ((uint8_t *) new_hash->pilots)[b] = build.pilots[b];
+        }
+        else if ( new_hash->pilot_size == 2 ) {
+            ((uint16_t *) new_hash->pilots)[b] = build.pilots[b];
+        }
+        else {
+            ((uint32_t *) new_hash->pilots)[b] = build.pilots[b];
+        }
+    }
+
+    /*  Store the keys in index order, so that a lookup's single key
+     *  comparison reads the key stored at the computed index.         */
+
+    size_t offset = 0;
+    for ( size_t i = 0; i < n; ++i ) {
+        const char * key = keys[build.slot_key[i]];
+        const size_t size = strlen(key) + 1;
+        memcpy(new_hash->keys + offset, key, size);
+        if ( new_hash->offset_size == 2 ) {
+            ((uint16_t *) new_hash->offsets)[i] = offset;
+        }
+        else {
+            ((uint32_t *) new_hash->offsets)[i] = offset;
+        }
+        offset += size;
+    }
+
+    phash_build_free(&build);
+
+    return new_hash;
+}
+
+void phash_destroy(PHash hash)
+{
+    if ( hash->free_on_destroy && hash->values ) {
+        for ( size_t i = 0; i < hash->num_keys; ++i ) {
+            phash_free_value(hash, i);
+        }
+    }
+
+    free(hash->pilots);
+    free(hash->offsets);
+    free(hash->keys);
+    free(hash->values);
+    free(hash);
+}
+
+size_t phash_index(PHash hash, const char * key)
+{
+    if ( hash->num_keys == 0 ) {
+        return PHASH_NOT_FOUND;
+    }
+
+    const uint64_t h = phash_hash_key(key, hash->seed);
+    const uint64_t pilot = phash_pilot(hash, h % hash->num_buckets);
+    const size_t index = (phash_mix(h) ^ phash_mix(pilot)) % hash->num_keys;
+
+    if ( strcmp(phash_key_at(hash, index), key) ) {
+        return PHASH_NOT_FOUND;
+    }
+
+    return index;
+}
+
+bool phash_has_key(PHash hash, const char * key)
+{
+    return phash_index(hash, key) != PHASH_NOT_FOUND;
+}
+
+bool phash_set_value(PHash hash, const char * key, ...)
+{
+    const size_t index = phash_index(hash, key);
+    if ( index == PHASH_NOT_FOUND ) {
+        return false;
+    }
+
+    if ( hash->free_on_destroy ) {
+        phash_free_value(hash, index);
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, key);
+    gdt_set_value(&value, hash->type, NULL, ap);
+    va_end(ap);
+
+    gdt_store_raw(&value, hash->values + index * hash->value_size,
+                  hash->value_size);
+
+    return true;
+}
+
+bool phash_value_for_key(PHash hash, const char * key, void * p)
+{
+    const size_t index = phash_index(hash, key);
+    if ( index == PHASH_NOT_FOUND ) {
+        return false;
+    }
+
+    memcpy(p, hash->values + index * hash->value_size, hash->value_size);
+
+    return true;
+}
+
+size_t phash_size(PHash hash)
+{
+    return hash->num_keys;
+}
+
+double phash_bits_per_key(PHash hash)
+{
+    if ( hash->num_keys == 0 ) {
+        return 0.0;
+    }
+
+    return (double) ((hash->num_buckets * hash->pilot_size +
+                      hash->num_keys * hash->offset_size) * 8) /
+           hash->num_keys;
+}
+
+static void phash_error(const int opts, const char * msg,
+                        const bool use_errno)
+{
+    if ( opts & GDS_EXIT_ON_ERROR ) {
+        if ( use_errno ) {
+            quit_strerror("gds library", msg);
+        }
+        else {
+            quit_error("gds library", msg);
+        }
+    }
+    else if ( use_errno ) {
+        log_strerror("gds library", msg);
+    }
+    else {
+        log_error("gds library", msg);
+    }
+}
+
+static uint64_t phash_mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+
+    return x;
+}
+
+static uint64_t phash_hash_key(const char * key, const uint64_t seed)
+{
+    uint64_t h = 0xcbf29ce484222325ULL ^ phash_mix(seed);
+    const unsigned char * p = (const unsigned char *) key;
+
+    while ( *p ) {
+        h = (h ^ *p++) * 0x100000001b3ULL;
+    }
+
+    return phash_mix(h);
+}
+
+static enum phash_result phash_try_seed(PHash hash,
+                                        struct phash_build * build,
+                                        const char * const * keys)
+{
+    const size_t n = hash->num_keys;
+    const size_t num_buckets = hash->num_buckets;
+
+    /*  Hash the keys, and group them by bucket  */
+
+    memset(build->bucket_start, 0,
+           (num_buckets + 1) * sizeof *build->bucket_start);
+
+    for ( size_t i = 0; i < n; ++i ) {
+        build->hashes[i] = phash_hash_key(keys[i], hash->seed);
+        build->mixed[i] = phash_mix(build->hashes[i]);
+        build->bucket_start[build->hashes[i] % num_buckets + 1] += 1;
+    }
+
+    size_t max_size = 0;
+    for ( size_t b = 0; b < num_buckets; ++b ) {
+        if ( build->bucket_start[b + 1] > max_size ) {
+            max_size = build->bucket_start[b + 1];
+        }
+        build->bucket_start[b + 1] += build->bucket_start[b];
+    }
+
+    /*  Use 'positions' as a fill count for each bucket, for now  */
+
+    memset(build->positions, 0, num_buckets * sizeof *build->positions);
+    for ( size_t i = 0; i < n; ++i ) {
+        const size_t b = build->hashes[i] % num_buckets;
+        build->bucket_keys[build->bucket_start[b] +
+                           build->positions[b]++] = i;
+    }
+
+    /*  Order the non-empty buckets by size, largest first, by counting
+     *  sort, using 'positions' to count the buckets of each size and
+     *  then as the next place in 'order' for a bucket of that size.     */
+
+    memset(build->positions, 0, (max_size + 1) * sizeof *build->positions);
+    for ( size_t b = 0; b < num_buckets; ++b ) {
+        build->positions[build->bucket_start[b + 1] -
+                         build->bucket_start[b]] += 1;
+    }
+
+    size_t num_ordered = 0;
+    for ( size_t size = max_size; size > 0; --size ) {
+        const size_t count = build->positions[size];
+        build->positions[size] = num_ordered;
+        num_ordered += count;
+    }
+
+    for ( size_t b = 0; b < num_buckets; ++b ) {
+        const size_t size = build->bucket_start[b + 1] -
+                            build->bucket_start[b];
+        if ( size > 0 ) {
+            build->order[build->positions[size]++] = b;
+        }
+    }
+
+    for ( size_t b = 0; b < num_buckets; ++b ) {
+        build->pilots[b] = 0;
+    }
+    memset(build->taken, 0, n);
+
+    /*  A singleton bucket placed when only one index is free expects
+     *  to try about 'n' pilots, so allow plenty more than that.        */
+
+    const uint64_t max_pilot = (n > (UINT32_MAX - 65536) / 64) ?
+                               UINT32_MAX : n * 64 + 65536;
+
+    for ( size_t o = 0; o < num_ordered; ++o ) {
+        const size_t b = build->order[o];
+        const size_t * bkeys = build->bucket_keys + build->bucket_start[b];
+        const size_t size = build->bucket_start[b + 1] -
+                            build->bucket_start[b];
+
+        /*  Keys with identical hashes can never be separated  */
+
+        for ( size_t i = 0; i < size; ++i ) {
+            for ( size_t j = i + 1; j < size; ++j ) {
+                if ( build->hashes[bkeys[i]] == build->hashes[bkeys[j]] ) {
+                    return strcmp(keys[bkeys[i]], keys[bkeys[j]]) ?
+                           PHASH_RETRY : PHASH_DUPLICATE;
+                }
+            }
+        }
+
+        uint64_t pilot = 0;
+        while ( true ) {
+            if ( pilot > max_pilot ) {
+                return PHASH_RETRY;
+            }
+
+            const uint64_t pmix = phash_mix(pilot);
+            size_t placed = 0;
+
+            for ( ; placed < size; ++placed ) {
+                const size_t pos = (build->mixed[bkeys[placed]] ^ pmix) % n;
+                if ( build->taken[pos] ) {
+                    break;
+                }
+
+                size_t j = 0;
+                while ( j < placed && build->positions[j] != pos ) {
+                    ++j;
+                }
+                if ( j < placed ) {
+                    break;
+                }
+
+                build->positions[placed] = pos;
+            }
+
+            if ( placed == size ) {
+                break;
+            }
+
+            pilot += 1;
+        }
+
+        for ( size_t i = 0; i < size; ++i ) {
+            build->taken[build->positions[i]] = 1;
+            build->slot_key[build->positions[i]] = bkeys[i];
+        }
+        build->pilots[b] = pilot;
+    }
+
+    return PHASH_BUILT;
+}
+
+static uint64_t phash_pilot(PHash hash, const size_t bucket)
+{
+    switch ( hash->pilot_size ) {
+        case 1:
+            return ((const uint8_t *) hash->pilots)[bucket];
+
+        case 2:
+            return ((const uint16_t *) hash->pilots)[bucket];
+
+        default:
+            return ((const uint32_t *) hash->pilots)[bucket];
+    }
+}
+
+static const char * phash_key_at(PHash hash, const size_t index)
+{
+    if ( hash->offset_size == 2 ) {
+        return hash->keys + ((const uint16_t *) hash->offsets)[index];
+    }
+
+    return hash->keys + ((const uint32_t *) hash->offsets)[index];
+}
+
+static void phash_build_free(struct phash_build * build)
+{
+    free(build->hashes);
+    free(build->mixed);
+    free(build->bucket_start);
+    free(build->bucket_keys);
+    free(build->order);
+    free(build->pilots);
+    free(build->taken);
+    free(build->slot_key);
+    free(build->positions);
+}
+
+static void phash_free_value(PHash hash, const size_t index)
+{
+    struct gdt_generic_datatype value;
+    gdt_load_raw(&value, hash->type, hash->values + index * hash->value_size,
+                 hash->value_size);
+
+    /*  Values start out zeroed, and may never have been set  */
+
+    if ( (hash->type == DATATYPE_STRING && value.data.pc) ||
+         (hash->type == DATATYPE_GDSSTRING && value.data.gdsstr) ||
+         (hash->type == DATATYPE_POINTER && value.data.p) ) {
+        gdt_free(&value);
+    }
+}
@@ -0,0 +1,568 @@
+/*!
+ * \file            pqueue.c
+ * \brief           Implementation of generic priority queue data structure.
+ * \details         The queue is a d-ary min-heap stored in a single array
+ * of raw values, rather than generic datatype wrappers, so that the
+ * children of a node sit next to each other in memory. With four
+ * children per node, a sift down reads one or two cache lines per level
+ * of a heap half as deep as a binary one. Sifting moves a hole through
+ * the heap and writes the sifted value once, at the end. An indexed queue
+ * keeps the identifier of each value alongside it in the heap, and the
+ * heap position of each identifier in a separate array.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds/pqueue.h>
+
+/*!  Default number of children of each node  */
+static const size_t PQUEUE_DEFAULT_ARITY = 4;
+
+/*!  Initial capacity of a non-indexed queue  */
+static const size_t PQUEUE_INITIAL_CAPACITY = 16;
+
+/*!  Heap position of an identifier with no value in the queue  */
+static const size_t PQUEUE_NO_POS = SIZE_MAX;
+
+/*!  Priority queue structure  */
+struct pqueue {
+    char * values;                  /*!<  Heap of values                    */
+    size_t * ids;           /*!<  Identifier of each value, if indexed      */
+    size_t * pos;           /*!<  Heap position of each identifier          */
+    size_t num_ids;                 /*!<  Number of identifiers             */
+    size_t size;                    /*!<  Number of values                  */
+    size_t capacity;                /*!<  Capacity of heap                  */
+    size_t arity;                   /*!<  Number of children of each node   */
+    size_t value_size;              /*!<  Size of each value                */
+    enum gds_datatype type;         /*!<  Queue datatype                    */
+    gds_cfunc compfunc;             /*!<  Value comparison function         */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Private function to create a priority queue.
+ * \param num_ids   The number of identifiers, or zero if the queue is
+ * not indexed.
+ * \param arity     The number of children of each node, or zero.
+ * \param type      The datatype for the queue.
+ * \param opts      The options for the queue.
+ * \param ap        A `va_list` containing the comparison function, if
+ * `type` is `DATATYPE_POINTER`.
+ * \retval NULL     Queue creation failed.
+ * \retval non-NULL A pointer to the new queue.
+ */
+static PriorityQueue pqueue_create_internal(const size_t num_ids,
+                                            const size_t arity,
+                                            const enum gds_datatype type,
+                                            const int opts, va_list ap);
+
+/*!
+ * \brief           Returns a pointer to the value at a heap position.
+ * \param queue     A pointer to the queue.
+ * \param index     The heap position.
+ * \returns         A pointer to the value.
+ */
+static char * pqueue_value_at(PriorityQueue queue, const size_t index);
+
+/*!
+ * \brief           Moves a value from one heap position to another.
+ * \param queue     A pointer to the queue.
+ * \param to        The destination position.
+ * \param from      The source position.
+ */
+static void pqueue_move(PriorityQueue queue, const size_t to,
+                        const size_t from);
+
+/*!
+ * \brief           Places a value and its identifier at a heap position.
+ * \param queue     A pointer to the queue.
+ * \param index     The heap position.
+ * \param value     A pointer to the raw value.
+ * \param id        The identifier, ignored if the queue is not indexed.
+ */
+static void pqueue_place(PriorityQueue queue, const size_t index,
+                         const void * value, const size_t id);
+
+/*!
+ * \brief           Sifts a value up the heap from a hole.
+ * \param queue     A pointer to the queue.
+ * \param index     The heap position of the hole.
+ * \param value     A pointer to the raw value to place, which must not
+ * point into the heap.
+ * \param id        The identifier of the value.
+ */
+static void pqueue_sift_up(PriorityQueue queue, size_t index,
+                           const void * value, const size_t id);
+
+/*!
+ * \brief           Sifts a value down the heap from a hole.
+ * \param queue     A pointer to the queue.
+ * \param index     The heap position of the hole.
+ * \param value     A pointer to the raw value to place, which must not
+ * point into the heap.
+ * \param id        The identifier of the value.
+ */
+static void pqueue_sift_down(PriorityQueue queue, size_t index,
+                             const void * value, const size_t id);
+
+/*!
+ * \brief           Removes the value at the top of the heap.
+ * \param queue     A pointer to the queue, which must not be empty.
+ * \param p         A pointer to an object to receive the value.
+ * \returns         The identifier of the value.
+ */
+static size_t pqueue_remove_top(PriorityQueue queue, void * p);
+
+/*!
+ * \brief           Ensures a queue has room for more values.
+ * \param queue     A pointer to the queue.
+ * \param n         The number of values to make room for.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory reallocation failed.
+ */
+static bool pqueue_reserve(PriorityQueue queue, const size_t n);
+
+PriorityQueue pqueue_create(const size_t arity,
+                            const enum gds_datatype type,
+                            const int opts, ...)
+{
+    va_list ap;
+    va_start(ap, opts);
+    PriorityQueue queue = pqueue_create_internal(0, arity, type, opts, ap);
+    va_end(ap);
+
+    return queue;
+}
+
+PriorityQueue pqueue_create_indexed(const size_t num_ids,
+                                    const size_t arity,
+                                    const enum gds_datatype type,
+                                    const int opts, ...)
+{
+    if ( num_ids == 0 ) {
+        abort_error("gds library", "indexed queue needs identifiers");
+    }
+
+    va_list ap;
+    va_start(ap, opts);
+    PriorityQueue queue = pqueue_create_internal(num_ids, arity,
+                                                 type, opts, ap);
+    va_end(ap);
+
+    return queue;
+}
+
+void pqueue_destroy(PriorityQueue queue)
+{
+    if ( queue->free_on_destroy ) {
+        struct gdt_generic_datatype value;
+
+        for ( size_t i = 0; i < queue->size; ++i ) {
+            gdt_load_raw(&value, queue->type, pqueue_value_at(queue, i),
+                         queue->value_size);
+            gdt_free(&value);
+        }
+    }
+
+    free(queue->pos);
+    free(queue->ids);
+    free(queue->values);
+    free(queue);
+}
+
+bool pqueue_push(PriorityQueue queue, ...)
+{
+    if ( queue->ids ) {
+        abort_error("gds library", "indexed queue needs identifier");
+    }
+
+    if ( !pqueue_reserve(queue, 1) ) {
+        return false;
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, queue);
+    gdt_set_value(&value, queue->type, NULL, ap);
+    va_end(ap);
+
+    pqueue_sift_up(queue, queue->size++, &value.data, 0);
+
+    return true;
+}
+
+bool pqueue_heapify(PriorityQueue queue, const void * values,
+                    const size_t n)
+{
+    if ( queue->ids ) {
+        abort_error("gds library", "indexed queue needs identifier");
+    }
+
+    if ( !pqueue_reserve(queue, n) ) {
+        return false;
+    }
+
+    memcpy(pqueue_value_at(queue, queue->size), values,
+           n * queue->value_size);
+    queue->size += n;
+
+    if ( queue->size < 2 ) {
+        return true;
+    }
+
+    /*  Sift down each parent, from the last to the root, which
+     *  takes linear time since most nodes are near the bottom.  */
+
+    struct gdt_generic_datatype value;
+    size_t i = (queue->size - 2) / queue->arity + 1;
+    while ( i-- > 0 ) {
+        gdt_load_raw(&value, queue->type, pqueue_value_at(queue, i),
+                     queue->value_size);
+        pqueue_sift_down(queue, i, &value.data, 0);
+    }
+
+    return true;
+}
+
+bool pqueue_pop(PriorityQueue queue, void * p)
+{
+    if ( queue->size == 0 ) {
+        if ( queue->exit_on_error ) {
+            quit_error("gds library", "queue empty");
+        }
+        else {
+            log_error("gds library", "queue empty");
+            return false;
+        }
+    }
+
+    pqueue_remove_top(queue, p);
+    return true;
+}
+
+bool pqueue_peek(PriorityQueue queue, void * p)
+{
+    if ( queue->size == 0 ) {
+        if ( queue->exit_on_error ) {
+            quit_error("gds library", "queue empty");
+        }
+        else {
+            log_error("gds library", "queue empty");
+            return false;
+        }
+    }
+
+    memcpy(p, pqueue_value_at(queue, 0), queue->value_size);
+    return true;
+}
+
+bool pqueue_push_with_id(PriorityQueue queue, const size_t id, ...)
+{
+    if ( !queue->ids ) {
+        abort_error("gds library", "queue is not indexed");
+    }
+    else if ( id >= queue->num_ids ) {
+        abort_error("gds library", "identifier out of range");
+    }
+
+    if ( queue->pos[id] != PQUEUE_NO_POS ) {
+        if ( queue->exit_on_error ) {
+            quit_error("gds library", "identifier already in queue");
+        }
+        else {
+            log_error("gds library", "identifier already in queue");
+            return false;
+        }
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, id);
+    gdt_set_value(&value, queue->type, NULL, ap);
+    va_end(ap);
+
+    pqueue_sift_up(queue, queue->size++, &value.data, id);
+
+    return true;
+}
+
+bool pqueue_pop_with_id(PriorityQueue queue, size_t * id, void * p)
+{
+    if ( !queue->ids ) {
+        abort_error("gds library", "queue is not indexed");
+    }
+
+    if ( queue->size == 0 ) {
+        if ( queue->exit_on_error ) {
+            quit_error("gds library", "queue empty");
+        }
+        else {
+            log_error("gds library", "queue empty");
+            return false;
+        }
+    }
+
+    *id = pqueue_remove_top(queue, p);
+    return true;
+}
+
+bool pqueue_decrease_key(PriorityQueue queue, const size_t id, ...)
+{
+    if ( !pqueue_contains_id(queue, id) ) {
+        if ( queue->exit_on_error ) {
+            quit_error("gds library", "identifier not in queue");
+        }
+        else {
+            log_error("gds library", "identifier not in queue");
+            return false;
+        }
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, id);
+    gdt_set_value(&value, queue->type, NULL, ap);
+    va_end(ap);
+
+    const size_t index = queue->pos[id];
+    char * old_value = pqueue_value_at(queue, index);
+
+    if ( queue->compfunc(&value.data, old_value) > 0 ) {
+        abort_error("gds library", "new key is greater than old key");
+    }
+
+    if ( queue->free_on_destroy &&
+         memcmp(&value.data, old_value, queue->value_size) ) {
+        struct gdt_generic_datatype old;
+        gdt_load_raw(&old, queue->type, old_value, queue->value_size);
+        gdt_free(&old);
+    }
+
+    pqueue_sift_up(queue, index, &value.data, id);
+
+    return true;
+}
+
+bool pqueue_contains_id(PriorityQueue queue, const size_t id)
+{
+    if ( !queue->ids ) {
+        abort_error("gds library", "queue is not indexed");
+    }
+    else if ( id >= queue->num_ids ) {
+        abort_error("gds library", "identifier out of range");
+    }
+
+    return queue->pos[id] != PQUEUE_NO_POS;
+}
+
+size_t pqueue_size(PriorityQueue queue)
+{
+    return queue->size;
+}
+
+bool pqueue_is_empty(PriorityQueue queue)
+{
+    return queue->size == 0;
+}
+
+static PriorityQueue pqueue_create_internal(const size_t num_ids,
+                                            const size_t arity,
+                                            const enum gds_datatype type,
+                                            const int opts, va_list ap)
+{
+    if ( arity == 1 ) {
+        abort_error("gds library", "heap arity must be at least two");
+    }
+
+    struct pqueue * new_queue = malloc(sizeof *new_queue);
+    if ( !new_queue ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    /*  Custom comparison function only needed for void * members  */
+
+    gds_cfunc cfunc = NULL;
+    if ( type == DATATYPE_POINTER ) {
+        cfunc = va_arg(ap, gds_cfunc);
+    }
+
+    new_queue->num_ids = num_ids;
+    new_queue->size = 0;
+    new_queue->arity = arity ? arity : PQUEUE_DEFAULT_ARITY;
+    new_queue->value_size = gdt_size_of_type(type);
+    new_queue->type = type;
+    new_queue->compfunc = gdt_compfunc_for_type(type, cfunc);
+    new_queue->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_queue->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    /*  An indexed queue holds at most one value per identifier,
+     *  so it never needs to grow.                                */
+
+    new_queue->capacity = num_ids ? num_ids : PQUEUE_INITIAL_CAPACITY;
+    new_queue->values = malloc(new_queue->capacity * new_queue->value_size);
+    new_queue->ids = NULL;
+    new_queue->pos = NULL;
+
+    if ( num_ids ) {
+        new_queue->ids = malloc(num_ids * sizeof *new_queue->ids);
+        new_queue->pos = malloc(num_ids * sizeof *new_queue->pos);
+    }
+
+    if ( !new_queue->values ||
+         (num_ids && (!new_queue->ids || !new_queue->pos)) ) {
+        free(new_queue->pos);
+        free(new_queue->ids);
+        free(new_queue->values);
+        free(new_queue);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    for ( size_t i = 0; i < num_ids; ++i ) {
+        new_queue->pos[i] = PQUEUE_NO_POS;
+    }
+
+    return new_queue;
+}
+
+static char * pqueue_value_at(PriorityQueue queue, const size_t index)
+{
+    return queue->values + index * queue->value_size;
+}
+
+static void pqueue_move(PriorityQueue queue, const size_t to,
+                        const size_t from)
+{
+    memcpy(pqueue_value_at(queue, to), pqueue_value_at(queue, from),
+           queue->value_size);
+    if ( queue->ids ) {
+        queue->ids[to] = queue->ids[from];
+        queue->pos[queue->ids[to]] = to;
+    }
+}
+
+static void pqueue_place(PriorityQueue queue, const size_t index,
+                         const void * value, const size_t id)
+{
+    memcpy(pqueue_value_at(queue, index), value, queue->value_size);
+    if ( queue->ids ) {
+        queue->ids[index] = id;
+        queue->pos[id] = index;
+    }
+}
+
+static void pqueue_sift_up(PriorityQueue queue, size_t index,
+                           const void * value, const size_t id)
+{
+    while ( index > 0 ) {
+        const size_t parent = (index - 1) / queue->arity;
+        if ( queue->compfunc(value, pqueue_value_at(queue, parent)) >= 0 ) {
+            break;
+        }
+        pqueue_move(queue, index, parent);
+        index = parent;
+    }
+
+    pqueue_place(queue, index, value, id);
+}
+
+static void pqueue_sift_down(PriorityQueue queue, size_t index,
+                             const void * value, const size_t id)
+{
+    while ( true ) {
+        const size_t first = index * queue->arity + 1;
+        if ( first >= queue->size ) {
+            break;
+        }
+
+        /*  Find the smallest child  */
+
+        const size_t last = queue->size - first < queue->arity ?
+                            queue->size : first + queue->arity;
+        size_t best = first;
+        for ( size_t child = first + 1; child < last; ++child ) {
+            if ( queue->compfunc(pqueue_value_at(queue, child),
+                                 pqueue_value_at(queue, best)) < 0 ) {
+                best = child;
+            }
+        }
+
+        if ( queue->compfunc(pqueue_value_at(queue, best), value) >= 0 ) {
+            break;
+        }
+        pqueue_move(queue, index, best);
+        index = best;
+    }
+
+    pqueue_place(queue, index, value, id);
+}
+
+static size_t pqueue_remove_top(PriorityQueue queue, void * p)
+{
+    size_t id = 0;
+    memcpy(p, pqueue_value_at(queue, 0), queue->value_size);
+    if ( queue->ids ) {
+        id = queue->ids[0];
+        queue->pos[id] = PQUEUE_NO_POS;
+    }
+
+    /*  Sift the last value down from the hole left at the root  */
+
+    const size_t last = --queue->size;
+    if ( last > 0 ) {
+        struct gdt_generic_datatype value;
+        gdt_load_raw(&value, queue->type, pqueue_value_at(queue, last),
+                     queue->value_size);
+        pqueue_sift_down(queue, 0, &value.data,
+                         queue->ids ? queue->ids[last] : 0);
+    }
+
+    return id;
+}
+
+static bool pqueue_reserve(PriorityQueue queue, const size_t n)
+{
+    if ( queue->capacity - queue->size >= n ) {
+        return true;
+    }
+
+    size_t new_capacity = queue->capacity;
+    while ( new_capacity - queue->size < n ) {
+        new_capacity *= 2;
+    }
+
+    char * new_values = realloc(queue->values,
+                                new_capacity * queue->value_size);
+    if ( !new_values ) {
+        if ( queue->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return false;
+        }
+    }
+
+    queue->values = new_values;
+    queue->capacity = new_capacity;
+    return true;
+}
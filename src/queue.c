@@ -13,10 +13,7 @@
 #include <pggds_internal/gds_common.h>
 #include <pggds/queue.h>
 
-/*!
- * \brief           Growth factor for dynamic memory allocation
- * \attention       queue_push() relies on this being at least 2.
- */
+/*!  Growth factor for dynamic memory allocation  */
 static const size_t GROWTH = 2;
 
 /*!  Queue structure  */
@@ -27,13 +24,34 @@ struct queue {
     size_t size;                                /*!<  Size of queue         */
 
     enum gds_datatype type;                     /*!<  Queue datatype        */
-    struct gdt_generic_datatype * elements;     /*!<  Pointer to elements   */
+    size_t value_size;                          /*!<  Size of each value    */
+    char * elements;                            /*!<  Pointer to elements   */
 
     bool resizable;         /*!<  Dynamically resizable if true             */
     bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
     bool exit_on_error;     /*!<  Exit on error if true                     */
 };
 
+/*!
+ * \brief           Returns a pointer to the element at an index.
+ * \param queue     A pointer to the queue.
+ * \param index     The index into the element array.
+ * \returns         A pointer to the element.
+ */
+static char * queue_element(Queue queue, const size_t index);
+
+/*!
+ * \brief           Ensures a queue has free space for more values.
+ * \details         If the queue is resizable it is grown as needed, and
+ * otherwise running out of space is an error.
+ * \param queue     A pointer to the queue.
+ * \param n         The number of values to make room for.
+ * \retval true     Success
+ * \retval false    Failure, the queue is full or dynamic memory
+ * reallocation failed.
+ */
+static bool queue_reserve(Queue queue, const size_t n);
+
 Queue queue_create(const size_t capacity, const enum gds_datatype type,
                    const int opts)
 {
@@ -53,12 +71,13 @@ Queue queue_create(const size_t capacity, const enum gds_datatype type,
     new_queue->capacity = capacity;
     new_queue->size = 0;
     new_queue->type = type;
+    new_queue->value_size = gdt_size_of_type(type);
 
     new_queue->resizable = (opts & GDS_RESIZABLE) ? true : false;
     new_queue->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
     new_queue->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
 
-    new_queue->elements = malloc(sizeof *new_queue->elements * capacity);
+    new_queue->elements = malloc(new_queue->value_size * capacity);
     if ( !new_queue->elements ) {
         if ( new_queue->exit_on_error ) {
             quit_strerror("gds library", "memory allocation failed");
@@ -85,8 +104,13 @@ void queue_destroy(Queue queue)
          *  to do it manually and tolerate a little code
          *  duplication for the greater good.                */
 
+        struct gdt_generic_datatype value;
+
         while ( queue->size ) {
-            gdt_free(&queue->elements[queue->front++]);
+            gdt_load_raw(&value, queue->type,
+                         queue_element(queue, queue->front++),
+                         queue->value_size);
+            gdt_free(&value);
             if ( queue->front == queue->capacity ) {
                 queue->front = 0;
             }
@@ -102,70 +126,19 @@ void queue_destroy(Queue queue)
 
 bool queue_push(Queue queue, ...)
 {
-    if ( queue_is_full(queue) ) {
-        if ( queue->resizable ) {
-            struct gdt_generic_datatype * new_elements;
-            const size_t new_capacity = queue->capacity * GROWTH;
-
-            new_elements = realloc(queue->elements,
-                                   sizeof *queue->elements * new_capacity);
-            if ( !new_elements ) {
-                if ( queue->exit_on_error ) {
-                    quit_strerror("gds library", "memory allocation failed");
-                }
-                else {
-                    log_strerror("gds library", "memory allocation failed");
-                    return false;
-                }
-            }
-
-            queue->elements = new_elements;
-
-            if ( queue->back < queue->front ||
-                 queue->size == queue->capacity ) {
-
-                /*  If we get here, then the back of the queue
-                 *  is at a lower index than the front of it
-                 *  (or the queue is full and both the back and
-                 *  front are zero). Conceptually the queue is
-                 *  wrapping around the back of the array, and if
-                 *  we resize it, there'll be a gap unless we move
-                 *  those wrapped elements back into the new space.
-                 *  Note that because we always grow by a factor of
-                 *  at least two, there'll always be enough space to
-                 *  move all the wrapped elements. In fact, we here
-                 *  move the entire array from the start through to
-                 *  the front element, including any "empty" ones,
-                 *  which is not really necessary.                    */
-
-                /**  \todo Rewrite to move only the required elements  */
-
-                const size_t excess = new_capacity - queue->capacity;
-                const size_t nfelem = queue->capacity - queue->front;
-                struct gdt_generic_datatype * old_front, * new_front;
-
-                old_front = queue->elements + queue->front;
-                new_front = old_front + excess;
-                memmove(new_front, old_front, nfelem * sizeof *old_front);
-                queue->front += excess;
-            }
-
-            queue->capacity = new_capacity;
-        }
-        else if ( queue->exit_on_error ) {
-            quit_error("gds library", "queue full");
-        }
-        else {
-            log_error("gds library", "queue full");
-            return false;
-        }
+    if ( !queue_reserve(queue, 1) ) {
+        return false;
     }
 
+    struct gdt_generic_datatype value;
     va_list ap;
     va_start(ap, queue);
-    gdt_set_value(&queue->elements[queue->back++], queue->type, NULL, ap);
+    gdt_set_value(&value, queue->type, NULL, ap);
     va_end(ap);
 
+    gdt_store_raw(&value, queue_element(queue, queue->back++),
+                  queue->value_size);
+
     if ( queue->back == queue->capacity ) {
         queue->back = 0;
     }
@@ -175,6 +148,32 @@ bool queue_push(Queue queue, ...)
     return true;
 }
 
+bool queue_push_n(Queue queue, const void * values, const size_t n)
+{
+    if ( n == 0 ) {
+        return true;
+    }
+    else if ( !queue_reserve(queue, n) ) {
+        return false;
+    }
+
+    /*  Copy up to the end of the array, and then wrap around  */
+
+    const size_t room = queue->capacity - queue->back;
+    const size_t first = n < room ? n : room;
+    const char * src = values;
+
+    memcpy(queue_element(queue, queue->back), src,
+           first * queue->value_size);
+    memcpy(queue->elements, src + first * queue->value_size,
+           (n - first) * queue->value_size);
+
+    queue->back = n < room ? queue->back + n : n - room;
+    queue->size += n;
+
+    return true;
+}
+
 bool queue_pop(Queue queue, void * p)
 {
     if ( queue_is_empty(queue) ) {
@@ -187,7 +186,7 @@ bool queue_pop(Queue queue, void * p)
         }
     }
 
-    gdt_get_value(&queue->elements[queue->front++], p);
+    memcpy(p, queue_element(queue, queue->front++), queue->value_size);
 
     if ( queue->front == queue->capacity ) {
         queue->front = 0;
@@ -198,6 +197,30 @@ bool queue_pop(Queue queue, void * p)
     return true;
 }
 
+size_t queue_pop_n(Queue queue, void * p, const size_t max)
+{
+    const size_t n = max < queue->size ? max : queue->size;
+    if ( n == 0 ) {
+        return 0;
+    }
+
+    /*  Copy up to the end of the array, and then wrap around  */
+
+    const size_t avail = queue->capacity - queue->front;
+    const size_t first = n < avail ? n : avail;
+    char * dst = p;
+
+    memcpy(dst, queue_element(queue, queue->front),
+           first * queue->value_size);
+    memcpy(dst + first * queue->value_size, queue->elements,
+           (n - first) * queue->value_size);
+
+    queue->front = n < avail ? queue->front + n : n - avail;
+    queue->size -= n;
+
+    return n;
+}
+
 bool queue_peek(Queue queue, void * p)
 {
     if ( queue_is_empty(queue) ) {
@@ -210,7 +233,7 @@ bool queue_peek(Queue queue, void * p)
         }
     }
 
-    gdt_get_value(&queue->elements[queue->front], p);
+    memcpy(p, queue_element(queue, queue->front), queue->value_size);
 
     return true;
 }
@@ -239,3 +262,67 @@ size_t queue_size(Queue queue)
 {
     return queue->size;
 }
+
+static char * queue_element(Queue queue, const size_t index)
+{
+    return queue->elements + index * queue->value_size;
+}
+
+static bool queue_reserve(Queue queue, const size_t n)
+{
+    if ( queue->capacity - queue->size >= n ) {
+        return true;
+    }
+    else if ( !queue->resizable ) {
+        if ( queue->exit_on_error ) {
+            quit_error("gds library", "queue full");
+        }
+        else {
+            log_error("gds library", "queue full");
+            return false;
+        }
+    }
+
+    size_t new_capacity = queue->capacity;
+    while ( new_capacity - queue->size < n ) {
+        new_capacity = new_capacity ? new_capacity * GROWTH : 1;
+    }
+
+    char * new_elements = realloc(queue->elements,
+                                  queue->value_size * new_capacity);
+    if ( !new_elements ) {
+        if ( queue->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return false;
+        }
+    }
+
+    queue->elements = new_elements;
+
+    if ( queue->front + queue->size > queue->capacity ) {
+
+        /*  The queue wraps around the end of the array, so move the
+         *  elements from the front of the queue up to the end of the
+         *  old array to the end of the new one, leaving the wrapped
+         *  elements at the start of the array where they are.         */
+
+        const size_t excess = new_capacity - queue->capacity;
+        const size_t nfelem = queue->capacity - queue->front;
+
+        memmove(queue_element(queue, queue->front + excess),
+                queue_element(queue, queue->front),
+                nfelem * queue->value_size);
+        queue->front += excess;
+    }
+
+    queue->capacity = new_capacity;
+    queue->back = queue->front + queue->size;
+    if ( queue->back >= queue->capacity ) {
+        queue->back -= queue->capacity;
+    }
+
+    return true;
+}
@@ -0,0 +1,495 @@
+/*!
+ * \file            rcudict.c
+ * \brief           Implementation of read-mostly generic dictionary.
+ * \details         Each snapshot is an open-addressed hash table with
+ * linear probing, whose slots point to immutable key-value pairs. An
+ * update copies the slot array, shares the unchanged pairs with the
+ * previous snapshot, and creates new pairs for inserted or replaced keys.
+ *
+ * Readers' critical sections are those of an epoch-based reclamation
+ * domain. After publishing a new snapshot, a writer synchronizes with the
+ * domain, after which any reader which could have loaded the old snapshot
+ * has left its critical section, and frees the old snapshot directly.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds_internal/dict_internal.h>
+#include <pggds/kvpair.h>
+#include <pggds/stack.h>
+#include <pggds/gds_epoch.h>
+#include <pggds/rcudict.h>
+
+/*!  Initial number of slots, must be a power of two  */
+static const size_t INITIAL_SLOTS = 16;
+
+/*!  Growth factor for dynamic memory allocation  */
+static const size_t GROWTH = 2;
+
+/*!  Initial capacity of the list of retired key-value pairs  */
+static const size_t RETIRED_CAPACITY = 16;
+
+/*!  Snapshot slot structure  */
+struct rcudict_slot {
+    size_t hash;                    /*!<  Full hash of the key              */
+    struct gds_kvpair * pair;       /*!<  Key-value pair, or NULL if empty  */
+};
+
+/*!  Snapshot structure  */
+struct rcudict_table {
+    size_t num_slots;       /*!<  Number of slots, always a power of two    */
+    size_t num_keys;        /*!<  Number of keys in the snapshot            */
+    struct rcudict_slot slots[];                /*!<  The slots             */
+};
+
+/*!  Read-mostly dict structure  */
+struct rcudict {
+
+    /*  Fields read by readers on every lookup  */
+
+    struct rcudict_table * table;       /*!<  Published snapshot            */
+    GDSEpoch epoch;                     /*!<  Reclamation domain            */
+    enum gds_datatype type;             /*!<  Dict datatype                 */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+
+    /*  Fields written by writers, on a separate cache line  */
+
+    char pad[GDS_CACHE_LINE];           /*!<  Padding                       */
+    pthread_mutex_t write_lock;         /*!<  Serializes updates            */
+    struct rcudict_table * pending;     /*!<  Unpublished snapshot          */
+    Stack retired;                      /*!<  Pairs to free after commit    */
+};
+
+/*!
+ * \brief           Creates a snapshot containing the keys of another.
+ * \param dict      A pointer to the dictionary.
+ * \param src       A pointer to the snapshot to copy.
+ * \param num_slots The number of slots in the new snapshot.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the new snapshot.
+ */
+static struct rcudict_table * rcudict_table_copy(RCUDict dict,
+                                        const struct rcudict_table * src,
+                                        const size_t num_slots);
+
+/*!
+ * \brief           Returns the pending snapshot of an update.
+ * \details         The pending snapshot is created by copying the
+ * published one the first time it is needed, and is grown if necessary
+ * to keep the load factor at most one half after `extra` more keys.
+ * \param dict      A pointer to the dictionary.
+ * \param extra     The number of keys about to be added.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the pending snapshot.
+ */
+static struct rcudict_table * rcudict_pending(RCUDict dict,
+                                              const size_t extra);
+
+/*!
+ * \brief           Finds the slot containing a key in a snapshot.
+ * \param table     A pointer to the snapshot.
+ * \param key       The key for which to search.
+ * \param hash      The hash of the key.
+ * \retval NULL     Key was not found
+ * \retval non-NULL A pointer to the slot containing the key
+ */
+static struct rcudict_slot * rcudict_find_slot(struct rcudict_table * table,
+                                               const char * key,
+                                               const size_t hash);
+
+/*!
+ * \brief           Empties a slot in a snapshot.
+ * \details         Later entries in the same probe run are shifted back
+ * to fill the gap, so snapshots never need deleted slot markers.
+ * \param table     A pointer to the snapshot.
+ * \param index     The index of the slot to empty.
+ */
+static void rcudict_remove_slot(struct rcudict_table * table, size_t index);
+
+/*!
+ * \brief           Inserts a key-value into the pending snapshot.
+ * \param dict      A pointer to the dictionary.
+ * \param key       The key.
+ * \param ap        A `va_list` containing the value.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+static bool rcudict_update_insert_internal(RCUDict dict, const char * key,
+                                           va_list ap);
+
+RCUDict rcudict_create(const enum gds_datatype type, const int opts)
+{
+    void * p;
+    if ( posix_memalign(&p, GDS_CACHE_LINE, sizeof(struct rcudict)) ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    struct rcudict * new_dict = p;
+    new_dict->pending = NULL;
+    new_dict->type = type;
+    new_dict->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_dict->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    new_dict->table = rcudict_table_copy(new_dict, NULL, INITIAL_SLOTS);
+    if ( !new_dict->table ) {
+        free(new_dict);
+        return NULL;
+    }
+
+    new_dict->retired = stack_create(RETIRED_CAPACITY, DATATYPE_POINTER,
+                                     GDS_RESIZABLE |
+                                     (opts & GDS_EXIT_ON_ERROR));
+    if ( !new_dict->retired ) {
+        free(new_dict->table);
+        free(new_dict);
+        return NULL;
+    }
+
+    new_dict->epoch = gds_epoch_create(opts & GDS_EXIT_ON_ERROR);
+    if ( !new_dict->epoch ) {
+        stack_destroy(new_dict->retired);
+        free(new_dict->table);
+        free(new_dict);
+        return NULL;
+    }
+
+    if ( pthread_mutex_init(&new_dict->write_lock, NULL) != 0 ) {
+        gds_epoch_destroy(new_dict->epoch);
+        stack_destroy(new_dict->retired);
+        free(new_dict->table);
+        free(new_dict);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "couldn't initialize mutex");
+        }
+        else {
+            log_error("gds library", "couldn't initialize mutex");
+        }
+        return NULL;
+    }
+
+    return new_dict;
+}
+
+void rcudict_destroy(RCUDict dict)
+{
+    gds_epoch_destroy(dict->epoch);
+
+    struct rcudict_table * table = dict->table;
+    for ( size_t i = 0; i < table->num_slots; ++i ) {
+        if ( table->slots[i].pair ) {
+            gds_kvpair_destroy(table->slots[i].pair, dict->free_on_destroy);
+        }
+    }
+    free(table);
+
+    struct gds_kvpair * pair;
+    while ( !stack_is_empty(dict->retired) ) {
+        stack_pop(dict->retired, &pair);
+        gds_kvpair_destroy(pair, dict->free_on_destroy);
+    }
+    stack_destroy(dict->retired);
+
+    pthread_mutex_destroy(&dict->write_lock);
+    free(dict);
+}
+
+bool rcudict_read_lock(RCUDict dict)
+{
+    return gds_epoch_enter(dict->epoch);
+}
+
+void rcudict_read_unlock(RCUDict dict)
+{
+    gds_epoch_exit(dict->epoch);
+}
+
+bool rcudict_has_key(RCUDict dict, const char * key)
+{
+    return rcudict_value_for_key(dict, key, NULL);
+}
+
+bool rcudict_value_for_key(RCUDict dict, const char * key, void * p)
+{
+    const size_t hash = dict_hash_key(key);
+    if ( !gds_epoch_enter(dict->epoch) ) {
+        return false;
+    }
+
+    struct rcudict_table * table = __atomic_load_n(&dict->table,
+                                                   __ATOMIC_ACQUIRE);
+    struct rcudict_slot * slot = rcudict_find_slot(table, key, hash);
+    if ( slot && p ) {
+        gdt_get_value(&slot->pair->value, p);
+    }
+
+    gds_epoch_exit(dict->epoch);
+
+    return slot != NULL;
+}
+
+bool rcudict_insert(RCUDict dict, const char * key, ...)
+{
+    rcudict_update_begin(dict);
+
+    va_list ap;
+    va_start(ap, key);
+    bool status = rcudict_update_insert_internal(dict, key, ap);
+    va_end(ap);
+
+    rcudict_update_commit(dict);
+
+    return status;
+}
+
+bool rcudict_delete(RCUDict dict, const char * key)
+{
+    rcudict_update_begin(dict);
+    bool status = rcudict_update_delete(dict, key);
+    rcudict_update_commit(dict);
+
+    return status;
+}
+
+void rcudict_update_begin(RCUDict dict)
+{
+    if ( pthread_mutex_lock(&dict->write_lock) != 0 ) {
+        abort_error("gds library", "couldn't lock mutex");
+    }
+}
+
+bool rcudict_update_insert(RCUDict dict, const char * key, ...)
+{
+    va_list ap;
+    va_start(ap, key);
+    bool status = rcudict_update_insert_internal(dict, key, ap);
+    va_end(ap);
+
+    return status;
+}
+
+bool rcudict_update_delete(RCUDict dict, const char * key)
+{
+    const size_t hash = dict_hash_key(key);
+
+    /*  Check the pending copy if this update already has one, or
+     *  the published snapshot otherwise, to avoid copying the whole
+     *  table only to find there is nothing to do.                    */
+
+    struct rcudict_table * table = dict->pending ? dict->pending : dict->table;
+    if ( !rcudict_find_slot(table, key, hash) ) {
+        return false;
+    }
+
+    table = rcudict_pending(dict, 0);
+    if ( !table ) {
+        return false;
+    }
+
+    struct rcudict_slot * slot = rcudict_find_slot(table, key, hash);
+    if ( !stack_push(dict->retired, (void *) slot->pair) ) {
+        return false;
+    }
+
+    rcudict_remove_slot(table, (size_t) (slot - table->slots));
+    table->num_keys -= 1;
+
+    return true;
+}
+
+void rcudict_update_commit(RCUDict dict)
+{
+    if ( dict->pending ) {
+        struct rcudict_table * old_table = dict->table;
+
+        __atomic_store_n(&dict->table, dict->pending, __ATOMIC_RELEASE);
+        dict->pending = NULL;
+
+        /*  This aborts if the writer is itself in a critical
+         *  section, since it would otherwise wait forever.     */
+
+        gds_epoch_synchronize(dict->epoch);
+
+        free(old_table);
+
+        struct gds_kvpair * pair;
+        while ( !stack_is_empty(dict->retired) ) {
+            stack_pop(dict->retired, &pair);
+            gds_kvpair_destroy(pair, dict->free_on_destroy);
+        }
+    }
+
+    if ( pthread_mutex_unlock(&dict->write_lock) != 0 ) {
+        abort_error("gds library", "couldn't unlock mutex");
+    }
+}
+
+static struct rcudict_table * rcudict_table_copy(RCUDict dict,
+                                        const struct rcudict_table * src,
+                                        const size_t num_slots)
+{
+    struct rcudict_table * table = calloc(1, sizeof *table +
+                                          num_slots * sizeof *table->slots);
+    if ( !table ) {
+        if ( dict->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    table->num_slots = num_slots;
+    table->num_keys = src ? src->num_keys : 0;
+
+    if ( src && src->num_slots == num_slots ) {
+        memcpy(table->slots, src->slots, num_slots * sizeof *table->slots);
+    }
+    else if ( src ) {
+        const size_t mask = num_slots - 1;
+        for ( size_t i = 0; i < src->num_slots; ++i ) {
+            if ( src->slots[i].pair ) {
+                size_t index = src->slots[i].hash & mask;
+                while ( table->slots[index].pair ) {
+                    index = (index + 1) & mask;
+                }
+                table->slots[index] = src->slots[i];
+            }
+        }
+    }
+
+    return table;
+}
+
+static struct rcudict_table * rcudict_pending(RCUDict dict,
+                                              const size_t extra)
+{
+    const struct rcudict_table * src = dict->pending ? dict->pending :
+                                                       dict->table;
+    size_t num_slots = src->num_slots;
+    while ( (src->num_keys + extra) * 2 > num_slots ) {
+        num_slots *= GROWTH;
+    }
+
+    if ( dict->pending && num_slots == dict->pending->num_slots ) {
+        return dict->pending;
+    }
+
+    struct rcudict_table * table = rcudict_table_copy(dict, src, num_slots);
+    if ( table ) {
+
+        /*  A previous pending snapshot was never published,
+         *  so no reader can be using it.                     */
+
+        free(dict->pending);
+        dict->pending = table;
+    }
+
+    return table;
+}
+
+static struct rcudict_slot * rcudict_find_slot(struct rcudict_table * table,
+                                               const char * key,
+                                               const size_t hash)
+{
+    const size_t mask = table->num_slots - 1;
+    size_t index = hash & mask;
+
+    while ( table->slots[index].pair ) {
+        struct rcudict_slot * slot = &table->slots[index];
+        if ( slot->hash == hash && !strcmp(slot->pair->key, key) ) {
+            return slot;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return NULL;
+}
+
+static void rcudict_remove_slot(struct rcudict_table * table, size_t index)
+{
+    const size_t mask = table->num_slots - 1;
+    size_t next = index;
+
+    while ( true ) {
+        next = (next + 1) & mask;
+        if ( !table->slots[next].pair ) {
+            break;
+        }
+
+        /*  The entry at 'next' may move back into the gap only if
+         *  its home slot does not lie cyclically in (index, next].  */
+
+        const size_t home = table->slots[next].hash & mask;
+        const bool stays = (index <= next) ?
+                           (index < home && home <= next) :
+                           (index < home || home <= next);
+        if ( !stays ) {
+            table->slots[index] = table->slots[next];
+            index = next;
+        }
+    }
+
+    table->slots[index].pair = NULL;
+}
+
+static bool rcudict_update_insert_internal(RCUDict dict, const char * key,
+                                           va_list ap)
+{
+    const size_t hash = dict_hash_key(key);
+
+    struct gds_kvpair * new_pair = gds_kvpair_create(key, dict->type, ap);
+    if ( !new_pair ) {
+        return false;
+    }
+
+    struct rcudict_table * table = rcudict_pending(dict, 1);
+    if ( !table ) {
+        gds_kvpair_destroy(new_pair, dict->free_on_destroy);
+        return false;
+    }
+
+    struct rcudict_slot * slot = rcudict_find_slot(table, key, hash);
+    if ( slot ) {
+
+        /*  Readers of the published snapshot may be using the
+         *  existing pair, so replace it rather than modify it.  */
+
+        if ( !stack_push(dict->retired, (void *) slot->pair) ) {
+            gds_kvpair_destroy(new_pair, dict->free_on_destroy);
+            return false;
+        }
+
+        slot->pair = new_pair;
+    }
+    else {
+        const size_t mask = table->num_slots - 1;
+        size_t index = hash & mask;
+        while ( table->slots[index].pair ) {
+            index = (index + 1) & mask;
+        }
+
+        table->slots[index].hash = hash;
+        table->slots[index].pair = new_pair;
+        table->num_keys += 1;
+    }
+
+    return true;
+}
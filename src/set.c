@@ -0,0 +1,532 @@
+/*!
+ * \file            set.c
+ * \brief           Implementation of generic set data structure.
+ * \details         The set is implemented as an open-addressed hash table
+ * with linear probing. Each slot holds the element's full hash followed by
+ * its raw value, so that probing compares hashes before calling the
+ * element comparison function, and growing the table never rehashes an
+ * element. The slot size depends on the datatype, so the slots are kept
+ * in a byte array.
+ * A hash of zero marks an empty slot. Deleted slots are filled by shifting
+ * back later elements in the same probe run, so the table never
+ * accumulates deleted slot markers.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds/set.h>
+
+/*!  Initial number of slots, must be a power of two  */
+#define SET_INITIAL_SLOTS 16
+
+/*!  Set hash table slot structure  */
+struct set_slot {
+    size_t hash;                    /*!<  Full hash, or 0 if empty          */
+    unsigned char value[];          /*!<  The element's raw value           */
+};
+
+/*!  Set structure  */
+struct set {
+    size_t size;                    /*!<  Number of elements                */
+    size_t num_slots;       /*!<  Number of slots, always a power of two    */
+    size_t value_size;              /*!<  Size of each element              */
+    size_t slot_size;       /*!<  Size of each slot, a multiple of its hash */
+    unsigned char * slots;          /*!<  The hash table slots              */
+    enum gds_datatype type;         /*!<  Set datatype                      */
+    gds_cfunc compfunc;             /*!<  Element comparison function       */
+    gds_hfunc hashfunc;             /*!<  Element hash function             */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Private function to create a set.
+ * \param type      The datatype for the set.
+ * \param compfunc  The comparison function for pointer elements.
+ * \param hashfunc  The hash function for pointer elements.
+ * \param num_slots The number of slots, which must be a power of two.
+ * \param opts      The options for the set.
+ * \retval NULL     Failure, dynamic memory allocation failed
+ * \retval non-NULL A pointer to the new set
+ */
+static Set set_create_internal(const enum gds_datatype type,
+                               gds_cfunc compfunc, gds_hfunc hashfunc,
+                               const size_t num_slots, const int opts);
+
+/*!
+ * \brief           Returns a pointer to a slot.
+ * \param set       A pointer to the set.
+ * \param index     The index of the slot.
+ * \returns         A pointer to the slot.
+ */
+static struct set_slot * set_slot_at(Set set, const size_t index);
+
+/*!
+ * \brief           Calculates the hash of an element.
+ * \param set       A pointer to the set.
+ * \param value     A pointer to the element.
+ * \returns         The hash, which is never zero.
+ */
+static size_t set_hash(Set set, const struct gdt_generic_datatype * value);
+
+/*!
+ * \brief           Frees the element in a slot.
+ * \param set       A pointer to the set.
+ * \param slot      A pointer to the slot.
+ */
+static void set_free_value(Set set, struct set_slot * slot);
+
+/*!
+ * \brief           Finds the slot containing an element.
+ * \param set       A pointer to the set.
+ * \param value     A pointer to the raw element for which to search.
+ * \param hash      The hash of the element.
+ * \returns         A pointer to the slot containing the element, or to the
+ * empty slot at which the search stopped if the element is not in the set.
+ */
+static struct set_slot * set_find_slot(Set set, const void * value,
+                                       const size_t hash);
+
+/*!
+ * \brief           Empties a slot in the hash table.
+ * \details         Later elements in the same probe run are shifted back
+ * to fill the gap.
+ * \param set       A pointer to the set.
+ * \param slot      A pointer to the slot to empty.
+ */
+static void set_remove_slot(Set set, struct set_slot * slot);
+
+/*!
+ * \brief           Doubles the number of slots in a set.
+ * \param set       A pointer to the set.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+static bool set_grow(Set set);
+
+/*!
+ * \brief           Private function to insert an element into a set.
+ * \details         The element is stored as is, and not freed if it is
+ * already a member.
+ * \param set       A pointer to the set.
+ * \param value     A pointer to the raw element to insert.
+ * \param hash      The hash of the element.
+ * \retval true     Success
+ * \retval false    Failure, dynamic memory allocation failed
+ */
+static bool set_insert_internal(Set set, const void * value,
+                                const size_t hash);
+
+/*!
+ * \brief           Checks that two sets may be combined.
+ * \details         Aborts if the sets hold different datatypes.
+ * \param a         A pointer to the first set.
+ * \param b         A pointer to the second set.
+ */
+static void set_check_compatible(Set a, Set b);
+
+Set set_create(const enum gds_datatype type, const int opts, ...)
+{
+    gds_cfunc compfunc = NULL;
+    gds_hfunc hashfunc = NULL;
+
+    va_list ap;
+    va_start(ap, opts);
+    if ( type == DATATYPE_POINTER ) {
+
+        /*  Custom comparison and hash functions only
+         *  needed for void * members                   */
+
+        compfunc = va_arg(ap, gds_cfunc);
+        hashfunc = va_arg(ap, gds_hfunc);
+    }
+    va_end(ap);
+
+    return set_create_internal(type, compfunc, hashfunc,
+                               SET_INITIAL_SLOTS, opts);
+}
+
+void set_destroy(Set set)
+{
+    if ( set->free_on_destroy ) {
+        for ( size_t i = 0; i < set->num_slots; ++i ) {
+            struct set_slot * slot = set_slot_at(set, i);
+            if ( slot->hash ) {
+                set_free_value(set, slot);
+            }
+        }
+    }
+
+    free(set->slots);
+    free(set);
+}
+
+bool set_insert(Set set, ...)
+{
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, set);
+    gdt_set_value(&value, set->type, NULL, ap);
+    va_end(ap);
+
+    const size_t hash = set_hash(set, &value);
+    if ( set_find_slot(set, &value.data, hash)->hash ) {
+        if ( set->free_on_destroy ) {
+            gdt_free(&value);
+        }
+        return true;
+    }
+
+    return set_insert_internal(set, &value.data, hash);
+}
+
+bool set_contains(Set set, ...)
+{
+    struct gdt_generic_datatype needle;
+    va_list ap;
+    va_start(ap, set);
+    gdt_set_value(&needle, set->type, NULL, ap);
+    va_end(ap);
+
+    const size_t hash = set_hash(set, &needle);
+    return set_find_slot(set, &needle.data, hash)->hash != 0;
+}
+
+bool set_remove(Set set, ...)
+{
+    struct gdt_generic_datatype needle;
+    va_list ap;
+    va_start(ap, set);
+    gdt_set_value(&needle, set->type, NULL, ap);
+    va_end(ap);
+
+    struct set_slot * slot = set_find_slot(set, &needle.data,
+                                           set_hash(set, &needle));
+    if ( !slot->hash ) {
+        return false;
+    }
+
+    if ( set->free_on_destroy ) {
+        set_free_value(set, slot);
+    }
+
+    set_remove_slot(set, slot);
+    set->size -= 1;
+    return true;
+}
+
+size_t set_size(Set set)
+{
+    return set->size;
+}
+
+bool set_is_empty(Set set)
+{
+    return set->size == 0;
+}
+
+SetItr set_itr_first(Set set)
+{
+    for ( size_t i = 0; i < set->num_slots; ++i ) {
+        struct set_slot * slot = set_slot_at(set, i);
+        if ( slot->hash ) {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+SetItr set_itr_next(Set set, SetItr itr)
+{
+    const unsigned char * end = set->slots +
+                                set->num_slots * set->slot_size;
+    unsigned char * p = (unsigned char *) itr;
+
+    while ( (p += set->slot_size) < end ) {
+        struct set_slot * slot = (struct set_slot *) p;
+        if ( slot->hash ) {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+void set_itr_value(Set set, SetItr itr, void * p)
+{
+    memcpy(p, itr->value, set->value_size);
+}
+
+Set set_union(Set a, Set b)
+{
+    set_check_compatible(a, b);
+
+    /*  Size the result for both sets up front, so that it
+     *  never grows while it is being filled.               */
+
+    size_t num_slots = a->num_slots > b->num_slots ?
+                       a->num_slots : b->num_slots;
+    while ( (a->size + b->size) * 4 > num_slots * 3 ) {
+        num_slots *= 2;
+    }
+
+    struct set * result = set_create_internal(a->type, a->compfunc,
+                                              a->hashfunc, num_slots,
+                                              a->exit_on_error ?
+                                              GDS_EXIT_ON_ERROR : 0);
+    if ( !result ) {
+        return NULL;
+    }
+
+    for ( size_t i = 0; i < a->num_slots; ++i ) {
+        const struct set_slot * slot = set_slot_at(a, i);
+        if ( slot->hash ) {
+            set_insert_internal(result, slot->value, slot->hash);
+        }
+    }
+
+    for ( size_t i = 0; i < b->num_slots; ++i ) {
+        const struct set_slot * slot = set_slot_at(b, i);
+        if ( slot->hash &&
+             !set_find_slot(result, slot->value, slot->hash)->hash ) {
+            set_insert_internal(result, slot->value, slot->hash);
+        }
+    }
+
+    return result;
+}
+
+Set set_intersection(Set a, Set b)
+{
+    set_check_compatible(a, b);
+
+    /*  Probe the larger set with the elements of the smaller  */
+
+    const Set small = a->size <= b->size ? a : b;
+    const Set large = a->size <= b->size ? b : a;
+
+    struct set * result = set_create_internal(a->type, a->compfunc,
+                                              a->hashfunc, SET_INITIAL_SLOTS,
+                                              a->exit_on_error ?
+                                              GDS_EXIT_ON_ERROR : 0);
+    if ( !result ) {
+        return NULL;
+    }
+
+    for ( size_t i = 0; i < small->num_slots; ++i ) {
+        const struct set_slot * slot = set_slot_at(small, i);
+        if ( slot->hash &&
+             set_find_slot(large, slot->value, slot->hash)->hash &&
+             !set_insert_internal(result, slot->value, slot->hash) ) {
+            set_destroy(result);
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+Set set_difference(Set a, Set b)
+{
+    set_check_compatible(a, b);
+
+    struct set * result = set_create_internal(a->type, a->compfunc,
+                                              a->hashfunc, SET_INITIAL_SLOTS,
+                                              a->exit_on_error ?
+                                              GDS_EXIT_ON_ERROR : 0);
+    if ( !result ) {
+        return NULL;
+    }
+
+    for ( size_t i = 0; i < a->num_slots; ++i ) {
+        const struct set_slot * slot = set_slot_at(a, i);
+        if ( slot->hash &&
+             !set_find_slot(b, slot->value, slot->hash)->hash &&
+             !set_insert_internal(result, slot->value, slot->hash) ) {
+            set_destroy(result);
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+static Set set_create_internal(const enum gds_datatype type,
+                               gds_cfunc compfunc, gds_hfunc hashfunc,
+                               const size_t num_slots, const int opts)
+{
+    /*  Rounding the slot size up to a multiple of the hash size keeps
+     *  every hash aligned, and every element, which is no larger.      */
+
+    const size_t value_size = gdt_size_of_type(type);
+    const size_t slot_size = (sizeof(struct set_slot) + value_size +
+                              sizeof(size_t) - 1) / sizeof(size_t) *
+                             sizeof(size_t);
+
+    struct set * new_set = malloc(sizeof *new_set);
+    if ( new_set ) {
+        new_set->slots = calloc(num_slots, slot_size);
+        if ( !new_set->slots ) {
+            free(new_set);
+            new_set = NULL;
+        }
+    }
+
+    if ( !new_set ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_set->size = 0;
+    new_set->num_slots = num_slots;
+    new_set->value_size = value_size;
+    new_set->slot_size = slot_size;
+    new_set->type = type;
+    new_set->compfunc = gdt_compfunc_for_type(type, compfunc);
+    new_set->hashfunc = hashfunc;
+    new_set->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_set->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    return new_set;
+}
+
+static struct set_slot * set_slot_at(Set set, const size_t index)
+{
+    return (struct set_slot *) (set->slots + index * set->slot_size);
+}
+
+static size_t set_hash(Set set, const struct gdt_generic_datatype * value)
+{
+    const size_t hash = gdt_hash(value, set->hashfunc);
+    return hash ? hash : 1;
+}
+
+static void set_free_value(Set set, struct set_slot * slot)
+{
+    struct gdt_generic_datatype value;
+    gdt_load_raw(&value, set->type, slot->value, set->value_size);
+    gdt_free(&value);
+}
+
+static struct set_slot * set_find_slot(Set set, const void * value,
+                                       const size_t hash)
+{
+    const size_t mask = set->num_slots - 1;
+    size_t index = hash & mask;
+    struct set_slot * slot;
+
+    while ( (slot = set_slot_at(set, index))->hash ) {
+        if ( slot->hash == hash && !set->compfunc(slot->value, value) ) {
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return slot;
+}
+
+static void set_remove_slot(Set set, struct set_slot * slot)
+{
+    const size_t mask = set->num_slots - 1;
+    size_t index = ((unsigned char *) slot - set->slots) / set->slot_size;
+    size_t next = index;
+
+    while ( true ) {
+        next = (next + 1) & mask;
+        const struct set_slot * next_slot = set_slot_at(set, next);
+        if ( !next_slot->hash ) {
+            break;
+        }
+
+        /*  The element at 'next' may move back into the gap only if
+         *  its home slot does not lie cyclically in (index, next].    */
+
+        const size_t home = next_slot->hash & mask;
+        const bool stays = (index <= next) ?
+                           (index < home && home <= next) :
+                           (index < home || home <= next);
+        if ( !stays ) {
+            memcpy(set_slot_at(set, index), next_slot, set->slot_size);
+            index = next;
+        }
+    }
+
+    set_slot_at(set, index)->hash = 0;
+}
+
+static bool set_grow(Set set)
+{
+    const size_t new_num_slots = set->num_slots * 2;
+    unsigned char * new_slots = calloc(new_num_slots, set->slot_size);
+    if ( !new_slots ) {
+        if ( set->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return false;
+        }
+    }
+
+    /*  Elements are distinct, so each needs only an empty slot  */
+
+    const size_t mask = new_num_slots - 1;
+    for ( size_t i = 0; i < set->num_slots; ++i ) {
+        const struct set_slot * slot = set_slot_at(set, i);
+        if ( slot->hash ) {
+            size_t index = slot->hash & mask;
+            struct set_slot * new_slot;
+            while ( (new_slot = (struct set_slot *)
+                         (new_slots + index * set->slot_size))->hash ) {
+                index = (index + 1) & mask;
+            }
+            memcpy(new_slot, slot, set->slot_size);
+        }
+    }
+
+    free(set->slots);
+    set->slots = new_slots;
+    set->num_slots = new_num_slots;
+    return true;
+}
+
+static bool set_insert_internal(Set set, const void * value,
+                                const size_t hash)
+{
+    /*  Keep the table at most three quarters full  */
+
+    if ( (set->size + 1) * 4 > set->num_slots * 3 && !set_grow(set) ) {
+        return false;
+    }
+
+    const size_t mask = set->num_slots - 1;
+    size_t index = hash & mask;
+    struct set_slot * slot;
+    while ( (slot = set_slot_at(set, index))->hash ) {
+        index = (index + 1) & mask;
+    }
+
+    slot->hash = hash;
+    memcpy(slot->value, value, set->value_size);
+    set->size += 1;
+    return true;
+}
+
+static void set_check_compatible(Set a, Set b)
+{
+    if ( a->type != b->type ) {
+        abort_error("gds library", "set types are not compatible");
+    }
+}
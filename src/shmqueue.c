@@ -0,0 +1,600 @@
+/*!
+ * \file            shmqueue.c
+ * \brief           Implementation of shared-memory queue.
+ * \details         The shared memory object holds a header followed by a
+ * circular buffer of cells. As in the multi-producer multi-consumer
+ * queue, each cell carries a sequence number which says whether it is
+ * ready to be written for a given lap of the buffer, or ready to be read.
+ * With several producers, a producer claims a cell by advancing the
+ * enqueue position with a compare-and-swap; with one, it simply stores
+ * the new position. The single consumer never needs a read-modify-write.
+ * Positions and sequence numbers are 64-bit counters, and cells are found
+ * by index, so the queue contains no addresses.
+ *
+ * A process which has to wait registers itself in a waiter count for the
+ * event it is waiting for, reads the event's sequence number, checks the
+ * queue once more, and then sleeps on a futex for as long as the event's
+ * sequence number is unchanged. After each push or pop, the process which
+ * made it reads the waiter count for the opposite event, and only if it
+ * is non-zero advances the sequence number and wakes the sleepers, so in
+ * the steady state no system calls are made. Both sides access the
+ * waiter count with a read-modify-write, rather than a fence and a load,
+ * which orders them so that either the waiter sees the change to the
+ * queue, or the other process sees the waiter.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/shmqueue.h>
+
+/*!  Magic number identifying an initialised queue  */
+static const uint64_t SHMQUEUE_MAGIC = 0x5547515348534447ULL;
+
+/*!  Queue format version  */
+#define SHMQUEUE_VERSION 1
+
+/*!  Number of spins before a waiting process goes to sleep  */
+static const int SPINS_BEFORE_SLEEP = 128;
+
+/*!  Event structure, padded to a cache line  */
+union shmqueue_event {
+    struct {
+        uint32_t sequence;          /*!<  Count of wakeups, futex word      */
+        uint32_t waiters;           /*!<  Number of processes waiting       */
+    } e;                                        /*!<  Event contents        */
+    char pad[GDS_CACHE_LINE];                   /*!<  Padding               */
+};
+
+/*!  Shared queue header structure, at the start of the mapping  */
+struct shmqueue_header {
+
+    /*!  Members set once at creation  */
+    union {
+        struct {
+            uint64_t magic;         /*!<  Magic number, stored last         */
+            uint32_t version;       /*!<  Format version                    */
+            uint32_t type;          /*!<  Queue datatype                    */
+            uint64_t capacity;      /*!<  Capacity, a power of two          */
+            uint64_t cell_size;     /*!<  Size of each cell                 */
+            uint32_t multi_producer;    /*!<  Non-zero if many producers    */
+        } h;                                    /*!<  Header contents       */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } info;
+
+    /*!  Position of next cell to push, shared by producers  */
+    union {
+        uint64_t pos;                           /*!<  Enqueue position      */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } enqueue;
+
+    /*!  Position of next cell to pop, owned by the consumer  */
+    union {
+        uint64_t pos;                           /*!<  Dequeue position      */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } dequeue;
+
+    union shmqueue_event not_empty;     /*!<  Signalled after a push        */
+    union shmqueue_event not_full;      /*!<  Signalled after a pop         */
+};
+
+/*!  Queue cell header structure, followed by the value  */
+struct shmqueue_cell {
+    uint64_t sequence;              /*!<  Sequence number                   */
+};
+
+/*!  Shared-memory queue handle structure, private to each process  */
+struct shmqueue {
+    struct shmqueue_header * header;    /*!<  Start of the mapping          */
+    char * cells;                   /*!<  Circular buffer of cells          */
+    size_t map_size;                /*!<  Size of the mapping               */
+    size_t mask;                    /*!<  Capacity less one                 */
+    size_t cell_size;               /*!<  Size of each cell                 */
+    size_t value_size;              /*!<  Size of each value                */
+    enum gds_datatype type;         /*!<  Queue datatype                    */
+    bool multi_producer;            /*!<  True if many producers            */
+};
+
+/*!
+ * \brief           Private function to report an error.
+ * \param opts      The options passed by the caller.
+ * \param msg       The error message.
+ * \param with_errno    True to include the description of `errno`.
+ * \returns         `NULL`, if the function returns.
+ */
+static ShmQueue shmqueue_error(const int opts, const char * msg,
+                               const bool with_errno);
+
+/*!
+ * \brief           Private function to create a handle for a mapping.
+ * \param header    A pointer to the start of the mapping.
+ * \param map_size  The size of the mapping.
+ * \param opts      The options passed by the caller.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the new handle.
+ */
+static ShmQueue shmqueue_new_handle(struct shmqueue_header * header,
+                                    const size_t map_size, const int opts);
+
+/*!
+ * \brief           Private function to check a datatype is usable.
+ * \param type      The datatype.
+ * \retval true     Values of the datatype may be shared between processes
+ * \retval false    Values of the datatype are pointers
+ */
+static bool shmqueue_type_is_pod(const enum gds_datatype type);
+
+/*!
+ * \brief           Private function to find a cell.
+ * \param queue     A pointer to the queue.
+ * \param pos       The position of the cell.
+ * \returns         A pointer to the cell.
+ */
+static struct shmqueue_cell * shmqueue_cell_at(ShmQueue queue,
+                                               const uint64_t pos);
+
+/*!
+ * \brief           Private function to try to push a value.
+ * \param queue     A pointer to the queue.
+ * \param value     A pointer to the value.
+ * \retval true     Success
+ * \retval false    Failure, the queue is full.
+ */
+static bool shmqueue_try_push_internal(ShmQueue queue,
+                                 const struct gdt_generic_datatype * value);
+
+/*!
+ * \brief           Registers the caller as waiting for an event.
+ * \details         The caller must check its condition again after this
+ * returns, and then call either `shmqueue_wait()` or
+ * `shmqueue_cancel_wait()`.
+ * \param event     A pointer to the event.
+ * \returns         The event's sequence number to pass to
+ * `shmqueue_wait()`.
+ */
+static uint32_t shmqueue_prepare_wait(union shmqueue_event * event);
+
+/*!
+ * \brief           Sleeps until an event is signalled.
+ * \details         Returns immediately if the event has been signalled
+ * since `shmqueue_prepare_wait()` was called, and may return spuriously.
+ * \param event     A pointer to the event.
+ * \param sequence  The sequence number returned by
+ * `shmqueue_prepare_wait()`.
+ */
+static void shmqueue_wait(union shmqueue_event * event,
+                          const uint32_t sequence);
+
+/*!
+ * \brief           Cancels a call to `shmqueue_prepare_wait()`.
+ * \param event     A pointer to the event.
+ */
+static void shmqueue_cancel_wait(union shmqueue_event * event);
+
+/*!
+ * \brief           Wakes any processes waiting for an event.
+ * \param event     A pointer to the event.
+ */
+static void shmqueue_signal(union shmqueue_event * event);
+
+ShmQueue shmqueue_create(const char * name, const size_t capacity,
+                         const enum gds_datatype type,
+                         const bool multi_producer, const int opts)
+{
+    if ( !shmqueue_type_is_pod(type) ) {
+        abort_error("gds library", "queue datatype must not be a pointer");
+    }
+
+    size_t actual_capacity = 2;
+    while ( actual_capacity < capacity ) {
+        actual_capacity *= 2;
+    }
+
+    /*  Round cells up to keep each sequence number aligned  */
+
+    const size_t align = sizeof(struct shmqueue_cell);
+    const size_t cell_size = (align + gdt_size_of_type(type) + align - 1) /
+                             align * align;
+    const size_t map_size = sizeof(struct shmqueue_header) +
+                            actual_capacity * cell_size;
+
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if ( fd == -1 ) {
+        return shmqueue_error(opts, "couldn't create shared memory", true);
+    }
+
+    if ( ftruncate(fd, map_size) == -1 ) {
+        close(fd);
+        shm_unlink(name);
+        return shmqueue_error(opts, "couldn't size shared memory", true);
+    }
+
+    void * base = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+    close(fd);
+    if ( base == MAP_FAILED ) {
+        shm_unlink(name);
+        return shmqueue_error(opts, "couldn't map shared memory", true);
+    }
+
+    /*  The object starts zero-filled, so only non-zero fields are set  */
+
+    struct shmqueue_header * header = base;
+    header->info.h.version = SHMQUEUE_VERSION;
+    header->info.h.type = type;
+    header->info.h.capacity = actual_capacity;
+    header->info.h.cell_size = cell_size;
+    header->info.h.multi_producer = multi_producer ? 1 : 0;
+
+    /*  Each cell is initially ready to be written on the first lap  */
+
+    char * cells = (char *) (header + 1);
+    for ( size_t i = 0; i < actual_capacity; ++i ) {
+        ((struct shmqueue_cell *) (cells + i * cell_size))->sequence = i;
+    }
+
+    /*  Store the magic number last, so another process opening the
+     *  queue sees it only after everything else is initialised.     */
+
+    __atomic_store_n(&header->info.h.magic, SHMQUEUE_MAGIC,
+                     __ATOMIC_RELEASE);
+
+    ShmQueue new_queue = shmqueue_new_handle(header, map_size, opts);
+    if ( !new_queue ) {
+        munmap(base, map_size);
+        shm_unlink(name);
+    }
+
+    return new_queue;
+}
+
+ShmQueue shmqueue_open(const char * name, const int opts)
+{
+    const int fd = shm_open(name, O_RDWR, 0);
+    if ( fd == -1 ) {
+        return shmqueue_error(opts, "couldn't open shared memory", true);
+    }
+
+    struct stat st;
+    if ( fstat(fd, &st) == -1 ) {
+        close(fd);
+        return shmqueue_error(opts, "couldn't get shared memory status",
+                              true);
+    }
+
+    const size_t map_size = st.st_size;
+    if ( map_size < sizeof(struct shmqueue_header) ) {
+        close(fd);
+        return shmqueue_error(opts, "shared memory is not a queue", false);
+    }
+
+    void * base = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+    close(fd);
+    if ( base == MAP_FAILED ) {
+        return shmqueue_error(opts, "couldn't map shared memory", true);
+    }
+
+    /*  Check the header describes exactly the memory we mapped  */
+
+    struct shmqueue_header * header = base;
+    if ( __atomic_load_n(&header->info.h.magic, __ATOMIC_ACQUIRE) !=
+         SHMQUEUE_MAGIC ) {
+        munmap(base, map_size);
+        return shmqueue_error(opts, "shared memory is not a queue", false);
+    }
+
+    const uint64_t capacity = header->info.h.capacity;
+    const uint64_t cell_size = header->info.h.cell_size;
+    if ( header->info.h.version != SHMQUEUE_VERSION ||
+         header->info.h.type > DATATYPE_POINTER ||
+         !shmqueue_type_is_pod(header->info.h.type) ||
+         capacity < 2 || (capacity & (capacity - 1)) ||
+         cell_size < sizeof(struct shmqueue_cell) +
+                     gdt_size_of_type(header->info.h.type) ||
+         capacity > (map_size - sizeof *header) / cell_size ||
+         map_size != sizeof *header + capacity * cell_size ) {
+        munmap(base, map_size);
+        return shmqueue_error(opts, "shared memory is not a valid queue",
+                              false);
+    }
+
+    ShmQueue queue = shmqueue_new_handle(header, map_size, opts);
+    if ( !queue ) {
+        munmap(base, map_size);
+    }
+
+    return queue;
+}
+
+void shmqueue_close(ShmQueue queue)
+{
+    munmap(queue->header, queue->map_size);
+    free(queue);
+}
+
+bool shmqueue_unlink(const char * name)
+{
+    if ( shm_unlink(name) == -1 ) {
+        log_strerror("gds library", "couldn't remove shared memory");
+        return false;
+    }
+
+    return true;
+}
+
+void shmqueue_push(ShmQueue queue, ...)
+{
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, queue);
+    gdt_set_value(&value, queue->type, NULL, ap);
+    va_end(ap);
+
+    union shmqueue_event * event = &queue->header->not_full;
+    int spins = 0;
+    while ( !shmqueue_try_push_internal(queue, &value) ) {
+        if ( spins < SPINS_BEFORE_SLEEP ) {
+            spins += 1;
+            gds_cpu_relax();
+            continue;
+        }
+
+        const uint32_t sequence = shmqueue_prepare_wait(event);
+        if ( shmqueue_try_push_internal(queue, &value) ) {
+            shmqueue_cancel_wait(event);
+            break;
+        }
+        shmqueue_wait(event, sequence);
+    }
+}
+
+bool shmqueue_try_push(ShmQueue queue, ...)
+{
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, queue);
+    gdt_set_value(&value, queue->type, NULL, ap);
+    va_end(ap);
+
+    return shmqueue_try_push_internal(queue, &value);
+}
+
+void shmqueue_pop(ShmQueue queue, void * p)
+{
+    union shmqueue_event * event = &queue->header->not_empty;
+    int spins = 0;
+    while ( !shmqueue_try_pop(queue, p) ) {
+        if ( spins < SPINS_BEFORE_SLEEP ) {
+            spins += 1;
+            gds_cpu_relax();
+            continue;
+        }
+
+        const uint32_t sequence = shmqueue_prepare_wait(event);
+        if ( shmqueue_try_pop(queue, p) ) {
+            shmqueue_cancel_wait(event);
+            break;
+        }
+        shmqueue_wait(event, sequence);
+    }
+}
+
+bool shmqueue_try_pop(ShmQueue queue, void * p)
+{
+    struct shmqueue_header * header = queue->header;
+    const uint64_t pos = __atomic_load_n(&header->dequeue.pos,
+                                         __ATOMIC_RELAXED);
+    struct shmqueue_cell * cell = shmqueue_cell_at(queue, pos);
+
+    if ( __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != pos + 1 ) {
+        return false;
+    }
+
+    memcpy(p, cell + 1, queue->value_size);
+
+    /*  Mark the cell ready to be written on the next lap  */
+
+    __atomic_store_n(&cell->sequence, pos + queue->mask + 1,
+                     __ATOMIC_RELEASE);
+    __atomic_store_n(&header->dequeue.pos, pos + 1, __ATOMIC_RELAXED);
+
+    shmqueue_signal(&header->not_full);
+
+    return true;
+}
+
+size_t shmqueue_size(ShmQueue queue)
+{
+    const uint64_t head = __atomic_load_n(&queue->header->dequeue.pos,
+                                          __ATOMIC_RELAXED);
+    const uint64_t tail = __atomic_load_n(&queue->header->enqueue.pos,
+                                          __ATOMIC_RELAXED);
+    const uint64_t size = tail - head;
+
+    /*  The positions are read separately, so may briefly
+     *  appear to cross, or to exceed the capacity.         */
+
+    if ( (int64_t) size < 0 ) {
+        return 0;
+    }
+    return size > queue->mask + 1 ? queue->mask + 1 : size;
+}
+
+size_t shmqueue_capacity(ShmQueue queue)
+{
+    return queue->mask + 1;
+}
+
+static ShmQueue shmqueue_error(const int opts, const char * msg,
+                               const bool with_errno)
+{
+    if ( opts & GDS_EXIT_ON_ERROR ) {
+        if ( with_errno ) {
+            quit_strerror("gds library", msg);
+        }
+        else {
+            quit_error("gds library", msg);
+        }
+    }
+    else if ( with_errno ) {
+        log_strerror("gds library", msg);
+    }
+    else {
+        log_error("gds library", msg);
+    }
+
+    return NULL;
+}
+
+static ShmQueue shmqueue_new_handle(struct shmqueue_header * header,
+                                    const size_t map_size, const int opts)
+{
+    struct shmqueue * new_queue = malloc(sizeof *new_queue);
+    if ( !new_queue ) {
+        return shmqueue_error(opts, "memory allocation failed", true);
+    }
+
+    new_queue->header = header;
+    new_queue->cells = (char *) (header + 1);
+    new_queue->map_size = map_size;
+    new_queue->mask = header->info.h.capacity - 1;
+    new_queue->cell_size = header->info.h.cell_size;
+    new_queue->type = header->info.h.type;
+    new_queue->value_size = gdt_size_of_type(new_queue->type);
+    new_queue->multi_producer = header->info.h.multi_producer != 0;
+
+    return new_queue;
+}
+
+static bool shmqueue_type_is_pod(const enum gds_datatype type)
+{
+    return type != DATATYPE_STRING && type != DATATYPE_GDSSTRING &&
+           type != DATATYPE_POINTER;
+}
+
+static struct shmqueue_cell * shmqueue_cell_at(ShmQueue queue,
+                                               const uint64_t pos)
+{
+    return (struct shmqueue_cell *) (queue->cells +
+                                     (pos & queue->mask) * queue->cell_size);
+}
+
+static bool shmqueue_try_push_internal(ShmQueue queue,
+                                 const struct gdt_generic_datatype * value)
+{
+    struct shmqueue_header * header = queue->header;
+    uint64_t pos = __atomic_load_n(&header->enqueue.pos, __ATOMIC_RELAXED);
+    struct shmqueue_cell * cell;
+
+    while ( true ) {
+        cell = shmqueue_cell_at(queue, pos);
+        const uint64_t seq = __atomic_load_n(&cell->sequence,
+                                             __ATOMIC_ACQUIRE);
+        const int64_t diff = (int64_t) (seq - pos);
+
+        if ( diff < 0 ) {
+
+            /*  The cell still holds a value from the previous lap  */
+
+            return false;
+        }
+        else if ( !queue->multi_producer ) {
+
+            /*  A single producer always finds the cell free  */
+
+            __atomic_store_n(&header->enqueue.pos, pos + 1,
+                             __ATOMIC_RELAXED);
+            break;
+        }
+        else if ( diff == 0 ) {
+
+            /*  The cell is free for this lap, so try to claim it  */
+
+            if ( __atomic_compare_exchange_n(&header->enqueue.pos, &pos,
+                                             pos + 1, true, __ATOMIC_RELAXED,
+                                             __ATOMIC_RELAXED) ) {
+                break;
+            }
+        }
+        else {
+
+            /*  Another producer claimed the cell first  */
+
+            pos = __atomic_load_n(&header->enqueue.pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(cell + 1, &value->data, queue->value_size);
+
+    /*  Publish the value to the consumer  */
+
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    shmqueue_signal(&header->not_empty);
+
+    return true;
+}
+
+static uint32_t shmqueue_prepare_wait(union shmqueue_event * event)
+{
+    __atomic_add_fetch(&event->e.waiters, 1, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&event->e.sequence, __ATOMIC_SEQ_CST);
+}
+
+static void shmqueue_wait(union shmqueue_event * event,
+                          const uint32_t sequence)
+{
+#ifdef __linux__
+
+    /*  The futex is shared between processes, so is not private  */
+
+    syscall(SYS_futex, &event->e.sequence, FUTEX_WAIT, sequence,
+            NULL, NULL, 0);
+#else
+    (void) sequence;
+    sched_yield();
+#endif
+
+    __atomic_sub_fetch(&event->e.waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+static void shmqueue_cancel_wait(union shmqueue_event * event)
+{
+    __atomic_sub_fetch(&event->e.waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+static void shmqueue_signal(union shmqueue_event * event)
+{
+    if ( __atomic_fetch_add(&event->e.waiters, 0, __ATOMIC_SEQ_CST) == 0 ) {
+        return;
+    }
+
+    __atomic_add_fetch(&event->e.sequence, 1, __ATOMIC_SEQ_CST);
+
+#ifdef __linux__
+    syscall(SYS_futex, &event->e.sequence, FUTEX_WAKE, INT_MAX,
+            NULL, NULL, 0);
+#endif
+}
@@ -0,0 +1,309 @@
+/*!
+ * \file            spscqueue.c
+ * \brief           Implementation of single-producer single-consumer queue.
+ * \details         The values are packed into a circular buffer whose size
+ * is a power of two, indexed by free-running head and tail counters which
+ * are masked to find a slot. The producer alone writes the tail and the
+ * consumer alone writes the head, each publishing with a release store
+ * which the other side reads with an acquire load, so no locks or
+ * read-modify-write operations are needed. The two counters live on
+ * separate cache lines, and each side keeps a private copy of the other's
+ * counter, reloading it only when the queue appears full or empty, so in
+ * the steady state neither side touches the other's cache line.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/spscqueue.h>
+
+/*!  Single-producer single-consumer queue structure  */
+struct spscqueue {
+
+    /*!  Members written only by the producer  */
+    union {
+        struct {
+            size_t tail;            /*!<  Count of values pushed            */
+            size_t cached_head;     /*!<  Last head seen by producer        */
+        } p;                                    /*!<  Producer contents     */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } producer;
+
+    /*!  Members written only by the consumer  */
+    union {
+        struct {
+            size_t head;            /*!<  Count of values popped            */
+            size_t cached_tail;     /*!<  Last tail seen by consumer        */
+        } c;                                    /*!<  Consumer contents     */
+        char pad[GDS_CACHE_LINE];               /*!<  Padding               */
+    } consumer;
+
+    char * values;                  /*!<  Packed circular buffer            */
+    size_t capacity;        /*!<  Capacity, always a power of two           */
+    size_t value_size;              /*!<  Size of each value                */
+    enum gds_datatype type;         /*!<  Queue datatype                    */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Copies values into the circular buffer.
+ * \details         The copy is split in two if it wraps around the end of
+ * the buffer.
+ * \param queue     A pointer to the queue.
+ * \param index     The counter value of the first slot to write.
+ * \param src       A pointer to the values.
+ * \param n         The number of values.
+ */
+static void spscqueue_copy_in(SPSCQueue queue, const size_t index,
+                              const char * src, const size_t n);
+
+/*!
+ * \brief           Copies values out of the circular buffer.
+ * \details         The copy is split in two if it wraps around the end of
+ * the buffer.
+ * \param queue     A pointer to the queue.
+ * \param index     The counter value of the first slot to read.
+ * \param dst       A pointer to the destination.
+ * \param n         The number of values.
+ */
+static void spscqueue_copy_out(SPSCQueue queue, const size_t index,
+                               char * dst, const size_t n);
+
+/*!
+ * \brief           Returns the free space available to the producer.
+ * \details         The consumer's head is reloaded only if the cached
+ * copy does not show enough room.
+ * \param queue     A pointer to the queue.
+ * \param tail      The producer's tail.
+ * \param wanted    The number of free slots wanted.
+ * \returns         The number of free slots.
+ */
+static size_t spscqueue_free_slots(SPSCQueue queue, const size_t tail,
+                                   const size_t wanted);
+
+/*!
+ * \brief           Returns the number of values available to the consumer.
+ * \details         The producer's tail is reloaded only if the cached copy
+ * does not show enough values.
+ * \param queue     A pointer to the queue.
+ * \param head      The consumer's head.
+ * \param wanted    The number of values wanted.
+ * \returns         The number of values available.
+ */
+static size_t spscqueue_used_slots(SPSCQueue queue, const size_t head,
+                                   const size_t wanted);
+
+SPSCQueue spscqueue_create(const size_t capacity,
+                           const enum gds_datatype type,
+                           const int opts)
+{
+    if ( capacity == 0 ) {
+        abort_error("gds library", "SPSC queue capacity must be non-zero");
+    }
+
+    size_t actual_capacity = 1;
+    while ( actual_capacity < capacity ) {
+        actual_capacity *= 2;
+    }
+
+    void * p;
+    if ( posix_memalign(&p, GDS_CACHE_LINE, sizeof(struct spscqueue)) ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    struct spscqueue * new_queue = p;
+    new_queue->capacity = actual_capacity;
+    new_queue->value_size = gdt_size_of_type(type);
+    new_queue->type = type;
+    new_queue->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_queue->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+    new_queue->producer.p.tail = 0;
+    new_queue->producer.p.cached_head = 0;
+    new_queue->consumer.c.head = 0;
+    new_queue->consumer.c.cached_tail = 0;
+
+    new_queue->values = malloc(actual_capacity * new_queue->value_size);
+    if ( !new_queue->values ) {
+        free(new_queue);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    return new_queue;
+}
+
+void spscqueue_destroy(SPSCQueue queue)
+{
+    if ( queue->free_on_destroy ) {
+        struct gdt_generic_datatype value;
+
+        for ( size_t i = queue->consumer.c.head;
+              i != queue->producer.p.tail; ++i ) {
+            gdt_load_raw(&value, queue->type,
+                         queue->values + (i & (queue->capacity - 1)) *
+                                         queue->value_size,
+                         queue->value_size);
+            gdt_free(&value);
+        }
+    }
+
+    free(queue->values);
+    free(queue);
+}
+
+bool spscqueue_push(SPSCQueue queue, ...)
+{
+    const size_t tail = queue->producer.p.tail;
+    if ( spscqueue_free_slots(queue, tail, 1) == 0 ) {
+        return false;
+    }
+
+    struct gdt_generic_datatype value;
+    va_list ap;
+    va_start(ap, queue);
+    gdt_set_value(&value, queue->type, NULL, ap);
+    va_end(ap);
+
+    gdt_store_raw(&value, queue->values +
+                          (tail & (queue->capacity - 1)) * queue->value_size,
+                  queue->value_size);
+    __atomic_store_n(&queue->producer.p.tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool spscqueue_pop(SPSCQueue queue, void * p)
+{
+    const size_t head = queue->consumer.c.head;
+    if ( spscqueue_used_slots(queue, head, 1) == 0 ) {
+        return false;
+    }
+
+    memcpy(p, queue->values + (head & (queue->capacity - 1)) *
+                              queue->value_size,
+           queue->value_size);
+    __atomic_store_n(&queue->consumer.c.head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+size_t spscqueue_push_many(SPSCQueue queue, const void * values,
+                           const size_t n)
+{
+    const size_t tail = queue->producer.p.tail;
+    const size_t free_slots = spscqueue_free_slots(queue, tail, n);
+    const size_t count = free_slots < n ? free_slots : n;
+
+    if ( count > 0 ) {
+        spscqueue_copy_in(queue, tail, values, count);
+        __atomic_store_n(&queue->producer.p.tail, tail + count,
+                         __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+size_t spscqueue_pop_many(SPSCQueue queue, void * p, const size_t max)
+{
+    const size_t head = queue->consumer.c.head;
+    const size_t used_slots = spscqueue_used_slots(queue, head, max);
+    const size_t count = used_slots < max ? used_slots : max;
+
+    if ( count > 0 ) {
+        spscqueue_copy_out(queue, head, p, count);
+        __atomic_store_n(&queue->consumer.c.head, head + count,
+                         __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+size_t spscqueue_size(SPSCQueue queue)
+{
+    /*  Load the head first, so that the tail is never behind it  */
+
+    const size_t head = __atomic_load_n(&queue->consumer.c.head,
+                                        __ATOMIC_ACQUIRE);
+    const size_t tail = __atomic_load_n(&queue->producer.p.tail,
+                                        __ATOMIC_ACQUIRE);
+    return tail - head;
+}
+
+size_t spscqueue_capacity(SPSCQueue queue)
+{
+    return queue->capacity;
+}
+
+static void spscqueue_copy_in(SPSCQueue queue, const size_t index,
+                              const char * src, const size_t n)
+{
+    const size_t start = index & (queue->capacity - 1);
+    const size_t first = queue->capacity - start < n ?
+                         queue->capacity - start : n;
+
+    memcpy(queue->values + start * queue->value_size, src,
+           first * queue->value_size);
+    memcpy(queue->values, src + first * queue->value_size,
+           (n - first) * queue->value_size);
+}
+
+static void spscqueue_copy_out(SPSCQueue queue, const size_t index,
+                               char * dst, const size_t n)
+{
+    const size_t start = index & (queue->capacity - 1);
+    const size_t first = queue->capacity - start < n ?
+                         queue->capacity - start : n;
+
+    memcpy(dst, queue->values + start * queue->value_size,
+           first * queue->value_size);
+    memcpy(dst + first * queue->value_size, queue->values,
+           (n - first) * queue->value_size);
+}
+
+static size_t spscqueue_free_slots(SPSCQueue queue, const size_t tail,
+                                   const size_t wanted)
+{
+    size_t free_slots = queue->capacity -
+                        (tail - queue->producer.p.cached_head);
+    if ( free_slots < wanted ) {
+        queue->producer.p.cached_head =
+            __atomic_load_n(&queue->consumer.c.head, __ATOMIC_ACQUIRE);
+        free_slots = queue->capacity -
+                     (tail - queue->producer.p.cached_head);
+    }
+
+    return free_slots;
+}
+
+static size_t spscqueue_used_slots(SPSCQueue queue, const size_t head,
+                                   const size_t wanted)
+{
+    size_t used_slots = queue->consumer.c.cached_tail - head;
+    if ( used_slots < wanted ) {
+        queue->consumer.c.cached_tail =
+            __atomic_load_n(&queue->producer.p.tail, __ATOMIC_ACQUIRE);
+        used_slots = queue->consumer.c.cached_tail - head;
+    }
+
+    return used_slots;
+}
@@ -0,0 +1,480 @@
+/*!
+ * \file            sstable.c
+ * \brief           Implementation of immutable sorted string table.
+ * \details         The keys are stored in key order in a single byte array,
+ * in blocks of `BLOCK_KEYS` keys. Each key is encoded as the length of the
+ * prefix it shares with the previous key, the length of the remaining
+ * suffix, and the suffix itself, with both lengths as variable-length
+ * integers. The first key in each block shares nothing with its
+ * predecessor, so is stored in full, and a sparse index holds the offset of
+ * each block. A lookup binary searches the blocks by their first keys, and
+ * then scans a single block. The values are held in a separate packed
+ * array, in key order.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds/kvpair.h>
+#include <pggds/sstable.h>
+
+/*!
+ * \brief           Number of keys in each block.
+ * \details         Larger blocks compress better, but a lookup scans up to
+ * a whole block, so this trades memory against lookup time.
+ */
+#define BLOCK_KEYS 16
+
+/*!  Marker for a key which was not found  */
+#define NOT_FOUND SIZE_MAX
+
+/*!  Longest key a prefix scan decodes without allocating  */
+#define SCAN_KEY_LEN 255
+
+/*!  Sorted string table structure  */
+struct sstable {
+    size_t num_keys;                /*!<  Number of keys                    */
+    size_t num_blocks;              /*!<  Number of blocks                  */
+    size_t data_size;               /*!<  Size of the key data in bytes     */
+    size_t max_key_len;             /*!<  Length of the longest key         */
+    size_t value_size;              /*!<  Size of each value in bytes       */
+    size_t * index;                 /*!<  Offset of each block              */
+    unsigned char * data;           /*!<  Encoded keys                      */
+    unsigned char * values;         /*!<  Packed values                     */
+    enum gds_datatype type;         /*!<  Value datatype                    */
+    bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Reports an error creating a table.
+ * \param opts      The options passed to `sstable_create()`.
+ * \param msg       The message to report.
+ * \param use_errno True to report the error described by `errno`.
+ */
+static void sstable_error(const int opts, const char * msg,
+                          const bool use_errno);
+
+/*!
+ * \brief           Returns the encoded size of a variable-length integer.
+ * \param n         The integer.
+ * \returns         The number of bytes needed to encode it.
+ */
+static size_t sstable_varint_size(size_t n);
+
+/*!
+ * \brief           Encodes a variable-length integer.
+ * \details         Seven bits are stored per byte, least significant first,
+ * with the high bit set on every byte except the last.
+ * \param p         A pointer to the buffer to write to.
+ * \param n         The integer.
+ * \returns         A pointer to the byte following the encoding.
+ */
+static unsigned char * sstable_write_varint(unsigned char * p, size_t n);
+
+/*!
+ * \brief           Decodes a variable-length integer.
+ * \param p         A pointer to the encoding.
+ * \param n         A pointer to an object to contain the integer.
+ * \returns         A pointer to the byte following the encoding.
+ */
+static const unsigned char * sstable_read_varint(const unsigned char * p,
+                                                 size_t * n);
+
+/*!
+ * \brief           Returns the length of the common prefix of two strings.
+ * \param s1        The first string.
+ * \param s2        The second string.
+ * \returns         The length of the common prefix.
+ */
+static size_t sstable_common_prefix(const char * s1, const char * s2);
+
+/*!
+ * \brief           Finds the block which may contain a key.
+ * \param table     A pointer to the table, which must not be empty.
+ * \param key       The key.
+ * \returns         The index of the last block whose first key is not
+ * greater than `key`, or zero if there is no such block.
+ */
+static size_t sstable_find_block(SSTable table, const char * key);
+
+/*!
+ * \brief           Finds the index of a key.
+ * \param table     A pointer to the table.
+ * \param key       The key.
+ * \returns         The index of the key, or `NOT_FOUND`.
+ */
+static size_t sstable_find(SSTable table, const char * key);
+
+SSTable sstable_create(Vector pairs, const enum gds_datatype type,
+                       const int opts)
+{
+    const size_t num_keys = vector_length(pairs);
+
+    /*  Check the pairs, and measure the encoded keys  */
+
+    size_t data_size = 0, max_key_len = 0;
+    const char * prev = "";
+
+    for ( size_t i = 0; i < num_keys; ++i ) {
+        KVPair pair;
+        vector_element_at_index(pairs, i, &pair);
+
+        if ( pair->value.type != type ) {
+            sstable_error(opts, "pair value has the wrong type", false);
+            return NULL;
+        }
+
+        if ( i > 0 && strcmp(prev, pair->key) >= 0 ) {
+            sstable_error(opts, "keys are not sorted and unique", false);
+            return NULL;
+        }
+
+        const size_t len = strlen(pair->key);
+        const size_t shared = (i % BLOCK_KEYS) ?
+                              sstable_common_prefix(prev, pair->key) : 0;
+        data_size += sstable_varint_size(shared) +
+                     sstable_varint_size(len - shared) + len - shared;
+        if ( len > max_key_len ) {
+            max_key_len = len;
+        }
+
+        prev = pair->key;
+    }
+
+    struct sstable * new_table = malloc(sizeof *new_table);
+    if ( !new_table ) {
+        sstable_error(opts, "memory allocation failed", true);
+        return NULL;
+    }
+
+    new_table->num_keys = num_keys;
+    new_table->num_blocks = (num_keys + BLOCK_KEYS - 1) / BLOCK_KEYS;
+    new_table->data_size = data_size;
+    new_table->max_key_len = max_key_len;
+    new_table->value_size = gdt_size_of_type(type);
+    new_table->type = type;
+    new_table->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
+    new_table->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    /*  Allocate at least one byte each, so that
+     *  an empty table is not mistaken for failure.  */
+
+    new_table->index = malloc(new_table->num_blocks * sizeof(size_t) + 1);
+    new_table->data = malloc(data_size + 1);
+    new_table->values = malloc(num_keys * new_table->value_size + 1);
+    if ( !new_table->index || !new_table->data || !new_table->values ) {
+        free(new_table->index);
+        free(new_table->data);
+        free(new_table->values);
+        free(new_table);
+        sstable_error(opts, "memory allocation failed", true);
+        return NULL;
+    }
+
+    /*  Encode the keys, and pack the values  */
+
+    unsigned char * p = new_table->data;
+    prev = "";
+
+    for ( size_t i = 0; i < num_keys; ++i ) {
+        KVPair pair;
+        vector_element_at_index(pairs, i, &pair);
+
+        size_t shared = 0;
+        if ( i % BLOCK_KEYS == 0 ) {
+            new_table->index[i / BLOCK_KEYS] = p - new_table->data;
+        }
+        else {
+            shared = sstable_common_prefix(prev, pair->key);
+        }
+
+        const size_t suffix_len = strlen(pair->key) - shared;
+        p = sstable_write_varint(p, shared);
+        p = sstable_write_varint(p, suffix_len);
+        memcpy(p, pair->key + shared, suffix_len);
+        p += suffix_len;
+
+        gdt_store_raw(&pair->value,
+                      new_table->values + i * new_table->value_size,
+                      new_table->value_size);
+
+        prev = pair->key;
+    }
+
+    return new_table;
+}
+
+void sstable_destroy(SSTable table)
+{
+    if ( table->free_on_destroy ) {
+        struct gdt_generic_datatype value;
+        for ( size_t i = 0; i < table->num_keys; ++i ) {
+            gdt_load_raw(&value, table->type,
+                         table->values + i * table->value_size,
+                         table->value_size);
+            gdt_free(&value);
+        }
+    }
+
+    free(table->index);
+    free(table->data);
+    free(table->values);
+    free(table);
+}
+
+bool sstable_has_key(SSTable table, const char * key)
+{
+    return sstable_find(table, key) != NOT_FOUND;
+}
+
+bool sstable_value_for_key(SSTable table, const char * key, void * p)
+{
+    const size_t n = sstable_find(table, key);
+    if ( n == NOT_FOUND ) {
+        return false;
+    }
+
+    memcpy(p, table->values + n * table->value_size, table->value_size);
+
+    return true;
+}
+
+size_t sstable_prefix_scan(SSTable table, const char * prefix,
+                           sstable_visit_func fn, void * ctx)
+{
+    if ( table->num_keys == 0 ) {
+        return 0;
+    }
+
+    /*  The table is never modified after creation, so scans may run
+     *  concurrently and each needs its own buffer. Only tables with
+     *  unusually long keys need one from the heap.                  */
+
+    char short_key[SCAN_KEY_LEN + 1];
+    char * key = short_key;
+    if ( table->max_key_len > SCAN_KEY_LEN ) {
+        key = malloc(table->max_key_len + 1);
+        if ( !key ) {
+            if ( table->exit_on_error ) {
+                quit_strerror("gds library", "memory allocation failed");
+            }
+            else {
+                log_strerror("gds library", "memory allocation failed");
+                return 0;
+            }
+        }
+    }
+
+    const size_t prefix_len = strlen(prefix);
+    const size_t block = sstable_find_block(table, prefix);
+    const unsigned char * p = table->data + table->index[block];
+    size_t visited = 0;
+
+    /*  Blocks are contiguous, so decode straight through
+     *  them until past the last key with the prefix.       */
+
+    for ( size_t n = block * BLOCK_KEYS; n < table->num_keys; ++n ) {
+        size_t shared, suffix_len;
+        p = sstable_read_varint(p, &shared);
+        p = sstable_read_varint(p, &suffix_len);
+        memcpy(key + shared, p, suffix_len);
+        key[shared + suffix_len] = '\0';
+        p += suffix_len;
+
+        const int cmp = strncmp(key, prefix, prefix_len);
+        if ( cmp < 0 ) {
+            continue;
+        }
+        else if ( cmp > 0 ) {
+            break;
+        }
+
+        struct gdt_generic_datatype value;
+        gdt_load_raw(&value, table->type,
+                     table->values + n * table->value_size, table->value_size);
+
+        visited += 1;
+        if ( !fn(key, &value.data, ctx) ) {
+            break;
+        }
+    }
+
+    if ( key != short_key ) {
+        free(key);
+    }
+
+    return visited;
+}
+
+size_t sstable_size(SSTable table)
+{
+    return table->num_keys;
+}
+
+size_t sstable_memory_usage(SSTable table)
+{
+    return sizeof *table + table->num_blocks * sizeof *table->index +
+           table->data_size + table->num_keys * table->value_size;
+}
+
+static void sstable_error(const int opts, const char * msg,
+                          const bool use_errno)
+{
+    if ( opts & GDS_EXIT_ON_ERROR ) {
+        if ( use_errno ) {
+            quit_strerror("gds library", msg);
+        }
+        else {
+            quit_error("gds library", msg);
+        }
+    }
+    else if ( use_errno ) {
+        log_strerror("gds library", msg);
+    }
+    else {
+        log_error("gds library", msg);
+    }
+}
+
+static size_t sstable_varint_size(size_t n)
+{
+    size_t size = 1;
+    while ( n >= 0x80 ) {
+        n >>= 7;
+        size += 1;
+    }
+
+    return size;
+}
+
+static unsigned char * sstable_write_varint(unsigned char * p, size_t n)
+{
+    while ( n >= 0x80 ) {
+        *p++ = (unsigned char) (n | 0x80);
+        n >>= 7;
+    }
+    *p++ = (unsigned char) n;
+
+    return p;
+}
+
+static const unsigned char * sstable_read_varint(const unsigned char * p,
+                                                 size_t * n)
+{
+    size_t value = 0;
+    unsigned int shift = 0;
+
+    while ( *p & 0x80 ) {
+        value |= (size_t) (*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= (size_t) *p++ << shift;
+
+    *n = value;
+    return p;
+}
+
+static size_t sstable_common_prefix(const char * s1, const char * s2)
+{
+    size_t n = 0;
+    while ( s1[n] && s1[n] == s2[n] ) {
+        ++n;
+    }
+
+    return n;
+}
+
+static size_t sstable_find_block(SSTable table, const char * key)
+{
+    const size_t key_len = strlen(key);
+    size_t lo = 0, hi = table->num_blocks;
+
+    while ( hi - lo > 1 ) {
+        const size_t mid = lo + (hi - lo) / 2;
+
+        /*  The first key of a block is stored in full  */
+
+        size_t shared, len;
+        const unsigned char * p = table->data + table->index[mid];
+        p = sstable_read_varint(p, &shared);
+        p = sstable_read_varint(p, &len);
+
+        int cmp = memcmp(p, key, len < key_len ? len : key_len);
+        if ( cmp == 0 ) {
+            cmp = (len > key_len) - (len < key_len);
+        }
+
+        if ( cmp <= 0 ) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static size_t sstable_find(SSTable table, const char * key)
+{
+    if ( table->num_keys == 0 ) {
+        return NOT_FOUND;
+    }
+
+    const size_t block = sstable_find_block(table, key);
+    const unsigned char * p = table->data + table->index[block];
+    const unsigned char * target = (const unsigned char *) key;
+    size_t end = (block + 1) * BLOCK_KEYS;
+    if ( end > table->num_keys ) {
+        end = table->num_keys;
+    }
+
+    /*  Compare without rebuilding the keys. 'match' is the length of
+     *  the prefix the previous key shares with the target, and the
+     *  previous key is always less than the target. A key sharing more
+     *  than that with its predecessor is also less than the target, and
+     *  one sharing less is greater, so only keys sharing exactly that
+     *  much need their suffixes compared.                                */
+
+    size_t match = 0;
+
+    for ( size_t n = block * BLOCK_KEYS; n < end; ++n ) {
+        size_t shared, suffix_len;
+        p = sstable_read_varint(p, &shared);
+        p = sstable_read_varint(p, &suffix_len);
+        const unsigned char * suffix = p;
+        p += suffix_len;
+
+        if ( shared > match ) {
+            continue;
+        }
+        else if ( shared < match ) {
+            return NOT_FOUND;
+        }
+
+        const unsigned char * t = target + match;
+        size_t i = 0;
+        while ( i < suffix_len && t[i] && suffix[i] == t[i] ) {
+            ++i;
+        }
+
+        if ( i == suffix_len ) {
+            if ( !t[i] ) {
+                return n;
+            }
+        }
+        else if ( !t[i] || suffix[i] > t[i] ) {
+            return NOT_FOUND;
+        }
+
+        match += i;
+    }
+
+    return NOT_FOUND;
+}
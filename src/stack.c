@@ -1,6 +1,11 @@
 /*!
  * \file            stack.c
  * \brief           Implementation of generic stack data structure.
+ * \details         The values are stored in a chain of chunks, with the
+ * top of the stack in the highest chunk holding any values. An ordinary
+ * stack has a single chunk which is reallocated when it fills. A
+ * segmented stack instead links a new chunk above the last, so values
+ * are never moved once pushed, and frees unused chunks as it shrinks.
  * \author          Paul Griffiths
  * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
  * of the GNU General Public License. <http://www.gnu.org/licenses/>
@@ -8,6 +13,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdarg.h>
 #include <pggds_internal/gds_common.h>
 #include <pggds/stack.h>
@@ -15,17 +21,68 @@
 /*!  Growth factor for dynamic memory allocation  */
 static const size_t GROWTH = 2;
 
+/*!  Size of each added chunk of a segmented stack with no initial capacity  */
+static const size_t STACK_CHUNK_SIZE = 64;
+
+/*!  Stack chunk structure  */
+struct stack_chunk {
+    struct stack_chunk * prev;              /*!<  Chunk below, or NULL      */
+    struct stack_chunk * next;      /*!<  Empty chunk above, or NULL        */
+    size_t capacity;                        /*!<  Number of values held     */
+    char elements[];                        /*!<  The values                */
+};
+
 /*!  Stack structure  */
 struct stack {
+    struct stack_chunk * chunk;     /*!<  Chunk holding top of stack        */
+    size_t used;                    /*!<  Number of values in that chunk    */
     size_t top;                                 /*!<  Top of stack          */
     size_t capacity;                            /*!<  Stack capacity        */
+    size_t chunk_size;      /*!<  Size of each chunk added when segmented   */
     enum gds_datatype type;                     /*!<  Stack datatype        */
-    struct gdt_generic_datatype * elements;     /*!<  Pointer to elements   */
+    size_t value_size;                          /*!<  Size of each value    */
     bool resizable;         /*!<  Dynamically resizabe if true              */
+    bool segmented;         /*!<  Grow by adding chunks if true             */
     bool free_on_destroy;   /*!<  Free pointer elements on destroy if true  */
     bool exit_on_error;     /*!<  Exit on error if true                     */
 };
 
+/*!
+ * \brief           Allocates a stack chunk.
+ * \param stack     A pointer to the stack.
+ * \param chunk     A pointer to a chunk to reallocate, or `NULL`.
+ * \param capacity  The number of values the chunk is to hold.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the chunk.
+ */
+static struct stack_chunk * stack_alloc_chunk(Stack stack,
+                                              struct stack_chunk * chunk,
+                                              const size_t capacity);
+
+/*!
+ * \brief           Moves the top of a stack down to the chunk below.
+ * \details         The chunk being left becomes the single spare chunk
+ * kept above the top, and any chunks already above it are freed, so
+ * that pushing and popping back and forth across a chunk boundary does
+ * not allocate and free a chunk every time.
+ * \param stack     A pointer to the stack, whose top chunk is empty.
+ */
+static void stack_chunk_down(Stack stack);
+
+/*!
+ * \brief           Ensures a stack has free space for more values.
+ * \details         If the stack is resizable it is grown as needed, and
+ * otherwise running out of space is an error. A segmented stack grows by
+ * adding fixed-size chunks above its existing chunks, and any other stack
+ * grows geometrically by reallocating its single chunk.
+ * \param stack     A pointer to the stack.
+ * \param n         The number of values to make room for.
+ * \retval true     Success
+ * \retval false    Failure, the stack is full or dynamic memory
+ * reallocation failed.
+ */
+static bool stack_reserve(Stack stack, const size_t n);
+
 Stack stack_create(const size_t capacity, const enum gds_datatype type,
                    const int opts)
 {
@@ -41,22 +98,20 @@ Stack stack_create(const size_t capacity, const enum gds_datatype type,
     }
 
     new_stack->capacity = capacity;
+    new_stack->chunk_size = capacity ? capacity : STACK_CHUNK_SIZE;
     new_stack->top = 0;
+    new_stack->used = 0;
     new_stack->type = type;
-    new_stack->resizable = (opts & GDS_RESIZABLE) ? true : false;
+    new_stack->value_size = gdt_size_of_type(type);
+    new_stack->segmented = (opts & GDS_SEGMENTED) ? true : false;
+    new_stack->resizable = (opts & GDS_RESIZABLE) || new_stack->segmented;
     new_stack->free_on_destroy = (opts & GDS_FREE_ON_DESTROY) ? true : false;
     new_stack->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
 
-    new_stack->elements = malloc(sizeof *new_stack->elements * capacity);
-    if ( !new_stack->elements ) {
-        if ( new_stack->exit_on_error ) {
-            quit_strerror("gds library", "memory allocation failed");
-        }
-        else {
-            log_strerror("gds library", "memory allocation failed");
-            free(new_stack);
-            return NULL;
-        }
+    new_stack->chunk = stack_alloc_chunk(new_stack, NULL, capacity);
+    if ( !new_stack->chunk ) {
+        free(new_stack);
+        return NULL;
     }
 
     return new_stack;
@@ -72,51 +127,89 @@ void stack_destroy(Stack stack)
          *  to do it manually and tolerate a little code
          *  duplication for the greater good.                */
 
-        while ( stack->top ) {
-            gdt_free(&stack->elements[--stack->top]);
+        struct gdt_generic_datatype value;
+
+        struct stack_chunk * chunk = stack->chunk;
+        size_t used = stack->used;
+        while ( chunk ) {
+            while ( used ) {
+                gdt_load_raw(&value, stack->type,
+                             chunk->elements + --used * stack->value_size,
+                             stack->value_size);
+                gdt_free(&value);
+            }
+            chunk = chunk->prev;
+            used = chunk ? chunk->capacity : 0;
         }
     }
 
-    free(stack->elements);
+    struct stack_chunk * chunk = stack->chunk;
+    while ( chunk->next ) {
+        chunk = chunk->next;
+    }
+    while ( chunk ) {
+        struct stack_chunk * prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+
     free(stack);
 }
 
 bool stack_push(Stack stack, ...)
 {
-    if ( stack_is_full(stack) ) {
-        if ( stack->resizable ) {
-            struct gdt_generic_datatype * new_elements;
-            const size_t new_capacity = stack->capacity * GROWTH;
-
-            new_elements = realloc(stack->elements,
-                                   sizeof *stack->elements * new_capacity);
-            if ( !new_elements ) {
-                if ( stack->exit_on_error ) {
-                    quit_strerror("gds library", "memory allocation failed");
-                }
-                else {
-                    log_strerror("gds library", "memory allocation failed");
-                    return false;
-                }
-            }
-
-            stack->elements = new_elements;
-            stack->capacity = new_capacity;
-        }
-        else if ( stack->exit_on_error ) {
-            quit_error("gds library", "stack full");
-        }
-        else {
-            log_error("gds library", "stack full");
-            return false;
-        }
+    if ( !stack_reserve(stack, 1) ) {
+        return false;
     }
 
+    struct gdt_generic_datatype value;
     va_list ap;
     va_start(ap, stack);
-    gdt_set_value(&stack->elements[stack->top++], stack->type, NULL, ap);
+    gdt_set_value(&value, stack->type, NULL, ap);
     va_end(ap);
 
+    if ( stack->used == stack->chunk->capacity ) {
+        stack->chunk = stack->chunk->next;
+        stack->used = 0;
+    }
+
+    gdt_store_raw(&value,
+                  stack->chunk->elements + stack->used++ * stack->value_size,
+                  stack->value_size);
+    stack->top += 1;
+
+    return true;
+}
+
+bool stack_push_n(Stack stack, const void * values, const size_t n)
+{
+    if ( n == 0 ) {
+        return true;
+    }
+    else if ( !stack_reserve(stack, n) ) {
+        return false;
+    }
+
+    /*  Copy as much as fits into each chunk in turn  */
+
+    const char * src = values;
+    size_t remaining = n;
+    while ( remaining ) {
+        if ( stack->used == stack->chunk->capacity ) {
+            stack->chunk = stack->chunk->next;
+            stack->used = 0;
+        }
+
+        const size_t room = stack->chunk->capacity - stack->used;
+        const size_t count = remaining < room ? remaining : room;
+        memcpy(stack->chunk->elements + stack->used * stack->value_size,
+               src, count * stack->value_size);
+        stack->used += count;
+        src += count * stack->value_size;
+        remaining -= count;
+    }
+    stack->top += n;
+
     return true;
 }
 
@@ -132,9 +225,34 @@ bool stack_pop(Stack stack, void * p)
         }
     }
 
-    gdt_get_value(&stack->elements[--stack->top], p);
+    return stack_pop_n(stack, p, 1) == 1;
+}
 
-    return true;
+size_t stack_pop_n(Stack stack, void * p, const size_t max)
+{
+    const size_t n = max < stack->top ? max : stack->top;
+
+    /*  Copy from the top chunk downwards, filling the
+     *  array from the end so values stay in push order.  */
+
+    char * dst = p;
+    size_t remaining = n;
+    while ( remaining ) {
+        const size_t count = remaining < stack->used ?
+                             remaining : stack->used;
+        stack->used -= count;
+        remaining -= count;
+        memcpy(dst + remaining * stack->value_size,
+               stack->chunk->elements + stack->used * stack->value_size,
+               count * stack->value_size);
+
+        if ( stack->used == 0 && stack->chunk->prev ) {
+            stack_chunk_down(stack);
+        }
+    }
+    stack->top -= n;
+
+    return n;
 }
 
 bool stack_peek(Stack stack, void * p)
@@ -149,7 +267,8 @@ bool stack_peek(Stack stack, void * p)
         }
     }
 
-    gdt_get_value(&stack->elements[stack->top - 1], p);
+    memcpy(p, stack->chunk->elements + (stack->used - 1) * stack->value_size,
+           stack->value_size);
 
     return true;
 }
@@ -178,3 +297,103 @@ size_t stack_size(Stack stack)
 {
     return stack->top;
 }
+
+static struct stack_chunk * stack_alloc_chunk(Stack stack,
+                                              struct stack_chunk * chunk,
+                                              const size_t capacity)
+{
+    struct stack_chunk * new_chunk =
+        realloc(chunk, sizeof *new_chunk + capacity * stack->value_size);
+    if ( !new_chunk ) {
+        if ( stack->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    if ( !chunk ) {
+        new_chunk->prev = NULL;
+        new_chunk->next = NULL;
+    }
+    new_chunk->capacity = capacity;
+
+    return new_chunk;
+}
+
+static void stack_chunk_down(Stack stack)
+{
+    struct stack_chunk * chunk = stack->chunk;
+    struct stack_chunk * spare = chunk->next;
+
+    while ( spare ) {
+        struct stack_chunk * next = spare->next;
+        stack->capacity -= spare->capacity;
+        free(spare);
+        spare = next;
+    }
+    chunk->next = NULL;
+
+    stack->chunk = chunk->prev;
+    stack->used = stack->chunk->capacity;
+}
+
+static bool stack_reserve(Stack stack, const size_t n)
+{
+    if ( stack->capacity - stack->top >= n ) {
+        return true;
+    }
+    else if ( !stack->resizable ) {
+        if ( stack->exit_on_error ) {
+            quit_error("gds library", "stack full");
+        }
+        else {
+            log_error("gds library", "stack full");
+            return false;
+        }
+    }
+
+    if ( stack->segmented ) {
+
+        /*  Add fixed-size chunks above the last chunk until there
+         *  is room, so no existing value is copied or moved.       */
+
+        struct stack_chunk * last = stack->chunk;
+        while ( last->next ) {
+            last = last->next;
+        }
+
+        while ( stack->capacity - stack->top < n ) {
+            struct stack_chunk * new_chunk =
+                stack_alloc_chunk(stack, NULL, stack->chunk_size);
+            if ( !new_chunk ) {
+                return false;
+            }
+
+            new_chunk->prev = last;
+            last->next = new_chunk;
+            last = new_chunk;
+            stack->capacity += stack->chunk_size;
+        }
+
+        return true;
+    }
+
+    size_t new_capacity = stack->capacity;
+    while ( new_capacity - stack->top < n ) {
+        new_capacity = new_capacity ? new_capacity * GROWTH : 1;
+    }
+
+    struct stack_chunk * new_chunk =
+        stack_alloc_chunk(stack, stack->chunk, new_capacity);
+    if ( !new_chunk ) {
+        return false;
+    }
+
+    stack->chunk = new_chunk;
+    stack->capacity = new_capacity;
+
+    return true;
+}
@@ -0,0 +1,726 @@
+/*!
+ * \file            threadpool.c
+ * \brief           Implementation of work-stealing thread pool.
+ * \details         Each worker owns a Chase-Lev deque of tasks. The owner
+ * pushes and takes tasks at the bottom without any read-modify-write
+ * operation except when taking the last task, and other workers steal
+ * from the top with a single compare-and-swap. Tasks submitted from
+ * outside the pool go to a shared injection queue guarded by the pool
+ * mutex. The deque arrays grow by doubling, and outgrown arrays are kept
+ * until the pool is destroyed, since a thief may still be reading one.
+ *
+ * Idle workers sleep on a condition variable. Every submission advances a
+ * work counter, and a worker only goes to sleep if the counter has not
+ * moved since it started its last unsuccessful search for work, so a task
+ * submitted while a worker is deciding to sleep is never missed. Threads
+ * waiting for tasks to finish run other tasks while they wait, and sleep
+ * on a second condition variable only when there are none to run.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds_internal/gds_atomic.h>
+#include <pggds/threadpool.h>
+
+/*!  Initial number of tasks in each deque, must be a power of two  */
+static const size_t INITIAL_DEQUE_SIZE = 64;
+
+/*!  Number of unsuccessful searches for work before sleeping  */
+static const int SPINS_BEFORE_SLEEP = 64;
+
+/*!  Parallel for loop structure  */
+struct threadpool_pfor {
+    threadpool_range_func fn;       /*!<  Loop body function                */
+    void * ctx;                     /*!<  Loop body context                 */
+    size_t grain;                   /*!<  Largest piece to run unsplit      */
+    size_t pending;                 /*!<  Number of unfinished pieces       */
+};
+
+/*!  Task structure, which is also the future for the task  */
+struct threadpool_task {
+    threadpool_task_func func;      /*!<  Task function                     */
+    void * arg;                     /*!<  Task function argument            */
+    void * result;                  /*!<  Task function result              */
+    size_t pending;                 /*!<  1 until the task has finished     */
+    struct threadpool_pfor * pfor;  /*!<  Loop, if a piece of a loop        */
+    size_t begin;                   /*!<  Start of loop piece               */
+    size_t end;                     /*!<  End of loop piece                 */
+    ThreadPool pool;                /*!<  The pool running the task         */
+    struct threadpool_task * next;  /*!<  Next task in injection queue      */
+};
+
+/*!  Deque array structure  */
+struct threadpool_array {
+    size_t mask;                    /*!<  Size less one                     */
+    struct threadpool_array * older;        /*!<  Outgrown array            */
+    struct threadpool_task * tasks[];       /*!<  The tasks                 */
+};
+
+/*!
+ * \brief           Worker structure.
+ * \details         The top of the deque, written by thieves, is kept on a
+ * separate cache line from the members used by the owner, and each worker
+ * is padded out so that neighbouring workers do not share a cache line.
+ */
+union threadpool_worker {
+    struct {
+        long top;                           /*!<  Next task to steal        */
+        char pad[GDS_CACHE_LINE - sizeof(long)];    /*!<  Padding           */
+        long bottom;                        /*!<  Next free deque slot      */
+        struct threadpool_array * array;    /*!<  Deque array               */
+        ThreadPool pool;                    /*!<  The owning pool           */
+        unsigned long rng;                  /*!<  Victim selection state    */
+        pthread_t thread;                   /*!<  Worker thread             */
+    } w;                                    /*!<  Worker contents           */
+    char pad[GDS_CACHE_LINE * 2];           /*!<  Padding                   */
+};
+
+/*!  Thread pool structure  */
+struct threadpool {
+    size_t num_threads;             /*!<  Number of worker threads          */
+    size_t num_started;             /*!<  Number of threads started         */
+    union threadpool_worker * workers;      /*!<  The workers               */
+    pthread_key_t key;              /*!<  Current thread's worker, if any   */
+    pthread_mutex_t lock;           /*!<  Lock for injection and sleeping   */
+    pthread_cond_t work_cond;       /*!<  Signalled when work is submitted  */
+    pthread_cond_t done_cond;       /*!<  Broadcast when a task finishes    */
+    struct threadpool_task * inject_head;   /*!<  Injection queue head      */
+    struct threadpool_task * inject_tail;   /*!<  Injection queue tail      */
+    size_t num_injected;            /*!<  Tasks in injection queue          */
+    unsigned long work_seq;         /*!<  Count of submissions              */
+    size_t sleepers;                /*!<  Workers asleep on work_cond       */
+    size_t waiters;                 /*!<  Threads asleep on done_cond       */
+    bool shutdown;                  /*!<  Workers exit when idle if true    */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Worker thread function.
+ * \param arg       A pointer to the worker.
+ * \returns         `NULL`.
+ */
+static void * threadpool_worker_main(void * arg);
+
+/*!
+ * \brief           Queues a task, and wakes a sleeping worker if needed.
+ * \details         If the calling thread is a worker of the pool, the task
+ * is pushed onto its deque, otherwise onto the injection queue.
+ * \param pool      A pointer to the pool.
+ * \param task      A pointer to the task.
+ */
+static void threadpool_push_task(ThreadPool pool,
+                                 struct threadpool_task * task);
+
+/*!
+ * \brief           Finds a task to run.
+ * \details         Looks in the calling worker's own deque, then in the
+ * injection queue, then tries to steal from each other worker in turn.
+ * \param pool      A pointer to the pool.
+ * \param self      A pointer to the calling worker, or `NULL` if the
+ * calling thread is not a worker of the pool.
+ * \param rng       A pointer to random state for choosing victims.
+ * \retval NULL     No task was found.
+ * \retval non-NULL A pointer to the task, now owned by the caller.
+ */
+static struct threadpool_task * threadpool_find_task(ThreadPool pool,
+                                        union threadpool_worker * self,
+                                        unsigned long * rng);
+
+/*!
+ * \brief           Runs a task.
+ * \details         A loop piece is freed afterwards. The future of an
+ * ordinary task is marked finished, and then belongs to its waiter.
+ * \param pool      A pointer to the pool.
+ * \param task      A pointer to the task.
+ */
+static void threadpool_run_task(ThreadPool pool,
+                                struct threadpool_task * task);
+
+/*!
+ * \brief           Runs part of a parallel for loop.
+ * \details         Splits off and queues the upper half of the range until
+ * it is no larger than the grain, then runs what remains.
+ * \param pool      A pointer to the pool.
+ * \param pfor      A pointer to the loop.
+ * \param begin     The start of the range.
+ * \param end       The end of the range.
+ */
+static void threadpool_run_range(ThreadPool pool,
+                                 struct threadpool_pfor * pfor,
+                                 size_t begin, size_t end);
+
+/*!
+ * \brief           Waits for a counter to reach zero, running tasks.
+ * \param pool      A pointer to the pool.
+ * \param counter   A pointer to the counter, which is decremented by
+ * finishing tasks followed by a call to `threadpool_notify_done()`.
+ */
+static void threadpool_wait_for_zero(ThreadPool pool, size_t * counter);
+
+/*!
+ * \brief           Wakes threads waiting for tasks to finish.
+ * \param pool      A pointer to the pool.
+ */
+static void threadpool_notify_done(ThreadPool pool);
+
+/*!
+ * \brief           Pushes a task onto the bottom of a worker's deque.
+ * \details         Only the owning worker may call this function.
+ * \param worker    A pointer to the worker.
+ * \param task      A pointer to the task.
+ * \retval true     Success
+ * \retval false    Failure, the deque was full and could not grow.
+ */
+static bool threadpool_deque_push(union threadpool_worker * worker,
+                                  struct threadpool_task * task);
+
+/*!
+ * \brief           Takes a task from the bottom of a worker's deque.
+ * \details         Only the owning worker may call this function.
+ * \param worker    A pointer to the worker.
+ * \retval NULL     The deque is empty.
+ * \retval non-NULL A pointer to the task.
+ */
+static struct threadpool_task *
+threadpool_deque_take(union threadpool_worker * worker);
+
+/*!
+ * \brief           Steals a task from the top of a worker's deque.
+ * \param worker    A pointer to the worker.
+ * \retval NULL     The deque is empty.
+ * \retval non-NULL A pointer to the task.
+ */
+static struct threadpool_task *
+threadpool_deque_steal(union threadpool_worker * worker);
+
+/*!
+ * \brief           Creates a deque array.
+ * \param size      The number of tasks, which must be a power of two.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the new array.
+ */
+static struct threadpool_array * threadpool_array_create(const size_t size);
+
+ThreadPool threadpool_create(const size_t num_threads, const int opts)
+{
+    size_t actual_threads = num_threads;
+    if ( actual_threads == 0 ) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        actual_threads = online > 0 ? (size_t) online : 1;
+    }
+
+    struct threadpool * new_pool = malloc(sizeof *new_pool);
+    void * workers = NULL;
+    if ( new_pool &&
+         posix_memalign(&workers, GDS_CACHE_LINE,
+                        actual_threads * sizeof *new_pool->workers) ) {
+        free(new_pool);
+        new_pool = NULL;
+    }
+
+    if ( !new_pool ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "memory allocation failed");
+        }
+        else {
+            log_error("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    new_pool->num_threads = 0;
+    new_pool->num_started = 0;
+    new_pool->workers = workers;
+    new_pool->inject_head = NULL;
+    new_pool->inject_tail = NULL;
+    new_pool->num_injected = 0;
+    new_pool->work_seq = 0;
+    new_pool->sleepers = 0;
+    new_pool->waiters = 0;
+    new_pool->shutdown = false;
+    new_pool->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    if ( pthread_key_create(&new_pool->key, NULL) != 0 ||
+         pthread_mutex_init(&new_pool->lock, NULL) != 0 ||
+         pthread_cond_init(&new_pool->work_cond, NULL) != 0 ||
+         pthread_cond_init(&new_pool->done_cond, NULL) != 0 ) {
+        free(workers);
+        free(new_pool);
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_error("gds library", "couldn't initialize thread pool");
+        }
+        else {
+            log_error("gds library", "couldn't initialize thread pool");
+            return NULL;
+        }
+    }
+
+    /*  Every deque must exist before any thread starts stealing  */
+
+    for ( size_t i = 0; i < actual_threads; ++i ) {
+        union threadpool_worker * worker = &new_pool->workers[i];
+        worker->w.top = 0;
+        worker->w.bottom = 0;
+        worker->w.pool = new_pool;
+        worker->w.rng = (unsigned long) i * 2654435761UL + 1;
+        worker->w.array = threadpool_array_create(INITIAL_DEQUE_SIZE);
+        if ( !worker->w.array ) {
+            new_pool->num_threads = i;
+            threadpool_destroy(new_pool);
+            if ( opts & GDS_EXIT_ON_ERROR ) {
+                quit_strerror("gds library", "memory allocation failed");
+            }
+            else {
+                log_strerror("gds library", "memory allocation failed");
+                return NULL;
+            }
+        }
+    }
+    new_pool->num_threads = actual_threads;
+
+    for ( size_t i = 0; i < actual_threads; ++i ) {
+        union threadpool_worker * worker = &new_pool->workers[i];
+        if ( pthread_create(&worker->w.thread, NULL,
+                            threadpool_worker_main, worker) != 0 ) {
+            threadpool_destroy(new_pool);
+            if ( opts & GDS_EXIT_ON_ERROR ) {
+                quit_error("gds library", "couldn't start worker thread");
+            }
+            else {
+                log_error("gds library", "couldn't start worker thread");
+                return NULL;
+            }
+        }
+        new_pool->num_started = i + 1;
+    }
+
+    return new_pool;
+}
+
+void threadpool_destroy(ThreadPool pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for ( size_t i = 0; i < pool->num_started; ++i ) {
+        pthread_join(pool->workers[i].w.thread, NULL);
+    }
+
+    for ( size_t i = 0; i < pool->num_threads; ++i ) {
+        struct threadpool_array * array = pool->workers[i].w.array;
+        while ( array ) {
+            struct threadpool_array * older = array->older;
+            free(array);
+            array = older;
+        }
+    }
+
+    pthread_key_delete(pool->key);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    free(pool->workers);
+    free(pool);
+}
+
+Future threadpool_submit(ThreadPool pool, threadpool_task_func fn,
+                         void * arg)
+{
+    struct threadpool_task * task = malloc(sizeof *task);
+    if ( !task ) {
+        if ( pool->exit_on_error ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    task->func = fn;
+    task->arg = arg;
+    task->result = NULL;
+    task->pending = 1;
+    task->pfor = NULL;
+    task->pool = pool;
+
+    threadpool_push_task(pool, task);
+    return task;
+}
+
+void * future_wait(Future future)
+{
+    threadpool_wait_for_zero(future->pool, &future->pending);
+
+    void * result = future->result;
+    free(future);
+    return result;
+}
+
+bool future_is_ready(Future future)
+{
+    return __atomic_load_n(&future->pending, __ATOMIC_ACQUIRE) == 0;
+}
+
+void threadpool_parallel_for(ThreadPool pool, const size_t begin,
+                             const size_t end, const size_t grain,
+                             threadpool_range_func fn, void * ctx)
+{
+    if ( begin >= end ) {
+        return;
+    }
+
+    struct threadpool_pfor pfor;
+    pfor.fn = fn;
+    pfor.ctx = ctx;
+    pfor.grain = grain ? grain : 1;
+    pfor.pending = 1;
+
+    threadpool_run_range(pool, &pfor, begin, end);
+    threadpool_wait_for_zero(pool, &pfor.pending);
+}
+
+size_t threadpool_num_threads(ThreadPool pool)
+{
+    return pool->num_threads;
+}
+
+static void * threadpool_worker_main(void * arg)
+{
+    union threadpool_worker * self = arg;
+    ThreadPool pool = self->w.pool;
+    int spins = 0;
+
+    pthread_setspecific(pool->key, self);
+
+    while ( true ) {
+        const unsigned long seq = __atomic_load_n(&pool->work_seq,
+                                                  __ATOMIC_SEQ_CST);
+
+        struct threadpool_task * task = threadpool_find_task(pool, self,
+                                                             &self->w.rng);
+        if ( task ) {
+            threadpool_run_task(pool, task);
+            spins = 0;
+            continue;
+        }
+
+        if ( spins < SPINS_BEFORE_SLEEP ) {
+            spins += 1;
+            gds_cpu_relax();
+            continue;
+        }
+
+        /*  Sleep only if nothing was submitted since the search began.
+         *  Registering as a sleeper before checking means a submitter
+         *  either sees the sleeper and signals, or is seen here.        */
+
+        bool exit_thread = false;
+        pthread_mutex_lock(&pool->lock);
+        __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        if ( __atomic_load_n(&pool->work_seq, __ATOMIC_SEQ_CST) == seq ) {
+            if ( pool->shutdown ) {
+                exit_thread = true;
+            }
+            else {
+                pthread_cond_wait(&pool->work_cond, &pool->lock);
+            }
+        }
+        __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&pool->lock);
+
+        if ( exit_thread ) {
+            break;
+        }
+        spins = 0;
+    }
+
+    return NULL;
+}
+
+static void threadpool_push_task(ThreadPool pool,
+                                 struct threadpool_task * task)
+{
+    union threadpool_worker * self = pthread_getspecific(pool->key);
+
+    if ( !self || !threadpool_deque_push(self, task) ) {
+        task->next = NULL;
+        pthread_mutex_lock(&pool->lock);
+        if ( pool->inject_tail ) {
+            pool->inject_tail->next = task;
+        }
+        else {
+            pool->inject_head = task;
+        }
+        pool->inject_tail = task;
+        __atomic_add_fetch(&pool->num_injected, 1, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    __atomic_add_fetch(&pool->work_seq, 1, __ATOMIC_SEQ_CST);
+    if ( __atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0 ) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->work_cond);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static struct threadpool_task * threadpool_find_task(ThreadPool pool,
+                                        union threadpool_worker * self,
+                                        unsigned long * rng)
+{
+    struct threadpool_task * task = NULL;
+
+    if ( self && (task = threadpool_deque_take(self)) ) {
+        return task;
+    }
+
+    if ( __atomic_load_n(&pool->num_injected, __ATOMIC_RELAXED) > 0 ) {
+        pthread_mutex_lock(&pool->lock);
+        task = pool->inject_head;
+        if ( task ) {
+            pool->inject_head = task->next;
+            if ( !pool->inject_head ) {
+                pool->inject_tail = NULL;
+            }
+            __atomic_sub_fetch(&pool->num_injected, 1, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        if ( task ) {
+            return task;
+        }
+    }
+
+    /*  Start at a random victim, so that thieves spread out  */
+
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 7;
+    *rng ^= *rng << 17;
+
+    const size_t start = (size_t) (*rng % pool->num_threads);
+    for ( size_t i = 0; i < pool->num_threads; ++i ) {
+        union threadpool_worker * victim =
+            &pool->workers[(start + i) % pool->num_threads];
+        if ( victim != self && (task = threadpool_deque_steal(victim)) ) {
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+static void threadpool_run_task(ThreadPool pool,
+                                struct threadpool_task * task)
+{
+    if ( task->pfor ) {
+        threadpool_run_range(pool, task->pfor, task->begin, task->end);
+        free(task);
+    }
+    else {
+        task->result = task->func(task->arg);
+
+        /*  The waiter may free the task as soon as this is stored  */
+
+        __atomic_store_n(&task->pending, 0, __ATOMIC_SEQ_CST);
+        threadpool_notify_done(pool);
+    }
+}
+
+static void threadpool_run_range(ThreadPool pool,
+                                 struct threadpool_pfor * pfor,
+                                 size_t begin, size_t end)
+{
+    while ( end - begin > pfor->grain ) {
+        struct threadpool_task * task = malloc(sizeof *task);
+        if ( !task ) {
+
+            /*  Not fatal, just run the rest of the range here  */
+
+            break;
+        }
+
+        const size_t mid = begin + (end - begin) / 2;
+        task->pfor = pfor;
+        task->begin = mid;
+        task->end = end;
+        task->pool = pool;
+
+        __atomic_add_fetch(&pfor->pending, 1, __ATOMIC_SEQ_CST);
+        threadpool_push_task(pool, task);
+        end = mid;
+    }
+
+    pfor->fn(begin, end, pfor->ctx);
+
+    /*  The loop may return as soon as this reaches zero  */
+
+    if ( __atomic_sub_fetch(&pfor->pending, 1, __ATOMIC_SEQ_CST) == 0 ) {
+        threadpool_notify_done(pool);
+    }
+}
+
+static void threadpool_wait_for_zero(ThreadPool pool, size_t * counter)
+{
+
+    /*  A finished future may outlive its pool, so check before
+     *  touching the pool at all.                                */
+
+    if ( __atomic_load_n(counter, __ATOMIC_ACQUIRE) == 0 ) {
+        return;
+    }
+
+    union threadpool_worker * self = pthread_getspecific(pool->key);
+    unsigned long rng = (unsigned long) (uintptr_t) &rng | 1;
+    int spins = 0;
+
+    while ( __atomic_load_n(counter, __ATOMIC_ACQUIRE) != 0 ) {
+        struct threadpool_task * task = threadpool_find_task(pool, self,
+                                                             &rng);
+        if ( task ) {
+            threadpool_run_task(pool, task);
+            spins = 0;
+            continue;
+        }
+
+        if ( spins < SPINS_BEFORE_SLEEP ) {
+            spins += 1;
+            gds_cpu_relax();
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        __atomic_add_fetch(&pool->waiters, 1, __ATOMIC_SEQ_CST);
+        if ( __atomic_load_n(counter, __ATOMIC_SEQ_CST) != 0 ) {
+            pthread_cond_wait(&pool->done_cond, &pool->lock);
+        }
+        __atomic_sub_fetch(&pool->waiters, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&pool->lock);
+        spins = 0;
+    }
+}
+
+static void threadpool_notify_done(ThreadPool pool)
+{
+    if ( __atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) > 0 ) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->done_cond);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static bool threadpool_deque_push(union threadpool_worker * worker,
+                                  struct threadpool_task * task)
+{
+    const long b = __atomic_load_n(&worker->w.bottom, __ATOMIC_RELAXED);
+    const long t = __atomic_load_n(&worker->w.top, __ATOMIC_ACQUIRE);
+    struct threadpool_array * array = worker->w.array;
+
+    if ( b - t > (long) array->mask ) {
+
+        /*  Full, so copy into an array twice the size. The old
+         *  array is kept, since thieves may still be reading it.  */
+
+        struct threadpool_array * new_array =
+            threadpool_array_create((array->mask + 1) * 2);
+        if ( !new_array ) {
+            return false;
+        }
+
+        for ( long i = t; i < b; ++i ) {
+            new_array->tasks[i & new_array->mask] =
+                __atomic_load_n(&array->tasks[i & array->mask],
+                                __ATOMIC_RELAXED);
+        }
+        new_array->older = array;
+        __atomic_store_n(&worker->w.array, new_array, __ATOMIC_RELEASE);
+        array = new_array;
+    }
+
+    __atomic_store_n(&array->tasks[b & array->mask], task, __ATOMIC_RELAXED);
+    __atomic_store_n(&worker->w.bottom, b + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static struct threadpool_task *
+threadpool_deque_take(union threadpool_worker * worker)
+{
+    const long b = __atomic_load_n(&worker->w.bottom, __ATOMIC_RELAXED) - 1;
+    struct threadpool_array * array = worker->w.array;
+
+    /*  Reserve the bottom task before looking at the top, so that
+     *  a thief and the owner cannot both take the last task.        */
+
+    __atomic_store_n(&worker->w.bottom, b, __ATOMIC_SEQ_CST);
+    long t = __atomic_load_n(&worker->w.top, __ATOMIC_SEQ_CST);
+
+    struct threadpool_task * task = NULL;
+    if ( t <= b ) {
+        task = __atomic_load_n(&array->tasks[b & array->mask],
+                               __ATOMIC_RELAXED);
+        if ( t == b ) {
+
+            /*  Last task, so race thieves for it  */
+
+            if ( !__atomic_compare_exchange_n(&worker->w.top, &t, t + 1,
+                                              false, __ATOMIC_SEQ_CST,
+                                              __ATOMIC_RELAXED) ) {
+                task = NULL;
+            }
+            __atomic_store_n(&worker->w.bottom, b + 1, __ATOMIC_RELAXED);
+        }
+    }
+    else {
+        __atomic_store_n(&worker->w.bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return task;
+}
+
+static struct threadpool_task *
+threadpool_deque_steal(union threadpool_worker * worker)
+{
+    while ( true ) {
+        long t = __atomic_load_n(&worker->w.top, __ATOMIC_SEQ_CST);
+        const long b = __atomic_load_n(&worker->w.bottom, __ATOMIC_SEQ_CST);
+        if ( t >= b ) {
+            return NULL;
+        }
+
+        struct threadpool_array * array =
+            __atomic_load_n(&worker->w.array, __ATOMIC_ACQUIRE);
+        struct threadpool_task * task =
+            __atomic_load_n(&array->tasks[t & array->mask], __ATOMIC_RELAXED);
+
+        if ( __atomic_compare_exchange_n(&worker->w.top, &t, t + 1, false,
+                                         __ATOMIC_SEQ_CST,
+                                         __ATOMIC_RELAXED) ) {
+            return task;
+        }
+
+        /*  Lost the race to another thief or the owner, so try again  */
+    }
+}
+
+static struct threadpool_array * threadpool_array_create(const size_t size)
+{
+    struct threadpool_array * array = malloc(sizeof *array +
+                                             size * sizeof *array->tasks);
+    if ( array ) {
+        array->mask = size - 1;
+        array->older = NULL;
+    }
+
+    return array;
+}
@@ -0,0 +1,546 @@
+/*!
+ * \file            timerwheel.c
+ * \brief           Implementation of hierarchical timer wheel.
+ * \details         The wheel has several levels of 64 slots each. A slot
+ * on level 0 holds the timers due at one tick, a slot on level 1 the
+ * timers due in one run of 64 ticks, a slot on level 2 one run of 4096
+ * ticks, and so on. A timer goes in the lowest level whose slots are wide
+ * enough to reach its expiry time, and each time the wheel reaches the
+ * start of a slot on a higher level, the timers in that slot are moved,
+ * or cascaded, down to lower levels. Each level keeps a bitmap of which
+ * of its slots hold timers, so the wheel can jump straight to the next
+ * tick at which there is work to do.
+ *
+ * Timers are kept in singly linked lists which hold, in each node, the
+ * address of the pointer to that node, so a node can be unlinked without
+ * knowing where its list starts. Nodes are allocated in slabs, and never
+ * move or are freed until the wheel is destroyed; a timer identifier is
+ * the index of its node together with a generation count which changes
+ * whenever the node is reused, so a stale identifier can be detected.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2014 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pggds_internal/gds_common.h>
+#include <pggds/timerwheel.h>
+
+/*!  Number of bits of expiry time resolved by each level  */
+#define WHEEL_BITS 6
+
+/*!  Number of slots on each level  */
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+
+/*!
+ * \brief           Number of levels.
+ * \details         This covers 2^48 ticks, almost nine years of
+ * millisecond ticks. Timers due later than this are cascaded from the
+ * top level until they come within range.
+ */
+#define WHEEL_LEVELS 8
+
+/*!  Slot number of a timer on the list of timers already due  */
+#define WHEEL_DUE (WHEEL_LEVELS * WHEEL_SLOTS)
+
+/*!  Slot number of a timer on a list being fired  */
+#define WHEEL_FIRING (WHEEL_DUE + 1)
+
+/*!  Number of timer nodes allocated at once  */
+#define TIMER_SLAB_SIZE 256
+
+/*!  Initial capacity of the array of slabs  */
+static const size_t TIMER_SLABS_INITIAL = 4;
+
+/*!  Timer node structure  */
+struct timer_node {
+    uint64_t expires;               /*!<  Time at which the timer is due    */
+    timerwheel_callback callback;   /*!<  Callback function                 */
+    void * arg;                     /*!<  Argument to callback function     */
+    struct timer_node * next;       /*!<  Next node in list                 */
+    struct timer_node ** pprev;     /*!<  Pointer to this node, or NULL     */
+    uint32_t index;                 /*!<  Index of this node                */
+    uint32_t generation;            /*!<  Times this node has been reused   */
+    unsigned int slot;              /*!<  Level and slot holding the node   */
+};
+
+/*!  Timer wheel structure  */
+struct timerwheel {
+    struct timer_node * slots[WHEEL_LEVELS][WHEEL_SLOTS];   /*!<  Slots     */
+    uint64_t occupied[WHEEL_LEVELS];    /*!<  Bitmap of non-empty slots     */
+    struct timer_node * due;        /*!<  Timers scheduled already due      */
+    uint64_t now;                   /*!<  Current time                      */
+    size_t count;                   /*!<  Number of pending timers          */
+    size_t in_wheel;                /*!<  Number of timers in slots         */
+    struct timer_node ** slabs;     /*!<  Slabs of timer nodes              */
+    size_t num_slabs;               /*!<  Number of slabs                   */
+    size_t slabs_capacity;          /*!<  Capacity of slab array            */
+    struct timer_node * free_nodes;         /*!<  List of unused nodes      */
+    bool exit_on_error;     /*!<  Exit on error if true                     */
+};
+
+/*!
+ * \brief           Allocates a timer node.
+ * \param wheel     A pointer to the wheel.
+ * \retval NULL     Failure, dynamic memory allocation failed.
+ * \retval non-NULL A pointer to the node.
+ */
+static struct timer_node * timerwheel_alloc_node(TimerWheel wheel);
+
+/*!
+ * \brief           Returns a timer node to the free list.
+ * \param wheel     A pointer to the wheel.
+ * \param node      A pointer to the node, which must not be in a list.
+ */
+static void timerwheel_free_node(TimerWheel wheel, struct timer_node * node);
+
+/*!
+ * \brief           Adds a node to the front of a list.
+ * \param head      A pointer to the list head.
+ * \param node      A pointer to the node.
+ */
+static void timer_list_push(struct timer_node ** head,
+                            struct timer_node * node);
+
+/*!
+ * \brief           Removes a node from whichever list holds it.
+ * \param node      A pointer to the node.
+ */
+static void timer_list_unlink(struct timer_node * node);
+
+/*!
+ * \brief           Places a timer in the slot appropriate to its expiry.
+ * \param wheel     A pointer to the wheel.
+ * \param node      A pointer to the node, which must be due no earlier
+ * than `base`.
+ * \param base      The time relative to which to place the timer. Levels
+ * above 0 are placed so that the timer is cascaded after this time.
+ */
+static void timerwheel_place(TimerWheel wheel, struct timer_node * node,
+                             const uint64_t base);
+
+/*!
+ * \brief           Removes a timer from its slot, if it is in one.
+ * \param wheel     A pointer to the wheel.
+ * \param node      A pointer to the node.
+ */
+static void timerwheel_remove(TimerWheel wheel, struct timer_node * node);
+
+/*!
+ * \brief           Detaches the list of timers in a slot.
+ * \param wheel     A pointer to the wheel.
+ * \param level     The level.
+ * \param slot      The slot.
+ * \param batch     A pointer to a list head which is modified to hold the
+ * detached timers.
+ */
+static void timerwheel_detach(TimerWheel wheel, const int level,
+                              const unsigned int slot,
+                              struct timer_node ** batch);
+
+/*!
+ * \brief           Calls and frees every timer in a list.
+ * \details         The callbacks may cancel timers still in the list.
+ * \param wheel     A pointer to the wheel.
+ * \param batch     A pointer to the list head.
+ * \returns         The number of timers called.
+ */
+static size_t timerwheel_fire(TimerWheel wheel, struct timer_node ** batch);
+
+/*!
+ * \brief           Finds the next tick at which the wheel has work to do.
+ * \param wheel     A pointer to the wheel, which must have timers in
+ * its slots.
+ * \returns         The earliest tick after the current time at which a
+ * level 0 slot is due or a higher level slot is cascaded.
+ */
+static uint64_t timerwheel_next_event(TimerWheel wheel);
+
+/*!
+ * \brief           Returns the index of the lowest set bit of a word.
+ * \param bits      The word, which must not be zero.
+ * \returns         The index of the lowest set bit.
+ */
+static unsigned int timerwheel_lowest_bit(const uint64_t bits);
+
+TimerWheel timerwheel_create(const uint64_t now, const int opts)
+{
+    struct timerwheel * new_wheel = malloc(sizeof *new_wheel);
+    if ( !new_wheel ) {
+        if ( opts & GDS_EXIT_ON_ERROR ) {
+            quit_strerror("gds library", "memory allocation failed");
+        }
+        else {
+            log_strerror("gds library", "memory allocation failed");
+            return NULL;
+        }
+    }
+
+    for ( int level = 0; level < WHEEL_LEVELS; ++level ) {
+        for ( int slot = 0; slot < WHEEL_SLOTS; ++slot ) {
+            new_wheel->slots[level][slot] = NULL;
+        }
+        new_wheel->occupied[level] = 0;
+    }
+
+    new_wheel->due = NULL;
+    new_wheel->now = now;
+    new_wheel->count = 0;
+    new_wheel->in_wheel = 0;
+    new_wheel->slabs = NULL;
+    new_wheel->num_slabs = 0;
+    new_wheel->slabs_capacity = 0;
+    new_wheel->free_nodes = NULL;
+    new_wheel->exit_on_error = (opts & GDS_EXIT_ON_ERROR) ? true : false;
+
+    return new_wheel;
+}
+
+void timerwheel_destroy(TimerWheel wheel)
+{
+    for ( size_t i = 0; i < wheel->num_slabs; ++i ) {
+        free(wheel->slabs[i]);
+    }
+
+    free(wheel->slabs);
+    free(wheel);
+}
+
+TimerId timerwheel_schedule(TimerWheel wheel, const uint64_t expires,
+                            timerwheel_callback fn, void * arg)
+{
+    struct timer_node * node = timerwheel_alloc_node(wheel);
+    if ( !node ) {
+        return 0;
+    }
+
+    node->expires = expires;
+    node->callback = fn;
+    node->arg = arg;
+
+    if ( expires <= wheel->now ) {
+        node->slot = WHEEL_DUE;
+        timer_list_push(&wheel->due, node);
+    }
+    else {
+        timerwheel_place(wheel, node, wheel->now);
+    }
+    wheel->count += 1;
+
+    return ((TimerId) node->generation << 32) | node->index;
+}
+
+bool timerwheel_cancel(TimerWheel wheel, const TimerId id)
+{
+    const size_t index = (size_t) (id & UINT32_MAX);
+    const uint32_t generation = (uint32_t) (id >> 32);
+
+    if ( index >= wheel->num_slabs * TIMER_SLAB_SIZE ) {
+        return false;
+    }
+
+    struct timer_node * node = &wheel->slabs[index / TIMER_SLAB_SIZE]
+                                            [index % TIMER_SLAB_SIZE];
+    if ( !node->pprev || node->generation != generation ) {
+        return false;
+    }
+
+    timerwheel_remove(wheel, node);
+    timerwheel_free_node(wheel, node);
+    wheel->count -= 1;
+
+    return true;
+}
+
+size_t timerwheel_tick(TimerWheel wheel, const uint64_t now)
+{
+    struct timer_node * batch;
+    size_t fired = 0;
+
+    /*  Timers scheduled already due go first, since they
+     *  are due no later than anything still in the wheel.  */
+
+    if ( wheel->due ) {
+        batch = wheel->due;
+        batch->pprev = &batch;
+        wheel->due = NULL;
+        for ( struct timer_node * node = batch; node; node = node->next ) {
+            node->slot = WHEEL_FIRING;
+        }
+        fired += timerwheel_fire(wheel, &batch);
+    }
+
+    while ( wheel->now < now ) {
+        if ( wheel->in_wheel == 0 ) {
+            wheel->now = now;
+            break;
+        }
+
+        const uint64_t t = timerwheel_next_event(wheel);
+        if ( t > now ) {
+            wheel->now = now;
+            break;
+        }
+        wheel->now = t;
+
+        /*  Find the highest level with a slot starting at this tick, and
+         *  cascade from there downwards, since timers cascaded from one
+         *  level may land in the slot due to be cascaded from the next.  */
+
+        int top = 0;
+        while ( top < WHEEL_LEVELS - 1 &&
+                (t & (((uint64_t) 1 << (WHEEL_BITS * (top + 1))) - 1)) == 0 ) {
+            ++top;
+        }
+
+        for ( int level = top; level > 0; --level ) {
+            timerwheel_detach(wheel, level,
+                              (t >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1),
+                              &batch);
+            while ( batch ) {
+                struct timer_node * node = batch;
+                timer_list_unlink(node);
+                timerwheel_place(wheel, node, t);
+            }
+        }
+
+        timerwheel_detach(wheel, 0, t & (WHEEL_SLOTS - 1), &batch);
+        fired += timerwheel_fire(wheel, &batch);
+    }
+
+    return fired;
+}
+
+size_t timerwheel_size(TimerWheel wheel)
+{
+    return wheel->count;
+}
+
+uint64_t timerwheel_now(TimerWheel wheel)
+{
+    return wheel->now;
+}
+
+static struct timer_node * timerwheel_alloc_node(TimerWheel wheel)
+{
+    if ( !wheel->free_nodes ) {
+        if ( wheel->num_slabs == wheel->slabs_capacity ) {
+            const size_t new_capacity = wheel->slabs_capacity ?
+                                        wheel->slabs_capacity * 2 :
+                                        TIMER_SLABS_INITIAL;
+            struct timer_node ** new_slabs;
+            new_slabs = realloc(wheel->slabs,
+                                new_capacity * sizeof *new_slabs);
+            if ( !new_slabs ) {
+                if ( wheel->exit_on_error ) {
+                    quit_strerror("gds library", "memory allocation failed");
+                }
+                else {
+                    log_strerror("gds library", "memory allocation failed");
+                    return NULL;
+                }
+            }
+            wheel->slabs = new_slabs;
+            wheel->slabs_capacity = new_capacity;
+        }
+
+        if ( wheel->num_slabs >= (UINT32_MAX / TIMER_SLAB_SIZE) ) {
+            if ( wheel->exit_on_error ) {
+                quit_error("gds library", "too many timers");
+            }
+            else {
+                log_error("gds library", "too many timers");
+                return NULL;
+            }
+        }
+
+        struct timer_node * slab = malloc(TIMER_SLAB_SIZE * sizeof *slab);
+        if ( !slab ) {
+            if ( wheel->exit_on_error ) {
+                quit_strerror("gds library", "memory allocation failed");
+            }
+            else {
+                log_strerror("gds library", "memory allocation failed");
+                return NULL;
+            }
+        }
+
+        /*  Push the new nodes in reverse, so lower indices are used first  */
+
+        const size_t first = wheel->num_slabs * TIMER_SLAB_SIZE;
+        for ( size_t i = TIMER_SLAB_SIZE; i > 0; --i ) {
+            slab[i - 1].index = (uint32_t) (first + i - 1);
+            slab[i - 1].generation = 1;
+            slab[i - 1].pprev = NULL;
+            slab[i - 1].next = wheel->free_nodes;
+            wheel->free_nodes = &slab[i - 1];
+        }
+        wheel->slabs[wheel->num_slabs++] = slab;
+    }
+
+    struct timer_node * node = wheel->free_nodes;
+    wheel->free_nodes = node->next;
+    return node;
+}
+
+static void timerwheel_free_node(TimerWheel wheel, struct timer_node * node)
+{
+    /*  Zero is not a valid identifier, so skip generation zero  */
+
+    node->generation += 1;
+    if ( node->generation == 0 ) {
+        node->generation = 1;
+    }
+    node->pprev = NULL;
+    node->next = wheel->free_nodes;
+    wheel->free_nodes = node;
+}
+
+static void timer_list_push(struct timer_node ** head,
+                            struct timer_node * node)
+{
+    node->next = *head;
+    if ( node->next ) {
+        node->next->pprev = &node->next;
+    }
+    node->pprev = head;
+    *head = node;
+}
+
+static void timer_list_unlink(struct timer_node * node)
+{
+    *node->pprev = node->next;
+    if ( node->next ) {
+        node->next->pprev = node->pprev;
+    }
+    node->next = NULL;
+    node->pprev = NULL;
+}
+
+static void timerwheel_place(TimerWheel wheel, struct timer_node * node,
+                             const uint64_t base)
+{
+    /*  Use the lowest level on which the timer's slot is less than a full
+     *  turn ahead of the base time's slot. The top level takes any timer
+     *  beyond the wheel's range, in the slot furthest from the base.     */
+
+    int level = 0;
+    uint64_t slot_time = node->expires;
+    while ( (slot_time >> (WHEEL_BITS * level)) -
+            (base >> (WHEEL_BITS * level)) >= WHEEL_SLOTS ) {
+        if ( level == WHEEL_LEVELS - 1 ) {
+            slot_time = base + ((uint64_t) (WHEEL_SLOTS - 1) <<
+                                (WHEEL_BITS * level));
+            break;
+        }
+        ++level;
+    }
+
+    const unsigned int slot = (slot_time >> (WHEEL_BITS * level)) &
+                              (WHEEL_SLOTS - 1);
+    node->slot = level * WHEEL_SLOTS + slot;
+    timer_list_push(&wheel->slots[level][slot], node);
+    wheel->occupied[level] |= (uint64_t) 1 << slot;
+    wheel->in_wheel += 1;
+}
+
+static void timerwheel_remove(TimerWheel wheel, struct timer_node * node)
+{
+    const unsigned int slot = node->slot;
+    timer_list_unlink(node);
+
+    if ( slot < WHEEL_DUE ) {
+        const unsigned int level = slot / WHEEL_SLOTS;
+        const unsigned int index = slot % WHEEL_SLOTS;
+        if ( !wheel->slots[level][index] ) {
+            wheel->occupied[level] &= ~((uint64_t) 1 << index);
+        }
+        wheel->in_wheel -= 1;
+    }
+}
+
+static void timerwheel_detach(TimerWheel wheel, const int level,
+                              const unsigned int slot,
+                              struct timer_node ** batch)
+{
+    *batch = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+    wheel->occupied[level] &= ~((uint64_t) 1 << slot);
+
+    if ( *batch ) {
+        (*batch)->pprev = batch;
+    }
+    for ( struct timer_node * node = *batch; node; node = node->next ) {
+        node->slot = WHEEL_FIRING;
+        wheel->in_wheel -= 1;
+    }
+}
+
+static size_t timerwheel_fire(TimerWheel wheel, struct timer_node ** batch)
+{
+    size_t fired = 0;
+
+    /*  Free each node before calling it, so the callback may
+     *  schedule a new timer, or cancel another in the batch.  */
+
+    while ( *batch ) {
+        struct timer_node * node = *batch;
+        timerwheel_callback callback = node->callback;
+        void * arg = node->arg;
+
+        timer_list_unlink(node);
+        timerwheel_free_node(wheel, node);
+        wheel->count -= 1;
+
+        callback(arg);
+        ++fired;
+    }
+
+    return fired;
+}
+
+static uint64_t timerwheel_next_event(TimerWheel wheel)
+{
+    uint64_t next = UINT64_MAX;
+
+    for ( int level = 0; level < WHEEL_LEVELS; ++level ) {
+        const uint64_t bits = wheel->occupied[level];
+        if ( !bits ) {
+            continue;
+        }
+
+        /*  Find the first occupied slot at or after the slot which
+         *  starts next, counting round the level from that slot.   */
+
+        const int shift = WHEEL_BITS * level;
+        const uint64_t start = ((wheel->now >> shift) + 1) << shift;
+        const unsigned int first = (start >> shift) & (WHEEL_SLOTS - 1);
+        const uint64_t rotated = first ?
+                                 (bits >> first) |
+                                 (bits << (WHEEL_SLOTS - first)) :
+                                 bits;
+        const uint64_t t = start +
+                           ((uint64_t) timerwheel_lowest_bit(rotated) <<
+                            shift);
+        if ( t < next ) {
+            next = t;
+        }
+    }
+
+    return next;
+}
+
+static unsigned int timerwheel_lowest_bit(const uint64_t bits)
+{
+#if defined(__GNUC__)
+    return (unsigned int) __builtin_ctzll(bits);
+#else
+    unsigned int index = 0;
+    while ( !(bits & ((uint64_t) 1 << index)) ) {
+        ++index;
+    }
+    return index;
+#endif
+}
@@ -7,4 +7,4 @@ SOURCES   += $(LOCAL_SRC)
 TESTS     += $(LOCAL_PROG)
 
 $(LOCAL_PROG): $(LOCAL_OBJ)
-	$(CC) -o $@ $^ -L$(LIBDIR) -lpggds
+	$(CC) -o $@ $^ -L$(LIBDIR) -pthread -lpggds -lpthread
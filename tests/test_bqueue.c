@@ -0,0 +1,233 @@
+/*  Unit tests for blocking queue data structure  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/bqueue.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_bqueue.h"
+
+TEST_SUITE(test_bqueue);
+
+/*  Number of producer and consumer threads for threaded tests  */
+#define NUM_THREADS 4
+
+/*  Number of values pushed by each producer thread  */
+#define VALUES_PER_THREAD 5000
+
+/*  Test basic single-threaded operations  */
+
+TEST_CASE(test_bqueue_basic)
+{
+    BlockingQueue queue = bqueue_create(3, DATATYPE_INT, 0);
+    if ( !queue ) {
+        perror("couldn't create blocking queue");
+        exit(EXIT_FAILURE);
+    }
+
+    int n;
+    TEST_ASSERT_EQUAL(bqueue_capacity(queue), 3);
+    TEST_ASSERT_FALSE(bqueue_try_pop(queue, &n));
+
+    TEST_ASSERT_TRUE(bqueue_push(queue, 1));
+    TEST_ASSERT_TRUE(bqueue_try_push(queue, 2));
+    TEST_ASSERT_TRUE(bqueue_timed_push(queue, 10, 3));
+    TEST_ASSERT_EQUAL(bqueue_size(queue), 3);
+    TEST_ASSERT_FALSE(bqueue_try_push(queue, 4));
+    TEST_ASSERT_FALSE(bqueue_timed_push(queue, 10, 4));
+
+    TEST_ASSERT_TRUE(bqueue_pop(queue, &n));
+    TEST_ASSERT_EQUAL(n, 1);
+    TEST_ASSERT_TRUE(bqueue_push(queue, 4));
+
+    /*  Values wrap around the end of the buffer  */
+
+    int values[5] = {0};
+    TEST_ASSERT_EQUAL(bqueue_pop_many(queue, values, 5), 3);
+    TEST_ASSERT_EQUAL(values[0], 2);
+    TEST_ASSERT_EQUAL(values[1], 3);
+    TEST_ASSERT_EQUAL(values[2], 4);
+    TEST_ASSERT_EQUAL(bqueue_size(queue), 0);
+
+    TEST_ASSERT_FALSE(bqueue_timed_pop(queue, &n, 10));
+
+    bqueue_destroy(queue);
+}
+
+/*  Test close and drain semantics  */
+
+TEST_CASE(test_bqueue_close)
+{
+    BlockingQueue queue = bqueue_create(10, DATATYPE_STRING,
+                                        GDS_FREE_ON_DESTROY);
+    if ( !queue ) {
+        perror("couldn't create blocking queue");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(bqueue_push(queue, gds_strdup("one")));
+    TEST_ASSERT_TRUE(bqueue_push(queue, gds_strdup("two")));
+    TEST_ASSERT_TRUE(bqueue_push(queue, gds_strdup("three")));
+    TEST_ASSERT_FALSE(bqueue_is_closed(queue));
+
+    bqueue_close(queue);
+    bqueue_close(queue);
+    TEST_ASSERT_TRUE(bqueue_is_closed(queue));
+    TEST_ASSERT_FALSE(bqueue_push(queue, "four"));
+    TEST_ASSERT_FALSE(bqueue_try_push(queue, "four"));
+
+    /*  Values already pushed may still be popped  */
+
+    char * pc;
+    TEST_ASSERT_TRUE(bqueue_pop(queue, &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "one");
+    free(pc);
+
+    /*  The remaining value is freed on destroy  */
+
+    TEST_ASSERT_TRUE(bqueue_pop(queue, &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "two");
+    free(pc);
+    TEST_ASSERT_EQUAL(bqueue_size(queue), 1);
+
+    bqueue_destroy(queue);
+}
+
+/*  Test that closing wakes a waiting consumer  */
+
+static void * bqueue_waiting_consumer(void * arg)
+{
+    BlockingQueue queue = arg;
+    int n;
+    return bqueue_pop(queue, &n) ? NULL : arg;
+}
+
+TEST_CASE(test_bqueue_close_wakes)
+{
+    BlockingQueue queue = bqueue_create(1, DATATYPE_INT, 0);
+    if ( !queue ) {
+        perror("couldn't create blocking queue");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_t tid[NUM_THREADS];
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        if ( pthread_create(&tid[i], NULL,
+                            bqueue_waiting_consumer, queue) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    bqueue_close(queue);
+
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        void * result;
+        pthread_join(tid[i], &result);
+        TEST_ASSERT_TRUE(result == queue);
+    }
+
+    bqueue_destroy(queue);
+}
+
+/*  Producer thread function, pushing 1 to VALUES_PER_THREAD  */
+
+static void * bqueue_producer(void * arg)
+{
+    BlockingQueue queue = arg;
+    bool ok = true;
+
+    for ( long i = 1; i <= VALUES_PER_THREAD; ++i ) {
+        ok = bqueue_push(queue, i) && ok;
+    }
+
+    return ok ? arg : NULL;
+}
+
+/*  Consumer thread function, summing values until the queue is closed  */
+
+struct bqueue_consumer_info {
+    BlockingQueue queue;            /*  The queue                           */
+    bool batch;                     /*  Use bqueue_pop_many() if true       */
+    long sum;                       /*  Sum of values popped                */
+    long count;                     /*  Number of values popped             */
+};
+
+static void * bqueue_consumer(void * arg)
+{
+    struct bqueue_consumer_info * info = arg;
+    long values[16];
+    size_t n;
+
+    while ( (n = bqueue_pop_many(info->queue, values,
+                                 info->batch ? 16 : 1)) > 0 ) {
+        for ( size_t i = 0; i < n; ++i ) {
+            info->sum += values[i];
+            info->count += 1;
+        }
+    }
+
+    return NULL;
+}
+
+/*  Test many producers and consumers through a small queue  */
+
+TEST_CASE(test_bqueue_threads)
+{
+    BlockingQueue queue = bqueue_create(8, DATATYPE_LONG, 0);
+    if ( !queue ) {
+        perror("couldn't create blocking queue");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_t producers[NUM_THREADS], consumers[NUM_THREADS];
+    struct bqueue_consumer_info info[NUM_THREADS];
+
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        info[i].queue = queue;
+        info[i].batch = (i % 2) == 0;
+        info[i].sum = 0;
+        info[i].count = 0;
+        if ( pthread_create(&consumers[i], NULL,
+                            bqueue_consumer, &info[i]) != 0 ||
+             pthread_create(&producers[i], NULL,
+                            bqueue_producer, queue) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        void * result;
+        pthread_join(producers[i], &result);
+        TEST_ASSERT_TRUE(result != NULL);
+    }
+
+    bqueue_close(queue);
+
+    long sum = 0, count = 0;
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        pthread_join(consumers[i], NULL);
+        sum += info[i].sum;
+        count += info[i].count;
+    }
+
+    TEST_ASSERT_EQUAL(count, (long) NUM_THREADS * VALUES_PER_THREAD);
+    TEST_ASSERT_EQUAL(sum, (long) NUM_THREADS * VALUES_PER_THREAD *
+                           (VALUES_PER_THREAD + 1) / 2);
+    TEST_ASSERT_EQUAL(bqueue_size(queue), 0);
+
+    bqueue_destroy(queue);
+}
+
+void test_bqueue(void)
+{
+    RUN_CASE(test_bqueue_basic);
+    RUN_CASE(test_bqueue_close);
+    RUN_CASE(test_bqueue_close_wakes);
+    RUN_CASE(test_bqueue_threads);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_BLOCKING_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_BLOCKING_QUEUE_H
+
+void test_bqueue(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_BLOCKING_QUEUE_H  */
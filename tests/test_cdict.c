@@ -0,0 +1,141 @@
+/*  Unit tests for concurrent generic dictionary data structure  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/cdict.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_cdict.h"
+
+TEST_SUITE(test_cdict);
+
+/*  Number of threads for threaded tests  */
+#define NUM_THREADS 4
+
+/*  Number of keys inserted by each thread  */
+#define KEYS_PER_THREAD 2000
+
+/*  Test basic single-threaded operations  */
+
+TEST_CASE(test_cdict_basic)
+{
+    CDict cdict = cdict_create(0, DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !cdict ) {
+        perror("couldn't create concurrent dict");
+        exit(EXIT_FAILURE);
+    }
+
+    char * pc;
+
+    TEST_ASSERT_TRUE(cdict_insert(cdict, "john", gds_strdup("Bolton")));
+    TEST_ASSERT_TRUE(cdict_insert(cdict, "mary", gds_strdup("Portsmouth")));
+    TEST_ASSERT_TRUE(cdict_insert(cdict, "skeletor", gds_strdup("Hull")));
+
+    TEST_ASSERT_TRUE(cdict_has_key(cdict, "john"));
+    TEST_ASSERT_TRUE(cdict_value_for_key(cdict, "mary", &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "Portsmouth");
+    TEST_ASSERT_FALSE(cdict_has_key(cdict, "fabio"));
+    TEST_ASSERT_FALSE(cdict_value_for_key(cdict, "fabio", &pc));
+
+    /*  Overwrite a value to check the old one frees  */
+
+    TEST_ASSERT_TRUE(cdict_insert(cdict, "skeletor", gds_strdup("Grayskull")));
+    TEST_ASSERT_TRUE(cdict_value_for_key(cdict, "skeletor", &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "Grayskull");
+
+    TEST_ASSERT_TRUE(cdict_delete(cdict, "john"));
+    TEST_ASSERT_FALSE(cdict_delete(cdict, "john"));
+    TEST_ASSERT_FALSE(cdict_has_key(cdict, "john"));
+
+    cdict_destroy(cdict);
+}
+
+/*  Visitor function to count keys  */
+
+static bool count_visitor(const char * key, void * value, void * ctx)
+{
+    (void) key;
+    *((long *) ctx) += *((int *) value);
+    return true;
+}
+
+/*  Thread function to insert, look up and delete keys  */
+
+static void * cdict_thread(void * arg)
+{
+    CDict cdict = *((CDict *) arg);
+    static pthread_mutex_t id_mutex = PTHREAD_MUTEX_INITIALIZER;
+    static int next_id = 0;
+
+    pthread_mutex_lock(&id_mutex);
+    const int id = next_id++;
+    pthread_mutex_unlock(&id_mutex);
+
+    char key[32];
+    bool ok = true;
+
+    for ( int i = 0; i < KEYS_PER_THREAD; ++i ) {
+        sprintf(key, "t%d-%d", id, i);
+        ok = cdict_insert(cdict, key, i) && ok;
+    }
+
+    for ( int i = 0; i < KEYS_PER_THREAD; ++i ) {
+        int n = -1;
+        sprintf(key, "t%d-%d", id, i);
+        ok = cdict_value_for_key(cdict, key, &n) && n == i && ok;
+    }
+
+    for ( int i = 0; i < KEYS_PER_THREAD; i += 2 ) {
+        sprintf(key, "t%d-%d", id, i);
+        ok = cdict_delete(cdict, key) && ok;
+    }
+
+    return ok ? arg : NULL;
+}
+
+/*  Test concurrent access from several threads  */
+
+TEST_CASE(test_cdict_threads)
+{
+    CDict cdict = cdict_create(8, DATATYPE_INT, 0);
+    if ( !cdict ) {
+        perror("couldn't create concurrent dict");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_t tid[NUM_THREADS];
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        if ( pthread_create(&tid[i], NULL, cdict_thread, &cdict) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        void * result;
+        pthread_join(tid[i], &result);
+        TEST_ASSERT_TRUE(result != NULL);
+    }
+
+    /*  Only the odd-numbered keys of each thread should remain  */
+
+    long sum = 0;
+    TEST_ASSERT_TRUE(cdict_foreach(cdict, count_visitor, &sum));
+    TEST_ASSERT_EQUAL(sum, (long) NUM_THREADS *
+                           (KEYS_PER_THREAD / 2) * (KEYS_PER_THREAD / 2));
+
+    TEST_ASSERT_TRUE(cdict_has_key(cdict, "t0-1"));
+    TEST_ASSERT_FALSE(cdict_has_key(cdict, "t0-0"));
+
+    cdict_destroy(cdict);
+}
+
+void test_cdict(void)
+{
+    RUN_CASE(test_cdict_basic);
+    RUN_CASE(test_cdict_threads);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_CONCURRENT_DICTIONARY_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_CONCURRENT_DICTIONARY_H
+
+void test_cdict(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_CONCURRENT_DICTIONARY_H  */
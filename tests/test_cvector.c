@@ -0,0 +1,204 @@
+/*  Unit tests for concurrent vector  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/cvector.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_cvector.h"
+
+TEST_SUITE(test_cvector);
+
+/*  Number of appending threads for threaded test  */
+#define NUM_THREADS 4
+
+/*  Number of values each thread appends  */
+#define NUM_APPENDS 20000
+
+/*  Test basic single-threaded operations  */
+
+TEST_CASE(test_cvector_basic)
+{
+    CVector vector = cvector_create(1, DATATYPE_INT, 0);
+    if ( !vector ) {
+        perror("couldn't create concurrent vector");
+        exit(EXIT_FAILURE);
+    }
+
+    int n;
+    TEST_ASSERT_TRUE(cvector_is_empty(vector));
+    TEST_ASSERT_EQUAL(cvector_length(vector), 0);
+    TEST_ASSERT_FALSE(cvector_element_at_index(vector, 0, &n));
+
+    /*  Capacity of one means a new segment at every power of two  */
+
+    for ( int i = 0; i < 1000; ++i ) {
+        size_t index;
+        TEST_ASSERT_TRUE(cvector_append(vector, &index, i * 3));
+        TEST_ASSERT_EQUAL(index, (size_t) i);
+    }
+    TEST_ASSERT_TRUE(cvector_append(vector, NULL, -1));
+
+    TEST_ASSERT_FALSE(cvector_is_empty(vector));
+    TEST_ASSERT_EQUAL(cvector_length(vector), 1001);
+
+    for ( int i = 0; i < 1000; ++i ) {
+        TEST_ASSERT_TRUE(cvector_element_at_index(vector, i, &n));
+        TEST_ASSERT_EQUAL(n, i * 3);
+    }
+    TEST_ASSERT_TRUE(cvector_element_at_index(vector, 1000, &n));
+    TEST_ASSERT_EQUAL(n, -1);
+    TEST_ASSERT_FALSE(cvector_element_at_index(vector, 1001, &n));
+
+    cvector_destroy(vector);
+}
+
+/*  Test pointer values with GDS_FREE_ON_DESTROY  */
+
+TEST_CASE(test_cvector_free)
+{
+    CVector vector = cvector_create(0, DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !vector ) {
+        perror("couldn't create concurrent vector");
+        exit(EXIT_FAILURE);
+    }
+
+    char buffer[32];
+    for ( int i = 0; i < 100; ++i ) {
+        sprintf(buffer, "string %d", i);
+        cvector_append(vector, NULL, gds_strdup(buffer));
+    }
+
+    char * pc;
+    TEST_ASSERT_TRUE(cvector_element_at_index(vector, 42, &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "string 42");
+
+    cvector_destroy(vector);
+}
+
+/*  Threaded test info structure  */
+
+struct cvector_test_info {
+    CVector vector;                 /*  The vector                          */
+    int thread;                     /*  Number of appending thread          */
+    int done;                       /*  Number of appenders finished        */
+    int errors;                     /*  Invalid values seen by the reader   */
+};
+
+/*  Appending thread function  */
+
+static void * cvector_append_thread(void * arg)
+{
+    struct cvector_test_info * info = arg;
+    const int thread = __atomic_fetch_add(&info->thread, 1,
+                                          __ATOMIC_RELAXED);
+
+    for ( int i = 0; i < NUM_APPENDS; ++i ) {
+        cvector_append(info->vector, NULL, thread * NUM_APPENDS + i);
+    }
+
+    __atomic_add_fetch(&info->done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+/*  Reading thread function, checking published values while
+ *  the appending threads are running.                        */
+
+static void * cvector_read_thread(void * arg)
+{
+    struct cvector_test_info * info = arg;
+    int errors = 0;
+    bool finished;
+
+    do {
+        finished = __atomic_load_n(&info->done, __ATOMIC_ACQUIRE) ==
+                   NUM_THREADS;
+        const size_t length = cvector_length(info->vector);
+        for ( size_t i = 0; i < length; ++i ) {
+            int n;
+            if ( cvector_element_at_index(info->vector, i, &n) &&
+                 (n < 0 || n >= NUM_THREADS * NUM_APPENDS) ) {
+                errors += 1;
+            }
+        }
+    } while ( !finished );
+
+    info->errors = errors;
+
+    return NULL;
+}
+
+/*  Test appending from several threads while another reads  */
+
+TEST_CASE(test_cvector_threads)
+{
+    struct cvector_test_info info;
+    info.vector = cvector_create(4, DATATYPE_INT, 0);
+    if ( !info.vector ) {
+        perror("couldn't create concurrent vector");
+        exit(EXIT_FAILURE);
+    }
+    info.thread = 0;
+    info.done = 0;
+    info.errors = 0;
+
+    pthread_t reader;
+    pthread_t tids[NUM_THREADS];
+    if ( pthread_create(&reader, NULL, cvector_read_thread, &info) != 0 ) {
+        perror("couldn't create thread");
+        exit(EXIT_FAILURE);
+    }
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        if ( pthread_create(&tids[i], NULL, cvector_append_thread,
+                            &info) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        pthread_join(tids[i], NULL);
+    }
+    pthread_join(reader, NULL);
+
+    TEST_ASSERT_EQUAL(info.errors, 0);
+    TEST_ASSERT_EQUAL(cvector_length(info.vector),
+                      NUM_THREADS * NUM_APPENDS);
+
+    /*  Every value was appended exactly once, and each thread's
+     *  values appear in the order that thread appended them.     */
+
+    char * seen = calloc(NUM_THREADS * NUM_APPENDS, 1);
+    int last[NUM_THREADS];
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        last[i] = -1;
+    }
+
+    bool valid = true;
+    for ( size_t i = 0; i < NUM_THREADS * NUM_APPENDS; ++i ) {
+        int n;
+        if ( !cvector_element_at_index(info.vector, i, &n) ||
+             n < 0 || n >= NUM_THREADS * NUM_APPENDS || seen[n] ||
+             n <= last[n / NUM_APPENDS] ) {
+            valid = false;
+            break;
+        }
+        seen[n] = 1;
+        last[n / NUM_APPENDS] = n;
+    }
+    TEST_ASSERT_TRUE(valid);
+
+    free(seen);
+    cvector_destroy(info.vector);
+}
+
+void test_cvector(void)
+{
+    RUN_CASE(test_cvector_basic);
+    RUN_CASE(test_cvector_free);
+    RUN_CASE(test_cvector_threads);
+}
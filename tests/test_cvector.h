@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_CVECTOR_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_CVECTOR_H
+
+void test_cvector(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_CVECTOR_H  */
@@ -0,0 +1,196 @@
+/*  Unit tests for generic double-ended queue data structure  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pggds/deque.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_deque.h"
+
+TEST_SUITE(test_deque);
+
+/*  Test basic operations at both ends  */
+
+TEST_CASE(test_deque_basic)
+{
+    Deque deque = deque_create(DATATYPE_INT, 0);
+    if ( !deque ) {
+        perror("couldn't create deque");
+        exit(EXIT_FAILURE);
+    }
+
+    int n;
+    TEST_ASSERT_TRUE(deque_is_empty(deque));
+    TEST_ASSERT_FALSE(deque_pop_front(deque, &n));
+
+    TEST_ASSERT_TRUE(deque_push_back(deque, 2));
+    TEST_ASSERT_TRUE(deque_push_back(deque, 3));
+    TEST_ASSERT_TRUE(deque_push_front(deque, 1));
+    TEST_ASSERT_TRUE(deque_push_front(deque, 0));
+    TEST_ASSERT_EQUAL(deque_size(deque), 4);
+    TEST_ASSERT_FALSE(deque_is_empty(deque));
+
+    for ( int i = 0; i < 4; ++i ) {
+        TEST_ASSERT_TRUE(deque_element_at_index(deque, i, &n));
+        TEST_ASSERT_EQUAL(n, i);
+    }
+    TEST_ASSERT_FALSE(deque_element_at_index(deque, 4, &n));
+    TEST_ASSERT_TRUE(deque_element_address(deque, 4) == NULL);
+
+    TEST_ASSERT_TRUE(deque_set_element_at_index(deque, 2, 20));
+    TEST_ASSERT_EQUAL(*((int *) deque_element_address(deque, 2)), 20);
+
+    TEST_ASSERT_TRUE(deque_pop_back(deque, &n));
+    TEST_ASSERT_EQUAL(n, 3);
+    TEST_ASSERT_TRUE(deque_pop_front(deque, &n));
+    TEST_ASSERT_EQUAL(n, 0);
+    TEST_ASSERT_TRUE(deque_pop_back(deque, &n));
+    TEST_ASSERT_EQUAL(n, 20);
+    TEST_ASSERT_TRUE(deque_pop_back(deque, &n));
+    TEST_ASSERT_EQUAL(n, 1);
+    TEST_ASSERT_TRUE(deque_is_empty(deque));
+
+    deque_destroy(deque);
+}
+
+/*  Test that addresses of values survive growth at both ends  */
+
+TEST_CASE(test_deque_stable_addresses)
+{
+    Deque deque = deque_create(DATATYPE_SIZE_T, 0);
+    if ( !deque ) {
+        perror("couldn't create deque");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(deque_push_back(deque, (size_t) 12345));
+    size_t * first = deque_element_address(deque, 0);
+
+    const size_t n = 20000;
+    for ( size_t i = 0; i < n; ++i ) {
+        TEST_ASSERT_TRUE(deque_push_front(deque, i));
+        TEST_ASSERT_TRUE(deque_push_back(deque, i));
+    }
+    TEST_ASSERT_EQUAL(deque_size(deque), 2 * n + 1);
+    TEST_ASSERT_TRUE(deque_element_address(deque, n) == first);
+    TEST_ASSERT_EQUAL(*first, 12345);
+
+    /*  Popping other values does not move it either  */
+
+    size_t value;
+    for ( size_t i = 0; i < n; ++i ) {
+        TEST_ASSERT_TRUE(deque_pop_front(deque, &value));
+        TEST_ASSERT_EQUAL(value, n - 1 - i);
+    }
+    TEST_ASSERT_TRUE(deque_element_address(deque, 0) == first);
+    TEST_ASSERT_EQUAL(*first, 12345);
+
+    for ( size_t i = 1; i <= n; ++i ) {
+        TEST_ASSERT_TRUE(deque_element_at_index(deque, i, &value));
+        TEST_ASSERT_EQUAL(value, i - 1);
+    }
+
+    deque_destroy(deque);
+}
+
+/*  Test random operations against a simple ring buffer  */
+
+TEST_CASE(test_deque_random)
+{
+    enum { RING = 1 << 14 };
+    static long ring[RING];
+    size_t head = RING / 2, size = 0;
+
+    Deque deque = deque_create(DATATYPE_LONG, 0);
+    if ( !deque ) {
+        perror("couldn't create deque");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long seed = 7;
+    for ( long i = 0; i < 100000; ++i ) {
+        seed = seed * 1103515245 + 12345;
+        const unsigned int op = (seed >> 8) % 8;
+        long value;
+
+        /*  Favour pushes at first, and pops later, so the deque
+         *  grows over several blocks and then shrinks again.     */
+
+        const bool grow = i < 50000 ? op < 5 : op < 3;
+
+        if ( (grow && size < RING) || size == 0 ) {
+            if ( op & 1 ) {
+                TEST_ASSERT_TRUE(deque_push_front(deque, i));
+                head = (head + RING - 1) % RING;
+                ring[head] = i;
+            }
+            else {
+                TEST_ASSERT_TRUE(deque_push_back(deque, i));
+                ring[(head + size) % RING] = i;
+            }
+            ++size;
+        }
+        else if ( op & 1 ) {
+            TEST_ASSERT_TRUE(deque_pop_front(deque, &value));
+            TEST_ASSERT_EQUAL(value, ring[head]);
+            head = (head + 1) % RING;
+            --size;
+        }
+        else {
+            TEST_ASSERT_TRUE(deque_pop_back(deque, &value));
+            TEST_ASSERT_EQUAL(value, ring[(head + size - 1) % RING]);
+            --size;
+        }
+
+        if ( size && i % 97 == 0 ) {
+            const size_t index = (seed >> 16) % size;
+            TEST_ASSERT_TRUE(deque_element_at_index(deque, index, &value));
+            TEST_ASSERT_EQUAL(value, ring[(head + index) % RING]);
+        }
+    }
+    TEST_ASSERT_EQUAL(deque_size(deque), size);
+
+    deque_destroy(deque);
+}
+
+/*  Test that strings still in a deque are freed when it is
+ *  destroyed. Run this test case through Valgrind or a
+ *  similar tool to check no memory leaks.                   */
+
+TEST_CASE(test_deque_free_strings)
+{
+    Deque deque = deque_create(DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !deque ) {
+        perror("couldn't create deque");
+        exit(EXIT_FAILURE);
+    }
+
+    char buffer[32];
+    for ( int i = 0; i < 300; ++i ) {
+        sprintf(buffer, "str%d", i);
+        if ( i % 2 ) {
+            TEST_ASSERT_TRUE(deque_push_front(deque, gds_strdup(buffer)));
+        }
+        else {
+            TEST_ASSERT_TRUE(deque_push_back(deque, gds_strdup(buffer)));
+        }
+    }
+
+    char * s;
+    TEST_ASSERT_TRUE(deque_element_at_index(deque, 0, &s));
+    TEST_ASSERT_STR_EQUAL(s, "str299");
+    TEST_ASSERT_TRUE(deque_pop_back(deque, &s));
+    TEST_ASSERT_STR_EQUAL(s, "str298");
+    free(s);
+
+    deque_destroy(deque);
+}
+
+void test_deque(void)
+{
+    RUN_CASE(test_deque_basic);
+    RUN_CASE(test_deque_stable_addresses);
+    RUN_CASE(test_deque_random);
+    RUN_CASE(test_deque_free_strings);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_DEQUE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_DEQUE_H
+
+void test_deque(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_DEQUE_H  */
@@ -5,7 +5,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <pggds/dict.h>
+#include <pggds/dict_mapped.h>
 #include <pggds/unittest.h>
 #include <pggds/string_util.h>
 #include "test_dict.h"
@@ -154,9 +156,448 @@ TEST_CASE(test_dict_delete)
     dict_destroy(dict);
 }
 
+/*  Test insertion and deletion of enough keys to force resizing  */
+
+TEST_CASE(test_dict_many_keys)
+{
+    Dict dict = dict_create(DATATYPE_INT, 0);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    char key[32];
+    int n;
+
+    for ( int i = 0; i < 5000; ++i ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(dict_insert(dict, key, i));
+    }
+
+    /*  Delete every odd key  */
+
+    for ( int i = 1; i < 5000; i += 2 ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(dict_delete(dict, key));
+    }
+
+    /*  Reinsert some, to reuse deleted slots  */
+
+    for ( int i = 1; i < 1000; i += 2 ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(dict_insert(dict, key, -i));
+    }
+
+    for ( int i = 0; i < 5000; ++i ) {
+        sprintf(key, "key%d", i);
+        if ( i % 2 == 0 ) {
+            TEST_ASSERT_TRUE(dict_value_for_key(dict, key, &n));
+            TEST_ASSERT_EQUAL(n, i);
+        }
+        else if ( i < 1000 ) {
+            TEST_ASSERT_TRUE(dict_value_for_key(dict, key, &n));
+            TEST_ASSERT_EQUAL(n, -i);
+        }
+        else {
+            TEST_ASSERT_FALSE(dict_has_key(dict, key));
+        }
+    }
+
+    dict_destroy(dict);
+}
+
+/*  Test the Bloom filter never rejects a present key  */
+
+TEST_CASE(test_dict_bloom)
+{
+    Dict dict = dict_create(DATATYPE_INT, GDS_BLOOM_FILTER);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    char key[32];
+    int n;
+
+    TEST_ASSERT_TRUE(dict_bloom_fp_rate(dict) == 0.0);
+
+    for ( int i = 0; i < 20000; ++i ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(dict_insert(dict, key, i));
+    }
+
+    for ( int i = 0; i < 20000; i += 3 ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(dict_delete(dict, key));
+    }
+
+    for ( int i = 0; i < 20000; ++i ) {
+        sprintf(key, "key%d", i);
+        if ( i % 3 ) {
+            TEST_ASSERT_TRUE(dict_value_for_key(dict, key, &n));
+            TEST_ASSERT_EQUAL(n, i);
+        }
+        else {
+            TEST_ASSERT_FALSE(dict_has_key(dict, key));
+        }
+    }
+
+    for ( int i = 0; i < 20000; ++i ) {
+        sprintf(key, "absent%d", i);
+        TEST_ASSERT_FALSE(dict_has_key(dict, key));
+    }
+
+    const double rate = dict_bloom_fp_rate(dict);
+    TEST_ASSERT_TRUE(rate > 0.0 && rate < 0.05);
+
+    dict_destroy(dict);
+
+    dict = dict_create(DATATYPE_INT, 0);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(dict_bloom_fp_rate(dict) == 1.0);
+
+    dict_destroy(dict);
+}
+
+/*  Test batched lookups  */
+
+TEST_CASE(test_dict_lookup_many)
+{
+    Dict dict = dict_create(DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(dict_insert(dict, "john", gds_strdup("Bolton")));
+    TEST_ASSERT_TRUE(dict_insert(dict, "mary", gds_strdup("Portsmouth")));
+    TEST_ASSERT_TRUE(dict_insert(dict, "skeletor", gds_strdup("Hull")));
+
+    const char * keys[] = { "mary", "fabio", "john", "skeletor", "he-man" };
+    char * values[5] = { NULL, NULL, NULL, NULL, NULL };
+    bool found[5];
+
+    TEST_ASSERT_EQUAL(dict_lookup_many(dict, keys, 5, values, found), 3);
+
+    TEST_ASSERT_TRUE(found[0]);
+    TEST_ASSERT_STR_EQUAL(values[0], "Portsmouth");
+    TEST_ASSERT_FALSE(found[1]);
+    TEST_ASSERT_TRUE(values[1] == NULL);
+    TEST_ASSERT_TRUE(found[2]);
+    TEST_ASSERT_STR_EQUAL(values[2], "Bolton");
+    TEST_ASSERT_TRUE(found[3]);
+    TEST_ASSERT_STR_EQUAL(values[3], "Hull");
+    TEST_ASSERT_FALSE(found[4]);
+    TEST_ASSERT_TRUE(values[4] == NULL);
+
+    dict_destroy(dict);
+
+    /*  Test a batch spanning several prefetch groups, with a filter  */
+
+    dict = dict_create(DATATYPE_INT, GDS_BLOOM_FILTER);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    char keybuf[100][16];
+    const char * keyptrs[100];
+    int nums[100];
+
+    for ( int i = 0; i < 100; ++i ) {
+        sprintf(keybuf[i], "key%d", i);
+        keyptrs[i] = keybuf[i];
+        nums[i] = -1;
+        if ( i % 3 ) {
+            TEST_ASSERT_TRUE(dict_insert(dict, keybuf[i], i * 10));
+        }
+    }
+
+    TEST_ASSERT_EQUAL(dict_lookup_many(dict, keyptrs, 100, nums, NULL), 66);
+
+    for ( int i = 0; i < 100; ++i ) {
+        TEST_ASSERT_EQUAL(nums[i], (i % 3) ? i * 10 : -1);
+    }
+
+    dict_destroy(dict);
+}
+
+/*  Test iteration, including deleting keys while iterating  */
+
+TEST_CASE(test_dict_itr)
+{
+    Dict dict = dict_create(DATATYPE_INT, 0);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(dict_itr_first(dict) == NULL);
+
+    char key[32];
+    for ( int i = 0; i < 1000; ++i ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(dict_insert(dict, key, i));
+    }
+
+    /*  Visit every key once, deleting the odd ones as we go, some
+     *  via the iterator and some directly by key.                  */
+
+    int sum = 0, count = 0;
+    DictItr itr = dict_itr_first(dict);
+    while ( itr ) {
+        int n;
+        dict_itr_value(itr, &n);
+        sprintf(key, "key%d", n);
+        TEST_ASSERT_STR_EQUAL(dict_itr_key(itr), key);
+
+        sum += n;
+        count += 1;
+
+        if ( n % 4 == 1 ) {
+            itr = dict_delete_itr(dict, itr);
+        }
+        else {
+            if ( n % 4 == 3 ) {
+                TEST_ASSERT_TRUE(dict_delete(dict, key));
+            }
+            itr = dict_itr_next(dict, itr);
+        }
+    }
+
+    TEST_ASSERT_EQUAL(count, 1000);
+    TEST_ASSERT_EQUAL(sum, 999 * 1000 / 2);
+
+    /*  Only the even keys should remain  */
+
+    count = 0;
+    for ( itr = dict_itr_first(dict); itr; itr = dict_itr_next(dict, itr) ) {
+        int n;
+        dict_itr_value(itr, &n);
+        TEST_ASSERT_EQUAL(n % 2, 0);
+        count += 1;
+    }
+
+    TEST_ASSERT_EQUAL(count, 500);
+    TEST_ASSERT_FALSE(dict_has_key(dict, "key1"));
+    TEST_ASSERT_FALSE(dict_has_key(dict, "key3"));
+    TEST_ASSERT_TRUE(dict_has_key(dict, "key2"));
+
+    dict_destroy(dict);
+}
+
+/*  Context for dict_foreach() test visitor function  */
+
+struct foreach_ctx {
+    size_t visited;
+    size_t total_length;
+    Dict dict;
+};
+
+/*  Visitor function for dict_foreach() test  */
+
+static bool foreach_visitor(const char * key, void * value, void * ctx)
+{
+    struct foreach_ctx * fctx = ctx;
+    const char * str = *((char **) value);
+
+    fctx->visited += 1;
+    fctx->total_length += strlen(str);
+
+    if ( !strcmp(key, "mary") ) {
+        dict_delete(fctx->dict, key);
+    }
+
+    return fctx->visited < 10;
+}
+
+/*  Test dict_foreach()  */
+
+TEST_CASE(test_dict_foreach)
+{
+    Dict dict = dict_create(DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    struct foreach_ctx ctx = { 0, 0, dict };
+
+    TEST_ASSERT_TRUE(dict_foreach(dict, foreach_visitor, &ctx));
+    TEST_ASSERT_EQUAL(ctx.visited, 0);
+
+    TEST_ASSERT_TRUE(dict_insert(dict, "john", gds_strdup("Bolton")));
+    TEST_ASSERT_TRUE(dict_insert(dict, "mary", gds_strdup("Portsmouth")));
+    TEST_ASSERT_TRUE(dict_insert(dict, "skeletor", gds_strdup("Hull")));
+
+    TEST_ASSERT_TRUE(dict_foreach(dict, foreach_visitor, &ctx));
+    TEST_ASSERT_EQUAL(ctx.visited, 3);
+    TEST_ASSERT_EQUAL(ctx.total_length, 20);
+    TEST_ASSERT_FALSE(dict_has_key(dict, "mary"));
+
+    /*  Check visitor can stop the iteration early  */
+
+    char key[32];
+    for ( int i = 0; i < 20; ++i ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(dict_insert(dict, key, gds_strdup("value")));
+    }
+
+    ctx.visited = 0;
+    TEST_ASSERT_FALSE(dict_foreach(dict, foreach_visitor, &ctx));
+    TEST_ASSERT_EQUAL(ctx.visited, 10);
+
+    dict_destroy(dict);
+}
+
+/*  Test saving and mapping a dictionary of integers  */
+
+TEST_CASE(test_dict_mapped_int)
+{
+    Dict dict = dict_create(DATATYPE_INT, 0);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    char key[32];
+    for ( int i = 0; i < 5000; ++i ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(dict_insert(dict, key, i * 3));
+    }
+
+    char path[] = "/tmp/pggds_test_dictXXXXXX";
+    const int fd = mkstemp(path);
+    if ( fd == -1 ) {
+        perror("couldn't create temporary file");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    TEST_ASSERT_TRUE(dict_save(dict, path));
+    dict_destroy(dict);
+
+    DictMapped mapped = dict_open_mapped(path);
+    TEST_ASSERT_TRUE(mapped != NULL);
+
+    if ( mapped ) {
+        TEST_ASSERT_EQUAL(dict_mapped_size(mapped), 5000);
+        TEST_ASSERT_EQUAL(dict_mapped_type(mapped), DATATYPE_INT);
+
+        for ( int i = 0; i < 5000; ++i ) {
+            int n = -1;
+            sprintf(key, "key%d", i);
+            TEST_ASSERT_TRUE(dict_mapped_value_for_key(mapped, key, &n));
+            TEST_ASSERT_EQUAL(n, i * 3);
+        }
+
+        TEST_ASSERT_FALSE(dict_mapped_has_key(mapped, "key5000"));
+        TEST_ASSERT_FALSE(dict_mapped_has_key(mapped, ""));
+
+        /*  Saving over the file leaves the old mapping usable  */
+
+        Dict other = dict_create(DATATYPE_INT, 0);
+        if ( !other ) {
+            perror("couldn't create dict");
+            exit(EXIT_FAILURE);
+        }
+        TEST_ASSERT_TRUE(dict_insert(other, "other", 42));
+        TEST_ASSERT_TRUE(dict_save(other, path));
+        dict_destroy(other);
+
+        int n = -1;
+        TEST_ASSERT_TRUE(dict_mapped_value_for_key(mapped, "key4999", &n));
+        TEST_ASSERT_EQUAL(n, 4999 * 3);
+        dict_mapped_close(mapped);
+
+        mapped = dict_open_mapped(path);
+        TEST_ASSERT_TRUE(mapped != NULL);
+        if ( mapped ) {
+            TEST_ASSERT_EQUAL(dict_mapped_size(mapped), 1);
+            TEST_ASSERT_TRUE(dict_mapped_value_for_key(mapped, "other", &n));
+            TEST_ASSERT_EQUAL(n, 42);
+            dict_mapped_close(mapped);
+        }
+    }
+
+    unlink(path);
+}
+
+/*  Test saving and mapping a dictionary of strings  */
+
+TEST_CASE(test_dict_mapped_string)
+{
+    Dict dict = dict_create(DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !dict ) {
+        perror("couldn't create dict");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(dict_insert(dict, "john", gds_strdup("Bolton")));
+    TEST_ASSERT_TRUE(dict_insert(dict, "mary", gds_strdup("Portsmouth")));
+    TEST_ASSERT_TRUE(dict_insert(dict, "skeletor", gds_strdup("")));
+
+    char path[] = "/tmp/pggds_test_dictXXXXXX";
+    const int fd = mkstemp(path);
+    if ( fd == -1 ) {
+        perror("couldn't create temporary file");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    TEST_ASSERT_TRUE(dict_save(dict, path));
+    dict_destroy(dict);
+
+    DictMapped mapped = dict_open_mapped(path);
+    TEST_ASSERT_TRUE(mapped != NULL);
+
+    if ( mapped ) {
+        TEST_ASSERT_TRUE(dict_verify_mapped(mapped));
+
+        char * pc;
+        TEST_ASSERT_TRUE(dict_mapped_value_for_key(mapped, "mary", &pc));
+        TEST_ASSERT_STR_EQUAL(pc, "Portsmouth");
+        TEST_ASSERT_TRUE(dict_mapped_value_for_key(mapped, "skeletor", &pc));
+        TEST_ASSERT_STR_EQUAL(pc, "");
+        TEST_ASSERT_FALSE(dict_mapped_value_for_key(mapped, "fabio", &pc));
+        dict_mapped_close(mapped);
+    }
+
+    /*  Corrupt the last byte, and check verification fails  */
+
+    FILE * fp = fopen(path, "r+b");
+    if ( !fp ) {
+        perror("couldn't open temporary file");
+        exit(EXIT_FAILURE);
+    }
+    fseek(fp, -1, SEEK_END);
+    fputc('x', fp);
+    fclose(fp);
+
+    mapped = dict_open_mapped(path);
+    TEST_ASSERT_TRUE(mapped != NULL);
+    if ( mapped ) {
+        TEST_ASSERT_FALSE(dict_verify_mapped(mapped));
+        dict_mapped_close(mapped);
+    }
+
+    unlink(path);
+}
+
 void test_dict(void)
 {
     RUN_CASE(test_dict_insert_int);
     RUN_CASE(test_dict_insert_string);
     RUN_CASE(test_dict_delete);
+    RUN_CASE(test_dict_many_keys);
+    RUN_CASE(test_dict_bloom);
+    RUN_CASE(test_dict_lookup_many);
+    RUN_CASE(test_dict_itr);
+    RUN_CASE(test_dict_foreach);
+    RUN_CASE(test_dict_mapped_int);
+    RUN_CASE(test_dict_mapped_string);
 }
@@ -0,0 +1,331 @@
+/*  Unit tests for persistent disk-backed queue  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <pggds/diskqueue.h>
+#include <pggds/unittest.h>
+#include "test_diskqueue.h"
+
+TEST_SUITE(test_diskqueue);
+
+/*  Size of segments for tests, small enough to fill many of them  */
+#define SEGMENT_SIZE 4096
+
+/*  Number of records pushed by tests  */
+#define NUM_RECORDS 500
+
+/*  Writes test record number n to buffer, returning its length  */
+
+static size_t diskqueue_test_record(char * buffer, const int n)
+{
+    int len = sprintf(buffer, "record %d:", n);
+    for ( int i = 0; i < n % 97; ++i ) {
+        buffer[len++] = (char) ('a' + i % 26);
+    }
+    return (size_t) len;
+}
+
+/*  Pops records first to last, returning true if all match  */
+
+static bool diskqueue_test_pop(DiskQueue queue, const int first,
+                               const int last)
+{
+    char expected[256];
+    bool ok = true;
+
+    for ( int n = first; n <= last; ++n ) {
+        const void * data;
+        size_t size;
+        const size_t len = diskqueue_test_record(expected, n);
+        ok = diskqueue_front(queue, &data, &size) && size == len &&
+             !memcmp(data, expected, len) && diskqueue_pop(queue) && ok;
+    }
+
+    return ok;
+}
+
+/*  Counts the segment files in a directory  */
+
+static int diskqueue_test_segments(const char * dir)
+{
+    DIR * d = opendir(dir);
+    int count = 0;
+    struct dirent * entry;
+
+    while ( d && (entry = readdir(d)) ) {
+        const size_t len = strlen(entry->d_name);
+        if ( len > 4 && !strcmp(entry->d_name + len - 4, ".seg") ) {
+            count += 1;
+        }
+    }
+
+    if ( d ) {
+        closedir(d);
+    }
+    return count;
+}
+
+/*  Removes a queue directory and its files  */
+
+static void diskqueue_test_remove(const char * dir)
+{
+    DIR * d = opendir(dir);
+    struct dirent * entry;
+    char path[512];
+
+    while ( d && (entry = readdir(d)) ) {
+        if ( strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..") ) {
+            snprintf(path, sizeof path, "%s/%s", dir, entry->d_name);
+            unlink(path);
+        }
+    }
+
+    if ( d ) {
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+/*  Test pushing and popping records across many segments  */
+
+TEST_CASE(test_diskqueue_basic)
+{
+    char dir[] = "/tmp/pggds_test_diskqueue_XXXXXX";
+    if ( !mkdtemp(dir) ) {
+        perror("couldn't create directory");
+        exit(EXIT_FAILURE);
+    }
+
+    DiskQueue queue = diskqueue_open(dir, SEGMENT_SIZE, 0, 0);
+    if ( !queue ) {
+        perror("couldn't open disk queue");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(diskqueue_is_empty(queue));
+    TEST_ASSERT_EQUAL(diskqueue_size(queue), 0);
+
+    char buffer[256];
+    for ( int n = 0; n < NUM_RECORDS; ++n ) {
+        const size_t len = diskqueue_test_record(buffer, n);
+        TEST_ASSERT_TRUE(diskqueue_push(queue, buffer, len));
+    }
+    TEST_ASSERT_EQUAL(diskqueue_size(queue), NUM_RECORDS);
+    TEST_ASSERT_TRUE(diskqueue_test_segments(dir) > 5);
+
+    /*  Empty records are allowed, records larger than a segment not  */
+
+    TEST_ASSERT_TRUE(diskqueue_push(queue, buffer, 0));
+    char * big = calloc(1, SEGMENT_SIZE);
+    if ( !big ) {
+        perror("couldn't allocate memory");
+        exit(EXIT_FAILURE);
+    }
+    TEST_ASSERT_FALSE(diskqueue_push(queue, big, SEGMENT_SIZE));
+    free(big);
+
+    /*  Consumed segments are recycled once synced,
+     *  keeping at most one spare.                   */
+
+    TEST_ASSERT_TRUE(diskqueue_test_pop(queue, 0, NUM_RECORDS - 1));
+    TEST_ASSERT_TRUE(diskqueue_test_segments(dir) > 5);
+    TEST_ASSERT_TRUE(diskqueue_sync(queue));
+    TEST_ASSERT_TRUE(diskqueue_test_segments(dir) <= 2);
+
+    const void * data;
+    size_t size;
+    TEST_ASSERT_TRUE(diskqueue_front(queue, &data, &size));
+    TEST_ASSERT_EQUAL(size, 0);
+    TEST_ASSERT_TRUE(diskqueue_pop(queue));
+    TEST_ASSERT_TRUE(diskqueue_is_empty(queue));
+
+    /*  Records go round the recycled segments  */
+
+    for ( int lap = 0; lap < 3; ++lap ) {
+        for ( int n = 0; n < NUM_RECORDS; ++n ) {
+            const size_t len = diskqueue_test_record(buffer, n);
+            diskqueue_push(queue, buffer, len);
+            if ( n % 2 ) {
+                TEST_ASSERT_TRUE(diskqueue_test_pop(queue, n / 2, n / 2));
+            }
+        }
+        TEST_ASSERT_TRUE(diskqueue_test_pop(queue, NUM_RECORDS / 2,
+                                            NUM_RECORDS - 1));
+        TEST_ASSERT_TRUE(diskqueue_sync(queue));
+        TEST_ASSERT_TRUE(diskqueue_test_segments(dir) <= 3);
+    }
+
+    TEST_ASSERT_TRUE(diskqueue_close(queue));
+    diskqueue_test_remove(dir);
+}
+
+/*  Test records survive closing and reopening the queue  */
+
+TEST_CASE(test_diskqueue_reopen)
+{
+    char dir[] = "/tmp/pggds_test_diskqueue_XXXXXX";
+    if ( !mkdtemp(dir) ) {
+        perror("couldn't create directory");
+        exit(EXIT_FAILURE);
+    }
+
+    DiskQueue queue = diskqueue_open(dir, SEGMENT_SIZE, 16, 0);
+    if ( !queue ) {
+        perror("couldn't open disk queue");
+        exit(EXIT_FAILURE);
+    }
+
+    char buffer[256];
+    for ( int n = 0; n < NUM_RECORDS; ++n ) {
+        const size_t len = diskqueue_test_record(buffer, n);
+        diskqueue_push(queue, buffer, len);
+    }
+    TEST_ASSERT_TRUE(diskqueue_test_pop(queue, 0, 99));
+    TEST_ASSERT_TRUE(diskqueue_close(queue));
+
+    /*  The segment size is taken from the existing queue  */
+
+    queue = diskqueue_open(dir, 1, 0, 0);
+    TEST_ASSERT_TRUE(queue != NULL);
+    if ( !queue ) {
+        diskqueue_test_remove(dir);
+        return;
+    }
+
+    TEST_ASSERT_EQUAL(diskqueue_size(queue), NUM_RECORDS - 100);
+    TEST_ASSERT_TRUE(diskqueue_test_pop(queue, 100, 199));
+    for ( int n = NUM_RECORDS; n < NUM_RECORDS + 100; ++n ) {
+        const size_t len = diskqueue_test_record(buffer, n);
+        diskqueue_push(queue, buffer, len);
+    }
+    TEST_ASSERT_TRUE(diskqueue_close(queue));
+
+    queue = diskqueue_open(dir, SEGMENT_SIZE, 0, 0);
+    TEST_ASSERT_TRUE(queue != NULL);
+    if ( queue ) {
+        TEST_ASSERT_EQUAL(diskqueue_size(queue), NUM_RECORDS - 100);
+        TEST_ASSERT_TRUE(diskqueue_test_pop(queue, 200,
+                                            NUM_RECORDS + 99));
+        TEST_ASSERT_TRUE(diskqueue_is_empty(queue));
+        diskqueue_close(queue);
+    }
+
+    diskqueue_test_remove(dir);
+}
+
+/*  Test recovery after a crash, and from a damaged record  */
+
+TEST_CASE(test_diskqueue_recovery)
+{
+    char dir[] = "/tmp/pggds_test_diskqueue_XXXXXX";
+    if ( !mkdtemp(dir) ) {
+        perror("couldn't create directory");
+        exit(EXIT_FAILURE);
+    }
+
+    const pid_t pid = fork();
+    if ( pid == -1 ) {
+        perror("couldn't fork");
+        exit(EXIT_FAILURE);
+    }
+    else if ( pid == 0 ) {
+
+        /*  The child pushes and pops without syncing, and
+         *  then exits without closing the queue.            */
+
+        DiskQueue child = diskqueue_open(dir, SEGMENT_SIZE, 0, 0);
+        if ( !child ) {
+            _exit(EXIT_FAILURE);
+        }
+
+        char buffer[256];
+        for ( int n = 0; n < NUM_RECORDS; ++n ) {
+            const size_t len = diskqueue_test_record(buffer, n);
+            diskqueue_push(child, buffer, len);
+        }
+        _exit(diskqueue_test_pop(child, 0, 49) ? EXIT_SUCCESS :
+                                                 EXIT_FAILURE);
+    }
+
+    int status;
+    TEST_ASSERT_EQUAL(waitpid(pid, &status, 0), pid);
+    TEST_ASSERT_TRUE(WIFEXITED(status) &&
+                     WEXITSTATUS(status) == EXIT_SUCCESS);
+
+    DiskQueue queue = diskqueue_open(dir, SEGMENT_SIZE, 0, 0);
+    TEST_ASSERT_TRUE(queue != NULL);
+    if ( !queue ) {
+        diskqueue_test_remove(dir);
+        return;
+    }
+    TEST_ASSERT_EQUAL(diskqueue_size(queue), NUM_RECORDS - 50);
+    TEST_ASSERT_TRUE(diskqueue_test_pop(queue, 50, 59));
+    TEST_ASSERT_TRUE(diskqueue_close(queue));
+
+    /*  Damage a byte of record 0 of the last segment, which must
+     *  be cut off along with every record after it.               */
+
+    unsigned int last = 0;
+    DIR * d = opendir(dir);
+    struct dirent * entry;
+    while ( d && (entry = readdir(d)) ) {
+        unsigned int n;
+        if ( sscanf(entry->d_name, "%x.seg", &n) == 1 && n > last ) {
+            last = n;
+        }
+    }
+    if ( d ) {
+        closedir(d);
+    }
+
+    char path[512];
+    snprintf(path, sizeof path, "%s/%016x.seg", dir, last);
+    const int fd = open(path, O_RDWR);
+    TEST_ASSERT_TRUE(fd != -1);
+    if ( fd != -1 ) {
+        char c = '?';
+        TEST_ASSERT_EQUAL(pwrite(fd, &c, 1, 20), 1);
+        close(fd);
+    }
+
+    queue = diskqueue_open(dir, SEGMENT_SIZE, 0, 0);
+    TEST_ASSERT_TRUE(queue != NULL);
+    if ( queue ) {
+        const size_t size = diskqueue_size(queue);
+        TEST_ASSERT_TRUE(size > 0 && size < NUM_RECORDS - 60);
+        TEST_ASSERT_TRUE(diskqueue_test_pop(queue, 60,
+                                            60 + (int) size - 1));
+
+        /*  New records follow straight on from the survivors  */
+
+        char buffer[256];
+        const size_t len = diskqueue_test_record(buffer, 7);
+        TEST_ASSERT_TRUE(diskqueue_push(queue, buffer, len));
+        TEST_ASSERT_TRUE(diskqueue_close(queue));
+
+        queue = diskqueue_open(dir, SEGMENT_SIZE, 0, 0);
+        TEST_ASSERT_TRUE(queue != NULL);
+        if ( queue ) {
+            TEST_ASSERT_EQUAL(diskqueue_size(queue), 1);
+            TEST_ASSERT_TRUE(diskqueue_test_pop(queue, 7, 7));
+            diskqueue_close(queue);
+        }
+    }
+
+    diskqueue_test_remove(dir);
+}
+
+void test_diskqueue(void)
+{
+    RUN_CASE(test_diskqueue_basic);
+    RUN_CASE(test_diskqueue_reopen);
+    RUN_CASE(test_diskqueue_recovery);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_DISKQUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_DISKQUEUE_H
+
+void test_diskqueue(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_DISKQUEUE_H  */
@@ -0,0 +1,183 @@
+/*  Unit tests for broadcast ring buffer  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/disruptor.h>
+#include <pggds/unittest.h>
+#include "test_disruptor.h"
+
+TEST_SUITE(test_disruptor);
+
+/*  Number of entries passed between threads in threaded test  */
+#define NUM_ENTRIES 200000
+
+/*  Number of consumer threads in threaded test  */
+#define NUM_CONSUMERS 4
+
+/*  Test entry structure  */
+
+struct test_entry {
+    long value;
+    long square;
+};
+
+/*  Test claiming, publishing and consuming in a single thread  */
+
+TEST_CASE(test_disruptor_basic)
+{
+    Disruptor ring = disruptor_create(3, sizeof(struct test_entry), 2, 0);
+    if ( !ring ) {
+        perror("couldn't create ring buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t first;
+    TEST_ASSERT_EQUAL(disruptor_capacity(ring), 4);
+    TEST_ASSERT_EQUAL(disruptor_available(ring, 0, &first), 0);
+    TEST_ASSERT_EQUAL(first, 0);
+
+    /*  Claimed entries are not visible until published  */
+
+    TEST_ASSERT_TRUE(disruptor_try_claim(ring, 3, &first));
+    TEST_ASSERT_EQUAL(first, 0);
+    for ( size_t i = 0; i < 3; ++i ) {
+        struct test_entry * entry = disruptor_entry(ring, first + i);
+        entry->value = (long) i;
+        entry->square = (long) (i * i);
+    }
+    TEST_ASSERT_EQUAL(disruptor_available(ring, 1, &first), 0);
+    disruptor_publish(ring, 2);
+    TEST_ASSERT_EQUAL(disruptor_available(ring, 1, &first), 2);
+    disruptor_publish(ring, 1);
+
+    /*  Both consumers read the same entries in place  */
+
+    TEST_ASSERT_EQUAL(disruptor_available(ring, 0, &first), 3);
+    TEST_ASSERT_EQUAL(first, 0);
+    struct test_entry * entry = disruptor_entry(ring, first + 2);
+    TEST_ASSERT_EQUAL(entry->square, 4);
+    disruptor_release(ring, 0, 3);
+
+    /*  The slower consumer holds back the producer  */
+
+    TEST_ASSERT_TRUE(disruptor_try_claim(ring, 1, &first));
+    TEST_ASSERT_EQUAL(first, 3);
+    TEST_ASSERT_FALSE(disruptor_try_claim(ring, 1, &first));
+
+    TEST_ASSERT_EQUAL(disruptor_available(ring, 1, &first), 2);
+    TEST_ASSERT_TRUE(disruptor_entry(ring, first) == disruptor_entry(ring, 0));
+    disruptor_release(ring, 1, 1);
+    TEST_ASSERT_TRUE(disruptor_try_claim(ring, 1, &first));
+    TEST_ASSERT_EQUAL(first, 4);
+    TEST_ASSERT_TRUE(disruptor_entry(ring, 4) == disruptor_entry(ring, 0));
+    disruptor_publish(ring, 2);
+
+    /*  A closed ring still gives up its last entries  */
+
+    disruptor_close(ring);
+    TEST_ASSERT_EQUAL(disruptor_wait(ring, 0, &first), 2);
+    TEST_ASSERT_EQUAL(first, 3);
+    disruptor_release(ring, 0, 2);
+    TEST_ASSERT_EQUAL(disruptor_wait(ring, 0, &first), 0);
+
+    disruptor_destroy(ring);
+}
+
+/*  Consumer thread argument structure  */
+
+struct consumer_arg {
+    Disruptor ring;
+    size_t consumer;
+    long count;
+    bool in_order;
+};
+
+/*  Consumer thread function, checking every entry in place  */
+
+static void * disruptor_consumer_thread(void * arg)
+{
+    struct consumer_arg * c = arg;
+    size_t first, n;
+
+    while ( (n = disruptor_wait(c->ring, c->consumer, &first)) ) {
+
+        /*  Release some entries at a time, so consumers move
+         *  at different speeds and gate the producer in turn.  */
+
+        if ( n > c->consumer + 1 ) {
+            n = c->consumer + 1;
+        }
+        for ( size_t i = 0; i < n; ++i ) {
+            const struct test_entry * entry = disruptor_entry(c->ring,
+                                                              first + i);
+            c->in_order = c->in_order && entry->value == c->count &&
+                          entry->square == c->count * c->count;
+            c->count += 1;
+        }
+        disruptor_release(c->ring, c->consumer, n);
+    }
+
+    return NULL;
+}
+
+/*  Test one producer broadcasting to several consumer threads  */
+
+TEST_CASE(test_disruptor_threads)
+{
+    Disruptor ring = disruptor_create(64, sizeof(struct test_entry),
+                                      NUM_CONSUMERS, 0);
+    if ( !ring ) {
+        perror("couldn't create ring buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_t tids[NUM_CONSUMERS];
+    struct consumer_arg args[NUM_CONSUMERS];
+    for ( size_t i = 0; i < NUM_CONSUMERS; ++i ) {
+        args[i].ring = ring;
+        args[i].consumer = i;
+        args[i].count = 0;
+        args[i].in_order = true;
+        if ( pthread_create(&tids[i], NULL, disruptor_consumer_thread,
+                            &args[i]) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    long next = 0;
+    while ( next < NUM_ENTRIES ) {
+        size_t n = (size_t) (next % 13) + 1;
+        if ( next + (long) n > NUM_ENTRIES ) {
+            n = (size_t) (NUM_ENTRIES - next);
+        }
+
+        const size_t first = disruptor_claim(ring, n);
+        for ( size_t i = 0; i < n; ++i ) {
+            struct test_entry * entry = disruptor_entry(ring, first + i);
+            entry->value = next;
+            entry->square = next * next;
+            ++next;
+        }
+        disruptor_publish(ring, n);
+    }
+    disruptor_close(ring);
+
+    for ( size_t i = 0; i < NUM_CONSUMERS; ++i ) {
+        pthread_join(tids[i], NULL);
+        TEST_ASSERT_TRUE(args[i].in_order);
+        TEST_ASSERT_EQUAL(args[i].count, NUM_ENTRIES);
+    }
+
+    disruptor_destroy(ring);
+}
+
+void test_disruptor(void)
+{
+    RUN_CASE(test_disruptor_basic);
+    RUN_CASE(test_disruptor_threads);
+}
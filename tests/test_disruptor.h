@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_DISRUPTOR_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_DISRUPTOR_H
+
+void test_disruptor(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_DISRUPTOR_H  */
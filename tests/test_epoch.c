@@ -0,0 +1,240 @@
+/*  Unit tests for epoch-based memory reclamation  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/gds_epoch.h>
+#include <pggds/unittest.h>
+#include "test_epoch.h"
+
+TEST_SUITE(test_epoch);
+
+/*  Number of reading threads for threaded test  */
+#define NUM_READERS 4
+
+/*  Number of writing threads for threaded test  */
+#define NUM_WRITERS 2
+
+/*  Number of objects each writer replaces  */
+#define NUM_UPDATES 20000
+
+/*  Test object structure  */
+
+struct epoch_object {
+    unsigned long value;            /*  Value of the object                 */
+    unsigned long check;            /*  Bitwise complement of the value     */
+};
+
+/*  Number of objects freed by epoch_object_free()  */
+static size_t epoch_freed;
+
+/*  Creates a test object  */
+
+static struct epoch_object * epoch_object_create(const unsigned long value)
+{
+    struct epoch_object * object = malloc(sizeof *object);
+    if ( !object ) {
+        perror("couldn't allocate memory");
+        exit(EXIT_FAILURE);
+    }
+    object->value = value;
+    object->check = ~value;
+    return object;
+}
+
+/*  Frees a test object, spoiling it first so that a thread
+ *  reading it too late sees a mismatch, or a data race
+ *  when running under ThreadSanitizer.                       */
+
+static void epoch_object_free(void * p)
+{
+    struct epoch_object * object = p;
+    object->check = object->value;
+    free(object);
+    __atomic_add_fetch(&epoch_freed, 1, __ATOMIC_RELAXED);
+}
+
+/*  Test retiring and reclaiming from a single thread  */
+
+TEST_CASE(test_epoch_basic)
+{
+    GDSEpoch domain = gds_epoch_create(0);
+    if ( !domain ) {
+        perror("couldn't create reclamation domain");
+        exit(EXIT_FAILURE);
+    }
+
+    epoch_freed = 0;
+    for ( unsigned long i = 0; i < 10; ++i ) {
+        TEST_ASSERT_TRUE(gds_epoch_retire(domain, epoch_object_create(i),
+                                          epoch_object_free));
+    }
+
+    /*  Two advances are needed before the objects are freed  */
+
+    size_t freed = 0;
+    for ( int i = 0; i < 3; ++i ) {
+        freed += gds_epoch_reclaim(domain);
+    }
+    TEST_ASSERT_EQUAL(freed, 10);
+    TEST_ASSERT_EQUAL(epoch_freed, 10);
+
+    /*  An object retired within a critical section survives it  */
+
+    TEST_ASSERT_TRUE(gds_epoch_enter(domain));
+    TEST_ASSERT_TRUE(gds_epoch_retire(domain, epoch_object_create(10),
+                                      epoch_object_free));
+    TEST_ASSERT_TRUE(gds_epoch_enter(domain));
+    gds_epoch_exit(domain);
+
+    freed = 0;
+    for ( int i = 0; i < 5; ++i ) {
+        freed += gds_epoch_reclaim(domain);
+    }
+    TEST_ASSERT_EQUAL(freed, 0);
+
+    gds_epoch_exit(domain);
+
+    for ( int i = 0; i < 3; ++i ) {
+        freed += gds_epoch_reclaim(domain);
+    }
+    TEST_ASSERT_EQUAL(freed, 1);
+    TEST_ASSERT_EQUAL(epoch_freed, 11);
+
+    /*  Synchronizing frees retired objects without further reclaims  */
+
+    TEST_ASSERT_TRUE(gds_epoch_retire(domain, epoch_object_create(11),
+                                      epoch_object_free));
+    gds_epoch_synchronize(domain);
+    TEST_ASSERT_EQUAL(epoch_freed, 12);
+
+    /*  Objects still retired are freed on destruction  */
+
+    TEST_ASSERT_TRUE(gds_epoch_retire(domain, malloc(16), NULL));
+    TEST_ASSERT_TRUE(gds_epoch_retire(domain, epoch_object_create(12),
+                                      epoch_object_free));
+    gds_epoch_destroy(domain);
+    TEST_ASSERT_EQUAL(epoch_freed, 13);
+}
+
+/*  Threaded test info structure  */
+
+struct epoch_test_info {
+    GDSEpoch domain;                /*  The reclamation domain              */
+    struct epoch_object * current;  /*  Shared object                       */
+    unsigned long next_value;       /*  Value for next shared object        */
+    int writers_done;               /*  Number of writers finished          */
+    int errors;                     /*  Spoiled objects seen by readers     */
+};
+
+/*  Writing thread function, replacing the shared object
+ *  and retiring the old one.                              */
+
+static void * epoch_write_thread(void * arg)
+{
+    struct epoch_test_info * info = arg;
+
+    for ( int i = 0; i < NUM_UPDATES; ++i ) {
+        const unsigned long value = __atomic_add_fetch(&info->next_value, 1,
+                                                       __ATOMIC_RELAXED);
+        struct epoch_object * object = epoch_object_create(value);
+        struct epoch_object * old = __atomic_exchange_n(&info->current,
+                                                        object,
+                                                        __ATOMIC_ACQ_REL);
+        gds_epoch_retire(info->domain, old, epoch_object_free);
+    }
+
+    __atomic_add_fetch(&info->writers_done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+/*  Reading thread function, checking the shared object
+ *  within critical sections, sometimes nested.          */
+
+static void * epoch_read_thread(void * arg)
+{
+    struct epoch_test_info * info = arg;
+    int errors = 0;
+    unsigned long reads = 0;
+
+    do {
+        gds_epoch_enter(info->domain);
+
+        struct epoch_object * object = __atomic_load_n(&info->current,
+                                                       __ATOMIC_ACQUIRE);
+        if ( ++reads % 8 == 0 ) {
+            gds_epoch_enter(info->domain);
+            object = __atomic_load_n(&info->current, __ATOMIC_ACQUIRE);
+            gds_epoch_exit(info->domain);
+        }
+
+        if ( object->check != ~object->value ) {
+            errors += 1;
+        }
+
+        gds_epoch_exit(info->domain);
+    } while ( __atomic_load_n(&info->writers_done, __ATOMIC_ACQUIRE) <
+              NUM_WRITERS );
+
+    __atomic_add_fetch(&info->errors, errors, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+/*  Stress test replacing an object while other threads read it  */
+
+TEST_CASE(test_epoch_threads)
+{
+    struct epoch_test_info info;
+    info.domain = gds_epoch_create(0);
+    if ( !info.domain ) {
+        perror("couldn't create reclamation domain");
+        exit(EXIT_FAILURE);
+    }
+    info.current = epoch_object_create(0);
+    info.next_value = 0;
+    info.writers_done = 0;
+    info.errors = 0;
+    epoch_freed = 0;
+
+    pthread_t readers[NUM_READERS];
+    pthread_t writers[NUM_WRITERS];
+    for ( size_t i = 0; i < NUM_READERS; ++i ) {
+        if ( pthread_create(&readers[i], NULL, epoch_read_thread,
+                            &info) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for ( size_t i = 0; i < NUM_WRITERS; ++i ) {
+        if ( pthread_create(&writers[i], NULL, epoch_write_thread,
+                            &info) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for ( size_t i = 0; i < NUM_WRITERS; ++i ) {
+        pthread_join(writers[i], NULL);
+    }
+    for ( size_t i = 0; i < NUM_READERS; ++i ) {
+        pthread_join(readers[i], NULL);
+    }
+
+    TEST_ASSERT_EQUAL(info.errors, 0);
+
+    /*  Objects left by the exited writers are freed on destruction  */
+
+    gds_epoch_retire(info.domain, info.current, epoch_object_free);
+    gds_epoch_destroy(info.domain);
+    TEST_ASSERT_EQUAL(epoch_freed, NUM_WRITERS * NUM_UPDATES + 1);
+}
+
+void test_epoch(void)
+{
+    RUN_CASE(test_epoch_basic);
+    RUN_CASE(test_epoch_threads);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_EPOCH_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_EPOCH_H
+
+void test_epoch(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_EPOCH_H  */
@@ -0,0 +1,182 @@
+/*  Unit tests for lock-free stack  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/lfstack.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_lfstack.h"
+
+TEST_SUITE(test_lfstack);
+
+/*  Number of threads for threaded test  */
+#define NUM_THREADS 4
+
+/*  Number of objects in the pool for threaded test  */
+#define NUM_OBJECTS 8
+
+/*  Number of times each thread takes and returns an object  */
+#define ITERATIONS 50000
+
+/*  Test basic single-threaded operations  */
+
+TEST_CASE(test_lfstack_basic)
+{
+    LFStack stack = lfstack_create(3, DATATYPE_INT, 0);
+    if ( !stack ) {
+        perror("couldn't create lock-free stack");
+        exit(EXIT_FAILURE);
+    }
+
+    int n;
+    TEST_ASSERT_EQUAL(lfstack_capacity(stack), 3);
+    TEST_ASSERT_TRUE(lfstack_is_empty(stack));
+    TEST_ASSERT_FALSE(lfstack_pop(stack, &n));
+
+    for ( int lap = 0; lap < 3; ++lap ) {
+        TEST_ASSERT_TRUE(lfstack_push(stack, 1));
+        TEST_ASSERT_TRUE(lfstack_push(stack, 2));
+        TEST_ASSERT_TRUE(lfstack_push(stack, 3));
+        TEST_ASSERT_FALSE(lfstack_push(stack, 4));
+        TEST_ASSERT_FALSE(lfstack_is_empty(stack));
+
+        for ( int i = 3; i >= 1; --i ) {
+            TEST_ASSERT_TRUE(lfstack_pop(stack, &n));
+            TEST_ASSERT_EQUAL(n, i);
+        }
+        TEST_ASSERT_FALSE(lfstack_pop(stack, &n));
+        TEST_ASSERT_TRUE(lfstack_is_empty(stack));
+    }
+
+    lfstack_destroy(stack);
+}
+
+/*  Test pointer values with GDS_FREE_ON_DESTROY  */
+
+TEST_CASE(test_lfstack_free)
+{
+    LFStack stack = lfstack_create(4, DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !stack ) {
+        perror("couldn't create lock-free stack");
+        exit(EXIT_FAILURE);
+    }
+
+    lfstack_push(stack, gds_strdup("one"));
+    lfstack_push(stack, gds_strdup("two"));
+    lfstack_push(stack, gds_strdup("three"));
+
+    char * pc;
+    lfstack_pop(stack, &pc);
+    TEST_ASSERT_STR_EQUAL(pc, "three");
+    free(pc);
+
+    lfstack_destroy(stack);
+}
+
+/*  Pool thread info structure  */
+
+struct lfstack_pool_info {
+    LFStack pool;                   /*  Stack of free object numbers        */
+    int * owners;                   /*  Number of owners of each object     */
+    int errors;                     /*  Objects found with two owners       */
+};
+
+/*  Pool thread function, taking and returning objects in a tight loop  */
+
+static void * lfstack_pool_thread(void * arg)
+{
+    struct lfstack_pool_info * info = arg;
+    int errors = 0;
+
+    for ( int i = 0; i < ITERATIONS; ++i ) {
+        int obj[2];
+        int taken = 0;
+
+        /*  Take up to two objects, so the stack is often empty
+         *  and nodes are recycled in varying orders.            */
+
+        while ( taken < 2 && lfstack_pop(info->pool, &obj[taken]) ) {
+            if ( __atomic_add_fetch(&info->owners[obj[taken]], 1,
+                                    __ATOMIC_RELAXED) != 1 ) {
+                errors += 1;
+            }
+            ++taken;
+        }
+
+        while ( taken ) {
+            --taken;
+            __atomic_sub_fetch(&info->owners[obj[taken]], 1,
+                               __ATOMIC_RELAXED);
+            if ( !lfstack_push(info->pool, obj[taken]) ) {
+                errors += 1;
+            }
+        }
+    }
+
+    __atomic_add_fetch(&info->errors, errors, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+/*  Test a shared pool of objects, where ABA would hand
+ *  out an object twice or lose it from the pool.         */
+
+TEST_CASE(test_lfstack_threads)
+{
+    struct lfstack_pool_info info;
+    int owners[NUM_OBJECTS] = {0};
+
+    info.pool = lfstack_create(NUM_OBJECTS, DATATYPE_INT, 0);
+    if ( !info.pool ) {
+        perror("couldn't create lock-free stack");
+        exit(EXIT_FAILURE);
+    }
+    info.owners = owners;
+    info.errors = 0;
+
+    for ( int i = 0; i < NUM_OBJECTS; ++i ) {
+        lfstack_push(info.pool, i);
+    }
+
+    pthread_t tids[NUM_THREADS];
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        if ( pthread_create(&tids[i], NULL, lfstack_pool_thread,
+                            &info) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        pthread_join(tids[i], NULL);
+    }
+
+    TEST_ASSERT_EQUAL(info.errors, 0);
+
+    /*  Every object is back in the pool exactly once  */
+
+    int n, seen[NUM_OBJECTS] = {0};
+    int count = 0;
+    bool valid = true;
+    while ( lfstack_pop(info.pool, &n) ) {
+        valid = valid && n >= 0 && n < NUM_OBJECTS && !seen[n];
+        if ( n >= 0 && n < NUM_OBJECTS ) {
+            seen[n] = 1;
+        }
+        ++count;
+    }
+    TEST_ASSERT_TRUE(valid);
+    TEST_ASSERT_EQUAL(count, NUM_OBJECTS);
+
+    lfstack_destroy(info.pool);
+}
+
+void test_lfstack(void)
+{
+    RUN_CASE(test_lfstack_basic);
+    RUN_CASE(test_lfstack_free);
+    RUN_CASE(test_lfstack_threads);
+}
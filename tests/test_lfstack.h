@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_LFSTACK_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_LFSTACK_H
+
+void test_lfstack(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_LFSTACK_H  */
@@ -0,0 +1,188 @@
+/*  Unit tests for generic LRU cache data structure  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pggds/lrucache.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_lrucache.h"
+
+TEST_SUITE(test_lrucache);
+
+/*  Eviction function to record the last evicted key and value  */
+
+static char last_key[32];
+static int last_value;
+
+static void record_evict(const char * key, void * value, void * ctx)
+{
+    strcpy(last_key, key);
+    last_value = *((int *) value);
+    *((int *) ctx) += 1;
+}
+
+/*  Test eviction order and promotion on access  */
+
+TEST_CASE(test_lrucache_evict)
+{
+    LRUCache cache = lrucache_create(3, DATATYPE_INT, 0);
+    if ( !cache ) {
+        perror("couldn't create LRU cache");
+        exit(EXIT_FAILURE);
+    }
+
+    int evictions = 0, n;
+    lrucache_set_evict_func(cache, record_evict, &evictions);
+
+    TEST_ASSERT_EQUAL(lrucache_capacity(cache), 3);
+    TEST_ASSERT_TRUE(lrucache_put(cache, "a", 1));
+    TEST_ASSERT_TRUE(lrucache_put(cache, "b", 2));
+    TEST_ASSERT_TRUE(lrucache_put(cache, "c", 3));
+    TEST_ASSERT_EQUAL(lrucache_size(cache), 3);
+    TEST_ASSERT_EQUAL(evictions, 0);
+
+    /*  Touch "a" so that "b" becomes least recently used  */
+
+    TEST_ASSERT_TRUE(lrucache_get(cache, "a", &n));
+    TEST_ASSERT_EQUAL(n, 1);
+
+    TEST_ASSERT_TRUE(lrucache_put(cache, "d", 4));
+    TEST_ASSERT_EQUAL(evictions, 1);
+    TEST_ASSERT_STR_EQUAL(last_key, "b");
+    TEST_ASSERT_EQUAL(last_value, 2);
+    TEST_ASSERT_FALSE(lrucache_has_key(cache, "b"));
+    TEST_ASSERT_EQUAL(lrucache_size(cache), 3);
+
+    /*  Overwriting promotes without evicting  */
+
+    TEST_ASSERT_TRUE(lrucache_put(cache, "c", 30));
+    TEST_ASSERT_EQUAL(evictions, 1);
+    TEST_ASSERT_TRUE(lrucache_put(cache, "e", 5));
+    TEST_ASSERT_STR_EQUAL(last_key, "a");
+    TEST_ASSERT_TRUE(lrucache_get(cache, "c", &n));
+    TEST_ASSERT_EQUAL(n, 30);
+
+    /*  Deleting frees a place without eviction  */
+
+    TEST_ASSERT_TRUE(lrucache_delete(cache, "d"));
+    TEST_ASSERT_FALSE(lrucache_delete(cache, "d"));
+    TEST_ASSERT_TRUE(lrucache_put(cache, "f", 6));
+    TEST_ASSERT_EQUAL(evictions, 2);
+    TEST_ASSERT_TRUE(lrucache_has_key(cache, "e"));
+
+    lrucache_destroy(cache);
+}
+
+/*  Test hit and miss counters  */
+
+TEST_CASE(test_lrucache_stats)
+{
+    LRUCache cache = lrucache_create(2, DATATYPE_INT, 0);
+    if ( !cache ) {
+        perror("couldn't create LRU cache");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(lrucache_put(cache, "x", 1));
+    TEST_ASSERT_TRUE(lrucache_get(cache, "x", NULL));
+    TEST_ASSERT_TRUE(lrucache_get(cache, "x", NULL));
+    TEST_ASSERT_FALSE(lrucache_get(cache, "y", NULL));
+    TEST_ASSERT_TRUE(lrucache_has_key(cache, "x"));
+    TEST_ASSERT_FALSE(lrucache_has_key(cache, "y"));
+
+    TEST_ASSERT_EQUAL(lrucache_hits(cache), 2);
+    TEST_ASSERT_EQUAL(lrucache_misses(cache), 1);
+
+    lrucache_reset_stats(cache);
+    TEST_ASSERT_EQUAL(lrucache_hits(cache), 0);
+    TEST_ASSERT_EQUAL(lrucache_misses(cache), 0);
+
+    lrucache_destroy(cache);
+}
+
+/*  Test many keys cycling through a small cache  */
+
+TEST_CASE(test_lrucache_many_keys)
+{
+    LRUCache cache = lrucache_create(100, DATATYPE_INT, 0);
+    if ( !cache ) {
+        perror("couldn't create LRU cache");
+        exit(EXIT_FAILURE);
+    }
+
+    int evictions = 0;
+    lrucache_set_evict_func(cache, record_evict, &evictions);
+
+    char key[32];
+    for ( int i = 0; i < 5000; ++i ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(lrucache_put(cache, key, i));
+    }
+
+    TEST_ASSERT_EQUAL(evictions, 4900);
+    TEST_ASSERT_EQUAL(lrucache_size(cache), 100);
+
+    /*  Only the last hundred keys should remain  */
+
+    for ( int i = 0; i < 5000; ++i ) {
+        int n;
+        sprintf(key, "key%d", i);
+        if ( i < 4900 ) {
+            TEST_ASSERT_FALSE(lrucache_get(cache, key, &n));
+        }
+        else {
+            TEST_ASSERT_TRUE(lrucache_get(cache, key, &n));
+            TEST_ASSERT_EQUAL(n, i);
+        }
+    }
+
+    lrucache_destroy(cache);
+}
+
+/*  Eviction function which checks a string value is still valid  */
+
+static void check_evict(const char * key, void * value, void * ctx)
+{
+    (void) ctx;
+    if ( strcmp(key, *((char **) value)) ) {
+        abort();
+    }
+}
+
+/*  Test pointer values with GDS_FREE_ON_DESTROY  */
+
+TEST_CASE(test_lrucache_free)
+{
+    LRUCache cache = lrucache_create(10, DATATYPE_STRING,
+                                     GDS_FREE_ON_DESTROY);
+    if ( !cache ) {
+        perror("couldn't create LRU cache");
+        exit(EXIT_FAILURE);
+    }
+
+    lrucache_set_evict_func(cache, check_evict, NULL);
+
+    char key[32];
+    for ( int i = 0; i < 50; ++i ) {
+        sprintf(key, "k%d", i);
+        TEST_ASSERT_TRUE(lrucache_put(cache, key, gds_strdup(key)));
+    }
+
+    TEST_ASSERT_TRUE(lrucache_put(cache, "k45", gds_strdup("k45")));
+    TEST_ASSERT_TRUE(lrucache_delete(cache, "k46"));
+
+    char * pc;
+    TEST_ASSERT_TRUE(lrucache_get(cache, "k49", &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "k49");
+
+    lrucache_destroy(cache);
+}
+
+void test_lrucache(void)
+{
+    RUN_CASE(test_lrucache_evict);
+    RUN_CASE(test_lrucache_stats);
+    RUN_CASE(test_lrucache_many_keys);
+    RUN_CASE(test_lrucache_free);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_LRU_CACHE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_LRU_CACHE_H
+
+void test_lrucache(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_LRU_CACHE_H  */
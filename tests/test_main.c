@@ -7,6 +7,26 @@
 #include "test_list.h"
 #include "test_vector.h"
 #include "test_dict.h"
+#include "test_cdict.h"
+#include "test_rcudict.h"
+#include "test_omap.h"
+#include "test_lrucache.h"
+#include "test_sstable.h"
+#include "test_phash.h"
+#include "test_set.h"
+#include "test_bqueue.h"
+#include "test_spscqueue.h"
+#include "test_mpmcqueue.h"
+#include "test_threadpool.h"
+#include "test_pqueue.h"
+#include "test_timerwheel.h"
+#include "test_deque.h"
+#include "test_disruptor.h"
+#include "test_shmqueue.h"
+#include "test_diskqueue.h"
+#include "test_lfstack.h"
+#include "test_cvector.h"
+#include "test_epoch.h"
 #include "test_string.h"
 #include "test_string_util.h"
 #include "test_std_wrappers.h"
@@ -15,7 +35,13 @@
 int main(int argc, char ** argv)
 {
     bool stack = false, queue = false, list = false, vector = false;
-    bool dict = false, string_util = false, gds_string = false;
+    bool dict = false, cdict = false, rcudict = false, omap = false;
+    bool lrucache = false, sstable = false, phash = false, set = false;
+    bool bqueue = false, spscqueue = false, mpmcqueue = false;
+    bool threadpool = false, pqueue = false, timerwheel = false, deque = false;
+    bool disruptor = false, shmqueue = false, diskqueue = false;
+    bool lfstack = false, cvector = false, epoch = false;
+    bool string_util = false, gds_string = false;
     bool stdwrap = false, options = false;
 
     if ( argc < 2 ) {
@@ -24,6 +50,26 @@ int main(int argc, char ** argv)
         list = true;
         vector = true;
         dict = true;
+        cdict = true;
+        rcudict = true;
+        omap = true;
+        lrucache = true;
+        sstable = true;
+        phash = true;
+        set = true;
+        bqueue = true;
+        spscqueue = true;
+        mpmcqueue = true;
+        threadpool = true;
+        pqueue = true;
+        timerwheel = true;
+        deque = true;
+        disruptor = true;
+        shmqueue = true;
+        diskqueue = true;
+        lfstack = true;
+        cvector = true;
+        epoch = true;
         string_util = true;
         gds_string = true;
         stdwrap = true;
@@ -48,6 +94,66 @@ int main(int argc, char ** argv)
             else if ( !strcmp(argv[i], "dict") ) {
                 dict = true;
             }
+            else if ( !strcmp(argv[i], "cdict") ) {
+                cdict = true;
+            }
+            else if ( !strcmp(argv[i], "rcudict") ) {
+                rcudict = true;
+            }
+            else if ( !strcmp(argv[i], "omap") ) {
+                omap = true;
+            }
+            else if ( !strcmp(argv[i], "lrucache") ) {
+                lrucache = true;
+            }
+            else if ( !strcmp(argv[i], "sstable") ) {
+                sstable = true;
+            }
+            else if ( !strcmp(argv[i], "phash") ) {
+                phash = true;
+            }
+            else if ( !strcmp(argv[i], "set") ) {
+                set = true;
+            }
+            else if ( !strcmp(argv[i], "bqueue") ) {
+                bqueue = true;
+            }
+            else if ( !strcmp(argv[i], "spscqueue") ) {
+                spscqueue = true;
+            }
+            else if ( !strcmp(argv[i], "mpmcqueue") ) {
+                mpmcqueue = true;
+            }
+            else if ( !strcmp(argv[i], "threadpool") ) {
+                threadpool = true;
+            }
+            else if ( !strcmp(argv[i], "pqueue") ) {
+                pqueue = true;
+            }
+            else if ( !strcmp(argv[i], "timerwheel") ) {
+                timerwheel = true;
+            }
+            else if ( !strcmp(argv[i], "deque") ) {
+                deque = true;
+            }
+            else if ( !strcmp(argv[i], "disruptor") ) {
+                disruptor = true;
+            }
+            else if ( !strcmp(argv[i], "shmqueue") ) {
+                shmqueue = true;
+            }
+            else if ( !strcmp(argv[i], "diskqueue") ) {
+                diskqueue = true;
+            }
+            else if ( !strcmp(argv[i], "lfstack") ) {
+                lfstack = true;
+            }
+            else if ( !strcmp(argv[i], "cvector") ) {
+                cvector = true;
+            }
+            else if ( !strcmp(argv[i], "epoch") ) {
+                epoch = true;
+            }
             else if ( !strcmp(argv[i], "string_util") ) {
                 string_util = true;
             }
@@ -90,6 +196,106 @@ int main(int argc, char ** argv)
         test_dict();
     }
 
+    if ( cdict ) {
+        printf("Running unit tests for concurrent dictionary...\n");
+        test_cdict();
+    }
+
+    if ( rcudict ) {
+        printf("Running unit tests for read-mostly dictionary...\n");
+        test_rcudict();
+    }
+
+    if ( omap ) {
+        printf("Running unit tests for ordered map...\n");
+        test_omap();
+    }
+
+    if ( lrucache ) {
+        printf("Running unit tests for LRU cache...\n");
+        test_lrucache();
+    }
+
+    if ( sstable ) {
+        printf("Running unit tests for sorted string table...\n");
+        test_sstable();
+    }
+
+    if ( phash ) {
+        printf("Running unit tests for minimal perfect hash...\n");
+        test_phash();
+    }
+
+    if ( set ) {
+        printf("Running unit tests for generic set...\n");
+        test_set();
+    }
+
+    if ( bqueue ) {
+        printf("Running unit tests for blocking queue...\n");
+        test_bqueue();
+    }
+
+    if ( spscqueue ) {
+        printf("Running unit tests for SPSC queue...\n");
+        test_spscqueue();
+    }
+
+    if ( mpmcqueue ) {
+        printf("Running unit tests for MPMC queue...\n");
+        test_mpmcqueue();
+    }
+
+    if ( threadpool ) {
+        printf("Running unit tests for thread pool...\n");
+        test_threadpool();
+    }
+
+    if ( pqueue ) {
+        printf("Running unit tests for priority queue...\n");
+        test_pqueue();
+    }
+
+    if ( timerwheel ) {
+        printf("Running unit tests for timer wheel...\n");
+        test_timerwheel();
+    }
+
+    if ( deque ) {
+        printf("Running unit tests for deque...\n");
+        test_deque();
+    }
+
+    if ( disruptor ) {
+        printf("Running unit tests for broadcast ring buffer...\n");
+        test_disruptor();
+    }
+
+    if ( shmqueue ) {
+        printf("Running unit tests for shared-memory queue...\n");
+        test_shmqueue();
+    }
+
+    if ( diskqueue ) {
+        printf("Running unit tests for persistent disk-backed queue...\n");
+        test_diskqueue();
+    }
+
+    if ( lfstack ) {
+        printf("Running unit tests for lock-free stack...\n");
+        test_lfstack();
+    }
+
+    if ( cvector ) {
+        printf("Running unit tests for concurrent vector...\n");
+        test_cvector();
+    }
+
+    if ( epoch ) {
+        printf("Running unit tests for epoch-based reclamation...\n");
+        test_epoch();
+    }
+
     if ( gds_string ) {
         printf("Running unit tests for string...\n");
         test_string();
@@ -0,0 +1,168 @@
+/*  Unit tests for multi-producer multi-consumer queue  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/mpmcqueue.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_mpmcqueue.h"
+
+TEST_SUITE(test_mpmcqueue);
+
+/*  Number of producer and consumer threads for threaded tests  */
+#define NUM_THREADS 4
+
+/*  Number of values pushed by each producer thread  */
+#define VALUES_PER_THREAD 20000
+
+/*  Test basic single-threaded operations  */
+
+TEST_CASE(test_mpmcqueue_basic)
+{
+    MPMCQueue queue = mpmcqueue_create(3, DATATYPE_INT, 0);
+    if ( !queue ) {
+        perror("couldn't create MPMC queue");
+        exit(EXIT_FAILURE);
+    }
+
+    int n;
+    TEST_ASSERT_EQUAL(mpmcqueue_capacity(queue), 4);
+    TEST_ASSERT_FALSE(mpmcqueue_try_pop(queue, &n));
+
+    /*  Go round the buffer several times  */
+
+    for ( int lap = 0; lap < 3; ++lap ) {
+        mpmcqueue_push(queue, 1);
+        TEST_ASSERT_TRUE(mpmcqueue_try_push(queue, 2));
+        TEST_ASSERT_TRUE(mpmcqueue_try_push(queue, 3));
+        TEST_ASSERT_TRUE(mpmcqueue_try_push(queue, 4));
+        TEST_ASSERT_FALSE(mpmcqueue_try_push(queue, 5));
+        TEST_ASSERT_EQUAL(mpmcqueue_size(queue), 4);
+
+        mpmcqueue_pop(queue, &n);
+        TEST_ASSERT_EQUAL(n, 1);
+        for ( int i = 2; i <= 4; ++i ) {
+            TEST_ASSERT_TRUE(mpmcqueue_try_pop(queue, &n));
+            TEST_ASSERT_EQUAL(n, i);
+        }
+        TEST_ASSERT_FALSE(mpmcqueue_try_pop(queue, &n));
+        TEST_ASSERT_EQUAL(mpmcqueue_size(queue), 0);
+    }
+
+    mpmcqueue_destroy(queue);
+}
+
+/*  Test pointer values with GDS_FREE_ON_DESTROY  */
+
+TEST_CASE(test_mpmcqueue_free)
+{
+    MPMCQueue queue = mpmcqueue_create(4, DATATYPE_STRING,
+                                       GDS_FREE_ON_DESTROY);
+    if ( !queue ) {
+        perror("couldn't create MPMC queue");
+        exit(EXIT_FAILURE);
+    }
+
+    mpmcqueue_push(queue, gds_strdup("one"));
+    mpmcqueue_push(queue, gds_strdup("two"));
+    mpmcqueue_push(queue, gds_strdup("three"));
+
+    char * pc;
+    mpmcqueue_pop(queue, &pc);
+    TEST_ASSERT_STR_EQUAL(pc, "one");
+    free(pc);
+
+    mpmcqueue_destroy(queue);
+}
+
+/*  Producer thread function, pushing 1 to VALUES_PER_THREAD  */
+
+static void * mpmcqueue_producer(void * arg)
+{
+    MPMCQueue queue = arg;
+
+    for ( long i = 1; i <= VALUES_PER_THREAD; ++i ) {
+        if ( i % 2 ) {
+            mpmcqueue_push(queue, i);
+        }
+        else {
+            while ( !mpmcqueue_try_push(queue, i) ) {
+                /*  Empty  */
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*  Consumer thread info structure  */
+
+struct mpmcqueue_consumer_info {
+    MPMCQueue queue;                /*  The queue                           */
+    long sum;                       /*  Sum of values popped                */
+};
+
+/*  Consumer thread function, popping VALUES_PER_THREAD values  */
+
+static void * mpmcqueue_consumer(void * arg)
+{
+    struct mpmcqueue_consumer_info * info = arg;
+    long value;
+
+    for ( long i = 0; i < VALUES_PER_THREAD; ++i ) {
+        mpmcqueue_pop(info->queue, &value);
+        info->sum += value;
+    }
+
+    return NULL;
+}
+
+/*  Test many producers and consumers through a small queue  */
+
+TEST_CASE(test_mpmcqueue_threads)
+{
+    MPMCQueue queue = mpmcqueue_create(16, DATATYPE_LONG, 0);
+    if ( !queue ) {
+        perror("couldn't create MPMC queue");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_t producers[NUM_THREADS], consumers[NUM_THREADS];
+    struct mpmcqueue_consumer_info info[NUM_THREADS];
+
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        info[i].queue = queue;
+        info[i].sum = 0;
+        if ( pthread_create(&consumers[i], NULL,
+                            mpmcqueue_consumer, &info[i]) != 0 ||
+             pthread_create(&producers[i], NULL,
+                            mpmcqueue_producer, queue) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    long sum = 0;
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        pthread_join(producers[i], NULL);
+        pthread_join(consumers[i], NULL);
+        sum += info[i].sum;
+    }
+
+    TEST_ASSERT_EQUAL(sum, (long) NUM_THREADS * VALUES_PER_THREAD *
+                           (VALUES_PER_THREAD + 1) / 2);
+    TEST_ASSERT_EQUAL(mpmcqueue_size(queue), 0);
+
+    mpmcqueue_destroy(queue);
+}
+
+void test_mpmcqueue(void)
+{
+    RUN_CASE(test_mpmcqueue_basic);
+    RUN_CASE(test_mpmcqueue_free);
+    RUN_CASE(test_mpmcqueue_threads);
+}
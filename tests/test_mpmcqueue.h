@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_MPMC_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_MPMC_QUEUE_H
+
+void test_mpmcqueue(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_MPMC_QUEUE_H  */
@@ -0,0 +1,247 @@
+/*  Unit tests for generic ordered map data structure  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pggds/omap.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_omap.h"
+
+TEST_SUITE(test_omap);
+
+/*  Number of keys for tests with many keys, a prime  */
+#define NUM_KEYS 5003
+
+/*  Multiplier to visit keys in a scattered order  */
+#define SCATTER 1931
+
+/*  Test basic operations with integer keys  */
+
+TEST_CASE(test_omap_basic)
+{
+    OMap omap = omap_create(DATATYPE_INT, DATATYPE_LONG, 0);
+    if ( !omap ) {
+        perror("couldn't create ordered map");
+        exit(EXIT_FAILURE);
+    }
+
+    long n;
+
+    TEST_ASSERT_TRUE(omap_is_empty(omap));
+    TEST_ASSERT_TRUE(omap_insert(omap, 20, 200L));
+    TEST_ASSERT_TRUE(omap_insert(omap, 10, 100L));
+    TEST_ASSERT_TRUE(omap_insert(omap, 30, 300L));
+    TEST_ASSERT_EQUAL(omap_size(omap), 3);
+
+    TEST_ASSERT_TRUE(omap_find(omap, &n, 10));
+    TEST_ASSERT_EQUAL(n, 100);
+    TEST_ASSERT_TRUE(omap_find(omap, NULL, 30));
+    TEST_ASSERT_FALSE(omap_find(omap, &n, 15));
+
+    /*  Overwrite an existing key  */
+
+    TEST_ASSERT_TRUE(omap_insert(omap, 20, 250L));
+    TEST_ASSERT_EQUAL(omap_size(omap), 3);
+    TEST_ASSERT_TRUE(omap_find(omap, &n, 20));
+    TEST_ASSERT_EQUAL(n, 250);
+
+    TEST_ASSERT_TRUE(omap_delete(omap, 10));
+    TEST_ASSERT_FALSE(omap_delete(omap, 10));
+    TEST_ASSERT_FALSE(omap_find(omap, NULL, 10));
+    TEST_ASSERT_EQUAL(omap_size(omap), 2);
+
+    omap_destroy(omap);
+}
+
+/*  Test ordering is kept through many insertions and deletions  */
+
+TEST_CASE(test_omap_many_keys)
+{
+    OMap omap = omap_create(DATATYPE_INT, DATATYPE_INT, 0);
+    if ( !omap ) {
+        perror("couldn't create ordered map");
+        exit(EXIT_FAILURE);
+    }
+
+    for ( int i = 0; i < NUM_KEYS; ++i ) {
+        const int key = (int) (((long) i * SCATTER) % NUM_KEYS);
+        TEST_ASSERT_TRUE(omap_insert(omap, key, key * 2));
+    }
+    TEST_ASSERT_EQUAL(omap_size(omap), NUM_KEYS);
+
+    /*  Delete the odd keys, in a different scattered order  */
+
+    for ( int i = 0; i < NUM_KEYS; ++i ) {
+        const int key = (int) (((long) i * 7) % NUM_KEYS);
+        if ( key % 2 ) {
+            TEST_ASSERT_TRUE(omap_delete(omap, key));
+        }
+    }
+    TEST_ASSERT_EQUAL(omap_size(omap), NUM_KEYS / 2 + 1);
+
+    /*  Walk forwards, then backwards  */
+
+    OMapItr itr;
+    int expected = 0, key, value;
+    bool ok = omap_itr_first(omap, &itr);
+    while ( ok ) {
+        omap_itr_key(&itr, &key);
+        omap_itr_value(&itr, &value);
+        TEST_ASSERT_EQUAL(key, expected);
+        TEST_ASSERT_EQUAL(value, expected * 2);
+        expected += 2;
+        ok = omap_itr_next(&itr);
+    }
+    TEST_ASSERT_EQUAL(expected, NUM_KEYS + 1);
+
+    ok = omap_itr_last(omap, &itr);
+    while ( ok ) {
+        expected -= 2;
+        omap_itr_key(&itr, &key);
+        TEST_ASSERT_EQUAL(key, expected);
+        ok = omap_itr_previous(&itr);
+    }
+    TEST_ASSERT_EQUAL(expected, 0);
+
+    /*  Delete everything else, and check the map can be reused  */
+
+    for ( int i = 0; i < NUM_KEYS; i += 2 ) {
+        TEST_ASSERT_TRUE(omap_delete(omap, i));
+    }
+    TEST_ASSERT_TRUE(omap_is_empty(omap));
+    TEST_ASSERT_FALSE(omap_itr_first(omap, &itr));
+
+    TEST_ASSERT_TRUE(omap_insert(omap, 42, 1));
+    TEST_ASSERT_TRUE(omap_find(omap, &value, 42));
+    TEST_ASSERT_EQUAL(value, 1);
+
+    omap_destroy(omap);
+}
+
+/*  Visitor function to sum keys  */
+
+static bool sum_visitor(const void * key, void * value, void * ctx)
+{
+    (void) value;
+    *((long *) ctx) += *((const int *) key);
+    return true;
+}
+
+/*  Visitor function to stop after the first key  */
+
+static bool stop_visitor(const void * key, void * value, void * ctx)
+{
+    (void) key;
+    (void) value;
+    (void) ctx;
+    return false;
+}
+
+/*  Test lower bound and range queries  */
+
+TEST_CASE(test_omap_range)
+{
+    OMap omap = omap_create(DATATYPE_INT, DATATYPE_INT, 0);
+    if ( !omap ) {
+        perror("couldn't create ordered map");
+        exit(EXIT_FAILURE);
+    }
+
+    /*  Insert multiples of ten from 0 to 9990  */
+
+    for ( int i = 999; i >= 0; --i ) {
+        TEST_ASSERT_TRUE(omap_insert(omap, i * 10, i));
+    }
+
+    OMapItr itr;
+    int key;
+
+    TEST_ASSERT_TRUE(omap_lower_bound(omap, &itr, 4321));
+    omap_itr_key(&itr, &key);
+    TEST_ASSERT_EQUAL(key, 4330);
+
+    TEST_ASSERT_TRUE(omap_lower_bound(omap, &itr, 4330));
+    omap_itr_key(&itr, &key);
+    TEST_ASSERT_EQUAL(key, 4330);
+
+    TEST_ASSERT_TRUE(omap_lower_bound(omap, &itr, -5));
+    omap_itr_key(&itr, &key);
+    TEST_ASSERT_EQUAL(key, 0);
+
+    TEST_ASSERT_FALSE(omap_lower_bound(omap, &itr, 9991));
+
+    /*  [100, 200) holds 100, 110, ..., 190  */
+
+    long sum = 0;
+    TEST_ASSERT_EQUAL(omap_range(omap, sum_visitor, &sum, 100, 200), 10);
+    TEST_ASSERT_EQUAL(sum, 1450);
+
+    sum = 0;
+    TEST_ASSERT_EQUAL(omap_range(omap, sum_visitor, &sum, 9985, 20000), 1);
+    TEST_ASSERT_EQUAL(sum, 9990);
+
+    TEST_ASSERT_EQUAL(omap_range(omap, sum_visitor, &sum, 201, 209), 0);
+    TEST_ASSERT_EQUAL(omap_range(omap, stop_visitor, NULL, 0, 10000), 1);
+
+    omap_destroy(omap);
+}
+
+/*  Test string keys and values with GDS_FREE_ON_DESTROY  */
+
+TEST_CASE(test_omap_strings)
+{
+    OMap omap = omap_create(DATATYPE_STRING, DATATYPE_STRING,
+                            GDS_FREE_ON_DESTROY);
+    if ( !omap ) {
+        perror("couldn't create ordered map");
+        exit(EXIT_FAILURE);
+    }
+
+    char buffer[32];
+    char * pc;
+
+    for ( int i = 0; i < 500; ++i ) {
+        sprintf(buffer, "key%04d", i);
+        TEST_ASSERT_TRUE(omap_insert(omap, gds_strdup(buffer),
+                                     gds_strdup(buffer + 3)));
+    }
+
+    /*  Overwriting frees the old value and the duplicate key  */
+
+    TEST_ASSERT_TRUE(omap_insert(omap, gds_strdup("key0100"),
+                                 gds_strdup("hundred")));
+    TEST_ASSERT_TRUE(omap_find(omap, &pc, "key0100"));
+    TEST_ASSERT_STR_EQUAL(pc, "hundred");
+
+    /*  Deleting keys which are also separators must not leave
+     *  the tree referring to freed memory.                      */
+
+    for ( int i = 0; i < 500; i += 3 ) {
+        sprintf(buffer, "key%04d", i);
+        TEST_ASSERT_TRUE(omap_delete(omap, buffer));
+    }
+
+    for ( int i = 0; i < 500; ++i ) {
+        sprintf(buffer, "key%04d", i);
+        TEST_ASSERT_EQUAL(omap_find(omap, NULL, buffer), i % 3 != 0);
+    }
+
+    OMapItr itr;
+    TEST_ASSERT_TRUE(omap_itr_first(omap, &itr));
+    omap_itr_key(&itr, &pc);
+    TEST_ASSERT_STR_EQUAL(pc, "key0001");
+    TEST_ASSERT_TRUE(omap_itr_last(omap, &itr));
+    omap_itr_key(&itr, &pc);
+    TEST_ASSERT_STR_EQUAL(pc, "key0499");
+
+    omap_destroy(omap);
+}
+
+void test_omap(void)
+{
+    RUN_CASE(test_omap_basic);
+    RUN_CASE(test_omap_many_keys);
+    RUN_CASE(test_omap_range);
+    RUN_CASE(test_omap_strings);
+}
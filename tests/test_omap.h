@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_ORDERED_MAP_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_ORDERED_MAP_H
+
+void test_omap(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_ORDERED_MAP_H  */
@@ -0,0 +1,133 @@
+/*  Unit tests for minimal perfect hash data structure  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pggds/phash.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_phash.h"
+
+TEST_SUITE(test_phash);
+
+/*  Number of keys for tests with many keys  */
+#define NUM_KEYS 20000
+
+/*  Test every key gets a distinct index in range  */
+
+TEST_CASE(test_phash_minimal)
+{
+    char (*buffers)[16] = malloc(NUM_KEYS * sizeof *buffers);
+    const char ** keys = malloc(NUM_KEYS * sizeof *keys);
+    bool * seen = calloc(NUM_KEYS, sizeof *seen);
+    if ( !buffers || !keys || !seen ) {
+        perror("couldn't allocate memory");
+        exit(EXIT_FAILURE);
+    }
+
+    for ( size_t i = 0; i < NUM_KEYS; ++i ) {
+        sprintf(buffers[i], "key%zu", i);
+        keys[i] = buffers[i];
+    }
+
+    PHash hash = phash_create(keys, NUM_KEYS, DATATYPE_SIZE_T, 0);
+    if ( !hash ) {
+        perror("couldn't create perfect hash");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_EQUAL(phash_size(hash), NUM_KEYS);
+
+    /*  A few bits of pilots plus a 32-bit offset for each key  */
+
+    TEST_ASSERT_TRUE(phash_bits_per_key(hash) > 32.0);
+    TEST_ASSERT_TRUE(phash_bits_per_key(hash) <= 40.0);
+
+    for ( size_t i = 0; i < NUM_KEYS; ++i ) {
+        const size_t index = phash_index(hash, keys[i]);
+        TEST_ASSERT_TRUE(index < NUM_KEYS);
+        if ( index < NUM_KEYS ) {
+            TEST_ASSERT_FALSE(seen[index]);
+            seen[index] = true;
+        }
+        TEST_ASSERT_TRUE(phash_set_value(hash, keys[i], i * 2));
+    }
+
+    for ( size_t i = 0; i < NUM_KEYS; ++i ) {
+        size_t n = 0;
+        TEST_ASSERT_TRUE(phash_value_for_key(hash, keys[i], &n));
+        TEST_ASSERT_EQUAL(n, i * 2);
+    }
+
+    char absent[32];
+    for ( size_t i = NUM_KEYS; i < NUM_KEYS * 2; ++i ) {
+        sprintf(absent, "key%zu", i);
+        TEST_ASSERT_EQUAL(phash_index(hash, absent), PHASH_NOT_FOUND);
+        TEST_ASSERT_FALSE(phash_set_value(hash, absent, i));
+    }
+
+    phash_destroy(hash);
+    free(seen);
+    free(keys);
+    free(buffers);
+}
+
+/*  Test small key sets  */
+
+TEST_CASE(test_phash_small)
+{
+    const char * keys[] = { "help", "verbose", "output", "quiet" };
+
+    for ( size_t n = 0; n <= 4; ++n ) {
+        PHash hash = phash_create(keys, n, DATATYPE_INT, 0);
+        if ( !hash ) {
+            perror("couldn't create perfect hash");
+            exit(EXIT_FAILURE);
+        }
+
+        for ( size_t i = 0; i < 4; ++i ) {
+            TEST_ASSERT_EQUAL(phash_has_key(hash, keys[i]), i < n);
+        }
+        TEST_ASSERT_FALSE(phash_has_key(hash, ""));
+
+        phash_destroy(hash);
+    }
+}
+
+/*  Test string values with GDS_FREE_ON_DESTROY, and duplicate keys  */
+
+TEST_CASE(test_phash_strings)
+{
+    const char * keys[] = { "john", "mary", "skeletor" };
+    PHash hash = phash_create(keys, 3, DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !hash ) {
+        perror("couldn't create perfect hash");
+        exit(EXIT_FAILURE);
+    }
+
+    /*  Short keys use 16-bit offsets  */
+
+    TEST_ASSERT_TRUE(phash_bits_per_key(hash) < 32.0);
+
+    char * pc = NULL;
+    TEST_ASSERT_TRUE(phash_value_for_key(hash, "mary", &pc));
+    TEST_ASSERT_TRUE(pc == NULL);
+
+    TEST_ASSERT_TRUE(phash_set_value(hash, "mary", gds_strdup("Portsmouth")));
+    TEST_ASSERT_TRUE(phash_set_value(hash, "mary", gds_strdup("Leeds")));
+    TEST_ASSERT_TRUE(phash_set_value(hash, "john", gds_strdup("Bolton")));
+    TEST_ASSERT_TRUE(phash_value_for_key(hash, "mary", &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "Leeds");
+
+    phash_destroy(hash);
+
+    const char * dups[] = { "john", "mary", "john" };
+    TEST_ASSERT_TRUE(phash_create(dups, 3, DATATYPE_INT, 0) == NULL);
+}
+
+void test_phash(void)
+{
+    RUN_CASE(test_phash_minimal);
+    RUN_CASE(test_phash_small);
+    RUN_CASE(test_phash_strings);
+}
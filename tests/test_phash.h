@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_PERFECT_HASH_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_PERFECT_HASH_H
+
+void test_phash(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_PERFECT_HASH_H  */
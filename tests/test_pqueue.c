@@ -0,0 +1,262 @@
+/*  Unit tests for generic priority queue data structure  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pggds/pqueue.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_pqueue.h"
+
+TEST_SUITE(test_pqueue);
+
+/*  Comparison function for pointers to int  */
+
+static int compare_int_ptr(const void * p1, const void * p2)
+{
+    const int a = **((int * const *) p1);
+    const int b = **((int * const *) p2);
+    return a < b ? -1 : a > b;
+}
+
+/*  Test basic pushing, peeking and popping  */
+
+TEST_CASE(test_pqueue_basic)
+{
+    PriorityQueue queue = pqueue_create(0, DATATYPE_INT, 0);
+    if ( !queue ) {
+        perror("couldn't create priority queue");
+        exit(EXIT_FAILURE);
+    }
+
+    int n;
+    TEST_ASSERT_TRUE(pqueue_is_empty(queue));
+    TEST_ASSERT_FALSE(pqueue_pop(queue, &n));
+    TEST_ASSERT_FALSE(pqueue_peek(queue, &n));
+
+    TEST_ASSERT_TRUE(pqueue_push(queue, 5));
+    TEST_ASSERT_TRUE(pqueue_push(queue, -3));
+    TEST_ASSERT_TRUE(pqueue_push(queue, 8));
+    TEST_ASSERT_TRUE(pqueue_push(queue, -3));
+    TEST_ASSERT_EQUAL(pqueue_size(queue), 4);
+    TEST_ASSERT_FALSE(pqueue_is_empty(queue));
+
+    TEST_ASSERT_TRUE(pqueue_peek(queue, &n));
+    TEST_ASSERT_EQUAL(n, -3);
+    TEST_ASSERT_EQUAL(pqueue_size(queue), 4);
+
+    const int expected[] = {-3, -3, 5, 8};
+    for ( size_t i = 0; i < 4; ++i ) {
+        TEST_ASSERT_TRUE(pqueue_pop(queue, &n));
+        TEST_ASSERT_EQUAL(n, expected[i]);
+    }
+    TEST_ASSERT_TRUE(pqueue_is_empty(queue));
+
+    pqueue_destroy(queue);
+}
+
+/*  Test ordering of many values for several arities  */
+
+TEST_CASE(test_pqueue_many)
+{
+    const size_t arities[] = {2, 3, 4, 8};
+    const size_t n = 5000;
+
+    for ( size_t a = 0; a < sizeof arities / sizeof *arities; ++a ) {
+        PriorityQueue queue = pqueue_create(arities[a], DATATYPE_SIZE_T, 0);
+        if ( !queue ) {
+            perror("couldn't create priority queue");
+            exit(EXIT_FAILURE);
+        }
+
+        for ( size_t i = 0; i < n; ++i ) {
+            TEST_ASSERT_TRUE(pqueue_push(queue, (i * 7919) % n));
+        }
+        TEST_ASSERT_EQUAL(pqueue_size(queue), n);
+
+        for ( size_t i = 0; i < n; ++i ) {
+            size_t value;
+            TEST_ASSERT_TRUE(pqueue_pop(queue, &value));
+            TEST_ASSERT_EQUAL(value, i);
+        }
+        TEST_ASSERT_TRUE(pqueue_is_empty(queue));
+
+        pqueue_destroy(queue);
+    }
+}
+
+/*  Test building a heap from an array  */
+
+TEST_CASE(test_pqueue_heapify)
+{
+    PriorityQueue queue = pqueue_create(0, DATATYPE_DOUBLE, 0);
+    if ( !queue ) {
+        perror("couldn't create priority queue");
+        exit(EXIT_FAILURE);
+    }
+
+    double values[1000];
+    for ( size_t i = 0; i < 1000; ++i ) {
+        values[i] = (double) ((i * 389) % 1000) / 4.0;
+    }
+
+    TEST_ASSERT_TRUE(pqueue_push(queue, 100.0));
+    TEST_ASSERT_TRUE(pqueue_heapify(queue, values, 1000));
+    TEST_ASSERT_TRUE(pqueue_push(queue, -1.0));
+    TEST_ASSERT_EQUAL(pqueue_size(queue), 1002);
+
+    double d, last = -2.0;
+    while ( !pqueue_is_empty(queue) ) {
+        TEST_ASSERT_TRUE(pqueue_pop(queue, &d));
+        TEST_ASSERT_TRUE(d >= last);
+        last = d;
+    }
+    TEST_ASSERT_EQUAL(last, 999.0 / 4.0);
+
+    pqueue_destroy(queue);
+}
+
+/*  Test string values which are freed on destroy  */
+
+TEST_CASE(test_pqueue_strings)
+{
+    PriorityQueue queue = pqueue_create(0, DATATYPE_STRING,
+                                        GDS_FREE_ON_DESTROY);
+    if ( !queue ) {
+        perror("couldn't create priority queue");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(pqueue_push(queue, gds_strdup("pear")));
+    TEST_ASSERT_TRUE(pqueue_push(queue, gds_strdup("apple")));
+    TEST_ASSERT_TRUE(pqueue_push(queue, gds_strdup("orange")));
+    TEST_ASSERT_TRUE(pqueue_push(queue, gds_strdup("banana")));
+
+    char * s;
+    TEST_ASSERT_TRUE(pqueue_pop(queue, &s));
+    TEST_ASSERT_STR_EQUAL(s, "apple");
+    free(s);
+    TEST_ASSERT_TRUE(pqueue_pop(queue, &s));
+    TEST_ASSERT_STR_EQUAL(s, "banana");
+    free(s);
+
+    pqueue_destroy(queue);
+}
+
+/*  Test pointer values with a custom comparison function  */
+
+TEST_CASE(test_pqueue_pointer)
+{
+    PriorityQueue queue = pqueue_create(2, DATATYPE_POINTER, 0,
+                                        compare_int_ptr);
+    if ( !queue ) {
+        perror("couldn't create priority queue");
+        exit(EXIT_FAILURE);
+    }
+
+    int values[] = {40, 10, 30, 20};
+    for ( size_t i = 0; i < 4; ++i ) {
+        TEST_ASSERT_TRUE(pqueue_push(queue, (void *) &values[i]));
+    }
+
+    int * p;
+    TEST_ASSERT_TRUE(pqueue_pop(queue, &p));
+    TEST_ASSERT_TRUE(p == &values[1]);
+    TEST_ASSERT_TRUE(pqueue_pop(queue, &p));
+    TEST_ASSERT_TRUE(p == &values[3]);
+
+    pqueue_destroy(queue);
+}
+
+/*  Test indexed queue with decrease key, as in Dijkstra's algorithm  */
+
+TEST_CASE(test_pqueue_indexed)
+{
+    PriorityQueue queue = pqueue_create_indexed(6, 0, DATATYPE_INT, 0);
+    if ( !queue ) {
+        perror("couldn't create priority queue");
+        exit(EXIT_FAILURE);
+    }
+
+    const int keys[] = {50, 40, 30, 20, 10, 60};
+    for ( size_t id = 0; id < 5; ++id ) {
+        TEST_ASSERT_TRUE(pqueue_push_with_id(queue, id, keys[id]));
+    }
+    TEST_ASSERT_TRUE(pqueue_contains_id(queue, 4));
+    TEST_ASSERT_FALSE(pqueue_contains_id(queue, 5));
+
+    TEST_ASSERT_TRUE(pqueue_decrease_key(queue, 0, 5));
+    TEST_ASSERT_TRUE(pqueue_decrease_key(queue, 2, 15));
+    TEST_ASSERT_TRUE(pqueue_decrease_key(queue, 3, 20));
+    TEST_ASSERT_TRUE(pqueue_push_with_id(queue, 5, keys[5]));
+
+    const size_t expected_ids[] = {0, 4, 2, 3, 1, 5};
+    const int expected_keys[] = {5, 10, 15, 20, 40, 60};
+    for ( size_t i = 0; i < 6; ++i ) {
+        size_t id;
+        int key;
+        TEST_ASSERT_TRUE(pqueue_pop_with_id(queue, &id, &key));
+        TEST_ASSERT_EQUAL(id, expected_ids[i]);
+        TEST_ASSERT_EQUAL(key, expected_keys[i]);
+        TEST_ASSERT_FALSE(pqueue_contains_id(queue, id));
+    }
+    TEST_ASSERT_TRUE(pqueue_is_empty(queue));
+
+    /*  Identifiers may be pushed again once popped  */
+
+    TEST_ASSERT_TRUE(pqueue_push_with_id(queue, 3, 7));
+    TEST_ASSERT_TRUE(pqueue_contains_id(queue, 3));
+
+    pqueue_destroy(queue);
+}
+
+/*  Test many random decreases against a simple array of keys  */
+
+TEST_CASE(test_pqueue_indexed_many)
+{
+    const size_t n = 2000;
+    PriorityQueue queue = pqueue_create_indexed(n, 3, DATATYPE_SIZE_T, 0);
+    size_t * keys = malloc(n * sizeof *keys);
+    if ( !queue || !keys ) {
+        perror("couldn't create priority queue");
+        exit(EXIT_FAILURE);
+    }
+
+    for ( size_t id = 0; id < n; ++id ) {
+        keys[id] = n * 10 + (id * 7919) % n;
+        TEST_ASSERT_TRUE(pqueue_push_with_id(queue, id, keys[id]));
+    }
+
+    size_t seed = 12345;
+    for ( size_t i = 0; i < n * 4; ++i ) {
+        seed = seed * 1103515245 + 12345;
+        const size_t id = (seed >> 8) % n;
+        const size_t drop = (seed >> 4) % 16;
+        keys[id] = keys[id] > drop ? keys[id] - drop : 0;
+        TEST_ASSERT_TRUE(pqueue_decrease_key(queue, id, keys[id]));
+    }
+
+    size_t last = 0;
+    for ( size_t i = 0; i < n; ++i ) {
+        size_t id, key;
+        TEST_ASSERT_TRUE(pqueue_pop_with_id(queue, &id, &key));
+        TEST_ASSERT_EQUAL(key, keys[id]);
+        TEST_ASSERT_TRUE(key >= last);
+        last = key;
+    }
+    TEST_ASSERT_TRUE(pqueue_is_empty(queue));
+
+    free(keys);
+    pqueue_destroy(queue);
+}
+
+void test_pqueue(void)
+{
+    RUN_CASE(test_pqueue_basic);
+    RUN_CASE(test_pqueue_many);
+    RUN_CASE(test_pqueue_heapify);
+    RUN_CASE(test_pqueue_strings);
+    RUN_CASE(test_pqueue_pointer);
+    RUN_CASE(test_pqueue_indexed);
+    RUN_CASE(test_pqueue_indexed_many);
+}
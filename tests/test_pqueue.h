@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_PQUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_PQUEUE_H
+
+void test_pqueue(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_PQUEUE_H  */
@@ -128,8 +128,84 @@ TEST_CASE(test_queue_free_strings)
     queue_destroy(queue);
 }
 
+/*  Test pushing and popping arrays of values across the wrap  */
+
+TEST_CASE(test_queue_batch)
+{
+    Queue queue = queue_create(4, DATATYPE_INT, 0);
+    if ( !queue ) {
+        perror("couldn't create queue");
+        exit(EXIT_FAILURE);
+    }
+
+    const int in[] = {1, 2, 3, 4, 5, 6};
+    int out[8];
+
+    /*  Move the front along so the next batch wraps  */
+
+    TEST_ASSERT_TRUE(queue_push_n(queue, in, 3));
+    TEST_ASSERT_EQUAL(queue_pop_n(queue, out, 2), 2);
+    TEST_ASSERT_EQUAL(out[0], 1);
+    TEST_ASSERT_EQUAL(out[1], 2);
+
+    TEST_ASSERT_TRUE(queue_push_n(queue, in + 3, 3));
+    TEST_ASSERT_TRUE(queue_is_full(queue));
+    TEST_ASSERT_FALSE(queue_push_n(queue, in, 1));
+    TEST_ASSERT_TRUE(queue_push_n(queue, in, 0));
+
+    TEST_ASSERT_EQUAL(queue_pop_n(queue, out, 8), 4);
+    for ( int i = 0; i < 4; ++i ) {
+        TEST_ASSERT_EQUAL(out[i], i + 3);
+    }
+    TEST_ASSERT_TRUE(queue_is_empty(queue));
+    TEST_ASSERT_EQUAL(queue_pop_n(queue, out, 8), 0);
+
+    queue_destroy(queue);
+}
+
+/*  Test growing a wrapped resizable queue with batches  */
+
+TEST_CASE(test_queue_batch_resize)
+{
+    Queue queue = queue_create(5, DATATYPE_SIZE_T, GDS_RESIZABLE);
+    if ( !queue ) {
+        perror("couldn't create queue");
+        exit(EXIT_FAILURE);
+    }
+
+    /*  Interleave single and batch operations, checking that
+     *  values always come out in the order they were pushed.  */
+
+    size_t pushed = 0, popped = 0;
+    for ( size_t round = 1; round < 40; ++round ) {
+        size_t batch[16];
+        const size_t n = (round * 7) % 16;
+        for ( size_t i = 0; i < n; ++i ) {
+            batch[i] = pushed++;
+        }
+        TEST_ASSERT_TRUE(queue_push_n(queue, batch, n));
+        TEST_ASSERT_TRUE(queue_push(queue, pushed++));
+
+        const size_t got = queue_pop_n(queue, batch, round % 13);
+        for ( size_t i = 0; i < got; ++i ) {
+            TEST_ASSERT_EQUAL(batch[i], popped++);
+        }
+        TEST_ASSERT_EQUAL(queue_size(queue), pushed - popped);
+    }
+
+    size_t value;
+    while ( queue_pop_n(queue, &value, 1) ) {
+        TEST_ASSERT_EQUAL(value, popped++);
+    }
+    TEST_ASSERT_EQUAL(popped, pushed);
+
+    queue_destroy(queue);
+}
+
 void test_queue(void)
 {
     RUN_CASE(test_queue_basic_ops);
     RUN_CASE(test_queue_free_strings);
+    RUN_CASE(test_queue_batch);
+    RUN_CASE(test_queue_batch_resize);
 }
@@ -0,0 +1,230 @@
+/*  Unit tests for read-mostly generic dictionary data structure  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/rcudict.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_rcudict.h"
+
+TEST_SUITE(test_rcudict);
+
+/*  Number of reader threads for threaded tests  */
+#define NUM_READERS 4
+
+/*  Number of keys in threaded tests  */
+#define NUM_KEYS 64
+
+/*  Number of updates made by the writer in threaded tests  */
+#define NUM_UPDATES 200
+
+/*  Test basic single-threaded operations  */
+
+TEST_CASE(test_rcudict_basic)
+{
+    RCUDict dict = rcudict_create(DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !dict ) {
+        perror("couldn't create read-mostly dict");
+        exit(EXIT_FAILURE);
+    }
+
+    char * pc;
+
+    TEST_ASSERT_FALSE(rcudict_has_key(dict, "john"));
+
+    TEST_ASSERT_TRUE(rcudict_insert(dict, "john", gds_strdup("Bolton")));
+    TEST_ASSERT_TRUE(rcudict_insert(dict, "mary", gds_strdup("Portsmouth")));
+    TEST_ASSERT_TRUE(rcudict_insert(dict, "skeletor", gds_strdup("Hull")));
+
+    TEST_ASSERT_TRUE(rcudict_has_key(dict, "john"));
+    TEST_ASSERT_TRUE(rcudict_value_for_key(dict, "mary", &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "Portsmouth");
+    TEST_ASSERT_FALSE(rcudict_value_for_key(dict, "fabio", &pc));
+
+    /*  Overwrite a value to check the old one frees  */
+
+    TEST_ASSERT_TRUE(rcudict_insert(dict, "skeletor",
+                                    gds_strdup("Grayskull")));
+    TEST_ASSERT_TRUE(rcudict_value_for_key(dict, "skeletor", &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "Grayskull");
+
+    TEST_ASSERT_TRUE(rcudict_delete(dict, "john"));
+    TEST_ASSERT_FALSE(rcudict_delete(dict, "john"));
+    TEST_ASSERT_FALSE(rcudict_has_key(dict, "john"));
+    TEST_ASSERT_TRUE(rcudict_has_key(dict, "mary"));
+    TEST_ASSERT_TRUE(rcudict_has_key(dict, "skeletor"));
+
+    rcudict_destroy(dict);
+}
+
+/*  Test a batched update, including growth and deletion  */
+
+TEST_CASE(test_rcudict_update)
+{
+    RCUDict dict = rcudict_create(DATATYPE_INT, 0);
+    if ( !dict ) {
+        perror("couldn't create read-mostly dict");
+        exit(EXIT_FAILURE);
+    }
+
+    char key[32];
+    int n;
+
+    rcudict_update_begin(dict);
+    for ( int i = 0; i < 1000; ++i ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(rcudict_update_insert(dict, key, i));
+    }
+
+    /*  Nothing is visible until the update is committed  */
+
+    TEST_ASSERT_FALSE(rcudict_has_key(dict, "key0"));
+
+    for ( int i = 0; i < 1000; i += 3 ) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT_TRUE(rcudict_update_delete(dict, key));
+    }
+    TEST_ASSERT_FALSE(rcudict_update_delete(dict, "key0"));
+    rcudict_update_commit(dict);
+
+    for ( int i = 0; i < 1000; ++i ) {
+        sprintf(key, "key%d", i);
+        if ( i % 3 ) {
+            TEST_ASSERT_TRUE(rcudict_value_for_key(dict, key, &n));
+            TEST_ASSERT_EQUAL(n, i);
+        }
+        else {
+            TEST_ASSERT_FALSE(rcudict_has_key(dict, key));
+        }
+    }
+
+    /*  Test nested critical sections see a consistent snapshot  */
+
+    TEST_ASSERT_TRUE(rcudict_read_lock(dict));
+    TEST_ASSERT_TRUE(rcudict_read_lock(dict));
+    TEST_ASSERT_TRUE(rcudict_value_for_key(dict, "key1", &n));
+    TEST_ASSERT_EQUAL(n, 1);
+    rcudict_read_unlock(dict);
+    rcudict_read_unlock(dict);
+
+    rcudict_destroy(dict);
+}
+
+/*  Shared state for threaded test  */
+
+struct rcudict_thread_info {
+    RCUDict dict;
+    int stop;
+    long lookups;
+    pthread_mutex_t mutex;
+};
+
+/*  Reader thread which checks every value it sees is intact  */
+
+static void * rcudict_reader_thread(void * arg)
+{
+    struct rcudict_thread_info * info = arg;
+    char key[32];
+    long lookups = 0;
+    bool ok = true;
+
+    /*  Make at least one pass, even if the writer has already
+     *  finished, so that every reader performs some lookups.    */
+
+    do {
+        for ( int i = 0; i < NUM_KEYS; ++i ) {
+            char * value;
+            sprintf(key, "key%d", i);
+
+            rcudict_read_lock(info->dict);
+            if ( rcudict_value_for_key(info->dict, key, &value) ) {
+
+                /*  Values are "key<n>:<version>", and must still be
+                 *  readable even if the writer has replaced them.    */
+
+                ok = !strncmp(value, key, strlen(key)) &&
+                     value[strlen(key)] == ':' && ok;
+            }
+            rcudict_read_unlock(info->dict);
+
+            lookups += 1;
+        }
+    } while ( !__atomic_load_n(&info->stop, __ATOMIC_ACQUIRE) );
+
+    pthread_mutex_lock(&info->mutex);
+    info->lookups += lookups;
+    pthread_mutex_unlock(&info->mutex);
+
+    return ok ? arg : NULL;
+}
+
+/*  Test concurrent lock-free readers with a writer  */
+
+TEST_CASE(test_rcudict_threads)
+{
+    struct rcudict_thread_info info;
+    info.dict = rcudict_create(DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !info.dict ) {
+        perror("couldn't create read-mostly dict");
+        exit(EXIT_FAILURE);
+    }
+    info.stop = 0;
+    info.lookups = 0;
+    pthread_mutex_init(&info.mutex, NULL);
+
+    pthread_t tid[NUM_READERS];
+    for ( size_t i = 0; i < NUM_READERS; ++i ) {
+        if ( pthread_create(&tid[i], NULL, rcudict_reader_thread,
+                            &info) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /*  Replace, insert and delete values while the readers run  */
+
+    char key[32], value[64];
+    for ( int v = 0; v < NUM_UPDATES; ++v ) {
+        rcudict_update_begin(info.dict);
+        for ( int i = v % 2; i < NUM_KEYS; i += 2 ) {
+            sprintf(key, "key%d", i);
+            sprintf(value, "%s:%d", key, v);
+            rcudict_update_insert(info.dict, key, gds_strdup(value));
+        }
+        sprintf(key, "key%d", v % NUM_KEYS);
+        rcudict_update_delete(info.dict, key);
+        rcudict_update_commit(info.dict);
+    }
+
+    __atomic_store_n(&info.stop, 1, __ATOMIC_RELEASE);
+
+    for ( size_t i = 0; i < NUM_READERS; ++i ) {
+        void * result;
+        pthread_join(tid[i], &result);
+        TEST_ASSERT_TRUE(result != NULL);
+    }
+
+    TEST_ASSERT_TRUE(info.lookups > 0);
+
+    /*  Check that records released by exited threads are reused  */
+
+    for ( size_t i = 0; i < NUM_READERS; ++i ) {
+        info.stop = 1;
+        pthread_create(&tid[i], NULL, rcudict_reader_thread, &info);
+        pthread_join(tid[i], NULL);
+    }
+
+    pthread_mutex_destroy(&info.mutex);
+    rcudict_destroy(info.dict);
+}
+
+void test_rcudict(void)
+{
+    RUN_CASE(test_rcudict_basic);
+    RUN_CASE(test_rcudict_update);
+    RUN_CASE(test_rcudict_threads);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_RCU_DICTIONARY_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_RCU_DICTIONARY_H
+
+void test_rcudict(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_RCU_DICTIONARY_H  */
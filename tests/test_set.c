@@ -0,0 +1,223 @@
+/*  Unit tests for generic set data structure  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pggds/set.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_set.h"
+
+TEST_SUITE(test_set);
+
+/*  Comparison and hash functions for pointers to int  */
+
+static int compare_int_ptr(const void * p1, const void * p2)
+{
+    const int a = **((int * const *) p1);
+    const int b = **((int * const *) p2);
+    return a < b ? -1 : a > b;
+}
+
+static size_t hash_int_ptr(const void * p)
+{
+    return (size_t) **((int * const *) p) * 31;
+}
+
+/*  Test basic insertion, membership and removal  */
+
+TEST_CASE(test_set_basic)
+{
+    Set set = set_create(DATATYPE_INT, 0);
+    if ( !set ) {
+        perror("couldn't create set");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(set_is_empty(set));
+    TEST_ASSERT_TRUE(set_insert(set, 5));
+    TEST_ASSERT_TRUE(set_insert(set, -5));
+    TEST_ASSERT_TRUE(set_insert(set, 5));
+    TEST_ASSERT_EQUAL(set_size(set), 2);
+    TEST_ASSERT_FALSE(set_is_empty(set));
+
+    TEST_ASSERT_TRUE(set_contains(set, 5));
+    TEST_ASSERT_TRUE(set_contains(set, -5));
+    TEST_ASSERT_FALSE(set_contains(set, 0));
+
+    TEST_ASSERT_TRUE(set_remove(set, 5));
+    TEST_ASSERT_FALSE(set_remove(set, 5));
+    TEST_ASSERT_FALSE(set_contains(set, 5));
+    TEST_ASSERT_EQUAL(set_size(set), 1);
+
+    set_destroy(set);
+}
+
+/*  Test growth and removal with many elements  */
+
+TEST_CASE(test_set_many)
+{
+    Set set = set_create(DATATYPE_SIZE_T, 0);
+    if ( !set ) {
+        perror("couldn't create set");
+        exit(EXIT_FAILURE);
+    }
+
+    const size_t n = 10000;
+    for ( size_t i = 0; i < n; ++i ) {
+        TEST_ASSERT_TRUE(set_insert(set, i * 7));
+    }
+    TEST_ASSERT_EQUAL(set_size(set), n);
+
+    for ( size_t i = 0; i < n; i += 2 ) {
+        TEST_ASSERT_TRUE(set_remove(set, i * 7));
+    }
+    TEST_ASSERT_EQUAL(set_size(set), n / 2);
+
+    for ( size_t i = 0; i < n; ++i ) {
+        TEST_ASSERT_EQUAL(set_contains(set, i * 7), (i % 2) == 1);
+        TEST_ASSERT_FALSE(set_contains(set, i * 7 + 1));
+    }
+
+    /*  Iteration visits each remaining element exactly once  */
+
+    size_t count = 0, sum = 0, value;
+    for ( SetItr itr = set_itr_first(set); itr;
+          itr = set_itr_next(set, itr) ) {
+        set_itr_value(set, itr, &value);
+        count += 1;
+        sum += value;
+    }
+    TEST_ASSERT_EQUAL(count, n / 2);
+    TEST_ASSERT_EQUAL(sum, 7 * (n / 2) * (n / 2));
+
+    set_destroy(set);
+}
+
+/*  Test string elements with GDS_FREE_ON_DESTROY  */
+
+TEST_CASE(test_set_strings)
+{
+    Set set = set_create(DATATYPE_STRING, GDS_FREE_ON_DESTROY);
+    if ( !set ) {
+        perror("couldn't create set");
+        exit(EXIT_FAILURE);
+    }
+
+    char buffer[32];
+    for ( int i = 0; i < 100; ++i ) {
+        sprintf(buffer, "str%d", i);
+        TEST_ASSERT_TRUE(set_insert(set, gds_strdup(buffer)));
+    }
+
+    /*  Duplicates are freed, not leaked  */
+
+    TEST_ASSERT_TRUE(set_insert(set, gds_strdup("str50")));
+    TEST_ASSERT_EQUAL(set_size(set), 100);
+
+    TEST_ASSERT_TRUE(set_contains(set, "str99"));
+    TEST_ASSERT_FALSE(set_contains(set, "str100"));
+    TEST_ASSERT_TRUE(set_remove(set, "str0"));
+    TEST_ASSERT_FALSE(set_contains(set, "str0"));
+
+    set_destroy(set);
+}
+
+/*  Test pointer elements with custom comparison and hash functions  */
+
+TEST_CASE(test_set_pointer)
+{
+    Set set = set_create(DATATYPE_POINTER, GDS_FREE_ON_DESTROY,
+                         compare_int_ptr, hash_int_ptr);
+    if ( !set ) {
+        perror("couldn't create set");
+        exit(EXIT_FAILURE);
+    }
+
+    for ( int i = 0; i < 50; ++i ) {
+        int * p = malloc(sizeof *p);
+        if ( !p ) {
+            perror("couldn't allocate memory");
+            exit(EXIT_FAILURE);
+        }
+        *p = i % 25;
+        TEST_ASSERT_TRUE(set_insert(set, p));
+    }
+    TEST_ASSERT_EQUAL(set_size(set), 25);
+
+    int n = 24;
+    TEST_ASSERT_TRUE(set_contains(set, &n));
+    n = 25;
+    TEST_ASSERT_FALSE(set_contains(set, &n));
+
+    set_destroy(set);
+}
+
+/*  Test union, intersection and difference  */
+
+TEST_CASE(test_set_operations)
+{
+    Set a = set_create(DATATYPE_INT, 0);
+    Set b = set_create(DATATYPE_INT, 0);
+    if ( !a || !b ) {
+        perror("couldn't create set");
+        exit(EXIT_FAILURE);
+    }
+
+    /*  a holds multiples of 2, b holds multiples of 3  */
+
+    for ( int i = 0; i < 300; ++i ) {
+        if ( i % 2 == 0 ) {
+            set_insert(a, i);
+        }
+        if ( i % 3 == 0 ) {
+            set_insert(b, i);
+        }
+    }
+
+    Set u = set_union(a, b);
+    Set n = set_intersection(a, b);
+    Set d = set_difference(a, b);
+    if ( !u || !n || !d ) {
+        perror("couldn't create set");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_EQUAL(set_size(u), 200);
+    TEST_ASSERT_EQUAL(set_size(n), 50);
+    TEST_ASSERT_EQUAL(set_size(d), 100);
+
+    for ( int i = 0; i < 300; ++i ) {
+        const bool in_a = i % 2 == 0, in_b = i % 3 == 0;
+        TEST_ASSERT_EQUAL(set_contains(u, i), in_a || in_b);
+        TEST_ASSERT_EQUAL(set_contains(n, i), in_a && in_b);
+        TEST_ASSERT_EQUAL(set_contains(d, i), in_a && !in_b);
+    }
+
+    /*  Operations on empty sets  */
+
+    Set e = set_create(DATATYPE_INT, 0);
+    Set en = set_intersection(a, e);
+    Set ed = set_difference(e, a);
+    TEST_ASSERT_TRUE(set_is_empty(en));
+    TEST_ASSERT_TRUE(set_is_empty(ed));
+    TEST_ASSERT_TRUE(set_itr_first(en) == NULL);
+
+    set_destroy(ed);
+    set_destroy(en);
+    set_destroy(e);
+    set_destroy(d);
+    set_destroy(n);
+    set_destroy(u);
+    set_destroy(b);
+    set_destroy(a);
+}
+
+void test_set(void)
+{
+    RUN_CASE(test_set_basic);
+    RUN_CASE(test_set_many);
+    RUN_CASE(test_set_strings);
+    RUN_CASE(test_set_pointer);
+    RUN_CASE(test_set_operations);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_SET_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_SET_H
+
+void test_set(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_SET_H  */
@@ -0,0 +1,207 @@
+/*  Unit tests for shared-memory queue  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <pggds/shmqueue.h>
+#include <pggds/unittest.h>
+#include "test_shmqueue.h"
+
+TEST_SUITE(test_shmqueue);
+
+/*  Number of producer threads for threaded test  */
+#define NUM_THREADS 4
+
+/*  Number of values pushed by each producer  */
+#define VALUES_PER_THREAD 20000
+
+/*  Writes a shared memory object name unique to this process  */
+
+static void shmqueue_test_name(char * buffer, const size_t size)
+{
+    snprintf(buffer, size, "/pggds_test_shmqueue_%ld", (long) getpid());
+}
+
+/*  Test basic operations through two handles in one process  */
+
+TEST_CASE(test_shmqueue_basic)
+{
+    char name[64];
+    shmqueue_test_name(name, sizeof name);
+
+    ShmQueue queue = shmqueue_create(name, 3, DATATYPE_DOUBLE, false, 0);
+    if ( !queue ) {
+        perror("couldn't create shared-memory queue");
+        exit(EXIT_FAILURE);
+    }
+
+    ShmQueue other = shmqueue_open(name, 0);
+    TEST_ASSERT_TRUE(other != NULL);
+    if ( !other ) {
+        shmqueue_close(queue);
+        shmqueue_unlink(name);
+        return;
+    }
+
+    double d;
+    TEST_ASSERT_EQUAL(shmqueue_capacity(other), 4);
+    TEST_ASSERT_FALSE(shmqueue_try_pop(other, &d));
+
+    /*  Go round the buffer several times, pushing through one
+     *  mapping and popping through the other.                   */
+
+    for ( int lap = 0; lap < 3; ++lap ) {
+        shmqueue_push(queue, 1.5);
+        TEST_ASSERT_TRUE(shmqueue_try_push(queue, 2.5));
+        TEST_ASSERT_TRUE(shmqueue_try_push(queue, 3.5));
+        TEST_ASSERT_TRUE(shmqueue_try_push(queue, 4.5));
+        TEST_ASSERT_FALSE(shmqueue_try_push(queue, 5.5));
+        TEST_ASSERT_EQUAL(shmqueue_size(other), 4);
+
+        shmqueue_pop(other, &d);
+        TEST_ASSERT_EQUAL(d, 1.5);
+        for ( int i = 2; i <= 4; ++i ) {
+            TEST_ASSERT_TRUE(shmqueue_try_pop(other, &d));
+            TEST_ASSERT_EQUAL(d, i + 0.5);
+        }
+        TEST_ASSERT_FALSE(shmqueue_try_pop(other, &d));
+        TEST_ASSERT_EQUAL(shmqueue_size(queue), 0);
+    }
+
+    /*  Values left in the queue outlive a handle  */
+
+    shmqueue_push(queue, 6.5);
+    shmqueue_close(queue);
+    TEST_ASSERT_TRUE(shmqueue_try_pop(other, &d));
+    TEST_ASSERT_EQUAL(d, 6.5);
+    shmqueue_close(other);
+
+    TEST_ASSERT_TRUE(shmqueue_unlink(name));
+}
+
+/*  Test one process pushing to another through a small queue  */
+
+TEST_CASE(test_shmqueue_processes)
+{
+    char name[64];
+    shmqueue_test_name(name, sizeof name);
+
+    ShmQueue queue = shmqueue_create(name, 8, DATATYPE_LONG, false, 0);
+    if ( !queue ) {
+        perror("couldn't create shared-memory queue");
+        exit(EXIT_FAILURE);
+    }
+
+    const pid_t pid = fork();
+    if ( pid == -1 ) {
+        perror("couldn't fork");
+        exit(EXIT_FAILURE);
+    }
+    else if ( pid == 0 ) {
+
+        /*  The child opens the queue afresh, as an unrelated process
+         *  would, and exits without running any parent cleanup.      */
+
+        ShmQueue child = shmqueue_open(name, 0);
+        if ( !child ) {
+            _exit(EXIT_FAILURE);
+        }
+        for ( long i = 1; i <= VALUES_PER_THREAD; ++i ) {
+            shmqueue_push(child, i);
+        }
+        shmqueue_close(child);
+        _exit(EXIT_SUCCESS);
+    }
+
+    bool in_order = true;
+    long value;
+    for ( long i = 1; i <= VALUES_PER_THREAD; ++i ) {
+        shmqueue_pop(queue, &value);
+        in_order = in_order && value == i;
+    }
+    TEST_ASSERT_TRUE(in_order);
+    TEST_ASSERT_FALSE(shmqueue_try_pop(queue, &value));
+
+    int status;
+    TEST_ASSERT_EQUAL(waitpid(pid, &status, 0), pid);
+    TEST_ASSERT_TRUE(WIFEXITED(status) &&
+                     WEXITSTATUS(status) == EXIT_SUCCESS);
+
+    shmqueue_close(queue);
+    shmqueue_unlink(name);
+}
+
+/*  Producer thread function, pushing 1 to VALUES_PER_THREAD  */
+
+static void * shmqueue_producer(void * arg)
+{
+    ShmQueue queue = arg;
+
+    for ( long i = 1; i <= VALUES_PER_THREAD; ++i ) {
+        shmqueue_push(queue, i);
+    }
+
+    return NULL;
+}
+
+/*  Test several producers sharing a handle to a multi-producer queue  */
+
+TEST_CASE(test_shmqueue_threads)
+{
+    char name[64];
+    shmqueue_test_name(name, sizeof name);
+
+    ShmQueue queue = shmqueue_create(name, 16, DATATYPE_LONG, true, 0);
+    if ( !queue ) {
+        perror("couldn't create shared-memory queue");
+        exit(EXIT_FAILURE);
+    }
+
+    ShmQueue producer_queue = shmqueue_open(name, 0);
+    TEST_ASSERT_TRUE(producer_queue != NULL);
+    if ( !producer_queue ) {
+        shmqueue_close(queue);
+        shmqueue_unlink(name);
+        return;
+    }
+
+    pthread_t producers[NUM_THREADS];
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        if ( pthread_create(&producers[i], NULL,
+                            shmqueue_producer, producer_queue) != 0 ) {
+            perror("couldn't create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    long sum = 0, value;
+    for ( long i = 0; i < (long) NUM_THREADS * VALUES_PER_THREAD; ++i ) {
+        shmqueue_pop(queue, &value);
+        sum += value;
+    }
+
+    for ( size_t i = 0; i < NUM_THREADS; ++i ) {
+        pthread_join(producers[i], NULL);
+    }
+
+    TEST_ASSERT_EQUAL(sum, (long) NUM_THREADS * VALUES_PER_THREAD *
+                           (VALUES_PER_THREAD + 1) / 2);
+    TEST_ASSERT_EQUAL(shmqueue_size(queue), 0);
+
+    shmqueue_close(producer_queue);
+    shmqueue_close(queue);
+    shmqueue_unlink(name);
+}
+
+void test_shmqueue(void)
+{
+    RUN_CASE(test_shmqueue_basic);
+    RUN_CASE(test_shmqueue_processes);
+    RUN_CASE(test_shmqueue_threads);
+}
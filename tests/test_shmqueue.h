@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_SHMQUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_SHMQUEUE_H
+
+void test_shmqueue(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_SHMQUEUE_H  */
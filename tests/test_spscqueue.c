@@ -0,0 +1,173 @@
+/*  Unit tests for single-producer single-consumer queue  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pggds/spscqueue.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_spscqueue.h"
+
+TEST_SUITE(test_spscqueue);
+
+/*  Number of values passed between threads in threaded test  */
+#define NUM_VALUES 200000
+
+/*  Test basic single-threaded operations  */
+
+TEST_CASE(test_spscqueue_basic)
+{
+    SPSCQueue queue = spscqueue_create(3, DATATYPE_INT, 0);
+    if ( !queue ) {
+        perror("couldn't create SPSC queue");
+        exit(EXIT_FAILURE);
+    }
+
+    int n;
+    TEST_ASSERT_EQUAL(spscqueue_capacity(queue), 4);
+    TEST_ASSERT_FALSE(spscqueue_pop(queue, &n));
+
+    for ( int i = 1; i <= 4; ++i ) {
+        TEST_ASSERT_TRUE(spscqueue_push(queue, i));
+    }
+    TEST_ASSERT_FALSE(spscqueue_push(queue, 5));
+    TEST_ASSERT_EQUAL(spscqueue_size(queue), 4);
+
+    for ( int i = 1; i <= 4; ++i ) {
+        TEST_ASSERT_TRUE(spscqueue_pop(queue, &n));
+        TEST_ASSERT_EQUAL(n, i);
+    }
+    TEST_ASSERT_FALSE(spscqueue_pop(queue, &n));
+    TEST_ASSERT_EQUAL(spscqueue_size(queue), 0);
+
+    spscqueue_destroy(queue);
+}
+
+/*  Test batch operations wrapping around the end of the buffer  */
+
+TEST_CASE(test_spscqueue_batch)
+{
+    SPSCQueue queue = spscqueue_create(8, DATATYPE_DOUBLE, 0);
+    if ( !queue ) {
+        perror("couldn't create SPSC queue");
+        exit(EXIT_FAILURE);
+    }
+
+    double in[10], out[10];
+    for ( int i = 0; i < 10; ++i ) {
+        in[i] = i + 0.5;
+    }
+
+    TEST_ASSERT_EQUAL(spscqueue_push_many(queue, in, 5), 5);
+    TEST_ASSERT_EQUAL(spscqueue_pop_many(queue, out, 3), 3);
+    TEST_ASSERT_EQUAL(out[2], 2.5);
+
+    /*  Only six slots are free, and the copy wraps  */
+
+    TEST_ASSERT_EQUAL(spscqueue_push_many(queue, in, 10), 6);
+    TEST_ASSERT_EQUAL(spscqueue_size(queue), 8);
+    TEST_ASSERT_EQUAL(spscqueue_push_many(queue, in, 1), 0);
+
+    TEST_ASSERT_EQUAL(spscqueue_pop_many(queue, out, 10), 8);
+    TEST_ASSERT_EQUAL(out[0], 3.5);
+    TEST_ASSERT_EQUAL(out[1], 4.5);
+    for ( int i = 0; i < 6; ++i ) {
+        TEST_ASSERT_EQUAL(out[i + 2], in[i]);
+    }
+    TEST_ASSERT_EQUAL(spscqueue_pop_many(queue, out, 10), 0);
+
+    spscqueue_destroy(queue);
+}
+
+/*  Test pointer values with GDS_FREE_ON_DESTROY  */
+
+TEST_CASE(test_spscqueue_free)
+{
+    SPSCQueue queue = spscqueue_create(4, DATATYPE_STRING,
+                                       GDS_FREE_ON_DESTROY);
+    if ( !queue ) {
+        perror("couldn't create SPSC queue");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(spscqueue_push(queue, gds_strdup("one")));
+    TEST_ASSERT_TRUE(spscqueue_push(queue, gds_strdup("two")));
+    TEST_ASSERT_TRUE(spscqueue_push(queue, gds_strdup("three")));
+
+    char * pc;
+    TEST_ASSERT_TRUE(spscqueue_pop(queue, &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "one");
+    free(pc);
+
+    spscqueue_destroy(queue);
+}
+
+/*  Producer thread function, pushing values singly and in batches  */
+
+static void * spscqueue_producer(void * arg)
+{
+    SPSCQueue queue = arg;
+    long batch[7];
+    long next = 0;
+
+    while ( next < NUM_VALUES ) {
+        if ( next % 2 ) {
+            if ( spscqueue_push(queue, next) ) {
+                next += 1;
+            }
+        }
+        else {
+            size_t n = 0;
+            while ( n < 7 && next + (long) n < NUM_VALUES ) {
+                batch[n] = next + (long) n;
+                n += 1;
+            }
+            next += (long) spscqueue_push_many(queue, batch, n);
+        }
+    }
+
+    return NULL;
+}
+
+/*  Test values pass between two threads in order  */
+
+TEST_CASE(test_spscqueue_threads)
+{
+    SPSCQueue queue = spscqueue_create(64, DATATYPE_LONG, 0);
+    if ( !queue ) {
+        perror("couldn't create SPSC queue");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_t tid;
+    if ( pthread_create(&tid, NULL, spscqueue_producer, queue) != 0 ) {
+        perror("couldn't create thread");
+        exit(EXIT_FAILURE);
+    }
+
+    long expected = 0, values[5];
+    bool in_order = true;
+    while ( expected < NUM_VALUES ) {
+        const size_t n = spscqueue_pop_many(queue, values, 5);
+        for ( size_t i = 0; i < n; ++i ) {
+            in_order = values[i] == expected++ && in_order;
+        }
+    }
+
+    pthread_join(tid, NULL);
+    TEST_ASSERT_TRUE(in_order);
+    TEST_ASSERT_EQUAL(spscqueue_size(queue), 0);
+
+    spscqueue_destroy(queue);
+}
+
+void test_spscqueue(void)
+{
+    RUN_CASE(test_spscqueue_basic);
+    RUN_CASE(test_spscqueue_batch);
+    RUN_CASE(test_spscqueue_free);
+    RUN_CASE(test_spscqueue_threads);
+}
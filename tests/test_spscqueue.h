@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_SPSC_QUEUE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_SPSC_QUEUE_H
+
+void test_spscqueue(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_SPSC_QUEUE_H  */
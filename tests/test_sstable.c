@@ -0,0 +1,301 @@
+/*  Unit tests for immutable sorted string table data structure  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pggds/sstable.h>
+#include <pggds/vector.h>
+#include <pggds_internal/gdt.h>
+#include <pggds/kvpair.h>
+#include <pggds/unittest.h>
+#include <pggds/string_util.h>
+#include "test_sstable.h"
+
+TEST_SUITE(test_sstable);
+
+/*  Number of keys for tests with many keys  */
+#define NUM_KEYS 3000
+
+/*  Length of keys for tests with long keys  */
+#define LONG_KEY_LEN 400
+
+/*  Appends a new key-value pair to a vector of pairs  */
+
+static void append_pair(Vector pairs, const char * key,
+                        const enum gds_datatype type, ...)
+{
+    va_list ap;
+    va_start(ap, type);
+    KVPair pair = gds_kvpair_create(key, type, ap);
+    va_end(ap);
+
+    if ( !pair || !vector_append(pairs, (void *) pair) ) {
+        perror("couldn't append pair");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*  Destroys a vector of pairs, and the pairs  */
+
+static void destroy_pairs(Vector pairs)
+{
+    for ( size_t i = 0; i < vector_length(pairs); ++i ) {
+        KVPair pair;
+        vector_element_at_index(pairs, i, &pair);
+        gds_kvpair_destroy(pair, false);
+    }
+    vector_destroy(pairs);
+}
+
+/*  Formats the key for a number  */
+
+static void make_key(char * buffer, const int n)
+{
+    sprintf(buffer, "%s/%04d", (n % 2) ? "config/network" : "config/display",
+            n);
+}
+
+/*  Test lookups of present and absent keys  */
+
+TEST_CASE(test_sstable_lookup)
+{
+    Vector pairs = vector_create(0, DATATYPE_POINTER, 0,
+                                 gds_kvpair_compare);
+    if ( !pairs ) {
+        perror("couldn't create vector");
+        exit(EXIT_FAILURE);
+    }
+
+    char key[64];
+    size_t raw_size = 0;
+    for ( int i = 0; i < NUM_KEYS; ++i ) {
+        make_key(key, i);
+        append_pair(pairs, key, DATATYPE_INT, i);
+        raw_size += strlen(key) + 1 + sizeof(int);
+    }
+    vector_sort(pairs);
+
+    SSTable table = sstable_create(pairs, DATATYPE_INT, 0);
+    destroy_pairs(pairs);
+    if ( !table ) {
+        perror("couldn't create sorted string table");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_EQUAL(sstable_size(table), NUM_KEYS);
+
+    /*  The shared prefixes should compress well  */
+
+    TEST_ASSERT_TRUE(sstable_memory_usage(table) < raw_size / 2);
+
+    for ( int i = 0; i < NUM_KEYS; ++i ) {
+        int n = -1;
+        make_key(key, i);
+        TEST_ASSERT_TRUE(sstable_value_for_key(table, key, &n));
+        TEST_ASSERT_EQUAL(n, i);
+    }
+
+    TEST_ASSERT_FALSE(sstable_has_key(table, ""));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "a"));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "config"));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "config/display/"));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "config/display/000"));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "config/display/00000"));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "config/display/0001"));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "config/network/0000"));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "config/zzz"));
+    TEST_ASSERT_FALSE(sstable_has_key(table, "zzz"));
+
+    sstable_destroy(table);
+}
+
+/*  Visitor function to count keys and check their order  */
+
+static bool count_visitor(const char * key, void * value, void * ctx)
+{
+    static char last[64];
+    size_t * count = ctx;
+
+    (void) value;
+    if ( *count > 0 && strcmp(last, key) >= 0 ) {
+        abort();
+    }
+    strcpy(last, key);
+    *count += 1;
+
+    return true;
+}
+
+/*  Visitor function to stop after the first key  */
+
+static bool first_visitor(const char * key, void * value, void * ctx)
+{
+    strcpy(ctx, key);
+    return *((int *) value) < 0;
+}
+
+/*  Visitor function to count keys and check their length  */
+
+static bool length_visitor(const char * key, void * value, void * ctx)
+{
+    size_t * count = ctx;
+
+    (void) value;
+    if ( strlen(key) != LONG_KEY_LEN ) {
+        abort();
+    }
+    *count += 1;
+
+    return true;
+}
+
+/*  Test prefix scans  */
+
+TEST_CASE(test_sstable_prefix_scan)
+{
+    Vector pairs = vector_create(0, DATATYPE_POINTER, 0,
+                                 gds_kvpair_compare);
+    if ( !pairs ) {
+        perror("couldn't create vector");
+        exit(EXIT_FAILURE);
+    }
+
+    char key[64];
+    for ( int i = 0; i < NUM_KEYS; ++i ) {
+        make_key(key, i);
+        append_pair(pairs, key, DATATYPE_INT, i);
+    }
+    vector_sort(pairs);
+
+    SSTable table = sstable_create(pairs, DATATYPE_INT, 0);
+    destroy_pairs(pairs);
+    if ( !table ) {
+        perror("couldn't create sorted string table");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t count = 0;
+    TEST_ASSERT_EQUAL(sstable_prefix_scan(table, "", count_visitor, &count),
+                      NUM_KEYS);
+
+    count = 0;
+    TEST_ASSERT_EQUAL(sstable_prefix_scan(table, "config/network/",
+                                          count_visitor, &count),
+                      NUM_KEYS / 2);
+
+    /*  Odd numbers from 1001 to 1099  */
+
+    count = 0;
+    TEST_ASSERT_EQUAL(sstable_prefix_scan(table, "config/network/10",
+                                          count_visitor, &count), 50);
+
+    count = 0;
+    TEST_ASSERT_EQUAL(sstable_prefix_scan(table, "config/sound",
+                                          count_visitor, &count), 0);
+    TEST_ASSERT_EQUAL(sstable_prefix_scan(table, "zzz",
+                                          count_visitor, &count), 0);
+
+    TEST_ASSERT_EQUAL(sstable_prefix_scan(table, "config/network/2",
+                                          first_visitor, key), 1);
+    TEST_ASSERT_STR_EQUAL(key, "config/network/2001");
+
+    sstable_destroy(table);
+
+    /*  Keys longer than the scan decodes without allocating  */
+
+    pairs = vector_create(0, DATATYPE_POINTER, 0, gds_kvpair_compare);
+    if ( !pairs ) {
+        perror("couldn't create vector");
+        exit(EXIT_FAILURE);
+    }
+
+    char long_key[LONG_KEY_LEN + 1];
+    memset(long_key, 'a', LONG_KEY_LEN - 3);
+    for ( int i = 0; i < 40; ++i ) {
+        sprintf(long_key + LONG_KEY_LEN - 3, "%03d", i);
+        append_pair(pairs, long_key, DATATYPE_INT, i);
+    }
+
+    table = sstable_create(pairs, DATATYPE_INT, 0);
+    destroy_pairs(pairs);
+    if ( !table ) {
+        perror("couldn't create sorted string table");
+        exit(EXIT_FAILURE);
+    }
+
+    long_key[LONG_KEY_LEN - 1] = '\0';
+    count = 0;
+    TEST_ASSERT_EQUAL(sstable_prefix_scan(table, long_key,
+                                          length_visitor, &count), 10);
+    TEST_ASSERT_EQUAL(count, 10);
+
+    sstable_destroy(table);
+}
+
+/*  Test string values with GDS_FREE_ON_DESTROY, and bad input  */
+
+TEST_CASE(test_sstable_strings)
+{
+    Vector pairs = vector_create(0, DATATYPE_POINTER, 0, gds_kvpair_compare);
+    if ( !pairs ) {
+        perror("couldn't create vector");
+        exit(EXIT_FAILURE);
+    }
+
+    append_pair(pairs, "john", DATATYPE_STRING, gds_strdup("Bolton"));
+    append_pair(pairs, "johnny", DATATYPE_STRING, gds_strdup("Leeds"));
+    append_pair(pairs, "mary", DATATYPE_STRING, gds_strdup("Portsmouth"));
+
+    SSTable table = sstable_create(pairs, DATATYPE_STRING,
+                                   GDS_FREE_ON_DESTROY);
+    destroy_pairs(pairs);
+    if ( !table ) {
+        perror("couldn't create sorted string table");
+        exit(EXIT_FAILURE);
+    }
+
+    char * pc;
+    TEST_ASSERT_TRUE(sstable_value_for_key(table, "johnny", &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "Leeds");
+    TEST_ASSERT_TRUE(sstable_value_for_key(table, "john", &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "Bolton");
+    TEST_ASSERT_FALSE(sstable_has_key(table, "joh"));
+
+    sstable_destroy(table);
+
+    /*  Unsorted keys are rejected  */
+
+    pairs = vector_create(0, DATATYPE_POINTER, 0, gds_kvpair_compare);
+    if ( !pairs ) {
+        perror("couldn't create vector");
+        exit(EXIT_FAILURE);
+    }
+
+    append_pair(pairs, "mary", DATATYPE_INT, 1);
+    append_pair(pairs, "john", DATATYPE_INT, 2);
+    TEST_ASSERT_TRUE(sstable_create(pairs, DATATYPE_INT, 0) == NULL);
+
+    /*  An empty table is valid  */
+
+    destroy_pairs(pairs);
+    pairs = vector_create(0, DATATYPE_POINTER, 0, gds_kvpair_compare);
+    if ( !pairs ) {
+        perror("couldn't create vector");
+        exit(EXIT_FAILURE);
+    }
+
+    table = sstable_create(pairs, DATATYPE_INT, 0);
+    TEST_ASSERT_TRUE(table != NULL);
+    TEST_ASSERT_FALSE(sstable_has_key(table, "john"));
+    sstable_destroy(table);
+
+    vector_destroy(pairs);
+}
+
+void test_sstable(void)
+{
+    RUN_CASE(test_sstable_lookup);
+    RUN_CASE(test_sstable_prefix_scan);
+    RUN_CASE(test_sstable_strings);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_SORTED_STRING_TABLE_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_SORTED_STRING_TABLE_H
+
+void test_sstable(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_SORTED_STRING_TABLE_H  */
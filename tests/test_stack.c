@@ -129,8 +129,192 @@ TEST_CASE(test_stack_free_strings)
     stack_destroy(stack);
 }
 
+/*  Test pushing and popping arrays of values  */
+
+TEST_CASE(test_stack_batch)
+{
+    Stack stack = stack_create(4, DATATYPE_INT, 0);
+    if ( !stack ) {
+        perror("couldn't create stack");
+        exit(EXIT_FAILURE);
+    }
+
+    const int in[] = {1, 2, 3, 4, 5};
+    int out[8], n;
+
+    TEST_ASSERT_TRUE(stack_push_n(stack, in, 3));
+    TEST_ASSERT_FALSE(stack_push_n(stack, in, 2));
+    TEST_ASSERT_TRUE(stack_push_n(stack, in + 3, 1));
+    TEST_ASSERT_TRUE(stack_is_full(stack));
+    TEST_ASSERT_TRUE(stack_push_n(stack, in, 0));
+
+    TEST_ASSERT_TRUE(stack_peek(stack, &n));
+    TEST_ASSERT_EQUAL(n, 4);
+
+    /*  Popped values come out in the order they were pushed  */
+
+    TEST_ASSERT_EQUAL(stack_pop_n(stack, out, 2), 2);
+    TEST_ASSERT_EQUAL(out[0], 3);
+    TEST_ASSERT_EQUAL(out[1], 4);
+    TEST_ASSERT_EQUAL(stack_pop_n(stack, out, 8), 2);
+    TEST_ASSERT_EQUAL(out[0], 1);
+    TEST_ASSERT_EQUAL(out[1], 2);
+    TEST_ASSERT_TRUE(stack_is_empty(stack));
+    TEST_ASSERT_EQUAL(stack_pop_n(stack, out, 8), 0);
+
+    stack_destroy(stack);
+}
+
+/*  Test growing a resizable stack with batches  */
+
+TEST_CASE(test_stack_batch_resize)
+{
+    Stack stack = stack_create(2, DATATYPE_SIZE_T, GDS_RESIZABLE);
+    if ( !stack ) {
+        perror("couldn't create stack");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t values[100];
+    for ( size_t i = 0; i < 100; ++i ) {
+        values[i] = i;
+    }
+
+    TEST_ASSERT_TRUE(stack_push(stack, values[0]));
+    TEST_ASSERT_TRUE(stack_push_n(stack, values + 1, 99));
+    TEST_ASSERT_EQUAL(stack_size(stack), 100);
+    TEST_ASSERT_TRUE(stack_capacity(stack) >= 100);
+
+    size_t out[100], value;
+    TEST_ASSERT_TRUE(stack_pop(stack, &value));
+    TEST_ASSERT_EQUAL(value, 99);
+    TEST_ASSERT_EQUAL(stack_pop_n(stack, out, 100), 99);
+    for ( size_t i = 0; i < 99; ++i ) {
+        TEST_ASSERT_EQUAL(out[i], i);
+    }
+
+    stack_destroy(stack);
+}
+
+/*  Test a segmented stack, growing and shrinking across many chunks  */
+
+TEST_CASE(test_stack_segmented)
+{
+    Stack stack = stack_create(0, DATATYPE_INT, GDS_SEGMENTED);
+    if ( !stack ) {
+        perror("couldn't create stack");
+        exit(EXIT_FAILURE);
+    }
+
+    int n, values[1000];
+    bool in_order = true;
+
+    for ( int i = 0; i < 1000; ++i ) {
+        TEST_ASSERT_TRUE(stack_push(stack, i));
+    }
+    TEST_ASSERT_EQUAL(stack_size(stack), 1000);
+    TEST_ASSERT_TRUE(stack_capacity(stack) >= 1000);
+
+    for ( int i = 999; i >= 500; --i ) {
+        in_order = stack_pop(stack, &n) && n == i && in_order;
+    }
+    TEST_ASSERT_TRUE(in_order);
+    TEST_ASSERT_TRUE(stack_peek(stack, &n));
+    TEST_ASSERT_EQUAL(n, 499);
+
+    /*  Batches are split across chunk boundaries  */
+
+    for ( int i = 0; i < 500; ++i ) {
+        values[i] = 500 + i;
+    }
+    TEST_ASSERT_TRUE(stack_push_n(stack, values, 500));
+    TEST_ASSERT_EQUAL(stack_pop_n(stack, values, 700), 700);
+    for ( int i = 0; i < 700; ++i ) {
+        in_order = values[i] == 300 + i && in_order;
+    }
+    TEST_ASSERT_TRUE(in_order);
+
+    /*  Going back and forth over a chunk boundary keeps a spare  */
+
+    const size_t capacity = stack_capacity(stack);
+    for ( int i = 0; i < 100; ++i ) {
+        stack_push_n(stack, values, 300);
+        stack_pop_n(stack, values, 300);
+    }
+    TEST_ASSERT_EQUAL(stack_capacity(stack), capacity);
+
+    TEST_ASSERT_EQUAL(stack_pop_n(stack, values, 1000), 300);
+    for ( int i = 0; i < 300; ++i ) {
+        in_order = values[i] == i && in_order;
+    }
+    TEST_ASSERT_TRUE(in_order);
+    TEST_ASSERT_TRUE(stack_is_empty(stack));
+    TEST_ASSERT_FALSE(stack_pop(stack, &n));
+
+    stack_destroy(stack);
+}
+
+/*  Test a segmented stack grows by chunks of its initial capacity  */
+
+TEST_CASE(test_stack_segmented_chunks)
+{
+    Stack stack = stack_create(16, DATATYPE_INT, GDS_SEGMENTED);
+    if ( !stack ) {
+        perror("couldn't create stack");
+        exit(EXIT_FAILURE);
+    }
+
+    for ( int i = 0; i < 16; ++i ) {
+        stack_push(stack, i);
+    }
+    TEST_ASSERT_EQUAL(stack_capacity(stack), 16);
+
+    stack_push(stack, 16);
+    TEST_ASSERT_EQUAL(stack_capacity(stack), 32);
+
+    for ( int i = 17; i < 100; ++i ) {
+        stack_push(stack, i);
+    }
+    TEST_ASSERT_EQUAL(stack_capacity(stack), 112);
+
+    int n;
+    TEST_ASSERT_TRUE(stack_peek(stack, &n));
+    TEST_ASSERT_EQUAL(n, 99);
+
+    stack_destroy(stack);
+}
+
+/*  Test strings still on a segmented stack are freed on destruction  */
+
+TEST_CASE(test_stack_segmented_free)
+{
+    Stack stack = stack_create(2, DATATYPE_STRING,
+                               GDS_SEGMENTED | GDS_FREE_ON_DESTROY);
+    if ( !stack ) {
+        perror("couldn't create stack");
+        exit(EXIT_FAILURE);
+    }
+
+    char buffer[32], * pc;
+    for ( int i = 0; i < 100; ++i ) {
+        sprintf(buffer, "String %d", i);
+        TEST_ASSERT_TRUE(stack_push(stack, strdup(buffer)));
+    }
+
+    TEST_ASSERT_TRUE(stack_pop(stack, &pc));
+    TEST_ASSERT_STR_EQUAL(pc, "String 99");
+    free(pc);
+
+    stack_destroy(stack);
+}
+
 void test_stack(void)
 {
     RUN_CASE(test_stack_basic_ops);
     RUN_CASE(test_stack_free_strings);
+    RUN_CASE(test_stack_batch);
+    RUN_CASE(test_stack_batch_resize);
+    RUN_CASE(test_stack_segmented);
+    RUN_CASE(test_stack_segmented_chunks);
+    RUN_CASE(test_stack_segmented_free);
 }
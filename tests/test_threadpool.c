@@ -0,0 +1,207 @@
+/*  Unit tests for work-stealing thread pool  */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pggds/threadpool.h>
+#include <pggds/unittest.h>
+#include "test_threadpool.h"
+
+TEST_SUITE(test_threadpool);
+
+/*  Number of worker threads for tests  */
+#define NUM_THREADS 4
+
+/*  Task function to square an integer  */
+
+static void * square_task(void * arg)
+{
+    const intptr_t n = (intptr_t) arg;
+    return (void *) (n * n);
+}
+
+/*  Test submitting independent tasks and waiting for their results  */
+
+TEST_CASE(test_threadpool_submit)
+{
+    ThreadPool pool = threadpool_create(NUM_THREADS, 0);
+    if ( !pool ) {
+        perror("couldn't create thread pool");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_EQUAL(threadpool_num_threads(pool), NUM_THREADS);
+
+    Future futures[500];
+    for ( intptr_t i = 0; i < 500; ++i ) {
+        futures[i] = threadpool_submit(pool, square_task, (void *) i);
+        TEST_ASSERT_TRUE(futures[i] != NULL);
+    }
+
+    bool results_ok = true;
+    for ( intptr_t i = 0; i < 500; ++i ) {
+        results_ok = (intptr_t) future_wait(futures[i]) == i * i &&
+                     results_ok;
+    }
+    TEST_ASSERT_TRUE(results_ok);
+
+    threadpool_destroy(pool);
+}
+
+/*  Task function to calculate Fibonacci numbers by submitting subtasks  */
+
+struct fib_arg {
+    ThreadPool pool;
+    intptr_t n;
+};
+
+static void * fib_task(void * arg)
+{
+    struct fib_arg * fa = arg;
+    if ( fa->n < 2 ) {
+        return (void *) fa->n;
+    }
+
+    struct fib_arg left = { fa->pool, fa->n - 1 };
+    struct fib_arg right = { fa->pool, fa->n - 2 };
+
+    /*  Submit one half, run the other here, then wait  */
+
+    Future future = threadpool_submit(fa->pool, fib_task, &left);
+    const intptr_t b = (intptr_t) fib_task(&right);
+    const intptr_t a = (intptr_t) future_wait(future);
+
+    return (void *) (a + b);
+}
+
+/*  Test tasks which submit and wait for further tasks  */
+
+TEST_CASE(test_threadpool_nested)
+{
+    ThreadPool pool = threadpool_create(NUM_THREADS, 0);
+    if ( !pool ) {
+        perror("couldn't create thread pool");
+        exit(EXIT_FAILURE);
+    }
+
+    struct fib_arg fa = { pool, 20 };
+    Future future = threadpool_submit(pool, fib_task, &fa);
+    TEST_ASSERT_EQUAL((intptr_t) future_wait(future), 6765);
+
+    /*  Also with a single worker, which must never wait for itself  */
+
+    threadpool_destroy(pool);
+    pool = threadpool_create(1, 0);
+    if ( !pool ) {
+        perror("couldn't create thread pool");
+        exit(EXIT_FAILURE);
+    }
+
+    fa.pool = pool;
+    fa.n = 15;
+    future = threadpool_submit(pool, fib_task, &fa);
+    TEST_ASSERT_EQUAL((intptr_t) future_wait(future), 610);
+
+    threadpool_destroy(pool);
+}
+
+/*  Loop body to add each index to a total, and count calls  */
+
+struct sum_ctx {
+    size_t grain;
+    size_t sum;
+    size_t calls;
+    bool pieces_ok;
+};
+
+static void sum_range(size_t begin, size_t end, void * ctx)
+{
+    struct sum_ctx * sc = ctx;
+    size_t sum = 0;
+    for ( size_t i = begin; i < end; ++i ) {
+        sum += i;
+    }
+
+    if ( end - begin > sc->grain || begin >= end ) {
+        __atomic_store_n(&sc->pieces_ok, false, __ATOMIC_RELAXED);
+    }
+
+    __atomic_add_fetch(&sc->sum, sum, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sc->calls, 1, __ATOMIC_RELAXED);
+}
+
+/*  Test parallel for loops  */
+
+TEST_CASE(test_threadpool_parallel_for)
+{
+    ThreadPool pool = threadpool_create(NUM_THREADS, 0);
+    if ( !pool ) {
+        perror("couldn't create thread pool");
+        exit(EXIT_FAILURE);
+    }
+
+    struct sum_ctx sc = { 1000, 0, 0, true };
+    threadpool_parallel_for(pool, 10, 100010, sc.grain, sum_range, &sc);
+    TEST_ASSERT_TRUE(sc.pieces_ok);
+    TEST_ASSERT_EQUAL(sc.sum, (size_t) 100009 * 100010 / 2 - 45);
+    TEST_ASSERT_TRUE(sc.calls >= 100);
+
+    /*  Empty ranges call nothing, and tiny ranges are not split  */
+
+    sc.sum = 0;
+    sc.calls = 0;
+    threadpool_parallel_for(pool, 5, 5, 1, sum_range, &sc);
+    TEST_ASSERT_EQUAL(sc.calls, 0);
+    threadpool_parallel_for(pool, 5, 8, 0, sum_range, &sc);
+    TEST_ASSERT_EQUAL(sc.sum, 18);
+    TEST_ASSERT_EQUAL(sc.calls, 3);
+    TEST_ASSERT_TRUE(sc.pieces_ok);
+
+    threadpool_destroy(pool);
+}
+
+/*  Task function to increment a counter  */
+
+static void * count_task(void * arg)
+{
+    __atomic_add_fetch((size_t *) arg, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/*  Test that destroying a pool finishes its tasks first  */
+
+TEST_CASE(test_threadpool_destroy)
+{
+    ThreadPool pool = threadpool_create(0, 0);
+    if ( !pool ) {
+        perror("couldn't create thread pool");
+        exit(EXIT_FAILURE);
+    }
+
+    TEST_ASSERT_TRUE(threadpool_num_threads(pool) > 0);
+
+    size_t count = 0;
+    Future futures[200];
+    for ( size_t i = 0; i < 200; ++i ) {
+        futures[i] = threadpool_submit(pool, count_task, &count);
+    }
+
+    threadpool_destroy(pool);
+    TEST_ASSERT_EQUAL(count, 200);
+
+    for ( size_t i = 0; i < 200; ++i ) {
+        TEST_ASSERT_TRUE(future_is_ready(futures[i]));
+        TEST_ASSERT_TRUE(future_wait(futures[i]) == NULL);
+    }
+}
+
+void test_threadpool(void)
+{
+    RUN_CASE(test_threadpool_submit);
+    RUN_CASE(test_threadpool_nested);
+    RUN_CASE(test_threadpool_parallel_for);
+    RUN_CASE(test_threadpool_destroy);
+}
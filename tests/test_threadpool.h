@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_THREAD_POOL_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_THREAD_POOL_H
+
+void test_threadpool(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_THREAD_POOL_H  */
@@ -0,0 +1,255 @@
+/*  Unit tests for hierarchical timer wheel  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pggds/timerwheel.h>
+#include <pggds/unittest.h>
+#include "test_timerwheel.h"
+
+TEST_SUITE(test_timerwheel);
+
+/*  Timer record, checked by the callback  */
+
+struct test_timer {
+    TimerWheel wheel;
+    uint64_t expires;
+    uint64_t fired_at;
+    TimerId id;
+    int fired;
+};
+
+/*  Time at which the last checked timer fired  */
+
+static uint64_t last_fired;
+
+/*  Number of timers which fired at the wrong time or out of order  */
+
+static size_t timer_errors;
+
+/*  Records the time at which a timer fired  */
+
+static void record_timer(void * arg)
+{
+    struct test_timer * timer = arg;
+    timer->fired_at = timerwheel_now(timer->wheel);
+    timer->fired += 1;
+}
+
+/*  Checks that a timer fires exactly on time and in order  */
+
+static void check_timer(void * arg)
+{
+    struct test_timer * timer = arg;
+    record_timer(timer);
+    if ( timer->fired_at != timer->expires ||
+         timer->fired_at < last_fired ) {
+        ++timer_errors;
+    }
+    last_fired = timer->fired_at;
+}
+
+/*  Reschedules a timer once, and cancels the timer passed with it  */
+
+static void reschedule_timer(void * arg)
+{
+    struct test_timer * timer = arg;
+    record_timer(timer);
+    if ( timer->fired == 1 ) {
+        timer->id = timerwheel_schedule(timer->wheel, timer->fired_at + 10,
+                                        reschedule_timer, timer);
+        if ( !timerwheel_cancel(timer->wheel, timer[1].id) ) {
+            ++timer_errors;
+        }
+    }
+}
+
+/*  Test basic scheduling, ticking and cancelling  */
+
+TEST_CASE(test_timerwheel_basic)
+{
+    TimerWheel wheel = timerwheel_create(1000, 0);
+    if ( !wheel ) {
+        perror("couldn't create timer wheel");
+        exit(EXIT_FAILURE);
+    }
+
+    struct test_timer timers[4];
+    const uint64_t expires[] = {1005, 1005, 1100, 5000};
+    for ( size_t i = 0; i < 4; ++i ) {
+        timers[i].wheel = wheel;
+        timers[i].fired = 0;
+        timers[i].id = timerwheel_schedule(wheel, expires[i],
+                                           record_timer, &timers[i]);
+        TEST_ASSERT_NOTEQUAL(timers[i].id, 0);
+    }
+    TEST_ASSERT_EQUAL(timerwheel_size(wheel), 4);
+    TEST_ASSERT_EQUAL(timerwheel_now(wheel), 1000);
+
+    TEST_ASSERT_EQUAL(timerwheel_tick(wheel, 1004), 0);
+    TEST_ASSERT_EQUAL(timerwheel_tick(wheel, 1050), 2);
+    TEST_ASSERT_EQUAL(timers[0].fired, 1);
+    TEST_ASSERT_EQUAL(timers[0].fired_at, 1005);
+    TEST_ASSERT_EQUAL(timers[1].fired_at, 1005);
+    TEST_ASSERT_EQUAL(timerwheel_now(wheel), 1050);
+
+    TEST_ASSERT_FALSE(timerwheel_cancel(wheel, timers[0].id));
+    TEST_ASSERT_TRUE(timerwheel_cancel(wheel, timers[2].id));
+    TEST_ASSERT_FALSE(timerwheel_cancel(wheel, timers[2].id));
+    TEST_ASSERT_FALSE(timerwheel_cancel(wheel, 0));
+    TEST_ASSERT_EQUAL(timerwheel_size(wheel), 1);
+
+    /*  Reused nodes get new identifiers  */
+
+    struct test_timer late = {wheel, 0, 0, 0, 0};
+    late.id = timerwheel_schedule(wheel, 10, record_timer, &late);
+    TEST_ASSERT_NOTEQUAL(late.id, timers[0].id);
+    TEST_ASSERT_NOTEQUAL(late.id, timers[2].id);
+
+    /*  Timers already due fire on the next tick, even without moving  */
+
+    TEST_ASSERT_EQUAL(timerwheel_tick(wheel, 1050), 1);
+    TEST_ASSERT_EQUAL(late.fired, 1);
+
+    /*  The clock does not go backwards  */
+
+    TEST_ASSERT_EQUAL(timerwheel_tick(wheel, 20), 0);
+    TEST_ASSERT_EQUAL(timerwheel_now(wheel), 1050);
+
+    TEST_ASSERT_EQUAL(timerwheel_tick(wheel, 4999), 0);
+    TEST_ASSERT_EQUAL(timerwheel_tick(wheel, 100000), 1);
+    TEST_ASSERT_EQUAL(timers[3].fired_at, 5000);
+    TEST_ASSERT_EQUAL(timers[2].fired, 0);
+    TEST_ASSERT_EQUAL(timerwheel_size(wheel), 0);
+
+    timerwheel_destroy(wheel);
+}
+
+/*  Test timers far beyond the range of the wheel  */
+
+TEST_CASE(test_timerwheel_far)
+{
+    TimerWheel wheel = timerwheel_create(0, 0);
+    if ( !wheel ) {
+        perror("couldn't create timer wheel");
+        exit(EXIT_FAILURE);
+    }
+
+    const uint64_t expires[] = {
+        (uint64_t) 1 << 20, ((uint64_t) 1 << 48) + 7,
+        ((uint64_t) 1 << 52) + 12345, ((uint64_t) 1 << 62) + 1
+    };
+    struct test_timer timers[4];
+    for ( size_t i = 0; i < 4; ++i ) {
+        timers[i].wheel = wheel;
+        timers[i].expires = expires[i];
+        timers[i].fired = 0;
+        timerwheel_schedule(wheel, expires[i], check_timer, &timers[i]);
+    }
+
+    last_fired = 0;
+    timer_errors = 0;
+    for ( size_t i = 0; i < 4; ++i ) {
+        TEST_ASSERT_EQUAL(timerwheel_tick(wheel, expires[i] - 1), 0);
+        TEST_ASSERT_EQUAL(timerwheel_tick(wheel, expires[i]), 1);
+        TEST_ASSERT_EQUAL(timers[i].fired, 1);
+    }
+    TEST_ASSERT_EQUAL(timer_errors, 0);
+
+    timerwheel_destroy(wheel);
+}
+
+/*  Test callbacks which schedule and cancel timers  */
+
+TEST_CASE(test_timerwheel_callbacks)
+{
+    TimerWheel wheel = timerwheel_create(0, 0);
+    if ( !wheel ) {
+        perror("couldn't create timer wheel");
+        exit(EXIT_FAILURE);
+    }
+
+    /*  The first timer reschedules itself once, and
+     *  cancels the second timer before it is due.    */
+
+    struct test_timer timers[2];
+    for ( size_t i = 0; i < 2; ++i ) {
+        timers[i].wheel = wheel;
+        timers[i].fired = 0;
+    }
+    timers[0].id = timerwheel_schedule(wheel, 100, reschedule_timer,
+                                       &timers[0]);
+    timers[1].id = timerwheel_schedule(wheel, 500, record_timer,
+                                       &timers[1]);
+    timer_errors = 0;
+
+    TEST_ASSERT_EQUAL(timerwheel_tick(wheel, 105), 1);
+    TEST_ASSERT_EQUAL(timerwheel_size(wheel), 1);
+    TEST_ASSERT_EQUAL(timerwheel_tick(wheel, 1000), 1);
+    TEST_ASSERT_EQUAL(timers[0].fired, 2);
+    TEST_ASSERT_EQUAL(timers[0].fired_at, 110);
+    TEST_ASSERT_EQUAL(timers[1].fired, 0);
+    TEST_ASSERT_EQUAL(timerwheel_size(wheel), 0);
+    TEST_ASSERT_EQUAL(timer_errors, 0);
+
+    timerwheel_destroy(wheel);
+}
+
+/*  Test many timers with random expiries and cancellations  */
+
+TEST_CASE(test_timerwheel_many)
+{
+    const size_t n = 20000;
+    TimerWheel wheel = timerwheel_create(0, 0);
+    struct test_timer * timers = malloc(n * sizeof *timers);
+    if ( !wheel || !timers ) {
+        perror("couldn't create timer wheel");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long seed = 42;
+    size_t expected = 0;
+    for ( size_t i = 0; i < n; ++i ) {
+        seed = seed * 1103515245 + 12345;
+        timers[i].wheel = wheel;
+        timers[i].fired = 0;
+        timers[i].expires = 1 + (seed >> 4) % (1 << (4 + (i % 20)));
+        timers[i].id = timerwheel_schedule(wheel, timers[i].expires,
+                                           check_timer, &timers[i]);
+        TEST_ASSERT_NOTEQUAL(timers[i].id, 0);
+    }
+
+    for ( size_t i = 0; i < n; i += 3 ) {
+        TEST_ASSERT_TRUE(timerwheel_cancel(wheel, timers[i].id));
+    }
+    for ( size_t i = 0; i < n; ++i ) {
+        expected += (i % 3) != 0;
+    }
+    TEST_ASSERT_EQUAL(timerwheel_size(wheel), expected);
+
+    size_t fired = 0;
+    uint64_t now = 0;
+    last_fired = 0;
+    timer_errors = 0;
+    while ( timerwheel_size(wheel) > 0 ) {
+        seed = seed * 1103515245 + 12345;
+        now += (seed >> 4) % 5000;
+        fired += timerwheel_tick(wheel, now);
+    }
+    TEST_ASSERT_EQUAL(fired, expected);
+    TEST_ASSERT_EQUAL(timer_errors, 0);
+
+    for ( size_t i = 0; i < n; ++i ) {
+        TEST_ASSERT_EQUAL(timers[i].fired, (i % 3) != 0);
+    }
+
+    free(timers);
+    timerwheel_destroy(wheel);
+}
+
+void test_timerwheel(void)
+{
+    RUN_CASE(test_timerwheel_basic);
+    RUN_CASE(test_timerwheel_far);
+    RUN_CASE(test_timerwheel_callbacks);
+    RUN_CASE(test_timerwheel_many);
+}
@@ -0,0 +1,6 @@
+#ifndef PG_GENERIC_DATA_STRUCTURES_TEST_TIMERWHEEL_H
+#define PG_GENERIC_DATA_STRUCTURES_TEST_TIMERWHEEL_H
+
+void test_timerwheel(void);
+
+#endif      /*  PG_GENERIC_DATA_STRUCTURES_TEST_TIMERWHEEL_H  */